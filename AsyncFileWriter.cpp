@@ -0,0 +1,107 @@
+#include "AsyncFileWriter.h"
+
+#include <cstdio>
+#include <fstream>
+
+AsyncFileWriter::AsyncFileWriter(size_t MaxQueuedBytes) : MaxQueuedBytes(MaxQueuedBytes), Writer(&AsyncFileWriter::WriterLoop, this)
+{
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+	{
+		std::lock_guard<std::mutex> Lock(QueueMutex);
+		ShuttingDown = true;
+	}
+
+	FileQueued.notify_one();
+	Writer.join();
+}
+
+void AsyncFileWriter::Write(std::string Path, std::vector<uint8_t> Data)
+{
+	std::unique_lock<std::mutex> Lock(QueueMutex);
+
+	// A file larger than the limit still goes through once the queue is empty
+	FileWritten.wait(Lock, [&] { return Queue.empty() || QueuedBytes + Data.size() <= MaxQueuedBytes; });
+
+	QueuedBytes += Data.size();
+	Queue.push_back({ std::move(Path), std::move(Data) });
+
+	Lock.unlock();
+	FileQueued.notify_one();
+}
+
+void AsyncFileWriter::Flush()
+{
+	std::unique_lock<std::mutex> Lock(QueueMutex);
+	FileWritten.wait(Lock, [this] { return Queue.empty() && !Writing; });
+}
+
+uint32_t AsyncFileWriter::GetWrittenCount() const
+{
+	std::lock_guard<std::mutex> Lock(QueueMutex);
+	return WrittenCount;
+}
+
+uint32_t AsyncFileWriter::GetFailedCount() const
+{
+	std::lock_guard<std::mutex> Lock(QueueMutex);
+	return FailedCount;
+}
+
+uint64_t AsyncFileWriter::GetWrittenBytes() const
+{
+	std::lock_guard<std::mutex> Lock(QueueMutex);
+	return WrittenBytes;
+}
+
+void AsyncFileWriter::WriterLoop()
+{
+	while (true)
+	{
+		File Current;
+
+		{
+			std::unique_lock<std::mutex> Lock(QueueMutex);
+			FileQueued.wait(Lock, [this] { return ShuttingDown || !Queue.empty(); });
+
+			if (Queue.empty())
+				return;
+
+			Current = std::move(Queue.front());
+			Queue.pop_front();
+			Writing = true;
+		}
+
+		std::ofstream Stream(Current.Path, std::ios::binary | std::ios::trunc);
+
+		if (Stream)
+			Stream.write(reinterpret_cast<const char*>(Current.Data.data()), Current.Data.size());
+
+		Stream.close();
+
+		const bool Written = !Stream.fail();
+
+		if (!Written)
+			printf("AsyncFileWriter: could not write %s\n", Current.Path.c_str());
+
+		{
+			std::lock_guard<std::mutex> Lock(QueueMutex);
+			QueuedBytes -= Current.Data.size();
+			Writing = false;
+
+			if (Written)
+			{
+				++WrittenCount;
+				WrittenBytes += Current.Data.size();
+			}
+			else
+			{
+				++FailedCount;
+			}
+		}
+
+		FileWritten.notify_all();
+	}
+}
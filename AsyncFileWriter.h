@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes whole files on a thread of its own. Write takes the data over and returns at once while less than
+// MaxQueuedBytes wait to be written, else it blocks until there is room, so a producer faster than the disk is
+// throttled instead of piling up memory.
+class AsyncFileWriter
+{
+public:
+	explicit AsyncFileWriter(size_t MaxQueuedBytes = 256 * 1024 * 1024);
+	// Writes what is still queued
+	~AsyncFileWriter();
+
+	AsyncFileWriter(const AsyncFileWriter&) = delete;
+	AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+	// Creates or replaces the file at Path
+	void Write(std::string Path, std::vector<uint8_t> Data);
+	// Blocks until every file queued so far is written
+	void Flush();
+
+	uint32_t GetWrittenCount() const;
+	// Files that could not be created or written, each reported once on stdout
+	uint32_t GetFailedCount() const;
+	uint64_t GetWrittenBytes() const;
+
+private:
+	struct File
+	{
+		std::string Path;
+		std::vector<uint8_t> Data;
+	};
+
+	void WriterLoop();
+
+	size_t MaxQueuedBytes;
+
+	mutable std::mutex QueueMutex;
+	std::condition_variable FileQueued;
+	std::condition_variable FileWritten;
+	std::deque<File> Queue;
+	size_t QueuedBytes = 0;
+	bool Writing = false;
+	bool ShuttingDown = false;
+
+	uint32_t WrittenCount = 0;
+	uint32_t FailedCount = 0;
+	uint64_t WrittenBytes = 0;
+
+	std::thread Writer;
+};
@@ -0,0 +1,405 @@
+#include "CPUCompressedDepth.h"
+#include "CPUParallel.h"
+
+#include <algorithm>
+#include <cstring>
+
+static bool SameBits(float a, float b)
+{
+	return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+void CPUCompressedDepthSurface::Allocate(uint32_t NewWidth, uint32_t NewHeight, uint32_t NewSampleCount, const CPUSamplePattern& NewPattern, uint32_t NewMaxPlanes)
+{
+	Width = NewWidth;
+	Height = NewHeight;
+	SampleCount = NewSampleCount;
+	MaxPlanes = std::clamp(NewMaxPlanes, 1u, MaxPlanesPerTile);
+	Pattern = NewPattern;
+
+	Blocks.clear();
+	Blocks.resize(static_cast<size_t>(GetBlocksX()) * GetBlocksY());
+}
+
+void CPUCompressedDepthSurface::Clear(float Depth, uint8_t Stencil)
+{
+	ClearStencil = Stencil;
+
+	for (Block& CurrentBlock : Blocks)
+	{
+		CurrentBlock.Planes.assign(1, CPUDepthPlane{ 0.0f, 0.0f, Depth });
+		CurrentBlock.Selectors.clear();
+		CurrentBlock.RawDepths.clear();
+
+		for (Tile& CurrentTile : CurrentBlock.Tiles)
+			CurrentTile = { 0, 0, 1 };
+	}
+}
+
+void CPUCompressedDepthSurface::DecodeBlock(uint32_t BlockX, uint32_t BlockY, CPUDepthStencilSample* Samples, uint32_t* PlaneIds, std::vector<CPUDepthPlane>& StoredPlanes) const
+{
+	const Block& CurrentBlock = Blocks[BlockY * GetBlocksX() + BlockX];
+	const uint32_t BlockPixelX = BlockX * BlockSize;
+	const uint32_t BlockPixelY = BlockY * BlockSize;
+
+	StoredPlanes = CurrentBlock.Planes;
+
+	for (uint32_t TileIndex = 0; TileIndex < TilesPerBlock; ++TileIndex)
+	{
+		const Tile& CurrentTile = CurrentBlock.Tiles[TileIndex];
+		const uint32_t TileX = (TileIndex % (BlockSize / TileSize)) * TileSize;
+		const uint32_t TileY = (TileIndex / (BlockSize / TileSize)) * TileSize;
+
+		for (uint32_t y = TileY; y < TileY + TileSize && BlockPixelY + y < Height; ++y)
+		{
+			for (uint32_t x = TileX; x < TileX + TileSize && BlockPixelX + x < Width; ++x)
+			{
+				const uint32_t PixelInTile = (y - TileY) * TileSize + (x - TileX);
+				const size_t ScratchOffset = (static_cast<size_t>(y) * BlockSize + x) * SampleCount;
+				CPUDepthStencilSample* Pixel = Samples + ScratchOffset;
+				uint32_t* PixelPlaneIds = PlaneIds + ScratchOffset;
+
+				if (CurrentTile.PlaneCount == 0)
+				{
+					const float* RawDepths = &CurrentBlock.RawDepths[CurrentTile.DataOffset + PixelInTile * SampleCount];
+
+					for (uint32_t s = 0; s < SampleCount; ++s)
+					{
+						Pixel[s] = { RawDepths[s], ClearStencil, { 0, 0, 0 } };
+						PixelPlaneIds[s] = RawPlaneId;
+					}
+
+					continue;
+				}
+
+				const uint32_t GlobalX = BlockPixelX + x;
+				const uint32_t GlobalY = BlockPixelY + y;
+				const CPUSamplePosition* Positions = Pattern.GetPixelPositions(Pattern.GetQuadPixel(GlobalX, GlobalY));
+				const uint32_t Selectors = CurrentTile.PlaneCount > 1 ? CurrentBlock.Selectors[CurrentTile.DataOffset + PixelInTile] : 0;
+
+				for (uint32_t s = 0; s < SampleCount; ++s)
+				{
+					const uint32_t PlaneIndex = CurrentTile.PlaneOffset + ((Selectors >> (2 * s)) & 3);
+					const CPUDepthPlane& Plane = CurrentBlock.Planes[PlaneIndex];
+					const float Depth = GetDepthPlaneSample(GetDepthPlanePixelCenter(Plane, GlobalX, GlobalY), GetDepthPlaneSampleDelta(Plane, Positions[s]));
+
+					Pixel[s] = { Depth, ClearStencil, { 0, 0, 0 } };
+					PixelPlaneIds[s] = StoredPlaneBit | PlaneIndex;
+				}
+			}
+		}
+	}
+}
+
+void CPUCompressedDepthSurface::EncodeBlock(uint32_t BlockX, uint32_t BlockY, const CPUDepthStencilSample* Samples, const uint32_t* PlaneIds, const CPUDepthPlane* DrawPlanes, const std::vector<CPUDepthPlane>& StoredPlanes)
+{
+	Block& CurrentBlock = Blocks[BlockY * GetBlocksX() + BlockX];
+	const uint32_t BlockPixelX = BlockX * BlockSize;
+	const uint32_t BlockPixelY = BlockY * BlockSize;
+
+	std::vector<CPUDepthPlane> Planes;
+	std::vector<uint32_t> Selectors;
+	std::vector<float> RawDepths;
+
+	for (uint32_t TileIndex = 0; TileIndex < TilesPerBlock; ++TileIndex)
+	{
+		Tile& CurrentTile = CurrentBlock.Tiles[TileIndex];
+		const uint32_t TileX = (TileIndex % (BlockSize / TileSize)) * TileSize;
+		const uint32_t TileY = (TileIndex / (BlockSize / TileSize)) * TileSize;
+
+		if (BlockPixelX + TileX >= Width || BlockPixelY + TileY >= Height)
+			continue;
+
+		const uint32_t TileWidth = std::min(TileSize, Width - (BlockPixelX + TileX));
+		const uint32_t TileHeight = std::min(TileSize, Height - (BlockPixelY + TileY));
+
+		auto ScratchOffset = [&](uint32_t x, uint32_t y)
+		{
+			return (static_cast<size_t>(TileY + y) * BlockSize + TileX + x) * SampleCount;
+		};
+
+		// Distinct planes of the tile, in first-use order
+		uint32_t TilePlaneIds[MaxPlanesPerTile];
+		uint32_t TilePlaneCount = 0;
+		bool StoreRaw = false;
+
+		for (uint32_t y = 0; y < TileHeight && !StoreRaw; ++y)
+		{
+			for (uint32_t x = 0; x < TileWidth && !StoreRaw; ++x)
+			{
+				const uint32_t* PixelPlaneIds = PlaneIds + ScratchOffset(x, y);
+
+				for (uint32_t s = 0; s < SampleCount && !StoreRaw; ++s)
+				{
+					if (PixelPlaneIds[s] == RawPlaneId)
+					{
+						StoreRaw = true;
+						break;
+					}
+
+					if (std::find(TilePlaneIds, TilePlaneIds + TilePlaneCount, PixelPlaneIds[s]) != TilePlaneIds + TilePlaneCount)
+						continue;
+
+					if (TilePlaneCount == MaxPlanes)
+						StoreRaw = true;
+					else
+						TilePlaneIds[TilePlaneCount++] = PixelPlaneIds[s];
+				}
+			}
+		}
+
+		CPUDepthPlane TilePlanes[MaxPlanesPerTile];
+
+		for (uint32_t p = 0; p < TilePlaneCount && !StoreRaw; ++p)
+			TilePlanes[p] = (TilePlaneIds[p] & StoredPlaneBit) ? StoredPlanes[TilePlaneIds[p] & ~StoredPlaneBit] : DrawPlanes[TilePlaneIds[p]];
+
+		uint32_t TileSelectors[TileSize * TileSize] = {};
+
+		// Keep the planes only if they give back every sample exactly
+		for (uint32_t y = 0; y < TileHeight && !StoreRaw; ++y)
+		{
+			for (uint32_t x = 0; x < TileWidth && !StoreRaw; ++x)
+			{
+				const uint32_t GlobalX = BlockPixelX + TileX + x;
+				const uint32_t GlobalY = BlockPixelY + TileY + y;
+				const CPUSamplePosition* Positions = Pattern.GetPixelPositions(Pattern.GetQuadPixel(GlobalX, GlobalY));
+				const CPUDepthStencilSample* Pixel = Samples + ScratchOffset(x, y);
+				const uint32_t* PixelPlaneIds = PlaneIds + ScratchOffset(x, y);
+				uint32_t PixelSelectors = 0;
+
+				for (uint32_t s = 0; s < SampleCount; ++s)
+				{
+					const uint32_t p = static_cast<uint32_t>(std::find(TilePlaneIds, TilePlaneIds + TilePlaneCount, PixelPlaneIds[s]) - TilePlaneIds);
+					const float Depth = GetDepthPlaneSample(GetDepthPlanePixelCenter(TilePlanes[p], GlobalX, GlobalY), GetDepthPlaneSampleDelta(TilePlanes[p], Positions[s]));
+
+					if (!SameBits(Depth, Pixel[s].Depth))
+					{
+						StoreRaw = true;
+						break;
+					}
+
+					PixelSelectors |= p << (2 * s);
+				}
+
+				TileSelectors[y * TileSize + x] = PixelSelectors;
+			}
+		}
+
+		if (StoreRaw)
+		{
+			CurrentTile = { 0, static_cast<uint32_t>(RawDepths.size()), 0 };
+			RawDepths.resize(RawDepths.size() + TileSize * TileSize * SampleCount);
+
+			for (uint32_t y = 0; y < TileHeight; ++y)
+				for (uint32_t x = 0; x < TileWidth; ++x)
+					for (uint32_t s = 0; s < SampleCount; ++s)
+						RawDepths[CurrentTile.DataOffset + (y * TileSize + x) * SampleCount + s] = Samples[ScratchOffset(x, y) + s].Depth;
+
+			continue;
+		}
+
+		CurrentTile = { static_cast<uint32_t>(Planes.size()), 0, static_cast<uint8_t>(TilePlaneCount) };
+		Planes.insert(Planes.end(), TilePlanes, TilePlanes + TilePlaneCount);
+
+		if (TilePlaneCount > 1)
+		{
+			CurrentTile.DataOffset = static_cast<uint32_t>(Selectors.size());
+			Selectors.insert(Selectors.end(), TileSelectors, TileSelectors + TileSize * TileSize);
+		}
+	}
+
+	CurrentBlock.Planes = std::move(Planes);
+	CurrentBlock.Selectors = std::move(Selectors);
+	CurrentBlock.RawDepths = std::move(RawDepths);
+}
+
+void CPUCompressedDepthSurface::Decompress(CPUDepthSurface& Destination) const
+{
+	Destination.Allocate(Width, Height, SampleCount);
+
+	const uint32_t BlocksX = GetBlocksX();
+
+	CPUThreadPool::GetDefault().ParallelFor(static_cast<uint32_t>(Blocks.size()), [&](uint32_t BlockIndex)
+	{
+		std::vector<CPUDepthStencilSample> Samples(BlockSize * BlockSize * SampleCount);
+		std::vector<uint32_t> PlaneIds(BlockSize * BlockSize * SampleCount);
+		std::vector<CPUDepthPlane> StoredPlanes;
+
+		const uint32_t BlockX = BlockIndex % BlocksX;
+		const uint32_t BlockY = BlockIndex / BlocksX;
+
+		DecodeBlock(BlockX, BlockY, Samples.data(), PlaneIds.data(), StoredPlanes);
+
+		const uint32_t RowPixels = std::min(BlockSize, Width - BlockX * BlockSize);
+
+		for (uint32_t y = 0; y < BlockSize && BlockY * BlockSize + y < Height; ++y)
+			memcpy(Destination.GetPixel(BlockX * BlockSize, BlockY * BlockSize + y), &Samples[static_cast<size_t>(y) * BlockSize * SampleCount], RowPixels * SampleCount * sizeof(CPUDepthStencilSample));
+	});
+}
+
+CPUCompressedDepthStats CPUCompressedDepthSurface::GetStats() const
+{
+	CPUCompressedDepthStats Stats;
+	const uint32_t BlocksX = GetBlocksX();
+
+	for (uint32_t BlockIndex = 0; BlockIndex < Blocks.size(); ++BlockIndex)
+	{
+		const Block& CurrentBlock = Blocks[BlockIndex];
+		const uint32_t BlockPixelX = (BlockIndex % BlocksX) * BlockSize;
+		const uint32_t BlockPixelY = (BlockIndex / BlocksX) * BlockSize;
+
+		for (uint32_t TileIndex = 0; TileIndex < TilesPerBlock; ++TileIndex)
+		{
+			if (BlockPixelX + (TileIndex % (BlockSize / TileSize)) * TileSize >= Width || BlockPixelY + (TileIndex / (BlockSize / TileSize)) * TileSize >= Height)
+				continue;
+
+			if (CurrentBlock.Tiles[TileIndex].PlaneCount == 0)
+				++Stats.RawTiles;
+			else
+				++Stats.PlaneTiles;
+
+			Stats.CompressedBytes += sizeof(Tile);
+		}
+
+		Stats.CompressedBytes += CurrentBlock.Planes.size() * sizeof(CPUDepthPlane) + CurrentBlock.Selectors.size() * sizeof(uint32_t) + CurrentBlock.RawDepths.size() * sizeof(float);
+	}
+
+	Stats.UncompressedBytes = static_cast<uint64_t>(Width) * Height * SampleCount * sizeof(CPUDepthStencilSample);
+	return Stats;
+}
+
+bool CPUResolveCompressedDepthRegion(CPUResolvedDepth& Destination, uint32_t DstX, uint32_t DstY, const CPUCompressedDepthSurface& Source, const CPURect* SourceRect, CPUResolveMode Mode, CPUThreadPool* Pool)
+{
+	using Surface = CPUCompressedDepthSurface;
+
+	CPURect Rect = SourceRect ? *SourceRect : CPURect{ 0, 0, static_cast<int32_t>(Source.Width), static_cast<int32_t>(Source.Height) };
+
+	if (Rect.Left < 0 || Rect.Top < 0 || Rect.Right > static_cast<int32_t>(Source.Width) || Rect.Bottom > static_cast<int32_t>(Source.Height) || Rect.Left > Rect.Right || Rect.Top > Rect.Bottom)
+		return false;
+
+	if (static_cast<uint64_t>(DstX) + (Rect.Right - Rect.Left) > Destination.Width || static_cast<uint64_t>(DstY) + (Rect.Bottom - Rect.Top) > Destination.Height)
+		return false;
+
+	if (Rect.Left == Rect.Right || Rect.Top == Rect.Bottom)
+		return true;
+
+	if (!Pool)
+		Pool = &CPUThreadPool::GetDefault();
+
+	const uint32_t SampleCount = Source.SampleCount;
+	const uint32_t BlocksX = Source.GetBlocksX();
+	const uint32_t FirstBlockX = Rect.Left / Surface::BlockSize, LastBlockX = (Rect.Right - 1) / Surface::BlockSize;
+	const uint32_t FirstBlockY = Rect.Top / Surface::BlockSize, LastBlockY = (Rect.Bottom - 1) / Surface::BlockSize;
+	const uint32_t RegionBlocksX = LastBlockX - FirstBlockX + 1;
+	const uint32_t RegionBlocksY = LastBlockY - FirstBlockY + 1;
+
+	float NaN;
+	memcpy(&NaN, &CPUResolveNaN, sizeof(NaN));
+
+	Pool->ParallelFor(RegionBlocksX * RegionBlocksY, [&](uint32_t RegionBlockIndex)
+	{
+		const uint32_t BlockX = FirstBlockX + RegionBlockIndex % RegionBlocksX;
+		const uint32_t BlockY = FirstBlockY + RegionBlockIndex / RegionBlocksX;
+		const Surface::Block& CurrentBlock = Source.Blocks[BlockY * BlocksX + BlockX];
+
+		for (uint32_t TileIndex = 0; TileIndex < Surface::TilesPerBlock; ++TileIndex)
+		{
+			const Surface::Tile& CurrentTile = CurrentBlock.Tiles[TileIndex];
+			const int32_t TileX = BlockX * Surface::BlockSize + (TileIndex % (Surface::BlockSize / Surface::TileSize)) * Surface::TileSize;
+			const int32_t TileY = BlockY * Surface::BlockSize + (TileIndex / (Surface::BlockSize / Surface::TileSize)) * Surface::TileSize;
+
+			const int32_t MinX = std::max(TileX, Rect.Left), MaxX = std::min<int32_t>(TileX + Surface::TileSize, Rect.Right);
+			const int32_t MinY = std::max(TileY, Rect.Top), MaxY = std::min<int32_t>(TileY + Surface::TileSize, Rect.Bottom);
+
+			if (MinX >= MaxX || MinY >= MaxY)
+				continue;
+
+			// Per plane and quad pixel: sample deltas, and the deltas of the extreme samples in resolve order
+			float Deltas[Surface::MaxPlanesPerTile][4][CPUMaxSampleCount];
+			float MinDelta[Surface::MaxPlanesPerTile][4];
+			float MaxDelta[Surface::MaxPlanesPerTile][4];
+			bool NaNDelta[Surface::MaxPlanesPerTile] = {};
+
+			for (uint32_t p = 0; p < CurrentTile.PlaneCount; ++p)
+			{
+				const CPUDepthPlane& Plane = CurrentBlock.Planes[CurrentTile.PlaneOffset + p];
+
+				for (uint32_t QuadPixel = 0; QuadPixel < Source.Pattern.PixelCount; ++QuadPixel)
+				{
+					const CPUSamplePosition* Positions = Source.Pattern.GetPixelPositions(QuadPixel);
+
+					MinDelta[p][QuadPixel] = MaxDelta[p][QuadPixel] = GetDepthPlaneSampleDelta(Plane, Positions[0]);
+
+					for (uint32_t s = 0; s < SampleCount; ++s)
+					{
+						const float Delta = GetDepthPlaneSampleDelta(Plane, Positions[s]);
+
+						Deltas[p][QuadPixel][s] = Delta;
+						NaNDelta[p] = NaNDelta[p] || IsDepthNaN(Delta);
+
+						if (DepthToOrderedKey(Delta) < DepthToOrderedKey(MinDelta[p][QuadPixel]))
+							MinDelta[p][QuadPixel] = Delta;
+						if (DepthToOrderedKey(Delta) > DepthToOrderedKey(MaxDelta[p][QuadPixel]))
+							MaxDelta[p][QuadPixel] = Delta;
+					}
+				}
+			}
+
+			for (int32_t y = MinY; y < MaxY; ++y)
+			{
+				float* DestinationRow = Destination.GetRow(DstY + (y - Rect.Top)) + DstX - Rect.Left;
+
+				for (int32_t x = MinX; x < MaxX; ++x)
+				{
+					const uint32_t PixelInTile = (y - TileY) * Surface::TileSize + (x - TileX);
+					CPUDepthStencilSample PixelSamples[CPUMaxSampleCount];
+
+					if (CurrentTile.PlaneCount == 0)
+					{
+						const float* RawDepths = &CurrentBlock.RawDepths[CurrentTile.DataOffset + PixelInTile * SampleCount];
+
+						for (uint32_t s = 0; s < SampleCount; ++s)
+							PixelSamples[s].Depth = RawDepths[s];
+
+						DestinationRow[x] = ResolveDepthSamples(PixelSamples, SampleCount, Mode);
+						continue;
+					}
+
+					const uint32_t QuadPixel = Source.Pattern.GetQuadPixel(x, y);
+					const uint32_t Selectors = CurrentTile.PlaneCount > 1 ? CurrentBlock.Selectors[CurrentTile.DataOffset + PixelInTile] : 0;
+					const uint32_t FirstPlane = Selectors & 3;
+					const uint32_t SelectorMask = SampleCount == 16 ? 0xFFFFFFFF : (1u << (2 * SampleCount)) - 1;
+					const bool Uniform = Selectors == (0x55555555u * FirstPlane & SelectorMask);
+
+					if (Uniform && Mode != CPU_RESOLVE_MODE_AVERAGE && !NaNDelta[FirstPlane])
+					{
+						const float Center = GetDepthPlanePixelCenter(CurrentBlock.Planes[CurrentTile.PlaneOffset + FirstPlane], x, y);
+
+						if (!IsDepthNaN(Center))
+						{
+							const float Delta = Mode == CPU_RESOLVE_MODE_MAX ? MaxDelta[FirstPlane][QuadPixel] : MinDelta[FirstPlane][QuadPixel];
+							const float Depth = GetDepthPlaneSample(Center, Delta);
+
+							DestinationRow[x] = IsDepthNaN(Depth) ? NaN : Depth;
+							continue;
+						}
+					}
+
+					float Centers[Surface::MaxPlanesPerTile];
+					for (uint32_t p = 0; p < CurrentTile.PlaneCount; ++p)
+						Centers[p] = GetDepthPlanePixelCenter(CurrentBlock.Planes[CurrentTile.PlaneOffset + p], x, y);
+
+					for (uint32_t s = 0; s < SampleCount; ++s)
+					{
+						const uint32_t p = (Selectors >> (2 * s)) & 3;
+						PixelSamples[s].Depth = GetDepthPlaneSample(Centers[p], Deltas[p][QuadPixel][s]);
+					}
+
+					DestinationRow[x] = ResolveDepthSamples(PixelSamples, SampleCount, Mode);
+				}
+			}
+		}
+	});
+
+	return true;
+}
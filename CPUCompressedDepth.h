@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CPUDepthSurface.h"
+#include "CPUDepthPlane.h"
+#include "CPUResolve.h"
+#include "CPUSamplePositions.h"
+
+class CPUThreadPool;
+
+struct CPUCompressedDepthStats
+{
+	uint32_t PlaneTiles = 0;        // tiles stored as plane equations
+	uint32_t RawTiles = 0;          // tiles that overflowed and keep every sample
+	uint64_t CompressedBytes = 0;   // tile headers, planes, selectors and raw samples
+	uint64_t UncompressedBytes = 0; // the same surface as D32_FLOAT_S8X24 samples
+};
+
+// Alternative storage for a multisampled depth target in the style of hardware depth compression.
+// The surface is split into 8x8 pixel tiles, grouped into 64x64 blocks that match the CPURasterizer tiles.
+// A tile keeps up to MaxPlanes depth planes plus 2-bit per-sample plane selectors (none when it has a single plane),
+// or falls back to raw depth samples when more planes touch it. Stencil is not stored per sample, only the clear value.
+class CPUCompressedDepthSurface
+{
+public:
+	static constexpr uint32_t TileSize = 8;
+	static constexpr uint32_t BlockSize = 64;
+	static constexpr uint32_t TilesPerBlock = (BlockSize / TileSize) * (BlockSize / TileSize);
+	static constexpr uint32_t MaxPlanesPerTile = 4;
+
+	// Plane id of a decoded sample that has no plane (raw tile)
+	static constexpr uint32_t RawPlaneId = 0xFFFFFFFF;
+	// Plane ids with this bit refer to planes already stored in the block, the others to planes of the current draw
+	static constexpr uint32_t StoredPlaneBit = 0x80000000;
+
+	void Allocate(uint32_t NewWidth, uint32_t NewHeight, uint32_t NewSampleCount, const CPUSamplePattern& NewPattern, uint32_t NewMaxPlanes = MaxPlanesPerTile);
+
+	// Every tile becomes a single constant plane
+	void Clear(float Depth, uint8_t Stencil);
+
+	void Decompress(CPUDepthSurface& Destination) const;
+
+	CPUCompressedDepthStats GetStats() const;
+
+	uint32_t GetBlocksX() const { return (Width + BlockSize - 1) / BlockSize; }
+	uint32_t GetBlocksY() const { return (Height + BlockSize - 1) / BlockSize; }
+
+	// Expands a block into BlockSize x BlockSize scratch samples (row pitch BlockSize * SampleCount) and matching plane ids.
+	// StoredPlanes receives the planes the ids with StoredPlaneBit index into.
+	void DecodeBlock(uint32_t BlockX, uint32_t BlockY, CPUDepthStencilSample* Samples, uint32_t* PlaneIds, std::vector<CPUDepthPlane>& StoredPlanes) const;
+
+	// Re-encodes a block from scratch samples and plane ids. Plane ids without StoredPlaneBit index DrawPlanes.
+	// A tile is kept as planes only when it has at most MaxPlanes of them and they reproduce every sample bit for bit.
+	void EncodeBlock(uint32_t BlockX, uint32_t BlockY, const CPUDepthStencilSample* Samples, const uint32_t* PlaneIds, const CPUDepthPlane* DrawPlanes, const std::vector<CPUDepthPlane>& StoredPlanes);
+
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t SampleCount = 1;
+	uint32_t MaxPlanes = MaxPlanesPerTile;
+	uint8_t ClearStencil = 0;
+	CPUSamplePattern Pattern;
+
+private:
+	friend bool CPUResolveCompressedDepthRegion(CPUResolvedDepth&, uint32_t, uint32_t, const CPUCompressedDepthSurface&, const CPURect*, CPUResolveMode, CPUThreadPool*);
+
+	struct Tile
+	{
+		uint32_t PlaneOffset; // first plane in Block::Planes
+		uint32_t DataOffset;  // first selector word (one per pixel) or first raw depth
+		uint8_t PlaneCount;   // 0 for a raw tile
+	};
+
+	struct Block
+	{
+		Tile Tiles[TilesPerBlock];
+		std::vector<CPUDepthPlane> Planes;
+		std::vector<uint32_t> Selectors;
+		std::vector<float> RawDepths;
+	};
+
+	std::vector<Block> Blocks;
+};
+
+// ResolveSubresourceRegion straight from the compressed tiles. MIN/MAX of a pixel whose samples share one plane
+// only evaluate that plane at its extreme sample offset, so uniform pixels cost O(planes) instead of O(samples).
+// AVERAGE and mixed pixels decode their samples. Results are bit-identical to CPUResolveDepthRegion on the decompressed surface.
+bool CPUResolveCompressedDepthRegion(CPUResolvedDepth& Destination, uint32_t DstX, uint32_t DstY, const CPUCompressedDepthSurface& Source, const CPURect* SourceRect, CPUResolveMode Mode, CPUThreadPool* Pool = nullptr);
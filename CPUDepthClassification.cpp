@@ -0,0 +1,68 @@
+#include "CPUDepthClassification.h"
+#include "CPUResolveKernels.h"
+#include "CPUParallel.h"
+
+#include <algorithm>
+#include <vector>
+
+// Rows per job, each job sums into a classification of its own and the jobs are merged in order
+constexpr uint32_t ClassifyBandHeight = 16;
+
+CPUDepthClassification CPUClassifyDepth(const CPUResolvedDepth& Depth, uint32_t* Colors, CPUThreadPool* Pool, const CPUResolveKernels* Kernels)
+{
+	const uint32_t BandCount = (Depth.Height + ClassifyBandHeight - 1) / ClassifyBandHeight;
+	const CPUClassifyRowFunc ClassifyRow = (Kernels ? *Kernels : GetBestCPUResolveKernels8x()).Classify;
+
+	std::vector<CPUDepthClassification> Bands(BandCount);
+
+	if (!Pool)
+		Pool = &CPUThreadPool::GetDefault();
+
+	Pool->ParallelFor(BandCount, [&](uint32_t BandIndex)
+	{
+		CPUDepthClassification& Band = Bands[BandIndex];
+		CPURect& Rect = Band.CoveredRect;
+
+		const uint32_t FirstRow = BandIndex * ClassifyBandHeight;
+		const uint32_t LastRow = std::min(FirstRow + ClassifyBandHeight, Depth.Height);
+
+		for (uint32_t y = FirstRow; y < LastRow; ++y)
+		{
+			int32_t FirstCovered;
+			int32_t LastCovered;
+
+			ClassifyRow(Depth.GetRow(y), Colors ? Colors + static_cast<size_t>(y) * Depth.Width : nullptr, Depth.Width, Band.Counts, FirstCovered, LastCovered);
+
+			if (LastCovered < 0)
+				continue;
+
+			if (Rect.Right == 0)
+				Rect = { FirstCovered, static_cast<int32_t>(y), LastCovered + 1, static_cast<int32_t>(y) + 1 };
+
+			Rect.Left = std::min(Rect.Left, FirstCovered);
+			Rect.Right = std::max(Rect.Right, LastCovered + 1);
+			Rect.Bottom = static_cast<int32_t>(y) + 1;
+		}
+	});
+
+	CPUDepthClassification Classification;
+	CPURect& Rect = Classification.CoveredRect;
+
+	for (const CPUDepthClassification& Band : Bands)
+	{
+		for (uint32_t i = 0; i < CPU_DEPTH_CLASS_COUNT; ++i)
+			Classification.Counts[i] += Band.Counts[i];
+
+		if (Band.CoveredRect.Right == 0)
+			continue;
+
+		if (Rect.Right == 0)
+			Rect = Band.CoveredRect;
+
+		Rect.Left = std::min(Rect.Left, Band.CoveredRect.Left);
+		Rect.Right = std::max(Rect.Right, Band.CoveredRect.Right);
+		Rect.Bottom = Band.CoveredRect.Bottom;
+	}
+
+	return Classification;
+}
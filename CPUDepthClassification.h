@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+#include "CPUDepthSurface.h"
+
+class CPUThreadPool;
+struct CPUResolveKernels;
+
+// Classes FSQuadPixelShaderSource tells resolved depth texels apart by
+enum CPUDepthClass
+{
+	CPU_DEPTH_CLASS_ZERO,    // exactly 0.0 or -0.0, drawn red
+	CPU_DEPTH_CLASS_ONE,     // exactly 1.0, the clear depth, drawn green
+	CPU_DEPTH_CLASS_BETWEEN, // strictly between 0.0 and 1.0, drawn blue
+	CPU_DEPTH_CLASS_OTHER,   // NaN, negative or above 1.0, drawn black
+	CPU_DEPTH_CLASS_COUNT
+};
+
+// RGBA8 colors of the classes, opaque
+constexpr uint32_t CPUDepthClassColors[CPU_DEPTH_CLASS_COUNT] = { 0xFF0000FF, 0xFF00FF00, 0xFFFF0000, 0xFF000000 };
+
+inline CPUDepthClass CPUGetDepthClass(float Depth)
+{
+	if (Depth == 0.0f)
+		return CPU_DEPTH_CLASS_ZERO;
+
+	if (Depth == 1.0f)
+		return CPU_DEPTH_CLASS_ONE;
+
+	return Depth > 0.0f && Depth < 1.0f ? CPU_DEPTH_CLASS_BETWEEN : CPU_DEPTH_CLASS_OTHER;
+}
+
+struct CPUDepthClassification
+{
+	uint64_t Counts[CPU_DEPTH_CLASS_COUNT] = {};
+	// Bounding box of the covered texels, all but those at the clear depth; all 0 when nothing is covered
+	CPURect CoveredRect = {};
+
+	uint64_t GetCoveredCount() const { return Counts[CPU_DEPTH_CLASS_ZERO] + Counts[CPU_DEPTH_CLASS_BETWEEN] + Counts[CPU_DEPTH_CLASS_OTHER]; }
+};
+
+// Classifies every texel of Depth in one streaming pass on the Classify kernel of Kernels (GetBestCPUResolveKernels8x
+// when nullptr), writing the visualization to Colors (row-major RGBA8, Width * Height texels) unless it is nullptr.
+// Colors match FSQuadPixelShaderCPU bit for bit.
+CPUDepthClassification CPUClassifyDepth(const CPUResolvedDepth& Depth, uint32_t* Colors, CPUThreadPool* Pool = nullptr, const CPUResolveKernels* Kernels = nullptr);
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// One sample of DXGI_FORMAT_D32_FLOAT_S8X24_UINT: 32-bit float depth, 8-bit stencil, 24 unused bits
+struct CPUDepthStencilSample
+{
+	float Depth;
+	uint8_t Stencil;
+	uint8_t Unused[3];
+};
+
+static_assert(sizeof(CPUDepthStencilSample) == 8, "D32_FLOAT_S8X24 sample must be 64 bits");
+
+// Sample layouts of CPUDepthSurface, the DXGI formats of the same names
+enum CPUDepthFormat
+{
+	CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT, // CPUDepthStencilSample
+	CPU_DEPTH_FORMAT_D32_FLOAT,            // float
+	CPU_DEPTH_FORMAT_D24_UNORM_S8_UINT,    // uint32_t, depth in the low 24 bits, stencil in the high 8
+	CPU_DEPTH_FORMAT_D16_UNORM,            // uint16_t
+	CPU_DEPTH_FORMAT_COUNT
+};
+
+// Compile-time description of a format for the kernels specialized on it. Value is what the depth test compares:
+// the float itself, or the UNORM code the depth rounds to, which orders like the depth it stands for.
+template <CPUDepthFormat Format>
+struct CPUDepthFormatTraits;
+
+template <>
+struct CPUDepthFormatTraits<CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT>
+{
+	typedef CPUDepthStencilSample Sample;
+	typedef float Value;
+	static constexpr bool Unorm = false;
+	static constexpr bool HasStencil = true;
+
+	static Value Encode(float Depth) { return Depth; }
+	static float Decode(Value Depth) { return Depth; }
+	static Value GetValue(const Sample& s) { return s.Depth; }
+	static void SetValue(Sample& s, Value Depth) { s.Depth = Depth; }
+	static uint8_t GetStencil(const Sample& s) { return s.Stencil; }
+	static Sample Make(float Depth, uint8_t Stencil) { return { Depth, Stencil, { 0, 0, 0 } }; }
+};
+
+template <>
+struct CPUDepthFormatTraits<CPU_DEPTH_FORMAT_D32_FLOAT>
+{
+	typedef float Sample;
+	typedef float Value;
+	static constexpr bool Unorm = false;
+	static constexpr bool HasStencil = false;
+
+	static Value Encode(float Depth) { return Depth; }
+	static float Decode(Value Depth) { return Depth; }
+	static Value GetValue(const Sample& s) { return s; }
+	static void SetValue(Sample& s, Value Depth) { s = Depth; }
+	static uint8_t GetStencil(const Sample&) { return 0; }
+	static Sample Make(float Depth, uint8_t) { return Depth; }
+};
+
+// FLOAT to UNORM as D3D converts: NaN is 0, the rest is clamped to [0, 1], scaled and rounded to nearest
+template <uint32_t Bits>
+inline uint32_t CPUEncodeUnormDepth(float Depth)
+{
+	constexpr float Max = static_cast<float>((1u << Bits) - 1);
+	return Depth > 0.0f ? static_cast<uint32_t>(std::nearbyint(std::fmin(Depth, 1.0f) * Max)) : 0;
+}
+
+template <uint32_t Bits>
+inline float CPUDecodeUnormDepth(uint32_t Code)
+{
+	return static_cast<float>(Code) / static_cast<float>((1u << Bits) - 1);
+}
+
+template <>
+struct CPUDepthFormatTraits<CPU_DEPTH_FORMAT_D24_UNORM_S8_UINT>
+{
+	typedef uint32_t Sample;
+	typedef uint32_t Value;
+	static constexpr bool Unorm = true;
+	static constexpr bool HasStencil = true;
+
+	static Value Encode(float Depth) { return CPUEncodeUnormDepth<24>(Depth); }
+	static float Decode(Value Depth) { return CPUDecodeUnormDepth<24>(Depth); }
+	static Value GetValue(const Sample& s) { return s & 0xFFFFFF; }
+	static void SetValue(Sample& s, Value Depth) { s = (s & 0xFF000000) | Depth; }
+	static uint8_t GetStencil(const Sample& s) { return static_cast<uint8_t>(s >> 24); }
+	static Sample Make(float Depth, uint8_t Stencil) { return Encode(Depth) | static_cast<uint32_t>(Stencil) << 24; }
+};
+
+template <>
+struct CPUDepthFormatTraits<CPU_DEPTH_FORMAT_D16_UNORM>
+{
+	typedef uint16_t Sample;
+	typedef uint32_t Value;
+	static constexpr bool Unorm = true;
+	static constexpr bool HasStencil = false;
+
+	static Value Encode(float Depth) { return CPUEncodeUnormDepth<16>(Depth); }
+	static float Decode(Value Depth) { return CPUDecodeUnormDepth<16>(Depth); }
+	static Value GetValue(const Sample& s) { return s; }
+	static void SetValue(Sample& s, Value Depth) { s = static_cast<uint16_t>(Depth); }
+	static uint8_t GetStencil(const Sample&) { return 0; }
+	static Sample Make(float Depth, uint8_t) { return static_cast<uint16_t>(Encode(Depth)); }
+};
+
+// Calls Func with the traits of Format as an argument, for code that picks its specialization at run time
+template <typename Function>
+inline auto CPUDispatchDepthFormat(CPUDepthFormat Format, Function&& Func)
+{
+	switch (Format)
+	{
+	case CPU_DEPTH_FORMAT_D32_FLOAT: return Func(CPUDepthFormatTraits<CPU_DEPTH_FORMAT_D32_FLOAT>());
+	case CPU_DEPTH_FORMAT_D24_UNORM_S8_UINT: return Func(CPUDepthFormatTraits<CPU_DEPTH_FORMAT_D24_UNORM_S8_UINT>());
+	case CPU_DEPTH_FORMAT_D16_UNORM: return Func(CPUDepthFormatTraits<CPU_DEPTH_FORMAT_D16_UNORM>());
+	default: return Func(CPUDepthFormatTraits<CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT>());
+	}
+}
+
+inline uint32_t CPUGetDepthFormatSampleSize(CPUDepthFormat Format)
+{
+	return CPUDispatchDepthFormat(Format, [](auto Traits) { return static_cast<uint32_t>(sizeof(typename decltype(Traits)::Sample)); });
+}
+
+inline bool CPUDepthFormatHasStencil(CPUDepthFormat Format)
+{
+	return CPUDispatchDepthFormat(Format, [](auto Traits) { return decltype(Traits)::HasStencil; });
+}
+
+// Depth as a texture of Format stores it and its depth plane view reads it back
+inline float CPUQuantizeDepth(CPUDepthFormat Format, float Depth)
+{
+	return CPUDispatchDepthFormat(Format, [Depth](auto Traits) { return decltype(Traits)::Decode(decltype(Traits)::Encode(Depth)); });
+}
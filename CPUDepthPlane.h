@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+#include "CPUSamplePositions.h"
+
+// Depth as a linear function of the screen position, Z = A * X + B * Y + C.
+// Every producer and consumer of plane depth goes through the helpers below, so a sample
+// reconstructed from its plane has exactly the bits the rasterizer wrote.
+struct CPUDepthPlane
+{
+	float A;
+	float B;
+	float C;
+};
+
+// Plane depth at the center of pixel (X, Y)
+inline float GetDepthPlanePixelCenter(const CPUDepthPlane& Plane, int32_t X, int32_t Y)
+{
+	return Plane.A * (X + 0.5f) + Plane.B * (Y + 0.5f) + Plane.C;
+}
+
+// Plane depth change from the pixel center to a sample
+inline float GetDepthPlaneSampleDelta(const CPUDepthPlane& Plane, const CPUSamplePosition& Position)
+{
+	return Plane.A * (Position.X / 16.0f) + Plane.B * (Position.Y / 16.0f);
+}
+
+// Viewport depth range [0, 1]; both steps are monotonic, so the extreme delta gives the extreme sample depth
+inline float GetDepthPlaneSample(float PixelCenterDepth, float SampleDelta)
+{
+	float Depth = PixelCenterDepth + SampleDelta;
+	return Depth < 0.0f ? 0.0f : (Depth > 1.0f ? 1.0f : Depth);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CPUDepthFormat.h"
+
+// Same layout as D3D12_RECT
+struct CPURect
+{
+	int32_t Left;
+	int32_t Top;
+	int32_t Right;
+	int32_t Bottom;
+};
+
+// CPU copy of a multisampled depth-stencil surface such as DepthBufferTexture.
+// The samples of a pixel are stored next to each other in Format, pixels go in row-major order.
+struct CPUDepthSurface
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t SampleCount = 1;
+	CPUDepthFormat Format = CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT;
+	uint32_t SampleSize = sizeof(CPUDepthStencilSample);
+	std::vector<uint8_t> Samples;
+	// One byte per pixel, nonzero when all the samples of the pixel hold the same depth so a resolve only needs the
+	// first. Empty unless TrackUniformPixels was called. Clear and CPURasterizer keep it up to date, anything else
+	// writing Samples must drop it.
+	std::vector<uint8_t> UniformPixels;
+
+	void Allocate(uint32_t NewWidth, uint32_t NewHeight, uint32_t NewSampleCount, CPUDepthFormat NewFormat = CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT)
+	{
+		Width = NewWidth;
+		Height = NewHeight;
+		SampleCount = NewSampleCount;
+		Format = NewFormat;
+		SampleSize = CPUGetDepthFormatSampleSize(Format);
+		Samples.resize(static_cast<size_t>(Width) * Height * SampleCount * SampleSize);
+
+		if (!UniformPixels.empty())
+			TrackUniformPixels();
+	}
+
+	// No pixel is known to be uniform until the next Clear
+	void TrackUniformPixels()
+	{
+		UniformPixels.assign(static_cast<size_t>(Width) * Height, 0);
+	}
+
+	void Clear(float Depth, uint8_t Stencil)
+	{
+		CPUDispatchDepthFormat(Format, [&](auto Traits)
+		{
+			typedef typename decltype(Traits)::Sample Sample;
+			const Sample Value = decltype(Traits)::Make(Depth, Stencil);
+			Sample* First = reinterpret_cast<Sample*>(Samples.data());
+
+			for (size_t i = 0; i < Samples.size() / sizeof(Sample); ++i)
+				First[i] = Value;
+		});
+
+		std::fill(UniformPixels.begin(), UniformPixels.end(), static_cast<uint8_t>(1));
+	}
+
+	// Samples of pixel (X, Y) as the Sample type of CPUDepthFormatTraits<Format>
+	template <typename Sample = CPUDepthStencilSample>
+	Sample* GetPixel(uint32_t X, uint32_t Y)
+	{
+		return reinterpret_cast<Sample*>(&Samples[(static_cast<size_t>(Y) * Width + X) * SampleCount * SampleSize]);
+	}
+
+	template <typename Sample = CPUDepthStencilSample>
+	const Sample* GetPixel(uint32_t X, uint32_t Y) const
+	{
+		return reinterpret_cast<const Sample*>(&Samples[(static_cast<size_t>(Y) * Width + X) * SampleCount * SampleSize]);
+	}
+};
+
+// Single-sample depth plane, the CPU counterpart of ResolvedDepthBufferTexture viewed through its depth plane format:
+// UNORM depths hold the float the view reads
+struct CPUResolvedDepth
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	std::vector<float> Depth;
+
+	void Allocate(uint32_t NewWidth, uint32_t NewHeight)
+	{
+		Width = NewWidth;
+		Height = NewHeight;
+		Depth.resize(static_cast<size_t>(Width) * Height);
+	}
+
+	float* GetRow(uint32_t Y) { return &Depth[static_cast<size_t>(Y) * Width]; }
+	const float* GetRow(uint32_t Y) const { return &Depth[static_cast<size_t>(Y) * Width]; }
+};
+
+// Single-sample stencil plane, the CPU counterpart of plane slice 1 of ResolvedDepthBufferTexture
+struct CPUResolvedStencil
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	std::vector<uint8_t> Stencil;
+
+	void Allocate(uint32_t NewWidth, uint32_t NewHeight)
+	{
+		Width = NewWidth;
+		Height = NewHeight;
+		Stencil.resize(static_cast<size_t>(Width) * Height);
+	}
+
+	uint8_t* GetRow(uint32_t Y) { return &Stencil[static_cast<size_t>(Y) * Width]; }
+	const uint8_t* GetRow(uint32_t Y) const { return &Stencil[static_cast<size_t>(Y) * Width]; }
+};
@@ -0,0 +1,162 @@
+#include "CPUHiZ.h"
+#include "CPUParallel.h"
+#include "CPUResolve.h"
+
+#include <algorithm>
+
+std::vector<CPUHiZLevel> GetHiZLevelLayout(uint32_t Width, uint32_t Height)
+{
+	std::vector<CPUHiZLevel> Levels;
+
+	if (Width == 0 || Height == 0)
+		return Levels;
+
+	uint32_t Offset = 0;
+
+	do
+	{
+		Width = (Width + 1) / 2;
+		Height = (Height + 1) / 2;
+		Levels.push_back({ Width, Height, Offset });
+		Offset += Width * Height;
+	}
+	while (Width > 1 || Height > 1);
+
+	return Levels;
+}
+
+void CPUHiZPyramid::Allocate(uint32_t NewWidth, uint32_t NewHeight)
+{
+	Width = NewWidth;
+	Height = NewHeight;
+	Levels = GetHiZLevelLayout(Width, Height);
+	Texels.resize(Levels.empty() ? 0 : Levels.back().Offset + 1);
+}
+
+// Ordered keys of a 2x2 footprint combined with NaN values left out
+static int32_t MinKey(float Depth)
+{
+	return IsDepthNaN(Depth) ? INT32_MAX : DepthToOrderedKey(Depth);
+}
+
+static int32_t MaxKey(float Depth)
+{
+	return IsDepthNaN(Depth) ? INT32_MIN : DepthToOrderedKey(Depth);
+}
+
+static CPUHiZTexel MakeTexel(int32_t Min, int32_t Max)
+{
+	// Both keys are unset together; CPUResolveNaN is the positive quiet NaN, whose ordered key is itself
+	const int32_t Empty = static_cast<int32_t>(CPUResolveNaN);
+	return { OrderedKeyToDepth(Min == INT32_MAX ? Empty : Min), OrderedKeyToDepth(Min == INT32_MAX ? Empty : Max) };
+}
+
+// Texels [X0, X1) x [Y0, Y1) of Layout from the Below level of the packed Texels, or from the Below sized source
+// pixels when Source is given. Each row first folds the two rows below into per-column keys, then pairs the columns,
+// so both loops are contiguous.
+static void ReduceLevel(CPUHiZTexel* Texels, const CPUHiZLevel& Layout, const CPUHiZLevel& Below, uint32_t X0, uint32_t Y0, uint32_t X1, uint32_t Y1, const CPUResolvedDepth* Source, uint32_t SourceX, uint32_t SourceY)
+{
+	constexpr uint32_t ChunkSize = 64;
+
+	const uint32_t BelowWidth = Below.Width;
+	const uint32_t BelowHeight = Below.Height;
+
+	int32_t ColumnMin[2 * ChunkSize];
+	int32_t ColumnMax[2 * ChunkSize];
+
+	for (uint32_t y = Y0; y < Y1; ++y)
+	{
+		CPUHiZTexel* Row = Texels + Layout.Offset + static_cast<size_t>(y) * Layout.Width;
+
+		// The last row and column may only have one texel or pixel below them
+		const uint32_t Row1 = std::min(2 * y + 1, BelowHeight - 1);
+
+		for (uint32_t ChunkX = X0; ChunkX < X1; ChunkX += ChunkSize)
+		{
+			const uint32_t Count = std::min(ChunkSize, X1 - ChunkX);
+			const uint32_t Columns = std::min(2 * Count, BelowWidth - 2 * ChunkX);
+
+			if (Source)
+			{
+				const float* Top = Source->GetRow(SourceY + 2 * y) + SourceX + 2 * ChunkX;
+				const float* Bottom = Source->GetRow(SourceY + Row1) + SourceX + 2 * ChunkX;
+
+				for (uint32_t i = 0; i < Columns; ++i)
+				{
+					ColumnMin[i] = std::min(MinKey(Top[i]), MinKey(Bottom[i]));
+					ColumnMax[i] = std::max(MaxKey(Top[i]), MaxKey(Bottom[i]));
+				}
+			}
+			else
+			{
+				const CPUHiZTexel* Top = Texels + Below.Offset + static_cast<size_t>(2 * y) * BelowWidth + 2 * ChunkX;
+				const CPUHiZTexel* Bottom = Texels + Below.Offset + static_cast<size_t>(Row1) * BelowWidth + 2 * ChunkX;
+
+				for (uint32_t i = 0; i < Columns; ++i)
+				{
+					ColumnMin[i] = std::min(MinKey(Top[i].Min), MinKey(Bottom[i].Min));
+					ColumnMax[i] = std::max(MaxKey(Top[i].Max), MaxKey(Bottom[i].Max));
+				}
+			}
+
+			if (Columns < 2 * Count)
+			{
+				ColumnMin[Columns] = ColumnMin[Columns - 1];
+				ColumnMax[Columns] = ColumnMax[Columns - 1];
+			}
+
+			for (uint32_t i = 0; i < Count; ++i)
+				Row[ChunkX + i] = MakeTexel(std::min(ColumnMin[2 * i], ColumnMin[2 * i + 1]), std::max(ColumnMax[2 * i], ColumnMax[2 * i + 1]));
+		}
+	}
+}
+
+void CPUReduceHiZTile(CPUHiZPyramid& HiZ, const CPUResolvedDepth& Source, uint32_t SourceX, uint32_t SourceY, uint32_t TileX, uint32_t TileY)
+{
+	const uint32_t LevelCount = std::min(CPUHiZTileLevels, static_cast<uint32_t>(HiZ.Levels.size()));
+
+	for (uint32_t Level = 0; Level < LevelCount; ++Level)
+	{
+		const CPUHiZLevel& Layout = HiZ.Levels[Level];
+		const uint32_t Shift = Level + 1;
+
+		ReduceLevel(HiZ.Texels.data(), Layout, Level == 0 ? CPUHiZLevel{ HiZ.Width, HiZ.Height, 0 } : HiZ.Levels[Level - 1], TileX >> Shift, TileY >> Shift,
+			std::min(Layout.Width, (TileX + CPUHiZTileSize) >> Shift), std::min(Layout.Height, (TileY + CPUHiZTileSize) >> Shift), Level == 0 ? &Source : nullptr, SourceX, SourceY);
+	}
+}
+
+void CPUFinishHiZPyramid(CPUHiZPyramid& HiZ)
+{
+	if (HiZ.Levels.size() > CPUHiZTileLevels)
+		CPUReduceHiZLevels(HiZ.Texels.data(), HiZ.Levels[CPUHiZTileLevels - 1], &HiZ.Levels[CPUHiZTileLevels], static_cast<uint32_t>(HiZ.Levels.size()) - CPUHiZTileLevels);
+}
+
+void CPUReduceHiZLevels(CPUHiZTexel* Texels, const CPUHiZLevel& Below, const CPUHiZLevel* Levels, uint32_t LevelCount)
+{
+	for (uint32_t Level = 0; Level < LevelCount; ++Level)
+		ReduceLevel(Texels, Levels[Level], Level == 0 ? Below : Levels[Level - 1], 0, 0, Levels[Level].Width, Levels[Level].Height, nullptr, 0, 0);
+}
+
+bool CPUBuildHiZPyramid(CPUHiZPyramid& HiZ, const CPUResolvedDepth& Source, const CPURect* SourceRect, CPUThreadPool* Pool)
+{
+	CPURect Rect = SourceRect ? *SourceRect : CPURect{ 0, 0, static_cast<int32_t>(Source.Width), static_cast<int32_t>(Source.Height) };
+
+	if (Rect.Left < 0 || Rect.Top < 0 || Rect.Right > static_cast<int32_t>(Source.Width) || Rect.Bottom > static_cast<int32_t>(Source.Height) || Rect.Left > Rect.Right || Rect.Top > Rect.Bottom)
+		return false;
+
+	HiZ.Allocate(Rect.Right - Rect.Left, Rect.Bottom - Rect.Top);
+
+	if (!Pool)
+		Pool = &CPUThreadPool::GetDefault();
+
+	const uint32_t TilesX = (HiZ.Width + CPUHiZTileSize - 1) / CPUHiZTileSize;
+	const uint32_t TilesY = (HiZ.Height + CPUHiZTileSize - 1) / CPUHiZTileSize;
+
+	Pool->ParallelFor(TilesX * TilesY, [&](uint32_t TileIndex)
+	{
+		CPUReduceHiZTile(HiZ, Source, Rect.Left, Rect.Top, (TileIndex % TilesX) * CPUHiZTileSize, (TileIndex / TilesX) * CPUHiZTileSize);
+	});
+
+	CPUFinishHiZPyramid(HiZ);
+	return true;
+}
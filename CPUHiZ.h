@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "CPUDepthSurface.h"
+
+class CPUThreadPool;
+
+// One texel of the min/max depth pyramid, the CPU counterpart of a float2 in the GPU HiZ buffer
+struct CPUHiZTexel
+{
+	float Min;
+	float Max;
+};
+
+struct CPUHiZLevel
+{
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t Offset; // first texel of the level in the packed texel array
+};
+
+// Source pixels reduced into the first levels by a single tile; one resolve tile yields CPUHiZTileLevels levels
+constexpr uint32_t CPUHiZTileSize = 64;
+constexpr uint32_t CPUHiZTileLevels = 6;
+
+// Level 0 halves the source region, every further level halves the previous one rounding up, down to 1x1.
+// A texel holds the min and max of the 2x2 texels (or pixels) below it that exist; NaN values are ignored like in
+// the MIN/MAX resolve, and a texel with nothing but NaN below it is CPUResolveNaN.
+std::vector<CPUHiZLevel> GetHiZLevelLayout(uint32_t Width, uint32_t Height);
+
+// All levels packed in one array, with the same layout as the buffer written by the HiZ compute shaders
+struct CPUHiZPyramid
+{
+	uint32_t Width = 0;  // size of the source region
+	uint32_t Height = 0;
+	std::vector<CPUHiZLevel> Levels;
+	std::vector<CPUHiZTexel> Texels;
+
+	void Allocate(uint32_t NewWidth, uint32_t NewHeight);
+
+	CPUHiZTexel* GetRow(uint32_t Level, uint32_t Y) { return &Texels[Levels[Level].Offset + static_cast<size_t>(Y) * Levels[Level].Width]; }
+	const CPUHiZTexel* GetRow(uint32_t Level, uint32_t Y) const { return &Texels[Levels[Level].Offset + static_cast<size_t>(Y) * Levels[Level].Width]; }
+};
+
+// Builds the levels of one source tile (TileX, TileY multiples of CPUHiZTileSize, relative to the region) from
+// Source pixels starting at (SourceX, SourceY). Tiles write disjoint texels and may run concurrently.
+void CPUReduceHiZTile(CPUHiZPyramid& HiZ, const CPUResolvedDepth& Source, uint32_t SourceX, uint32_t SourceY, uint32_t TileX, uint32_t TileY);
+
+// Builds the levels above the ones produced per tile
+void CPUFinishHiZPyramid(CPUHiZPyramid& HiZ);
+
+// Counterpart of ReduceHiZCS on packed texels: reduces the Below level into Levels[0], then each level into the next
+void CPUReduceHiZLevels(CPUHiZTexel* Texels, const CPUHiZLevel& Below, const CPUHiZLevel* Levels, uint32_t LevelCount);
+
+// Separate pass over an already resolved region (whole Source when SourceRect is nullptr).
+// CPUResolveDepthRegionHiZ produces the same pyramid without reading the resolved depth back.
+bool CPUBuildHiZPyramid(CPUHiZPyramid& HiZ, const CPUResolvedDepth& Source, const CPURect* SourceRect, CPUThreadPool* Pool = nullptr);
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cmath>
+
+// Minimal stand-ins for the DirectXMath types and functions the cube transform uses, so the frame builds without DirectXMath.
+// Matrices are row-major and multiply row vectors, matching mul(float4(Position, 1.0f), TransformMatrix) with D3DCOMPILE_PACK_MATRIX_ROW_MAJOR.
+
+struct CPUFloat3
+{
+	float x, y, z;
+};
+
+struct CPUFloat4
+{
+	float x, y, z, w;
+};
+
+struct CPUMatrix
+{
+	float m[4][4];
+};
+
+inline CPUMatrix CPUMatrixIdentity()
+{
+	return { { { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } } };
+}
+
+inline CPUMatrix CPUMatrixMultiply(const CPUMatrix& M1, const CPUMatrix& M2)
+{
+	CPUMatrix Result;
+
+	for (int Row = 0; Row < 4; ++Row)
+		for (int Column = 0; Column < 4; ++Column)
+			Result.m[Row][Column] = M1.m[Row][0] * M2.m[0][Column] + M1.m[Row][1] * M2.m[1][Column] + M1.m[Row][2] * M2.m[2][Column] + M1.m[Row][3] * M2.m[3][Column];
+
+	return Result;
+}
+
+inline CPUFloat4 CPUTransformPoint(const CPUFloat3& Position, const CPUMatrix& M)
+{
+	return
+	{
+		Position.x * M.m[0][0] + Position.y * M.m[1][0] + Position.z * M.m[2][0] + M.m[3][0],
+		Position.x * M.m[0][1] + Position.y * M.m[1][1] + Position.z * M.m[2][1] + M.m[3][1],
+		Position.x * M.m[0][2] + Position.y * M.m[1][2] + Position.z * M.m[2][2] + M.m[3][2],
+		Position.x * M.m[0][3] + Position.y * M.m[1][3] + Position.z * M.m[2][3] + M.m[3][3]
+	};
+}
+
+// Same rotation order as XMMatrixRotationRollPitchYaw: roll (Z), then pitch (X), then yaw (Y)
+inline CPUMatrix CPUMatrixRotationRollPitchYaw(float Pitch, float Yaw, float Roll)
+{
+	const float cp = std::cos(Pitch), sp = std::sin(Pitch);
+	const float cy = std::cos(Yaw), sy = std::sin(Yaw);
+	const float cr = std::cos(Roll), sr = std::sin(Roll);
+
+	return
+	{ {
+		{ cr * cy + sr * sp * sy, sr * cp, sr * sp * cy - cr * sy, 0.0f },
+		{ cr * sp * sy - sr * cy, cr * cp, sr * sy + cr * sp * cy, 0.0f },
+		{ cp * sy, -sp, cp * cy, 0.0f },
+		{ 0.0f, 0.0f, 0.0f, 1.0f }
+	} };
+}
+
+inline CPUMatrix CPUMatrixTranslation(float x, float y, float z)
+{
+	CPUMatrix Result = CPUMatrixIdentity();
+	Result.m[3][0] = x;
+	Result.m[3][1] = y;
+	Result.m[3][2] = z;
+	return Result;
+}
+
+inline CPUMatrix CPUMatrixScaling(float x, float y, float z)
+{
+	CPUMatrix Result = CPUMatrixIdentity();
+	Result.m[0][0] = x;
+	Result.m[1][1] = y;
+	Result.m[2][2] = z;
+	return Result;
+}
+
+inline CPUMatrix CPUMatrixLookToLH(const CPUFloat3& EyePosition, const CPUFloat3& EyeDirection, const CPUFloat3& UpDirection)
+{
+	auto Normalize = [](CPUFloat3 v)
+	{
+		float Length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+		return CPUFloat3{ v.x / Length, v.y / Length, v.z / Length };
+	};
+
+	auto Cross = [](CPUFloat3 a, CPUFloat3 b)
+	{
+		return CPUFloat3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	};
+
+	auto Dot = [](CPUFloat3 a, CPUFloat3 b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	};
+
+	const CPUFloat3 R2 = Normalize(EyeDirection);
+	const CPUFloat3 R0 = Normalize(Cross(UpDirection, R2));
+	const CPUFloat3 R1 = Cross(R2, R0);
+	const CPUFloat3 NegEye = { -EyePosition.x, -EyePosition.y, -EyePosition.z };
+
+	return
+	{ {
+		{ R0.x, R1.x, R2.x, 0.0f },
+		{ R0.y, R1.y, R2.y, 0.0f },
+		{ R0.z, R1.z, R2.z, 0.0f },
+		{ Dot(R0, NegEye), Dot(R1, NegEye), Dot(R2, NegEye), 1.0f }
+	} };
+}
+
+inline CPUMatrix CPUMatrixPerspectiveFovLH(float FovAngleY, float AspectRatio, float NearZ, float FarZ)
+{
+	const float Height = std::cos(0.5f * FovAngleY) / std::sin(0.5f * FovAngleY);
+	const float Width = Height / AspectRatio;
+	const float Range = FarZ / (FarZ - NearZ);
+
+	return
+	{ {
+		{ Width, 0.0f, 0.0f, 0.0f },
+		{ 0.0f, Height, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, Range, 1.0f },
+		{ 0.0f, 0.0f, -Range * NearZ, 0.0f }
+	} };
+}
@@ -0,0 +1,103 @@
+#include "CPUParallel.h"
+
+#include <algorithm>
+
+static thread_local bool InsidePoolJob = false;
+
+CPUThreadPool::CPUThreadPool(uint32_t ThreadCount)
+{
+	if (ThreadCount == 0)
+		ThreadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	Workers.reserve(ThreadCount - 1);
+
+	for (uint32_t i = 1; i < ThreadCount; ++i)
+		Workers.emplace_back(&CPUThreadPool::WorkerLoop, this);
+}
+
+CPUThreadPool::~CPUThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> Lock(StateMutex);
+		ShuttingDown = true;
+	}
+
+	JobStarted.notify_all();
+
+	for (std::thread& Worker : Workers)
+		Worker.join();
+}
+
+void CPUThreadPool::ParallelFor(uint32_t Count, const std::function<void(uint32_t)>& Func)
+{
+	if (Count == 0)
+		return;
+
+	std::unique_lock<std::mutex> JobLock(JobMutex, std::try_to_lock);
+
+	if (Count == 1 || Workers.empty() || InsidePoolJob || !JobLock.owns_lock())
+	{
+		for (uint32_t i = 0; i < Count; ++i)
+			Func(i);
+
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> Lock(StateMutex);
+		JobFunc = &Func;
+		JobCount = Count;
+		NextIndex.store(0, std::memory_order_relaxed);
+		BusyWorkers = static_cast<uint32_t>(Workers.size());
+		++JobGeneration;
+	}
+
+	JobStarted.notify_all();
+
+	RunJob();
+
+	std::unique_lock<std::mutex> Lock(StateMutex);
+	JobFinished.wait(Lock, [this] { return BusyWorkers == 0; });
+	JobFunc = nullptr;
+}
+
+CPUThreadPool& CPUThreadPool::GetDefault()
+{
+	static CPUThreadPool DefaultPool;
+	return DefaultPool;
+}
+
+void CPUThreadPool::WorkerLoop()
+{
+	uint64_t SeenGeneration = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> Lock(StateMutex);
+			JobStarted.wait(Lock, [&] { return ShuttingDown || JobGeneration != SeenGeneration; });
+
+			if (ShuttingDown)
+				return;
+
+			SeenGeneration = JobGeneration;
+		}
+
+		RunJob();
+
+		std::lock_guard<std::mutex> Lock(StateMutex);
+		if (--BusyWorkers == 0)
+			JobFinished.notify_one();
+	}
+}
+
+void CPUThreadPool::RunJob()
+{
+	InsidePoolJob = true;
+
+	uint32_t Index;
+	while ((Index = NextIndex.fetch_add(1, std::memory_order_relaxed)) < JobCount)
+		(*JobFunc)(Index);
+
+	InsidePoolJob = false;
+}
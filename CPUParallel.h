@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker pool used by the CPU depth pipeline (resolve, rasterization)
+class CPUThreadPool
+{
+public:
+	// ThreadCount == 0 means std::thread::hardware_concurrency()
+	explicit CPUThreadPool(uint32_t ThreadCount = 0);
+	~CPUThreadPool();
+
+	CPUThreadPool(const CPUThreadPool&) = delete;
+	CPUThreadPool& operator=(const CPUThreadPool&) = delete;
+
+	// Number of threads taking part in ParallelFor, including the calling thread
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(Workers.size()) + 1; }
+
+	// Calls Func(Index) for every Index in [0, Count) and returns when all calls are done.
+	// Nested or concurrent calls fall back to running serially on the calling thread.
+	void ParallelFor(uint32_t Count, const std::function<void(uint32_t)>& Func);
+
+	static CPUThreadPool& GetDefault();
+
+private:
+	void WorkerLoop();
+	void RunJob();
+
+	std::vector<std::thread> Workers;
+
+	std::mutex JobMutex;
+	std::mutex StateMutex;
+	std::condition_variable JobStarted;
+	std::condition_variable JobFinished;
+
+	const std::function<void(uint32_t)>* JobFunc = nullptr;
+	uint32_t JobCount = 0;
+	std::atomic<uint32_t> NextIndex{ 0 };
+	uint32_t BusyWorkers = 0;
+	uint64_t JobGeneration = 0;
+	bool ShuttingDown = false;
+};
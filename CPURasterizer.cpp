@@ -0,0 +1,443 @@
+#include "CPURasterizer.h"
+#include "CPUCompressedDepth.h"
+#include "CPUParallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+constexpr int64_t SubpixelBits = 8;
+constexpr int64_t SubpixelScale = 1 << SubpixelBits;
+constexpr int64_t SamplePositionScale = SubpixelScale / 16;
+
+// Signed distances of a clip-space vertex to the six D3D12 clip planes, inside when >= 0
+static float ClipPlaneDistance(const CPUFloat4& v, int Plane)
+{
+	switch (Plane)
+	{
+		case 0: return v.z;
+		case 1: return v.w - v.z;
+		case 2: return v.w + v.x;
+		case 3: return v.w - v.x;
+		case 4: return v.w + v.y;
+		default: return v.w - v.y;
+	}
+}
+
+// Sutherland-Hodgman clipping of a triangle against the view frustum, returns the vertex count of the convex result
+static uint32_t ClipTriangle(const CPUFloat4 Input[3], CPUFloat4 Output[9])
+{
+	CPUFloat4 Buffers[2][9];
+	uint32_t Count = 3;
+
+	std::copy(Input, Input + 3, Buffers[0]);
+
+	for (int Plane = 0; Plane < 6; ++Plane)
+	{
+		const CPUFloat4* Source = Buffers[Plane & 1];
+		CPUFloat4* Destination = Buffers[(Plane + 1) & 1];
+		uint32_t DestinationCount = 0;
+
+		for (uint32_t i = 0; i < Count; ++i)
+		{
+			const CPUFloat4& a = Source[i];
+			const CPUFloat4& b = Source[(i + 1) % Count];
+			const float da = ClipPlaneDistance(a, Plane);
+			const float db = ClipPlaneDistance(b, Plane);
+
+			if (da >= 0.0f)
+				Destination[DestinationCount++] = a;
+
+			if ((da >= 0.0f) != (db >= 0.0f))
+			{
+				const float t = da / (da - db);
+				Destination[DestinationCount++] = { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t };
+			}
+		}
+
+		Count = DestinationCount;
+
+		if (Count < 3)
+			return 0;
+	}
+
+	std::copy(Buffers[0], Buffers[0] + Count, Output);
+	return Count;
+}
+
+CPURasterizer::CPURasterizer(CPUThreadPool* Pool) : Pool(Pool ? Pool : &CPUThreadPool::GetDefault())
+{
+}
+
+bool CPURasterizer::SetSamplePositions(uint32_t NumSamplesPerPixel, uint32_t NumPixels, const CPUSamplePosition* Positions)
+{
+	if (NumSamplesPerPixel == 0)
+	{
+		ProgrammedPattern = CPUSamplePattern();
+		return true;
+	}
+
+	CPUSamplePattern Pattern;
+
+	if (!MakeSamplePattern(NumSamplesPerPixel, NumPixels, Positions, Pattern))
+		return false;
+
+	ProgrammedPattern = Pattern;
+	return true;
+}
+
+CPUSamplePattern CPURasterizer::GetSamplePattern(uint32_t SampleCount) const
+{
+	return ProgrammedPattern.SampleCount == SampleCount ? ProgrammedPattern : GetStandardSamplePattern(SampleCount);
+}
+
+bool CPURasterizer::SetupDraw(uint32_t Width, uint32_t Height, const CPUSamplePattern& Pattern, const CPUDrawIndexedDesc& Draw)
+{
+	Triangles.clear();
+
+	if (!GetStandardSamplePositions(Pattern.SampleCount) || Pattern.PixelCount == 0 || Width == 0 || Height == 0)
+		return false;
+
+	std::vector<CPUFloat4> ClipPositions(Draw.VertexCount);
+
+	for (uint32_t Instance = 0; Instance < Draw.InstanceCount; ++Instance)
+	{
+		const CPUMatrix Transform = Draw.InstanceTransforms ? CPUMatrixMultiply(Draw.InstanceTransforms[Instance], Draw.TransformMatrix) : Draw.TransformMatrix;
+
+		for (uint32_t i = 0; i < Draw.VertexCount; ++i)
+			ClipPositions[i] = CPUTransformPoint(Draw.Vertices[i], Transform);
+
+		for (uint32_t i = 0; i + 3 <= Draw.IndexCount; i += 3)
+		{
+			const uint16_t* Index = &Draw.Indices[i];
+
+			if (Index[0] >= Draw.VertexCount || Index[1] >= Draw.VertexCount || Index[2] >= Draw.VertexCount)
+				continue;
+
+			const CPUFloat4 Vertices[3] = { ClipPositions[Index[0]], ClipPositions[Index[1]], ClipPositions[Index[2]] };
+
+			bool Inside = true;
+			bool Outside = false;
+
+			for (int Plane = 0; Plane < 6 && !Outside; ++Plane)
+			{
+				const float d0 = ClipPlaneDistance(Vertices[0], Plane);
+				const float d1 = ClipPlaneDistance(Vertices[1], Plane);
+				const float d2 = ClipPlaneDistance(Vertices[2], Plane);
+
+				Outside = d0 < 0.0f && d1 < 0.0f && d2 < 0.0f;
+				Inside = Inside && d0 >= 0.0f && d1 >= 0.0f && d2 >= 0.0f;
+			}
+
+			if (Outside)
+				continue;
+
+			if (Inside)
+			{
+				SetupTriangle(Vertices, Draw.CullMode, Width, Height);
+				continue;
+			}
+
+			CPUFloat4 Polygon[9];
+			const uint32_t PolygonCount = ClipTriangle(Vertices, Polygon);
+
+			for (uint32_t v = 2; v < PolygonCount; ++v)
+			{
+				const CPUFloat4 Fan[3] = { Polygon[0], Polygon[v - 1], Polygon[v] };
+				SetupTriangle(Fan, Draw.CullMode, Width, Height);
+			}
+		}
+	}
+
+	const uint32_t TilesX = (Width + TileSize - 1) / TileSize;
+	const uint32_t TilesY = (Height + TileSize - 1) / TileSize;
+
+	TileBins.resize(TilesX * TilesY);
+
+	for (std::vector<uint32_t>& Bin : TileBins)
+		Bin.clear();
+
+	for (uint32_t i = 0; i < Triangles.size(); ++i)
+	{
+		const Triangle& Tri = Triangles[i];
+
+		for (uint32_t TileY = Tri.MinY / TileSize; TileY <= Tri.MaxY / TileSize; ++TileY)
+			for (uint32_t TileX = Tri.MinX / TileSize; TileX <= Tri.MaxX / TileSize; ++TileX)
+				TileBins[TileY * TilesX + TileX].push_back(i);
+	}
+
+	// Edge function and depth offsets of every sample relative to its pixel center, per pixel of the 2x2 quad for
+	// Tier 2 patterns, computed once per triangle so programmable positions cost the same as the standard pattern in
+	// every tile the triangle touches
+	const uint32_t SampleCount = Pattern.SampleCount;
+	const size_t OffsetStride = GetSampleOffsetStride(SampleCount);
+
+	SampleOffsets.resize(Triangles.size() * Pattern.PixelCount * OffsetStride);
+	SampleDepthDeltas.resize(Triangles.size() * Pattern.PixelCount * SampleCount);
+
+	for (size_t i = 0; i < Triangles.size(); ++i)
+	{
+		const Triangle& Tri = Triangles[i];
+
+		for (uint32_t QuadPixel = 0; QuadPixel < Pattern.PixelCount; ++QuadPixel)
+		{
+			const CPUSamplePosition* SamplePositions = Pattern.GetPixelPositions(QuadPixel);
+			int64_t* Offsets = &SampleOffsets[(i * Pattern.PixelCount + QuadPixel) * OffsetStride];
+			int64_t* MinOffsets = Offsets + 3 * SampleCount;
+			int64_t* MaxOffsets = MinOffsets + 3;
+			float* Deltas = &SampleDepthDeltas[(i * Pattern.PixelCount + QuadPixel) * SampleCount];
+
+			for (int e = 0; e < 3; ++e)
+			{
+				MinOffsets[e] = INT64_MAX;
+				MaxOffsets[e] = INT64_MIN;
+
+				for (uint32_t s = 0; s < SampleCount; ++s)
+				{
+					const int64_t Offset = Tri.EdgeDX[e] * (SamplePositions[s].Y * SamplePositionScale) - Tri.EdgeDY[e] * (SamplePositions[s].X * SamplePositionScale);
+
+					Offsets[e * SampleCount + s] = Offset;
+					MinOffsets[e] = std::min(MinOffsets[e], Offset);
+					MaxOffsets[e] = std::max(MaxOffsets[e], Offset);
+				}
+			}
+
+			for (uint32_t s = 0; s < SampleCount; ++s)
+				Deltas[s] = GetDepthPlaneSampleDelta(Tri.Plane, SamplePositions[s]);
+		}
+	}
+
+	return !Triangles.empty();
+}
+
+uint32_t CPURasterizer::DrawIndexed(CPUDepthSurface& DepthTarget, const CPUDrawIndexedDesc& Draw)
+{
+	const CPUSamplePattern Pattern = GetSamplePattern(DepthTarget.SampleCount);
+
+	if (!SetupDraw(DepthTarget.Width, DepthTarget.Height, Pattern, Draw))
+		return 0;
+
+	const uint32_t TilesX = (DepthTarget.Width + TileSize - 1) / TileSize;
+	const uint32_t TilesY = (DepthTarget.Height + TileSize - 1) / TileSize;
+	uint8_t* UniformPixels = DepthTarget.UniformPixels.empty() ? nullptr : DepthTarget.UniformPixels.data();
+	const TileTarget Target = { DepthTarget.Samples.data(), nullptr, UniformPixels, static_cast<size_t>(DepthTarget.Width) * DepthTarget.SampleCount, 0, 0, DepthTarget.Width, DepthTarget.Height, DepthTarget.SampleCount };
+
+	CPUDispatchDepthFormat(DepthTarget.Format, [&](auto Traits)
+	{
+		Pool->ParallelFor(TilesX * TilesY, [&](uint32_t TileIndex)
+		{
+			if (!TileBins[TileIndex].empty())
+				RasterizeTile<decltype(Traits)>(Target, Pattern, TileIndex % TilesX, TileIndex / TilesX, TileBins[TileIndex]);
+		});
+	});
+
+	return static_cast<uint32_t>(Triangles.size());
+}
+
+uint32_t CPURasterizer::DrawIndexed(CPUCompressedDepthSurface& DepthTarget, const CPUDrawIndexedDesc& Draw)
+{
+	static_assert(TileSize == CPUCompressedDepthSurface::BlockSize, "rasterizer tiles and compressed blocks must match");
+
+	if (!SetupDraw(DepthTarget.Width, DepthTarget.Height, DepthTarget.Pattern, Draw))
+		return 0;
+
+	const uint32_t TilesX = (DepthTarget.Width + TileSize - 1) / TileSize;
+	const uint32_t TilesY = (DepthTarget.Height + TileSize - 1) / TileSize;
+	const size_t ScratchSize = static_cast<size_t>(TileSize) * TileSize * DepthTarget.SampleCount;
+
+	std::vector<CPUDepthPlane> DrawPlanes(Triangles.size());
+
+	for (uint32_t i = 0; i < Triangles.size(); ++i)
+		DrawPlanes[i] = Triangles[i].Plane;
+
+	Pool->ParallelFor(TilesX * TilesY, [&](uint32_t TileIndex)
+	{
+		if (TileBins[TileIndex].empty())
+			return;
+
+		thread_local std::vector<CPUDepthStencilSample> Samples;
+		thread_local std::vector<uint32_t> PlaneIds;
+		thread_local std::vector<CPUDepthPlane> StoredPlanes;
+
+		Samples.resize(ScratchSize);
+		PlaneIds.resize(ScratchSize);
+
+		const uint32_t TileX = TileIndex % TilesX;
+		const uint32_t TileY = TileIndex / TilesX;
+		const TileTarget Target = { Samples.data(), PlaneIds.data(), nullptr, static_cast<size_t>(TileSize) * DepthTarget.SampleCount, static_cast<int32_t>(TileX * TileSize), static_cast<int32_t>(TileY * TileSize), DepthTarget.Width, DepthTarget.Height, DepthTarget.SampleCount };
+
+		DepthTarget.DecodeBlock(TileX, TileY, Samples.data(), PlaneIds.data(), StoredPlanes);
+		RasterizeTile<CPUDepthFormatTraits<CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT>>(Target, DepthTarget.Pattern, TileX, TileY, TileBins[TileIndex]);
+		DepthTarget.EncodeBlock(TileX, TileY, Samples.data(), PlaneIds.data(), DrawPlanes.data(), StoredPlanes);
+	});
+
+	return static_cast<uint32_t>(Triangles.size());
+}
+
+void CPURasterizer::SetupTriangle(const CPUFloat4 ClipPositions[3], CPUCullMode CullMode, uint32_t Width, uint32_t Height)
+{
+	int64_t X[3], Y[3];
+	float Z[3];
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const CPUFloat4& v = ClipPositions[i];
+		const float InvW = 1.0f / v.w;
+
+		X[i] = std::llround((v.x * InvW * 0.5f + 0.5f) * static_cast<float>(Width) * SubpixelScale);
+		Y[i] = std::llround((0.5f - v.y * InvW * 0.5f) * static_cast<float>(Height) * SubpixelScale);
+		Z[i] = v.z * InvW;
+	}
+
+	// Positive area is clockwise on screen, the front face with FrontCounterClockwise = FALSE
+	const int64_t Area = (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+
+	if (Area == 0)
+		return;
+
+	const bool FrontFacing = Area > 0;
+
+	if ((CullMode == CPU_CULL_MODE_BACK && !FrontFacing) || (CullMode == CPU_CULL_MODE_FRONT && FrontFacing))
+		return;
+
+	if (!FrontFacing)
+	{
+		std::swap(X[1], X[2]);
+		std::swap(Y[1], Y[2]);
+		std::swap(Z[1], Z[2]);
+	}
+
+	Triangle Tri;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const int j = (i + 1) % 3;
+
+		Tri.EdgeDX[i] = X[j] - X[i];
+		Tri.EdgeDY[i] = Y[j] - Y[i];
+		Tri.EdgeX0[i] = X[i];
+		Tri.EdgeY0[i] = Y[i];
+
+		// Top-left rule: samples exactly on a top or left edge are inside, on other edges outside
+		const bool TopLeft = Tri.EdgeDY[i] < 0 || (Tri.EdgeDY[i] == 0 && Tri.EdgeDX[i] > 0);
+		Tri.EdgeBias[i] = TopLeft ? 0 : -1;
+	}
+
+	const float x0 = static_cast<float>(X[0]) / SubpixelScale, y0 = static_cast<float>(Y[0]) / SubpixelScale;
+	const float x1 = static_cast<float>(X[1]) / SubpixelScale, y1 = static_cast<float>(Y[1]) / SubpixelScale;
+	const float x2 = static_cast<float>(X[2]) / SubpixelScale, y2 = static_cast<float>(Y[2]) / SubpixelScale;
+	const float Determinant = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+
+	Tri.Plane.A = ((Z[1] - Z[0]) * (y2 - y0) - (Z[2] - Z[0]) * (y1 - y0)) / Determinant;
+	Tri.Plane.B = ((x1 - x0) * (Z[2] - Z[0]) - (x2 - x0) * (Z[1] - Z[0])) / Determinant;
+	Tri.Plane.C = Z[0] - Tri.Plane.A * x0 - Tri.Plane.B * y0;
+
+	// Samples lie within half a pixel of the center, so one extra pixel on each side is conservative
+	const int64_t MinX = (std::min({ X[0], X[1], X[2] }) >> SubpixelBits) - 1;
+	const int64_t MinY = (std::min({ Y[0], Y[1], Y[2] }) >> SubpixelBits) - 1;
+	const int64_t MaxX = (std::max({ X[0], X[1], X[2] }) >> SubpixelBits) + 1;
+	const int64_t MaxY = (std::max({ Y[0], Y[1], Y[2] }) >> SubpixelBits) + 1;
+
+	Tri.MinX = static_cast<int32_t>(std::max<int64_t>(MinX, 0));
+	Tri.MinY = static_cast<int32_t>(std::max<int64_t>(MinY, 0));
+	Tri.MaxX = static_cast<int32_t>(std::min<int64_t>(MaxX, Width - 1));
+	Tri.MaxY = static_cast<int32_t>(std::min<int64_t>(MaxY, Height - 1));
+
+	if (Tri.MinX > Tri.MaxX || Tri.MinY > Tri.MaxY)
+		return;
+
+	Triangles.push_back(Tri);
+}
+
+template <typename Traits>
+void CPURasterizer::RasterizeTile(const TileTarget& Target, const CPUSamplePattern& Pattern, uint32_t TileX, uint32_t TileY, const std::vector<uint32_t>& Bin) const
+{
+	const uint32_t SampleCount = Target.SampleCount;
+	const size_t OffsetStride = GetSampleOffsetStride(SampleCount);
+
+	const int32_t TileMinX = static_cast<int32_t>(TileX * TileSize);
+	const int32_t TileMinY = static_cast<int32_t>(TileY * TileSize);
+	const int32_t TileMaxX = std::min<int32_t>(TileMinX + TileSize, Target.Width) - 1;
+	const int32_t TileMaxY = std::min<int32_t>(TileMinY + TileSize, Target.Height) - 1;
+
+	for (uint32_t TriangleIndex : Bin)
+	{
+		const Triangle& Tri = Triangles[TriangleIndex];
+
+		const int32_t MinX = std::max(Tri.MinX, TileMinX);
+		const int32_t MinY = std::max(Tri.MinY, TileMinY);
+		const int32_t MaxX = std::min(Tri.MaxX, TileMaxX);
+		const int32_t MaxY = std::min(Tri.MaxY, TileMaxY);
+
+		// Sample offsets of the triangle from SetupDraw
+		const int64_t* TriangleOffsets = &SampleOffsets[static_cast<size_t>(TriangleIndex) * Pattern.PixelCount * OffsetStride];
+		const float* TriangleDeltas = &SampleDepthDeltas[static_cast<size_t>(TriangleIndex) * Pattern.PixelCount * SampleCount];
+
+		const int64_t CenterX = static_cast<int64_t>(MinX) * SubpixelScale + SubpixelScale / 2;
+		const int64_t CenterY = static_cast<int64_t>(MinY) * SubpixelScale + SubpixelScale / 2;
+
+		int64_t RowEdges[3];
+		for (int e = 0; e < 3; ++e)
+			RowEdges[e] = Tri.EdgeDX[e] * (CenterY - Tri.EdgeY0[e]) - Tri.EdgeDY[e] * (CenterX - Tri.EdgeX0[e]) + Tri.EdgeBias[e];
+
+		for (int32_t y = MinY; y <= MaxY; ++y)
+		{
+			int64_t Edges[3] = { RowEdges[0], RowEdges[1], RowEdges[2] };
+			const size_t RowOffset = (y - Target.OriginY) * Target.RowPitch + static_cast<size_t>(MinX - Target.OriginX) * SampleCount;
+			typename Traits::Sample* Pixel = static_cast<typename Traits::Sample*>(Target.Samples) + RowOffset;
+			uint32_t* PixelPlaneIds = Target.PlaneIds ? Target.PlaneIds + RowOffset : nullptr;
+			uint8_t* PixelUniform = Target.UniformPixels ? Target.UniformPixels + static_cast<size_t>(y) * Target.Width + MinX : nullptr;
+
+			for (int32_t x = MinX; x <= MaxX; ++x, Pixel += SampleCount, PixelPlaneIds += PixelPlaneIds ? SampleCount : 0, PixelUniform += PixelUniform ? 1 : 0)
+			{
+				const uint32_t QuadPixel = Pattern.GetQuadPixel(x, y);
+				const int64_t* Offsets = TriangleOffsets + QuadPixel * OffsetStride;
+				const int64_t* MinOffsets = Offsets + 3 * SampleCount;
+				const int64_t* MaxOffsets = MinOffsets + 3;
+
+				if (Edges[0] + MaxOffsets[0] >= 0 && Edges[1] + MaxOffsets[1] >= 0 && Edges[2] + MaxOffsets[2] >= 0)
+				{
+					const float* Deltas = TriangleDeltas + QuadPixel * SampleCount;
+
+					const bool AllCovered = Edges[0] + MinOffsets[0] >= 0 && Edges[1] + MinOffsets[1] >= 0 && Edges[2] + MinOffsets[2] >= 0;
+					const float PixelDepth = GetDepthPlanePixelCenter(Tri.Plane, x, y);
+
+					// The pixel stays uniform only if the triangle writes all its samples with the same bits
+					uint32_t WrittenCount = 0;
+					typename Traits::Value FirstWritten = {};
+					bool SameWritten = true;
+
+					for (uint32_t s = 0; s < SampleCount; ++s)
+					{
+						if (!AllCovered && (Edges[0] + Offsets[s] < 0 || Edges[1] + Offsets[SampleCount + s] < 0 || Edges[2] + Offsets[2 * SampleCount + s] < 0))
+							continue;
+
+						const typename Traits::Value Depth = Traits::Encode(GetDepthPlaneSample(PixelDepth, Deltas[s]));
+
+						if (Depth < Traits::GetValue(Pixel[s]))
+						{
+							Traits::SetValue(Pixel[s], Depth);
+
+							if (PixelPlaneIds)
+								PixelPlaneIds[s] = TriangleIndex;
+
+							if (WrittenCount++ == 0)
+								FirstWritten = Depth;
+							else
+								SameWritten = SameWritten && memcmp(&Depth, &FirstWritten, sizeof(Depth)) == 0;
+						}
+					}
+
+					if (PixelUniform && WrittenCount > 0)
+						*PixelUniform = WrittenCount == SampleCount && SameWritten;
+				}
+
+				for (int e = 0; e < 3; ++e)
+					Edges[e] -= Tri.EdgeDY[e] * SubpixelScale;
+			}
+
+			for (int e = 0; e < 3; ++e)
+				RowEdges[e] += Tri.EdgeDX[e] * SubpixelScale;
+		}
+	}
+}
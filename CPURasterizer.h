@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "CPUDepthPlane.h"
+#include "CPUDepthSurface.h"
+#include "CPUMath.h"
+#include "CPUSamplePositions.h"
+
+class CPUCompressedDepthSurface;
+class CPUThreadPool;
+
+// Mirrors D3D12_CULL_MODE
+enum CPUCullMode
+{
+	CPU_CULL_MODE_NONE,
+	CPU_CULL_MODE_FRONT,
+	CPU_CULL_MODE_BACK
+};
+
+// Equivalent of the cube pass: DrawIndexedInstanced with a single float3 stream transformed per instance,
+// FillMode SOLID, FrontCounterClockwise FALSE, DepthFunc LESS with depth writes, no stencil.
+// UNORM targets compare and store the depth rounded to the format.
+struct CPUDrawIndexedDesc
+{
+	const CPUFloat3* Vertices = nullptr;
+	uint32_t VertexCount = 0;
+	const uint16_t* Indices = nullptr;
+	uint32_t IndexCount = 0;
+	CPUMatrix TransformMatrix = CPUMatrixIdentity();
+	CPUCullMode CullMode = CPU_CULL_MODE_BACK;
+	// Instances are drawn one after the other. With InstanceTransforms, instance i is transformed by
+	// InstanceTransforms[i] and then TransformMatrix, else every instance by TransformMatrix alone.
+	uint32_t InstanceCount = 1;
+	const CPUMatrix* InstanceTransforms = nullptr;
+};
+
+// Tile-based multisampled depth rasterizer following the D3D12 rules: frustum clipping, viewport covering the
+// whole target with depth range [0, 1], 16.8 fixed-point vertex snapping, standard or programmable sample positions and the top-left fill rule.
+// Tiles are rasterized in parallel, triangles inside a tile keep their submission order.
+// Targets that track their uniform pixels have them updated from the samples each triangle writes.
+class CPURasterizer
+{
+public:
+	explicit CPURasterizer(CPUThreadPool* Pool = nullptr);
+
+	// Returns the number of triangles that reached rasterization (after culling and clipping)
+	uint32_t DrawIndexed(CPUDepthSurface& DepthTarget, const CPUDrawIndexedDesc& Draw);
+
+	// Same draw into a compressed target: touched blocks are decoded, rasterized and re-encoded, and the samples
+	// each triangle wins keep its plane so they compress back. The target's pattern is used for the sample positions.
+	uint32_t DrawIndexed(CPUCompressedDepthSurface& DepthTarget, const CPUDrawIndexedDesc& Draw);
+
+	// Same contract as ID3D12GraphicsCommandList1::SetSamplePositions: NumPixels is 1 (Tier 1) or 4 (Tier 2, 2x2 quad),
+	// NumSamplesPerPixel == 0 restores the standard pattern. Invalid positions are rejected and the current pattern is kept.
+	// Targets whose sample count differs from the programmed pattern are rasterized with the standard pattern.
+	bool SetSamplePositions(uint32_t NumSamplesPerPixel, uint32_t NumPixels, const CPUSamplePosition* Positions);
+
+	// Pattern used for a target with the given sample count
+	CPUSamplePattern GetSamplePattern(uint32_t SampleCount) const;
+
+	static constexpr uint32_t TileSize = 64;
+
+private:
+	struct Triangle
+	{
+		int64_t EdgeDX[3];
+		int64_t EdgeDY[3];
+		int64_t EdgeX0[3];
+		int64_t EdgeY0[3];
+		int64_t EdgeBias[3];
+		CPUDepthPlane Plane;
+		int32_t MinX, MinY, MaxX, MaxY;
+	};
+
+	// Samples a tile is rasterized into, either the target itself or a block scratch
+	struct TileTarget
+	{
+		void* Samples;                  // samples of pixel (OriginX, OriginY) in the target's format
+		uint32_t* PlaneIds;             // optional, receives the triangle index of every sample that passes the depth test
+		uint8_t* UniformPixels;         // optional, CPUDepthSurface::UniformPixels of the whole target
+		size_t RowPitch;                // in samples
+		int32_t OriginX;
+		int32_t OriginY;
+		uint32_t Width;                 // size of the whole target
+		uint32_t Height;
+		uint32_t SampleCount;
+	};
+
+	// Transforms, clips and bins the draw and computes the sample offsets of its triangles for Pattern, returns false
+	// when there is nothing to rasterize
+	bool SetupDraw(uint32_t Width, uint32_t Height, const CPUSamplePattern& Pattern, const CPUDrawIndexedDesc& Draw);
+	void SetupTriangle(const CPUFloat4 ClipPositions[3], CPUCullMode CullMode, uint32_t Width, uint32_t Height);
+	// Traits is the CPUDepthFormatTraits of the target, so the depth test compiles for its format
+	template <typename Traits>
+	void RasterizeTile(const TileTarget& Target, const CPUSamplePattern& Pattern, uint32_t TileX, uint32_t TileY, const std::vector<uint32_t>& Bin) const;
+
+	CPUThreadPool* Pool;
+
+	CPUSamplePattern ProgrammedPattern;
+
+	// Per triangle and quad pixel of the pattern: edge function offsets of every sample from the pixel center, edge
+	// by edge, then their minimum and maximum per edge
+	static size_t GetSampleOffsetStride(uint32_t SampleCount) { return 3 * SampleCount + 6; }
+
+	std::vector<Triangle> Triangles;
+	std::vector<int64_t> SampleOffsets;
+	// Per triangle and quad pixel, the depth plane delta of every sample from the pixel center
+	std::vector<float> SampleDepthDeltas;
+	std::vector<std::vector<uint32_t>> TileBins;
+};
@@ -0,0 +1,226 @@
+#include "CPUResolve.h"
+#include "CPUResolveKernels.h"
+#include "CPUHiZ.h"
+#include "CPUParallel.h"
+
+#include <algorithm>
+
+constexpr uint32_t ResolveTileSize = 64;
+
+static_assert(ResolveTileSize == CPUHiZTileSize, "resolve tiles must line up with the HiZ tiles");
+
+static bool IsSupportedSampleCount(uint32_t SampleCount)
+{
+	return SampleCount != 0 && SampleCount <= 16 && (SampleCount & (SampleCount - 1)) == 0;
+}
+
+// Rect of Source resolved into a destination of the given size at (DstX, DstY), false when it does not fit
+static bool GetResolveRect(CPURect& Rect, uint32_t DstX, uint32_t DstY, uint32_t DestinationWidth, uint32_t DestinationHeight, const CPUDepthSurface& Source, const CPURect* SourceRect)
+{
+	Rect = SourceRect ? *SourceRect : CPURect{ 0, 0, static_cast<int32_t>(Source.Width), static_cast<int32_t>(Source.Height) };
+
+	if (!IsSupportedSampleCount(Source.SampleCount))
+		return false;
+
+	if (Rect.Left < 0 || Rect.Top < 0 || Rect.Right > static_cast<int32_t>(Source.Width) || Rect.Bottom > static_cast<int32_t>(Source.Height) || Rect.Left > Rect.Right || Rect.Top > Rect.Bottom)
+		return false;
+
+	return static_cast<uint64_t>(DstX) + (Rect.Right - Rect.Left) <= DestinationWidth && static_cast<uint64_t>(DstY) + (Rect.Bottom - Rect.Top) <= DestinationHeight;
+}
+
+// Resolves PixelCount pixels from (X, Y) on: runs of the pixels Source.UniformPixels marks decode their first sample,
+// runs of the others go through ResolveRow
+typedef void (*UniformResolveRowFunc)(const CPUDepthSurface& Source, CPUResolveRowFunc ResolveRow, CPUResolveMode Mode, uint32_t X, uint32_t Y, float* Destination, uint32_t PixelCount);
+
+template <typename Traits>
+static void ResolveUniformRow(const CPUDepthSurface& Source, CPUResolveRowFunc ResolveRow, CPUResolveMode Mode, uint32_t X, uint32_t Y, float* Destination, uint32_t PixelCount)
+{
+	const uint8_t* Uniform = &Source.UniformPixels[static_cast<size_t>(Y) * Source.Width + X];
+	const typename Traits::Sample* Samples = Source.GetPixel<typename Traits::Sample>(X, Y);
+
+	for (uint32_t x = 0; x < PixelCount;)
+	{
+		if (Uniform[x])
+		{
+			for (; x < PixelCount && Uniform[x]; ++x)
+				Destination[x] = ResolveUniformDepth(Traits::Decode(Traits::GetValue(Samples[static_cast<size_t>(x) * Source.SampleCount])), Source.SampleCount, Mode);
+
+			continue;
+		}
+
+		uint32_t End = x + 1;
+
+		while (End < PixelCount && !Uniform[End])
+			++End;
+
+		ResolveRow(Source.GetPixel<uint8_t>(X + x, Y), Destination + x, End - x);
+		x = End;
+	}
+}
+
+// nullptr when Source does not track its uniform pixels
+static UniformResolveRowFunc GetUniformResolveRow(const CPUDepthSurface& Source)
+{
+	if (Source.UniformPixels.empty())
+		return nullptr;
+
+	return CPUDispatchDepthFormat(Source.Format, [](auto Traits) -> UniformResolveRowFunc { return &ResolveUniformRow<decltype(Traits)>; });
+}
+
+static bool ResolveDepthRegion(CPUResolvedDepth& Destination, uint32_t DstX, uint32_t DstY, const CPUDepthSurface& Source, const CPURect* SourceRect, CPUResolveMode Mode, CPUHiZPyramid* HiZ, CPUThreadPool* Pool)
+{
+	CPURect Rect;
+
+	if (!GetResolveRect(Rect, DstX, DstY, Destination.Width, Destination.Height, Source, SourceRect))
+		return false;
+
+	const uint32_t RegionWidth = static_cast<uint32_t>(Rect.Right - Rect.Left);
+	const uint32_t RegionHeight = static_cast<uint32_t>(Rect.Bottom - Rect.Top);
+
+	if (HiZ)
+		HiZ->Allocate(RegionWidth, RegionHeight);
+
+	const uint32_t TilesX = (RegionWidth + ResolveTileSize - 1) / ResolveTileSize;
+	const uint32_t TilesY = (RegionHeight + ResolveTileSize - 1) / ResolveTileSize;
+
+	if (!Pool)
+		Pool = &CPUThreadPool::GetDefault();
+
+	const CPUResolveRowFunc ResolveRow = GetCPUResolveRowKernel(Source.Format, Source.SampleCount, Mode);
+	const UniformResolveRowFunc ResolveUniform = GetUniformResolveRow(Source);
+
+	Pool->ParallelFor(TilesX * TilesY, [&](uint32_t TileIndex)
+	{
+		const uint32_t TileX = (TileIndex % TilesX) * ResolveTileSize;
+		const uint32_t TileY = (TileIndex / TilesX) * ResolveTileSize;
+		const uint32_t TileWidth = std::min(ResolveTileSize, RegionWidth - TileX);
+		const uint32_t TileHeight = std::min(ResolveTileSize, RegionHeight - TileY);
+
+		for (uint32_t y = 0; y < TileHeight; ++y)
+		{
+			float* Row = Destination.GetRow(DstY + TileY + y) + DstX + TileX;
+
+			if (ResolveUniform)
+				ResolveUniform(Source, ResolveRow, Mode, Rect.Left + TileX, Rect.Top + TileY + y, Row, TileWidth);
+			else
+				ResolveRow(Source.GetPixel<uint8_t>(Rect.Left + TileX, Rect.Top + TileY + y), Row, TileWidth);
+		}
+
+		if (HiZ)
+			CPUReduceHiZTile(*HiZ, Destination, DstX, DstY, TileX, TileY);
+	});
+
+	if (HiZ)
+		CPUFinishHiZPyramid(*HiZ);
+
+	return true;
+}
+
+bool CPUResolveDepthRegion(CPUResolvedDepth& Destination, uint32_t DstX, uint32_t DstY, const CPUDepthSurface& Source, const CPURect* SourceRect, CPUResolveMode Mode, CPUThreadPool* Pool)
+{
+	return ResolveDepthRegion(Destination, DstX, DstY, Source, SourceRect, Mode, nullptr, Pool);
+}
+
+bool CPUResolveDepthRegionHiZ(CPUResolvedDepth& Destination, uint32_t DstX, uint32_t DstY, const CPUDepthSurface& Source, const CPURect* SourceRect, CPUResolveMode Mode, CPUHiZPyramid& HiZ, CPUThreadPool* Pool)
+{
+	return ResolveDepthRegion(Destination, DstX, DstY, Source, SourceRect, Mode, &HiZ, Pool);
+}
+
+// Largest group CPUResolveShadeGroups keeps a row of on the stack
+constexpr uint32_t MaxResolveGroupSize = 256;
+
+static bool ResolveDepthGroups(CPUResolvedDepth* Destination, uint32_t* Colors, uint32_t (*PixelShader)(float Depth), const CPUDepthSurface& Source, CPUResolveMode Mode, uint32_t GroupSize, CPUThreadPool* Pool)
+{
+	if (!IsSupportedSampleCount(Source.SampleCount) || GroupSize == 0 || GroupSize > MaxResolveGroupSize)
+		return false;
+
+	if (Destination && (Destination->Width < Source.Width || Destination->Height < Source.Height))
+		return false;
+
+	const uint32_t GroupsX = (Source.Width + GroupSize - 1) / GroupSize;
+	const uint32_t GroupsY = (Source.Height + GroupSize - 1) / GroupSize;
+
+	if (!Pool)
+		Pool = &CPUThreadPool::GetDefault();
+
+	const CPUResolveRowFunc ResolveRow = GetCPUResolveRowKernel(Source.Format, Source.SampleCount, Mode);
+	const UniformResolveRowFunc ResolveUniform = GetUniformResolveRow(Source);
+
+	Pool->ParallelFor(GroupsX * GroupsY, [&](uint32_t GroupIndex)
+	{
+		const uint32_t GroupX = (GroupIndex % GroupsX) * GroupSize;
+		const uint32_t GroupY = (GroupIndex / GroupsX) * GroupSize;
+		const uint32_t GroupWidth = std::min(GroupSize, Source.Width - GroupX);
+		const uint32_t GroupHeight = std::min(GroupSize, Source.Height - GroupY);
+
+		// Shaded rows keep the depth on the stack only, like the fused kernel keeps it in registers
+		float Depths[MaxResolveGroupSize];
+
+		for (uint32_t y = 0; y < GroupHeight; ++y)
+		{
+			float* DepthRow = Destination ? Destination->GetRow(GroupY + y) + GroupX : Depths;
+
+			if (ResolveUniform)
+				ResolveUniform(Source, ResolveRow, Mode, GroupX, GroupY + y, DepthRow, GroupWidth);
+			else
+				ResolveRow(Source.GetPixel<uint8_t>(GroupX, GroupY + y), DepthRow, GroupWidth);
+
+			if (Destination)
+				continue;
+
+			uint32_t* Row = Colors + static_cast<size_t>(GroupY + y) * Source.Width + GroupX;
+
+			for (uint32_t x = 0; x < GroupWidth; ++x)
+				Row[x] = PixelShader(Depths[x]);
+		}
+	});
+
+	return true;
+}
+
+bool CPUResolveDepthGroups(CPUResolvedDepth& Destination, const CPUDepthSurface& Source, CPUResolveMode Mode, uint32_t GroupSize, CPUThreadPool* Pool)
+{
+	return ResolveDepthGroups(&Destination, nullptr, nullptr, Source, Mode, GroupSize, Pool);
+}
+
+bool CPUResolveShadeGroups(uint32_t* Colors, uint32_t (*PixelShader)(float Depth), const CPUDepthSurface& Source, CPUResolveMode Mode, uint32_t GroupSize, CPUThreadPool* Pool)
+{
+	return ResolveDepthGroups(nullptr, Colors, PixelShader, Source, Mode, GroupSize, Pool);
+}
+
+bool CPUResolveStencilRegion(CPUResolvedStencil& Destination, uint32_t DstX, uint32_t DstY, const CPUDepthSurface& Source, const CPURect* SourceRect, CPUResolveMode Mode, CPUThreadPool* Pool)
+{
+	CPURect Rect;
+
+	if (Mode == CPU_RESOLVE_MODE_AVERAGE || !CPUDepthFormatHasStencil(Source.Format) || !GetResolveRect(Rect, DstX, DstY, Destination.Width, Destination.Height, Source, SourceRect))
+		return false;
+
+	const uint32_t RegionWidth = static_cast<uint32_t>(Rect.Right - Rect.Left);
+	const uint32_t RegionHeight = static_cast<uint32_t>(Rect.Bottom - Rect.Top);
+
+	if (!Pool)
+		Pool = &CPUThreadPool::GetDefault();
+
+	CPUDispatchDepthFormat(Source.Format, [&](auto Traits)
+	{
+		typedef decltype(Traits) FormatTraits;
+
+		Pool->ParallelFor(RegionHeight, [&](uint32_t y)
+		{
+			const typename FormatTraits::Sample* SourcePixel = Source.GetPixel<typename FormatTraits::Sample>(Rect.Left, Rect.Top + y);
+			uint8_t* DestinationPixel = Destination.GetRow(DstY + y) + DstX;
+
+			for (uint32_t x = 0; x < RegionWidth; ++x, SourcePixel += Source.SampleCount)
+			{
+				uint8_t Result = FormatTraits::GetStencil(SourcePixel[0]);
+
+				for (uint32_t i = 1; i < Source.SampleCount; ++i)
+					Result = Mode == CPU_RESOLVE_MODE_MAX ? std::max(Result, FormatTraits::GetStencil(SourcePixel[i])) : std::min(Result, FormatTraits::GetStencil(SourcePixel[i]));
+
+				DestinationPixel[x] = Result;
+			}
+		});
+	});
+
+	return true;
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+
+#include "CPUDepthSurface.h"
+
+class CPUThreadPool;
+struct CPUHiZPyramid;
+
+// Mirrors D3D12_RESOLVE_MODE for the modes the depth resolve uses
+enum CPUResolveMode
+{
+	CPU_RESOLVE_MODE_MIN,
+	CPU_RESOLVE_MODE_MAX,
+	CPU_RESOLVE_MODE_AVERAGE
+};
+
+// Reference semantics of the CPU resolve:
+// - MIN/MAX order -0.0 below +0.0 and ignore NaN samples; a pixel whose samples are all NaN resolves to CPUResolveNaN.
+// - AVERAGE sums the samples pairwise (sample i with sample i + N/2, then halves again) and scales by 1/N;
+//   a NaN result is always returned as CPUResolveNaN so no NaN payload depends on operand order.
+
+constexpr uint32_t CPUResolveNaN = 0x7FC00000;
+
+// Maps float bits to a signed integer with the same total order (-0.0 < +0.0)
+inline int32_t DepthToOrderedKey(float Value)
+{
+	int32_t Bits;
+	memcpy(&Bits, &Value, sizeof(Bits));
+	return Bits ^ ((Bits >> 31) & 0x7FFFFFFF);
+}
+
+inline float OrderedKeyToDepth(int32_t Key)
+{
+	int32_t Bits = Key ^ ((Key >> 31) & 0x7FFFFFFF);
+	float Value;
+	memcpy(&Value, &Bits, sizeof(Value));
+	return Value;
+}
+
+inline bool IsDepthNaN(float Value)
+{
+	uint32_t Bits;
+	memcpy(&Bits, &Value, sizeof(Bits));
+	return (Bits & 0x7FFFFFFF) > 0x7F800000;
+}
+
+// Scalar reduction of the sample depths of one pixel; SampleCount must be a power of two not above 16
+inline float ResolveDepthValues(const float* Depths, uint32_t SampleCount, CPUResolveMode Mode)
+{
+	float NaN;
+	memcpy(&NaN, &CPUResolveNaN, sizeof(NaN));
+
+	if (Mode == CPU_RESOLVE_MODE_AVERAGE)
+	{
+		float Sums[16];
+
+		for (uint32_t i = 0; i < SampleCount; ++i)
+			Sums[i] = Depths[i];
+
+		for (uint32_t Half = SampleCount / 2; Half > 0; Half /= 2)
+			for (uint32_t i = 0; i < Half; ++i)
+				Sums[i] = Sums[i] + Sums[i + Half];
+
+		float Average = Sums[0] * (1.0f / static_cast<float>(SampleCount));
+		return IsDepthNaN(Average) ? NaN : Average;
+	}
+
+	const bool IsMax = Mode == CPU_RESOLVE_MODE_MAX;
+	const int32_t Ignored = IsMax ? INT32_MIN : INT32_MAX;
+
+	int32_t Result = Ignored;
+
+	for (uint32_t i = 0; i < SampleCount; ++i)
+	{
+		int32_t Key = IsDepthNaN(Depths[i]) ? Ignored : DepthToOrderedKey(Depths[i]);
+
+		if (IsMax ? Key > Result : Key < Result)
+			Result = Key;
+	}
+
+	return Result == Ignored ? NaN : OrderedKeyToDepth(Result);
+}
+
+// What ResolveDepthValues gives for SampleCount samples that all decode to Depth. Doubling and scaling by a power of
+// two are exact, so the pairwise AVERAGE of equal samples is Depth * SampleCount / SampleCount, overflow included.
+inline float ResolveUniformDepth(float Depth, uint32_t SampleCount, CPUResolveMode Mode)
+{
+	if (IsDepthNaN(Depth))
+	{
+		float NaN;
+		memcpy(&NaN, &CPUResolveNaN, sizeof(NaN));
+		return NaN;
+	}
+
+	return Mode == CPU_RESOLVE_MODE_AVERAGE ? Depth * static_cast<float>(SampleCount) * (1.0f / static_cast<float>(SampleCount)) : Depth;
+}
+
+inline float ResolveDepthSamples(const CPUDepthStencilSample* Samples, uint32_t SampleCount, CPUResolveMode Mode)
+{
+	float Depths[16];
+
+	for (uint32_t i = 0; i < SampleCount; ++i)
+		Depths[i] = Samples[i].Depth;
+
+	return ResolveDepthValues(Depths, SampleCount, Mode);
+}
+
+// Same reduction specialized for a format and a sample count. UNORM MIN/MAX compare the codes and decode the result
+// once, which gives what decoding every sample first would.
+template <CPUDepthFormat Format, uint32_t SampleCount, CPUResolveMode Mode>
+inline float ResolveDepthSamples(const typename CPUDepthFormatTraits<Format>::Sample* Samples)
+{
+	typedef CPUDepthFormatTraits<Format> Traits;
+
+	if constexpr (Traits::Unorm && Mode != CPU_RESOLVE_MODE_AVERAGE)
+	{
+		typename Traits::Value Result = Traits::GetValue(Samples[0]);
+
+		for (uint32_t i = 1; i < SampleCount; ++i)
+			Result = Mode == CPU_RESOLVE_MODE_MAX ? std::max(Result, Traits::GetValue(Samples[i])) : std::min(Result, Traits::GetValue(Samples[i]));
+
+		return Traits::Decode(Result);
+	}
+	else
+	{
+		float Depths[SampleCount];
+
+		for (uint32_t i = 0; i < SampleCount; ++i)
+			Depths[i] = Traits::Decode(Traits::GetValue(Samples[i]));
+
+		return ResolveDepthValues(Depths, SampleCount, Mode);
+	}
+}
+
+// Reference resolve of pixel (X, Y) of a surface of any format
+inline float ResolveDepthPixel(const CPUDepthSurface& Surface, uint32_t X, uint32_t Y, CPUResolveMode Mode)
+{
+	return CPUDispatchDepthFormat(Surface.Format, [&](auto Traits)
+	{
+		typedef decltype(Traits) FormatTraits;
+		const typename FormatTraits::Sample* Samples = Surface.GetPixel<typename FormatTraits::Sample>(X, Y);
+		float Depths[16];
+
+		for (uint32_t i = 0; i < Surface.SampleCount; ++i)
+			Depths[i] = FormatTraits::Decode(FormatTraits::GetValue(Samples[i]));
+
+		return ResolveDepthValues(Depths, Surface.SampleCount, Mode);
+	});
+}
+
+// CPU counterpart of ID3D12GraphicsCommandList1::ResolveSubresourceRegion for the depth plane.
+// Resolves SourceRect (whole surface when nullptr) of Source into Destination at (DstX, DstY),
+// splitting the work into tiles spread over Pool (CPUThreadPool::GetDefault() when nullptr).
+// Rows go through the kernel GetCPUResolveRowKernel picks for the format and sample count of Source, except the pixels
+// Source.UniformPixels marks, which read their first sample only.
+// Returns false if the region does not fit the source or the destination.
+bool CPUResolveDepthRegion(CPUResolvedDepth& Destination, uint32_t DstX, uint32_t DstY, const CPUDepthSurface& Source, const CPURect* SourceRect, CPUResolveMode Mode, CPUThreadPool* Pool = nullptr);
+
+// Same resolve that also emits every level of a min/max depth pyramid over the resolved region (see CPUHiZ.h).
+// Each tile reduces its pixels while they are still in cache, so the pyramid costs no extra pass over the destination.
+bool CPUResolveDepthRegionHiZ(CPUResolvedDepth& Destination, uint32_t DstX, uint32_t DstY, const CPUDepthSurface& Source, const CPURect* SourceRect, CPUResolveMode Mode, CPUHiZPyramid& HiZ, CPUThreadPool* Pool = nullptr);
+
+// Counterparts of compute kernels resolving the whole of Source one GroupSize pixels square block per group: each
+// block is a work item of Pool, resolved row by row like the threads of a group. CPUResolveDepthGroups writes the
+// depth to Destination, CPUResolveShadeGroups writes PixelShader of it to Colors (RGBA8, Source.Width texels per
+// row) and keeps no resolved depth. Uniform pixels read one sample as in CPUResolveDepthRegion. Return false for a
+// Destination smaller than Source and unsupported sample counts.
+bool CPUResolveDepthGroups(CPUResolvedDepth& Destination, const CPUDepthSurface& Source, CPUResolveMode Mode, uint32_t GroupSize, CPUThreadPool* Pool = nullptr);
+bool CPUResolveShadeGroups(uint32_t* Colors, uint32_t (*PixelShader)(float Depth), const CPUDepthSurface& Source, CPUResolveMode Mode, uint32_t GroupSize, CPUThreadPool* Pool = nullptr);
+
+// Stencil plane counterpart, plane slice 1: MIN or MAX of the stencil values of the samples. Returns false for
+// AVERAGE, for formats without stencil and for regions that do not fit.
+bool CPUResolveStencilRegion(CPUResolvedStencil& Destination, uint32_t DstX, uint32_t DstY, const CPUDepthSurface& Source, const CPURect* SourceRect, CPUResolveMode Mode, CPUThreadPool* Pool = nullptr);
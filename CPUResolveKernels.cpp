@@ -0,0 +1,490 @@
+#include "CPUResolveKernels.h"
+
+#include <bit>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CPU_RESOLVE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define CPU_RESOLVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+// MSVC compiles intrinsics for any instruction set, GCC and Clang need the target on the function
+#if defined(CPU_RESOLVE_X86) && !defined(_MSC_VER)
+#define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#define CPU_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define CPU_TARGET_AVX2
+#define CPU_TARGET_AVX512
+#endif
+
+// Every kernel follows the scalar ResolveDepthSamples() step by step:
+// MIN/MAX compare ordered integer keys with NaN samples replaced by the ignored key,
+// AVERAGE adds sample i to sample i + 4, then i to i + 2, then 0 to 1, keeping the lower index as the first operand.
+
+// Any format and sample count, specialized at compile time so the sample loop unrolls and UNORM formats reduce codes
+template <CPUDepthFormat Format, uint32_t SampleCount, CPUResolveMode Mode>
+static void ResolveRowScalar(const void* SampleData, float* Destination, uint32_t PixelCount)
+{
+	const typename CPUDepthFormatTraits<Format>::Sample* Samples = static_cast<const typename CPUDepthFormatTraits<Format>::Sample*>(SampleData);
+
+	for (uint32_t i = 0; i < PixelCount; ++i, Samples += SampleCount)
+		Destination[i] = ResolveDepthSamples<Format, SampleCount, Mode>(Samples);
+}
+
+static void ClassifyRowScalar(const float* Depth, uint32_t* Colors, uint32_t PixelCount, uint64_t* Counts, int32_t& FirstCovered, int32_t& LastCovered)
+{
+	FirstCovered = -1;
+	LastCovered = -1;
+
+	for (uint32_t i = 0; i < PixelCount; ++i)
+	{
+		const CPUDepthClass Class = CPUGetDepthClass(Depth[i]);
+
+		++Counts[Class];
+
+		if (Colors)
+			Colors[i] = CPUDepthClassColors[Class];
+
+		if (Class != CPU_DEPTH_CLASS_ONE)
+		{
+			FirstCovered = FirstCovered < 0 ? static_cast<int32_t>(i) : FirstCovered;
+			LastCovered = static_cast<int32_t>(i);
+		}
+	}
+}
+
+// Adds the covered lanes of a group starting at Index, CoveredMask holding one bit per lane
+static inline void AddCoveredLanes(uint32_t CoveredMask, uint32_t Index, int32_t& FirstCovered, int32_t& LastCovered)
+{
+	if (CoveredMask == 0)
+		return;
+
+	if (FirstCovered < 0)
+		FirstCovered = static_cast<int32_t>(Index + std::countr_zero(CoveredMask));
+
+	LastCovered = static_cast<int32_t>(Index + 31 - std::countl_zero(CoveredMask));
+}
+
+static float FinishMinMax(int32_t Key, int32_t Ignored)
+{
+	float NaN;
+	memcpy(&NaN, &CPUResolveNaN, sizeof(NaN));
+	return Key == Ignored ? NaN : OrderedKeyToDepth(Key);
+}
+
+static float FinishAverage(float Average)
+{
+	float NaN;
+	memcpy(&NaN, &CPUResolveNaN, sizeof(NaN));
+	return IsDepthNaN(Average) ? NaN : Average;
+}
+
+#if defined(CPU_RESOLVE_X86)
+
+// Keys of 8 depth bits in one register, NaN lanes replaced by Ignored
+CPU_TARGET_AVX2 static inline __m256i DepthKeysAVX2(__m256i Bits, __m256i Ignored)
+{
+	const __m256i Magnitude = _mm256_set1_epi32(0x7FFFFFFF);
+	const __m256i Infinity = _mm256_set1_epi32(0x7F800000);
+
+	__m256i Keys = _mm256_xor_si256(Bits, _mm256_and_si256(_mm256_srai_epi32(Bits, 31), Magnitude));
+	__m256i IsNaN = _mm256_cmpgt_epi32(_mm256_and_si256(Bits, Magnitude), Infinity);
+
+	return _mm256_blendv_epi8(Keys, Ignored, IsNaN);
+}
+
+// Gathers the 8 depth dwords of a pixel as d0 d1 d4 d5 | d2 d3 d6 d7, skipping the stencil dwords
+CPU_TARGET_AVX2 static inline __m256 LoadPixelDepthsAVX2(const CPUDepthStencilSample* Samples)
+{
+	__m256 Low = _mm256_loadu_ps(reinterpret_cast<const float*>(Samples));
+	__m256 High = _mm256_loadu_ps(reinterpret_cast<const float*>(Samples + 4));
+
+	return _mm256_shuffle_ps(Low, High, _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+template <CPUResolveMode Mode>
+CPU_TARGET_AVX2 static void ResolveRowAVX2(const void* SampleData, float* Destination, uint32_t PixelCount)
+{
+	const CPUDepthStencilSample* Samples = static_cast<const CPUDepthStencilSample*>(SampleData);
+	const int32_t IgnoredKey = Mode == CPU_RESOLVE_MODE_MAX ? INT32_MIN : INT32_MAX;
+	const __m256i Ignored = _mm256_set1_epi32(IgnoredKey);
+
+	for (uint32_t i = 0; i < PixelCount; ++i, Samples += 8)
+	{
+		__m256 Depths = LoadPixelDepthsAVX2(Samples);
+
+		if constexpr (Mode == CPU_RESOLVE_MODE_AVERAGE)
+		{
+			__m256 Sums = _mm256_add_ps(Depths, _mm256_shuffle_ps(Depths, Depths, _MM_SHUFFLE(1, 0, 3, 2)));
+			__m128 Sums2 = _mm_add_ps(_mm256_castps256_ps128(Sums), _mm256_extractf128_ps(Sums, 1));
+			__m128 Sum = _mm_add_ss(Sums2, _mm_shuffle_ps(Sums2, Sums2, _MM_SHUFFLE(1, 1, 1, 1)));
+
+			Destination[i] = FinishAverage(_mm_cvtss_f32(_mm_mul_ss(Sum, _mm_set_ss(0.125f))));
+		}
+		else
+		{
+			__m256i Keys = DepthKeysAVX2(_mm256_castps_si256(Depths), Ignored);
+			__m128i Keys4 = _mm256_castsi256_si128(Keys);
+			__m128i KeysHigh = _mm256_extracti128_si256(Keys, 1);
+
+			if constexpr (Mode == CPU_RESOLVE_MODE_MAX)
+			{
+				Keys4 = _mm_max_epi32(Keys4, KeysHigh);
+				Keys4 = _mm_max_epi32(Keys4, _mm_shuffle_epi32(Keys4, _MM_SHUFFLE(1, 0, 3, 2)));
+				Keys4 = _mm_max_epi32(Keys4, _mm_shuffle_epi32(Keys4, _MM_SHUFFLE(2, 3, 0, 1)));
+			}
+			else
+			{
+				Keys4 = _mm_min_epi32(Keys4, KeysHigh);
+				Keys4 = _mm_min_epi32(Keys4, _mm_shuffle_epi32(Keys4, _MM_SHUFFLE(1, 0, 3, 2)));
+				Keys4 = _mm_min_epi32(Keys4, _mm_shuffle_epi32(Keys4, _MM_SHUFFLE(2, 3, 0, 1)));
+			}
+
+			Destination[i] = FinishMinMax(_mm_cvtsi128_si32(Keys4), IgnoredKey);
+		}
+	}
+}
+
+// Compares as the shader does: ordered, so NaN lanes fail every test and fall into CPU_DEPTH_CLASS_OTHER
+CPU_TARGET_AVX2 static void ClassifyRowAVX2(const float* Depth, uint32_t* Colors, uint32_t PixelCount, uint64_t* Counts, int32_t& FirstCovered, int32_t& LastCovered)
+{
+	const __m256 Zero = _mm256_setzero_ps();
+	const __m256 One = _mm256_set1_ps(1.0f);
+	const __m256i Red = _mm256_set1_epi32(0x000000FF);
+	const __m256i Green = _mm256_set1_epi32(0x0000FF00);
+	const __m256i Blue = _mm256_set1_epi32(0x00FF0000);
+	const __m256i Alpha = _mm256_set1_epi32(static_cast<int32_t>(0xFF000000));
+
+	uint32_t ZeroCount = 0;
+	uint32_t OneCount = 0;
+	uint32_t BetweenCount = 0;
+	uint32_t i = 0;
+
+	FirstCovered = -1;
+	LastCovered = -1;
+
+	for (; i + 8 <= PixelCount; i += 8)
+	{
+		const __m256 Depths = _mm256_loadu_ps(Depth + i);
+		const __m256 IsZero = _mm256_cmp_ps(Depths, Zero, _CMP_EQ_OQ);
+		const __m256 IsOne = _mm256_cmp_ps(Depths, One, _CMP_EQ_OQ);
+		const __m256 IsBetween = _mm256_and_ps(_mm256_cmp_ps(Depths, Zero, _CMP_GT_OQ), _mm256_cmp_ps(Depths, One, _CMP_LT_OQ));
+
+		if (Colors)
+		{
+			__m256i Color = _mm256_or_si256(Alpha, _mm256_and_si256(_mm256_castps_si256(IsZero), Red));
+			Color = _mm256_or_si256(Color, _mm256_and_si256(_mm256_castps_si256(IsOne), Green));
+			Color = _mm256_or_si256(Color, _mm256_and_si256(_mm256_castps_si256(IsBetween), Blue));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(Colors + i), Color);
+		}
+
+		const uint32_t OneMask = static_cast<uint32_t>(_mm256_movemask_ps(IsOne));
+
+		ZeroCount += std::popcount(static_cast<uint32_t>(_mm256_movemask_ps(IsZero)));
+		OneCount += std::popcount(OneMask);
+		BetweenCount += std::popcount(static_cast<uint32_t>(_mm256_movemask_ps(IsBetween)));
+
+		AddCoveredLanes(~OneMask & 0xFF, i, FirstCovered, LastCovered);
+	}
+
+	Counts[CPU_DEPTH_CLASS_ZERO] += ZeroCount;
+	Counts[CPU_DEPTH_CLASS_ONE] += OneCount;
+	Counts[CPU_DEPTH_CLASS_BETWEEN] += BetweenCount;
+	Counts[CPU_DEPTH_CLASS_OTHER] += i - ZeroCount - OneCount - BetweenCount;
+
+	if (i < PixelCount)
+	{
+		int32_t TailFirst;
+		int32_t TailLast;
+		ClassifyRowScalar(Depth + i, Colors ? Colors + i : nullptr, PixelCount - i, Counts, TailFirst, TailLast);
+
+		if (TailLast >= 0)
+		{
+			FirstCovered = FirstCovered < 0 ? static_cast<int32_t>(i) + TailFirst : FirstCovered;
+			LastCovered = static_cast<int32_t>(i) + TailLast;
+		}
+	}
+}
+
+// GCC 12 reports the undefined pass-through operand inside its own AVX-512 intrinsic wrappers as maybe uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// Two pixels per iteration: the 16 depth dwords of both pixels are packed into one register,
+// pixel 0 in the low 256 bits and pixel 1 in the high 256 bits, each in sample order
+template <CPUResolveMode Mode>
+CPU_TARGET_AVX512 static void ResolveRowAVX512(const void* SampleData, float* Destination, uint32_t PixelCount)
+{
+	const CPUDepthStencilSample* Samples = static_cast<const CPUDepthStencilSample*>(SampleData);
+	const int32_t IgnoredKey = Mode == CPU_RESOLVE_MODE_MAX ? INT32_MIN : INT32_MAX;
+	const __m512i Ignored = _mm512_set1_epi32(IgnoredKey);
+	const __m512i Magnitude = _mm512_set1_epi32(0x7FFFFFFF);
+	const __m512i Infinity = _mm512_set1_epi32(0x7F800000);
+	const __m512i EvenDwords = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+
+	uint32_t i = 0;
+
+	for (; i + 2 <= PixelCount; i += 2, Samples += 16)
+	{
+		__m512i Pixel0 = _mm512_loadu_si512(Samples);
+		__m512i Pixel1 = _mm512_loadu_si512(Samples + 8);
+		__m512i Bits = _mm512_permutex2var_epi32(Pixel0, EvenDwords, Pixel1);
+
+		if constexpr (Mode == CPU_RESOLVE_MODE_AVERAGE)
+		{
+			__m512 Depths = _mm512_castsi512_ps(Bits);
+			__m512 Sums = _mm512_add_ps(Depths, _mm512_shuffle_f32x4(Depths, Depths, _MM_SHUFFLE(2, 3, 0, 1)));
+			Sums = _mm512_add_ps(Sums, _mm512_permute_ps(Sums, _MM_SHUFFLE(1, 0, 3, 2)));
+			Sums = _mm512_add_ps(Sums, _mm512_permute_ps(Sums, _MM_SHUFFLE(2, 3, 0, 1)));
+			Sums = _mm512_mul_ps(Sums, _mm512_set1_ps(0.125f));
+
+			alignas(64) float Lanes[16];
+			_mm512_store_ps(Lanes, Sums);
+
+			Destination[i] = FinishAverage(Lanes[0]);
+			Destination[i + 1] = FinishAverage(Lanes[8]);
+		}
+		else
+		{
+			__m512i Keys = _mm512_xor_si512(Bits, _mm512_and_si512(_mm512_srai_epi32(Bits, 31), Magnitude));
+			__mmask16 IsNaN = _mm512_cmpgt_epi32_mask(_mm512_and_si512(Bits, Magnitude), Infinity);
+			Keys = _mm512_mask_mov_epi32(Keys, IsNaN, Ignored);
+
+			if constexpr (Mode == CPU_RESOLVE_MODE_MAX)
+			{
+				Keys = _mm512_max_epi32(Keys, _mm512_shuffle_i32x4(Keys, Keys, _MM_SHUFFLE(2, 3, 0, 1)));
+				Keys = _mm512_max_epi32(Keys, _mm512_shuffle_epi32(Keys, (_MM_PERM_ENUM)_MM_SHUFFLE(1, 0, 3, 2)));
+				Keys = _mm512_max_epi32(Keys, _mm512_shuffle_epi32(Keys, (_MM_PERM_ENUM)_MM_SHUFFLE(2, 3, 0, 1)));
+			}
+			else
+			{
+				Keys = _mm512_min_epi32(Keys, _mm512_shuffle_i32x4(Keys, Keys, _MM_SHUFFLE(2, 3, 0, 1)));
+				Keys = _mm512_min_epi32(Keys, _mm512_shuffle_epi32(Keys, (_MM_PERM_ENUM)_MM_SHUFFLE(1, 0, 3, 2)));
+				Keys = _mm512_min_epi32(Keys, _mm512_shuffle_epi32(Keys, (_MM_PERM_ENUM)_MM_SHUFFLE(2, 3, 0, 1)));
+			}
+
+			alignas(64) int32_t Lanes[16];
+			_mm512_store_si512(Lanes, Keys);
+
+			Destination[i] = FinishMinMax(Lanes[0], IgnoredKey);
+			Destination[i + 1] = FinishMinMax(Lanes[8], IgnoredKey);
+		}
+	}
+
+	if (i < PixelCount)
+		ResolveRowScalar<CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT, 8, Mode>(Samples, Destination + i, PixelCount - i);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+static bool CPUSupportsAVX2()
+{
+#if defined(_MSC_VER)
+	int Registers[4];
+	__cpuid(Registers, 1);
+	const bool OSXSAVE = (Registers[2] & (1 << 27)) != 0;
+	const bool AVX = (Registers[2] & (1 << 28)) != 0;
+
+	if (!OSXSAVE || !AVX || (_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	__cpuidex(Registers, 7, 0);
+	return (Registers[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static bool CPUSupportsAVX512()
+{
+#if defined(_MSC_VER)
+	if (!CPUSupportsAVX2() || (_xgetbv(0) & 0xE6) != 0xE6)
+		return false;
+
+	int Registers[4];
+	__cpuidex(Registers, 7, 0);
+	return (Registers[1] & (1 << 16)) != 0;
+#else
+	return __builtin_cpu_supports("avx512f");
+#endif
+}
+
+#elif defined(CPU_RESOLVE_NEON)
+
+static inline int32x4_t DepthKeysNEON(uint32x4_t Bits, int32x4_t Ignored)
+{
+	const uint32x4_t Magnitude = vdupq_n_u32(0x7FFFFFFF);
+	const uint32x4_t Infinity = vdupq_n_u32(0x7F800000);
+
+	int32x4_t SignedBits = vreinterpretq_s32_u32(Bits);
+	int32x4_t Keys = veorq_s32(SignedBits, vandq_s32(vshrq_n_s32(SignedBits, 31), vreinterpretq_s32_u32(Magnitude)));
+	uint32x4_t IsNaN = vcgtq_u32(vandq_u32(Bits, Magnitude), Infinity);
+
+	return vbslq_s32(IsNaN, Ignored, Keys);
+}
+
+// vld2q deinterleaves depth and stencil dwords: val[0] holds samples 0..3, the second load samples 4..7
+template <CPUResolveMode Mode>
+static void ResolveRowNEON(const void* SampleData, float* Destination, uint32_t PixelCount)
+{
+	const CPUDepthStencilSample* Samples = static_cast<const CPUDepthStencilSample*>(SampleData);
+	const int32_t IgnoredKey = Mode == CPU_RESOLVE_MODE_MAX ? INT32_MIN : INT32_MAX;
+	const int32x4_t Ignored = vdupq_n_s32(IgnoredKey);
+
+	for (uint32_t i = 0; i < PixelCount; ++i, Samples += 8)
+	{
+		uint32x4x2_t Low = vld2q_u32(reinterpret_cast<const uint32_t*>(Samples));
+		uint32x4x2_t High = vld2q_u32(reinterpret_cast<const uint32_t*>(Samples + 4));
+
+		if constexpr (Mode == CPU_RESOLVE_MODE_AVERAGE)
+		{
+			float32x4_t Sums = vaddq_f32(vreinterpretq_f32_u32(Low.val[0]), vreinterpretq_f32_u32(High.val[0]));
+			float32x2_t Sums2 = vadd_f32(vget_low_f32(Sums), vget_high_f32(Sums));
+
+			Destination[i] = FinishAverage(vpadds_f32(Sums2) * 0.125f);
+		}
+		else
+		{
+			int32x4_t KeysLow = DepthKeysNEON(Low.val[0], Ignored);
+			int32x4_t KeysHigh = DepthKeysNEON(High.val[0], Ignored);
+
+			if constexpr (Mode == CPU_RESOLVE_MODE_MAX)
+				Destination[i] = FinishMinMax(vmaxvq_s32(vmaxq_s32(KeysLow, KeysHigh)), IgnoredKey);
+			else
+				Destination[i] = FinishMinMax(vminvq_s32(vminq_s32(KeysLow, KeysHigh)), IgnoredKey);
+		}
+	}
+}
+
+static void ClassifyRowNEON(const float* Depth, uint32_t* Colors, uint32_t PixelCount, uint64_t* Counts, int32_t& FirstCovered, int32_t& LastCovered)
+{
+	const float32x4_t Zero = vdupq_n_f32(0.0f);
+	const float32x4_t One = vdupq_n_f32(1.0f);
+	const uint32x4_t Red = vdupq_n_u32(0x000000FF);
+	const uint32x4_t Green = vdupq_n_u32(0x0000FF00);
+	const uint32x4_t Blue = vdupq_n_u32(0x00FF0000);
+	const uint32x4_t Alpha = vdupq_n_u32(0xFF000000);
+	const uint32x4_t LaneBits = { 1, 2, 4, 8 };
+
+	uint32_t ZeroCount = 0;
+	uint32_t OneCount = 0;
+	uint32_t BetweenCount = 0;
+	uint32_t i = 0;
+
+	FirstCovered = -1;
+	LastCovered = -1;
+
+	for (; i + 4 <= PixelCount; i += 4)
+	{
+		const float32x4_t Depths = vld1q_f32(Depth + i);
+		const uint32x4_t IsZero = vceqq_f32(Depths, Zero);
+		const uint32x4_t IsOne = vceqq_f32(Depths, One);
+		const uint32x4_t IsBetween = vandq_u32(vcgtq_f32(Depths, Zero), vcltq_f32(Depths, One));
+
+		if (Colors)
+			vst1q_u32(Colors + i, vorrq_u32(vorrq_u32(Alpha, vandq_u32(IsZero, Red)), vorrq_u32(vandq_u32(IsOne, Green), vandq_u32(IsBetween, Blue))));
+
+		// Mask lanes are all ones, shifting right by 31 leaves 1 per set lane
+		ZeroCount += vaddvq_u32(vshrq_n_u32(IsZero, 31));
+		OneCount += vaddvq_u32(vshrq_n_u32(IsOne, 31));
+		BetweenCount += vaddvq_u32(vshrq_n_u32(IsBetween, 31));
+
+		AddCoveredLanes(vaddvq_u32(vbicq_u32(LaneBits, IsOne)), i, FirstCovered, LastCovered);
+	}
+
+	Counts[CPU_DEPTH_CLASS_ZERO] += ZeroCount;
+	Counts[CPU_DEPTH_CLASS_ONE] += OneCount;
+	Counts[CPU_DEPTH_CLASS_BETWEEN] += BetweenCount;
+	Counts[CPU_DEPTH_CLASS_OTHER] += i - ZeroCount - OneCount - BetweenCount;
+
+	if (i < PixelCount)
+	{
+		int32_t TailFirst;
+		int32_t TailLast;
+		ClassifyRowScalar(Depth + i, Colors ? Colors + i : nullptr, PixelCount - i, Counts, TailFirst, TailLast);
+
+		if (TailLast >= 0)
+		{
+			FirstCovered = FirstCovered < 0 ? static_cast<int32_t>(i) + TailFirst : FirstCovered;
+			LastCovered = static_cast<int32_t>(i) + TailLast;
+		}
+	}
+}
+
+#endif
+
+static const CPUResolveKernels ScalarKernels = { CPU_RESOLVE_ISA_SCALAR, "Scalar", { ResolveRowScalar<CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT, 8, CPU_RESOLVE_MODE_MIN>, ResolveRowScalar<CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT, 8, CPU_RESOLVE_MODE_MAX>, ResolveRowScalar<CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT, 8, CPU_RESOLVE_MODE_AVERAGE> }, ClassifyRowScalar };
+
+#if defined(CPU_RESOLVE_X86)
+static const CPUResolveKernels AVX2Kernels = { CPU_RESOLVE_ISA_AVX2, "AVX2", { ResolveRowAVX2<CPU_RESOLVE_MODE_MIN>, ResolveRowAVX2<CPU_RESOLVE_MODE_MAX>, ResolveRowAVX2<CPU_RESOLVE_MODE_AVERAGE> }, ClassifyRowAVX2 };
+// The classification streams through memory, wider registers than AVX2 gain nothing
+static const CPUResolveKernels AVX512Kernels = { CPU_RESOLVE_ISA_AVX512, "AVX-512", { ResolveRowAVX512<CPU_RESOLVE_MODE_MIN>, ResolveRowAVX512<CPU_RESOLVE_MODE_MAX>, ResolveRowAVX512<CPU_RESOLVE_MODE_AVERAGE> }, ClassifyRowAVX2 };
+#elif defined(CPU_RESOLVE_NEON)
+static const CPUResolveKernels NEONKernels = { CPU_RESOLVE_ISA_NEON, "NEON", { ResolveRowNEON<CPU_RESOLVE_MODE_MIN>, ResolveRowNEON<CPU_RESOLVE_MODE_MAX>, ResolveRowNEON<CPU_RESOLVE_MODE_AVERAGE> }, ClassifyRowNEON };
+#endif
+
+const CPUResolveKernels* GetCPUResolveKernels8x(CPUResolveISA ISA)
+{
+	switch (ISA)
+	{
+		case CPU_RESOLVE_ISA_SCALAR:
+			return &ScalarKernels;
+#if defined(CPU_RESOLVE_X86)
+		case CPU_RESOLVE_ISA_AVX2:
+			return CPUSupportsAVX2() ? &AVX2Kernels : nullptr;
+		case CPU_RESOLVE_ISA_AVX512:
+			return CPUSupportsAVX512() ? &AVX512Kernels : nullptr;
+#elif defined(CPU_RESOLVE_NEON)
+		case CPU_RESOLVE_ISA_NEON:
+			return &NEONKernels;
+#endif
+		default:
+			return nullptr;
+	}
+}
+
+const CPUResolveKernels& GetBestCPUResolveKernels8x()
+{
+	static const CPUResolveKernels* BestKernels = []
+	{
+		for (CPUResolveISA ISA : { CPU_RESOLVE_ISA_AVX512, CPU_RESOLVE_ISA_AVX2, CPU_RESOLVE_ISA_NEON })
+			if (const CPUResolveKernels* Kernels = GetCPUResolveKernels8x(ISA))
+				return Kernels;
+
+		return &ScalarKernels;
+	}();
+
+	return *BestKernels;
+}
+
+#define CPU_RESOLVE_ROW_MODES(Format, SampleCount) { ResolveRowScalar<Format, SampleCount, CPU_RESOLVE_MODE_MIN>, ResolveRowScalar<Format, SampleCount, CPU_RESOLVE_MODE_MAX>, ResolveRowScalar<Format, SampleCount, CPU_RESOLVE_MODE_AVERAGE> }
+#define CPU_RESOLVE_ROW_SAMPLE_COUNTS(Format) { CPU_RESOLVE_ROW_MODES(Format, 1), CPU_RESOLVE_ROW_MODES(Format, 2), CPU_RESOLVE_ROW_MODES(Format, 4), CPU_RESOLVE_ROW_MODES(Format, 8), CPU_RESOLVE_ROW_MODES(Format, 16) }
+
+// Indexed by format, log2 of the sample count and mode
+static const CPUResolveRowFunc SpecializedRowKernels[CPU_DEPTH_FORMAT_COUNT][5][3] =
+{
+	CPU_RESOLVE_ROW_SAMPLE_COUNTS(CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT),
+	CPU_RESOLVE_ROW_SAMPLE_COUNTS(CPU_DEPTH_FORMAT_D32_FLOAT),
+	CPU_RESOLVE_ROW_SAMPLE_COUNTS(CPU_DEPTH_FORMAT_D24_UNORM_S8_UINT),
+	CPU_RESOLVE_ROW_SAMPLE_COUNTS(CPU_DEPTH_FORMAT_D16_UNORM)
+};
+
+CPUResolveRowFunc GetCPUResolveRowKernel(CPUDepthFormat Format, uint32_t SampleCount, CPUResolveMode Mode)
+{
+	if (Format == CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT && SampleCount == 8)
+		return GetBestCPUResolveKernels8x().Resolve[Mode];
+
+	if (Format >= CPU_DEPTH_FORMAT_COUNT || SampleCount == 0 || SampleCount > 16 || (SampleCount & (SampleCount - 1)) != 0)
+		return nullptr;
+
+	return SpecializedRowKernels[Format][std::countr_zero(SampleCount)][Mode];
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+#include "CPUResolve.h"
+#include "CPUDepthClassification.h"
+
+// Instruction sets the 8x depth resolve kernels and the depth classification are specialized for
+enum CPUResolveISA
+{
+	CPU_RESOLVE_ISA_SCALAR,
+	CPU_RESOLVE_ISA_AVX2,
+	CPU_RESOLVE_ISA_AVX512,
+	CPU_RESOLVE_ISA_NEON
+};
+
+// Resolves PixelCount consecutive pixels of the format and sample count the kernel is for into PixelCount floats
+typedef void (*CPUResolveRowFunc)(const void* Samples, float* Destination, uint32_t PixelCount);
+
+// Classifies PixelCount depths with CPUGetDepthClass, writes their colors unless Colors is nullptr and adds to
+// Counts[CPU_DEPTH_CLASS_COUNT]. FirstCovered and LastCovered get the first and last index not at 1.0, -1 for none.
+typedef void (*CPUClassifyRowFunc)(const float* Depth, uint32_t* Colors, uint32_t PixelCount, uint64_t* Counts, int32_t& FirstCovered, int32_t& LastCovered);
+
+struct CPUResolveKernels
+{
+	CPUResolveISA ISA;
+	const char* Name;
+	CPUResolveRowFunc Resolve[3]; // 8x D32_FLOAT_S8X24_UINT, indexed by CPUResolveMode
+	CPUClassifyRowFunc Classify;
+};
+
+// Kernels for a specific instruction set, nullptr when the CPU or the build lacks it.
+// Every kernel set returns the same bits as the scalar one, ResolveDepthSamples().
+const CPUResolveKernels* GetCPUResolveKernels8x(CPUResolveISA ISA);
+
+// Fastest kernel set supported by the running CPU, detected once
+const CPUResolveKernels& GetBestCPUResolveKernels8x();
+
+// Row kernel for a surface: the fastest 8x kernels for 8x D32_FLOAT_S8X24_UINT, else the scalar kernel specialized for
+// Format, SampleCount and Mode. nullptr for sample counts that are not a power of two up to 16.
+CPUResolveRowFunc GetCPUResolveRowKernel(CPUDepthFormat Format, uint32_t SampleCount, CPUResolveMode Mode);
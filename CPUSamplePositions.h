@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+
+// Sample offset from the pixel center in 1/16 pixel units, same encoding as D3D12_SAMPLE_POSITION
+struct CPUSamplePosition
+{
+	int8_t X;
+	int8_t Y;
+};
+
+constexpr uint32_t CPUMaxSampleCount = 16;
+
+// D3D standard multisample patterns (D3D11_STANDARD_MULTISAMPLE_PATTERN), nullptr for unsupported counts
+inline const CPUSamplePosition* GetStandardSamplePositions(uint32_t SampleCount)
+{
+	static const CPUSamplePosition Positions1x[] = { { 0, 0 } };
+	static const CPUSamplePosition Positions2x[] = { { 4, 4 }, { -4, -4 } };
+	static const CPUSamplePosition Positions4x[] = { { -2, -6 }, { 6, -2 }, { -6, 2 }, { 2, 6 } };
+	static const CPUSamplePosition Positions8x[] = { { 1, -3 }, { -1, 3 }, { 5, 1 }, { -3, -5 }, { -5, 5 }, { -7, -1 }, { 3, 7 }, { 7, -7 } };
+	static const CPUSamplePosition Positions16x[] =
+	{
+		{ 1, 1 }, { -1, -3 }, { -3, 2 }, { 4, -1 }, { -5, -2 }, { 2, 5 }, { 5, 3 }, { 3, -5 },
+		{ -2, 6 }, { 0, -7 }, { -4, -6 }, { -6, 4 }, { -8, 0 }, { 7, -4 }, { 6, 7 }, { -7, -8 }
+	};
+
+	switch (SampleCount)
+	{
+		case 1:
+			return Positions1x;
+		case 2:
+			return Positions2x;
+		case 4:
+			return Positions4x;
+		case 8:
+			return Positions8x;
+		case 16:
+			return Positions16x;
+		default:
+			return nullptr;
+	}
+}
+
+// Sample positions set with SetSamplePositions: PixelCount is 1 for a pattern shared by every pixel (Tier 1)
+// or 4 for a pattern repeating over 2x2 pixel quads (Tier 2). Quad pixels are ordered (0,0), (1,0), (0,1), (1,1),
+// and the positions of quad pixel p start at Positions[p * SampleCount].
+struct CPUSamplePattern
+{
+	uint32_t SampleCount = 0;
+	uint32_t PixelCount = 0;
+	CPUSamplePosition Positions[4 * CPUMaxSampleCount];
+
+	uint32_t GetQuadPixel(uint32_t X, uint32_t Y) const
+	{
+		return PixelCount == 4 ? (Y & 1) * 2 + (X & 1) : 0;
+	}
+
+	const CPUSamplePosition* GetPixelPositions(uint32_t QuadPixel) const
+	{
+		return &Positions[QuadPixel * SampleCount];
+	}
+};
+
+// Checks the SetSamplePositions rules: 1 or 4 pixels, a sample count with a standard pattern, offsets in [-8, 7]
+inline bool MakeSamplePattern(uint32_t NumSamplesPerPixel, uint32_t NumPixels, const CPUSamplePosition* Positions, CPUSamplePattern& Pattern)
+{
+	if ((NumPixels != 1 && NumPixels != 4) || !GetStandardSamplePositions(NumSamplesPerPixel) || !Positions)
+		return false;
+
+	for (uint32_t i = 0; i < NumSamplesPerPixel * NumPixels; ++i)
+		if (Positions[i].X < -8 || Positions[i].X > 7 || Positions[i].Y < -8 || Positions[i].Y > 7)
+			return false;
+
+	Pattern.SampleCount = NumSamplesPerPixel;
+	Pattern.PixelCount = NumPixels;
+
+	for (uint32_t i = 0; i < NumSamplesPerPixel * NumPixels; ++i)
+		Pattern.Positions[i] = Positions[i];
+
+	return true;
+}
+
+inline CPUSamplePattern GetStandardSamplePattern(uint32_t SampleCount)
+{
+	CPUSamplePattern Pattern;
+	MakeSamplePattern(SampleCount, 1, GetStandardSamplePositions(SampleCount), Pattern);
+	return Pattern;
+}
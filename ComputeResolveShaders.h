@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+
+// Root constants of ResolveCS and ResolveVisualizeCS, laid out like the ResolveConstants cbuffer below
+struct ComputeResolveShaderConstants
+{
+	uint32_t ResolveMode; // D3D12_RESOLVE_MODE_MIN, _MAX or _AVERAGE
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t Padding;
+};
+
+constexpr uint32_t ComputeResolveGroupSize = 8;
+
+// Compute replacement of ResolveSubresourceRegion, one thread per pixel reading the samples through a Texture2DMS
+// SRV. ResolveCS writes the resolved depth for the full screen quad to read, ResolveVisualizeCS classifies it like
+// FSQuadPixelShaderSource and writes the color to the back buffer, so the resolved depth never goes to memory. The
+// reduction is the CPU reference one: MIN and MAX skip NaN samples, AVERAGE sums pairwise and scales by 1/N.
+constexpr auto ComputeResolveShaderSource = R"(
+Texture2DMS<float> DepthBuffer : register(t0);
+RWTexture2D<float> ResolvedDepth : register(u0);
+RWTexture2D<unorm float4> Visualization : register(u1);
+
+cbuffer ResolveConstants : register(b0)
+{
+	uint ResolveMode;
+	uint2 Size;
+};
+
+float ResolvePixel(uint2 Position)
+{
+	uint Width, Height, SampleCount;
+	DepthBuffer.GetDimensions(Width, Height, SampleCount);
+
+	float Depths[16];
+
+	for (uint s = 0; s < SampleCount; ++s)
+		Depths[s] = DepthBuffer.Load(Position, s);
+
+	if (ResolveMode == 3)
+	{
+		for (uint Half = SampleCount / 2; Half > 0; Half /= 2)
+		{
+			for (uint i = 0; i < Half; ++i)
+				Depths[i] += Depths[i + Half];
+		}
+
+		return Depths[0] * (1.0f / SampleCount);
+	}
+
+	float Result = Depths[0];
+
+	for (uint i = 1; i < SampleCount; ++i)
+		Result = ResolveMode == 2 ? max(Result, Depths[i]) : min(Result, Depths[i]);
+
+	return Result;
+}
+
+[numthreads(8, 8, 1)]
+void ResolveCS(uint3 Position : SV_DispatchThreadID)
+{
+	if (all(Position.xy < Size))
+		ResolvedDepth[Position.xy] = ResolvePixel(Position.xy);
+}
+
+[numthreads(8, 8, 1)]
+void ResolveVisualizeCS(uint3 Position : SV_DispatchThreadID)
+{
+	if (all(Position.xy < Size))
+	{
+		const float PixelDepth = ResolvePixel(Position.xy);
+		Visualization[Position.xy] = float4(PixelDepth == 0.0f ? 1.0f : 0.0f, PixelDepth == 1.0f ? 1.0f : 0.0f, (PixelDepth > 0.0f) && (PixelDepth < 1.0f) ? 1.0f : 0.0f, 1.0f);
+	}
+}
+)";
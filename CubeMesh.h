@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+#include "CPUMath.h"
+
+// The cube drawn by the depth pass, shared by the D3D12 upload code and the CPU rasterizer
+
+constexpr uint32_t CubeVertexCount = 8;
+constexpr uint32_t CubeIndexCount = 36;
+
+constexpr CPUFloat3 CubeVertices[CubeVertexCount] =
+{
+	{ 1.0f, 1.0f, 1.0f },
+	{ -1.0f, 1.0f, 1.0f },
+	{ 1.0f, -1.0f, 1.0f },
+	{ -1.0f, -1.0f, 1.0f },
+	{ 1.0f, 1.0f, -1.0f },
+	{ -1.0f, 1.0f, -1.0f },
+	{ 1.0f, -1.0f, -1.0f },
+	{ -1.0f, -1.0f, -1.0f }
+};
+
+constexpr uint16_t CubeIndices[CubeIndexCount] =
+{
+	5, 4, 7, 7, 4, 6,
+	0, 1, 2, 2, 1, 3,
+	4, 0, 6, 6, 0, 2,
+	1, 5, 3, 3, 5, 7,
+	1, 0, 5, 5, 0, 4,
+	2, 3, 6, 6, 3, 7
+};
+
+// World matrix of the cube, the same values DirectXMath builds for these parameters
+inline CPUMatrix GetCubeWorldMatrix()
+{
+	return CPUMatrixRotationRollPitchYaw(3.14f / 4, 0.0f, 3.14f / 4);
+}
+
+// Camera at (0, 0, -2.5) looking down +Z with a 90 degree vertical field of view, Aspect is width over height
+inline CPUMatrix GetCubeViewProjectionMatrix(float Aspect)
+{
+	CPUMatrix ViewMatrix = CPUMatrixLookToLH({ 0.0f, 0.0f, -2.5f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f });
+	CPUMatrix ProjMatrix = CPUMatrixPerspectiveFovLH(3.14f / 2, Aspect, 0.01f, 1000.0f);
+
+	return CPUMatrixMultiply(ViewMatrix, ProjMatrix);
+}
@@ -0,0 +1,1362 @@
+#include "D3D12RenderBackend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <cstdio>
+
+#include <d3dcompiler.h>
+
+#include "DXHelpers.h"
+#include "Profiler.h"
+
+using namespace Microsoft::WRL;
+
+static_assert(sizeof(RenderRect) == sizeof(D3D12_RECT));
+
+constexpr UINT ShaderCompileFlags = D3DCOMPILE_PACK_MATRIX_ROW_MAJOR;
+constexpr const D3D_SHADER_MACRO* ShaderDefines = nullptr;
+
+
+// N of Name=N on the command line, Default when it is not there
+static uint32_t GetCommandLineValue(const std::string& CommandLine, const char* Name, uint32_t Default)
+{
+	const size_t Index = CommandLine.find(Name);
+
+	if (Index == -1)
+		return Default;
+
+	uint32_t Value = Default;
+	sscanf_s(CommandLine.c_str() + Index + strlen(Name), "%u", &Value);
+
+	return Value;
+}
+
+// Runs on the ShaderCompiler threads
+static ShaderCompileResult CompileShaderWithD3D(const ShaderCompileRequest& Request)
+{
+	ComPtr<ID3DBlob> ShaderByteCodeBlob;
+	ComPtr<ID3DBlob> ErrorBlob;
+	HRESULT hr = D3DCompile(Request.Source.data(), Request.Source.size(), Request.Name.c_str(), ShaderDefines, nullptr, Request.EntryPoint.c_str(), Request.Model.c_str(), ShaderCompileFlags, 0, &ShaderByteCodeBlob, &ErrorBlob);
+
+	ShaderCompileResult Result;
+	Result.Succeeded = SUCCEEDED(hr);
+
+	if (ErrorBlob)
+		Result.Log = static_cast<const char*>(ErrorBlob->GetBufferPointer());
+	else if (!Result.Succeeded)
+		Result.Log = "error: D3DCompile failed with " + std::to_string(static_cast<uint32_t>(hr));
+
+	if (Result.Succeeded)
+	{
+		const uint8_t* ByteCode = static_cast<const uint8_t*>(ShaderByteCodeBlob->GetBufferPointer());
+		Result.Bytecode.assign(ByteCode, ByteCode + ShaderByteCodeBlob->GetBufferSize());
+	}
+
+	return Result;
+}
+
+static DescriptorHeapLayout CreateDescriptorHeap(ID3D12Device* Device, D3D12_DESCRIPTOR_HEAP_TYPE Type, uint32_t Count, bool ShaderVisible, ComPtr<ID3D12DescriptorHeap>& Heap)
+{
+	D3D12_DESCRIPTOR_HEAP_DESC DescriptorHeapDesc;
+	DescriptorHeapDesc.Flags = ShaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	DescriptorHeapDesc.NodeMask = 0;
+	DescriptorHeapDesc.NumDescriptors = Count;
+	DescriptorHeapDesc.Type = Type;
+
+	SAFE_DX(Device->CreateDescriptorHeap(&DescriptorHeapDesc, IID_PPV_ARGS(Heap.ReleaseAndGetAddressOf())));
+
+	DescriptorHeapLayout Layout;
+	Layout.CPUStart = Heap->GetCPUDescriptorHandleForHeapStart().ptr;
+	Layout.GPUStart = ShaderVisible ? Heap->GetGPUDescriptorHandleForHeapStart().ptr : 0;
+	Layout.IncrementSize = Device->GetDescriptorHandleIncrementSize(Type);
+
+	return Layout;
+}
+
+D3D12FrameFence::~D3D12FrameFence()
+{
+	if (Event)
+		CloseHandle(Event);
+}
+
+void D3D12FrameFence::Initialize(ID3D12Device* Device, ID3D12CommandQueue* CommandQueue)
+{
+	this->CommandQueue = CommandQueue;
+
+	SAFE_DX(Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(Fence.ReleaseAndGetAddressOf())));
+
+	Event = CreateEvent(nullptr, FALSE, FALSE, L"FrameEvent");
+}
+
+void D3D12FrameFence::Signal(uint64_t Value)
+{
+	SAFE_DX(CommandQueue->Signal(Fence.Get(), Value));
+}
+
+void D3D12FrameFence::Wait(uint64_t Value)
+{
+	if (Fence->GetCompletedValue() >= Value)
+		return;
+
+	SAFE_DX(Fence->SetEventOnCompletion(Value, Event));
+	WaitForSingleObject(Event, INFINITE);
+}
+
+D3D12RenderBackend::D3D12RenderBackend(HWND Window, uint32_t Width, uint32_t Height, const std::string& CommandLine)
+	: Width(Width), Height(Height), Scheduler(Fence, GetCommandLineValue(CommandLine, "-framesinflight=", 2)), ShaderCompiler(CompileShaderWithD3D, GetCommandLineValue(CommandLine, "-shaderthreads=", 0))
+{
+	bool DebugMode = CommandLine.find("-dxdebug") != -1;
+
+	SAFE_DX(CreateDXGIFactory2(DebugMode ? DXGI_CREATE_FACTORY_DEBUG : 0, IID_PPV_ARGS(Factory.ReleaseAndGetAddressOf())));
+
+	ComPtr<IDXGIAdapter> Adapter;
+
+	if (size_t Index = CommandLine.find("-adapterindex"); Index != -1)
+	{
+		int AdapterIndex = 0;
+		auto AdapterIndexStr = CommandLine.substr(Index, CommandLine.find(' ', Index));
+
+		sscanf_s(AdapterIndexStr.c_str(), "-adapterindex=%d", &AdapterIndex);
+
+		SAFE_DX(Factory->EnumAdapters(AdapterIndex, &Adapter));
+	}
+	else if (size_t Index = CommandLine.find("-adaptervendor"); Index != -1)
+	{
+		auto AdapterVendorStr = CommandLine.substr(Index, CommandLine.find(' ', Index));
+
+		char AdapterVendor[512];
+		wchar_t wAdapterVendor[512];
+
+		sscanf_s(AdapterVendorStr.c_str(), "-adaptervendor=%s", AdapterVendor, 512);
+
+		for (int i = 0; i <= strlen(AdapterVendor); ++i)
+			wAdapterVendor[i] = (wchar_t)AdapterVendor[i];
+
+		int AdapterIndex = 0;
+
+		while (Factory->EnumAdapters(AdapterIndex, (IDXGIAdapter**)&Adapter) != DXGI_ERROR_NOT_FOUND)
+		{
+			DXGI_ADAPTER_DESC AdapterDesc;
+			SAFE_DX(Adapter->GetDesc(&AdapterDesc));
+
+			if (std::wstring(AdapterDesc.Description).find(wAdapterVendor) != -1) break;
+
+			++AdapterIndex;
+		}
+
+		if (Factory->EnumAdapters(AdapterIndex, (IDXGIAdapter**)&Adapter) == DXGI_ERROR_NOT_FOUND)
+		{
+			std::wcout << L"Не найдено графического адаптера с заданным производителем" << std::endl;
+			ExitProcess(-1);
+		}
+	}
+	else
+	{
+		SAFE_DX(Factory->EnumAdapters(0, &Adapter));
+	}
+
+	DXGI_ADAPTER_DESC AdapterDesc;
+	SAFE_DX(Adapter->GetDesc(&AdapterDesc));
+	std::wcout << AdapterDesc.Description << std::endl;
+
+	if (DebugMode)
+	{
+		ComPtr<ID3D12Debug1> DebugInterface;
+		SAFE_DX(D3D12GetDebugInterface(IID_PPV_ARGS(&DebugInterface)));
+		DebugInterface->EnableDebugLayer();
+		DebugInterface->SetEnableGPUBasedValidation(true);
+	}
+
+	SAFE_DX(D3D12CreateDevice(Adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(Device.ReleaseAndGetAddressOf())));
+
+	// Pipeline state blobs are only valid for the adapter and driver that wrote them
+	if (CommandLine.find("-nopipelinecache") == -1)
+	{
+		LARGE_INTEGER DriverVersion{};
+		Adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &DriverVersion);
+
+		PipelineCacheHasher DeviceHasher;
+		DeviceHasher.AddValue(AdapterDesc.VendorId);
+		DeviceHasher.AddValue(AdapterDesc.DeviceId);
+		DeviceHasher.AddValue(AdapterDesc.SubSysId);
+		DeviceHasher.AddValue(AdapterDesc.Revision);
+		DeviceHasher.AddValue(DriverVersion.QuadPart);
+
+		Cache.Load("PipelineCache.bin", DeviceHasher.GetHash());
+	}
+
+	D3D12_FEATURE_DATA_D3D12_OPTIONS2 FeatureOptions{};
+	SAFE_DX(Device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS2, &FeatureOptions, sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS2)));
+
+	if (FeatureOptions.ProgrammableSamplePositionsTier == D3D12_PROGRAMMABLE_SAMPLE_POSITIONS_TIER_NOT_SUPPORTED)
+		std::wcout << L"D3D12_PROGRAMMABLE_SAMPLE_POSITIONS_TIER_NOT_SUPPORTED" << std::endl;
+	else if (FeatureOptions.ProgrammableSamplePositionsTier == D3D12_PROGRAMMABLE_SAMPLE_POSITIONS_TIER_1)
+		std::wcout << L"D3D12_PROGRAMMABLE_SAMPLE_POSITIONS_TIER_1" << std::endl;
+	else if (FeatureOptions.ProgrammableSamplePositionsTier == D3D12_PROGRAMMABLE_SAMPLE_POSITIONS_TIER_2)
+		std::wcout << L"D3D12_PROGRAMMABLE_SAMPLE_POSITIONS_TIER_2" << std::endl;
+
+	D3D12_COMMAND_QUEUE_DESC CommandQueueDesc{};
+	CommandQueueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	CommandQueueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+
+	SAFE_DX(Device->CreateCommandQueue(&CommandQueueDesc, IID_PPV_ARGS(CommandQueue.ReleaseAndGetAddressOf())));
+
+	const uint32_t FramesInFlight = Scheduler.GetFramesInFlight();
+
+	for (uint32_t i = 0; i < FramesInFlight; ++i)
+		SAFE_DX(Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(CommandAllocators[i].ReleaseAndGetAddressOf())));
+
+	CommandList.Backend = this;
+
+	SAFE_DX(Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, CommandAllocators[0].Get(), nullptr, IID_PPV_ARGS(CommandList.CommandList.ReleaseAndGetAddressOf())));
+	SAFE_DX(CommandList.CommandList->Close());
+
+	SAFE_DX(CommandList.CommandList->QueryInterface<ID3D12GraphicsCommandList1>(CommandList.CommandList1.ReleaseAndGetAddressOf()));
+
+	DXGI_SWAP_CHAIN_DESC1 SwapChainDesc{};
+	SwapChainDesc.BufferCount = FramesInFlight;
+	SwapChainDesc.Width = Width;
+	SwapChainDesc.Height = Height;
+	SwapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	// The fused compute resolve writes the back buffer through an R8G8B8A8_UNORM UAV
+	SwapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT | DXGI_USAGE_UNORDERED_ACCESS;
+	SwapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+	SwapChainDesc.SampleDesc.Count = 1;
+	SwapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+
+	DXGI_SWAP_CHAIN_FULLSCREEN_DESC fsChainDesc{};
+	fsChainDesc.Windowed = TRUE;
+
+	ComPtr<IDXGISwapChain1> swapChain1;
+	SAFE_DX(Factory->CreateSwapChainForHwnd(CommandQueue.Get(), Window, &SwapChainDesc, &fsChainDesc, nullptr, swapChain1.GetAddressOf()));
+	SAFE_DX(swapChain1.As(&SwapChain));
+
+	// The window goes fullscreen borderless, DXGI's exclusive fullscreen on Alt+Enter would fight it
+	SAFE_DX(Factory->MakeWindowAssociation(Window, DXGI_MWA_NO_ALT_ENTER));
+
+	// The CPU waits on the swap chain before recording, so it never runs more presents ahead than the latency allows
+	ComPtr<IDXGISwapChain2> SwapChain2;
+	SAFE_DX(SwapChain.As(&SwapChain2));
+	SAFE_DX(SwapChain2->SetMaximumFrameLatency(GetCommandLineValue(CommandLine, "-framelatency=", FramesInFlight)));
+	FrameLatencyWaitableObject = SwapChain2->GetFrameLatencyWaitableObject();
+
+	SyncInterval = CommandLine.find("-novsync") != -1 ? 0 : 1;
+
+	Fence.Initialize(Device.Get(), CommandQueue.Get());
+
+	const DescriptorHeapLayout RTVLayout = CreateDescriptorHeap(Device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, MaxRenderTargetViews, false, RTDescriptorHeap);
+	const DescriptorHeapLayout DSVLayout = CreateDescriptorHeap(Device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, MaxDepthStencilViews, false, DSDescriptorHeap);
+	const DescriptorHeapLayout ShaderViewLayout = CreateDescriptorHeap(Device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, RenderMaxViews, false, CBSRUADescriptorHeap);
+	const DescriptorHeapLayout StagingLayout = CreateDescriptorHeap(Device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, MaxStagedShaderViews, true, CBSRUAStagingHeap);
+
+	RTVDescriptors.SetLayouts(RTVLayout, {});
+	DSVDescriptors.SetLayouts(DSVLayout, {});
+	ShaderViewDescriptors.SetLayouts(ShaderViewLayout, StagingLayout);
+
+	D3D12_RENDER_TARGET_VIEW_DESC RTVDesc{};
+	RTVDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+	RTVDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D;
+
+	for (UINT i = 0; i < FramesInFlight; ++i)
+	{
+		Resource BackBuffer;
+		SAFE_DX(SwapChain->GetBuffer(i, IID_PPV_ARGS(BackBuffer.Object.GetAddressOf())));
+
+		BackBuffer.RTVIndex = AllocateDescriptor(RTVDescriptors, "render target");
+		BackBuffer.RTV.ptr = RTVDescriptors.GetPersistentHandle(BackBuffer.RTVIndex);
+		Device->CreateRenderTargetView(BackBuffer.Object.Get(), &RTVDesc, BackBuffer.RTV);
+
+		BackBuffers[i] = AddResource(std::move(BackBuffer));
+	}
+
+	CurrentBackBufferIndex = SwapChain->GetCurrentBackBufferIndex();
+}
+
+D3D12RenderBackend::~D3D12RenderBackend()
+{
+	WaitIdle();
+	CloseHandle(FrameLatencyWaitableObject);
+
+	SavePipelineCache();
+}
+
+void D3D12RenderBackend::SavePipelineCache()
+{
+	if (!Cache.Save())
+		std::wcout << L"D3D12RenderBackend: could not write the pipeline cache" << std::endl;
+}
+
+RenderResource D3D12RenderBackend::AddResource(Resource&& NewResource)
+{
+	Resources.push_back(std::move(NewResource));
+	return static_cast<RenderResource>(Resources.size());
+}
+
+uint32_t D3D12RenderBackend::AllocateDescriptor(DescriptorAllocator& Allocator, const char* Kind)
+{
+	const uint32_t Index = Allocator.AllocatePersistent();
+
+	if (Index == DescriptorAllocator::InvalidIndex)
+	{
+		std::wcout << L"D3D12RenderBackend: out of " << Kind << L" descriptors" << std::endl;
+		ExitProcess(-1);
+	}
+
+	return Index;
+}
+
+RenderView D3D12RenderBackend::AllocateShaderView()
+{
+	return AllocateDescriptor(ShaderViewDescriptors, "shader view") + 1;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE D3D12RenderBackend::GetShaderViewHandle(RenderView View) const
+{
+	return D3D12_CPU_DESCRIPTOR_HANDLE{ ShaderViewDescriptors.GetPersistentHandle(View - 1) };
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE D3D12RenderBackend::StageShaderViews(RenderView FirstView, uint32_t Count)
+{
+	const uint32_t Index = ShaderViewDescriptors.AllocateStaging(Count);
+
+	if (Index == DescriptorAllocator::InvalidIndex)
+	{
+		std::wcout << L"D3D12RenderBackend: out of shader visible descriptors" << std::endl;
+		ExitProcess(-1);
+	}
+
+	Device->CopyDescriptorsSimple(Count, D3D12_CPU_DESCRIPTOR_HANDLE{ ShaderViewDescriptors.GetStagingCPUHandle(Index) }, GetShaderViewHandle(FirstView), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	return D3D12_GPU_DESCRIPTOR_HANDLE{ ShaderViewDescriptors.GetStagingGPUHandle(Index) };
+}
+
+static D3D12_RESOURCE_DESC GetTextureResourceDesc(const RenderTextureDesc& Desc)
+{
+	D3D12_RESOURCE_DESC ResourceDesc;
+	ResourceDesc.Alignment = 0;
+	ResourceDesc.DepthOrArraySize = 1;
+	ResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	ResourceDesc.Flags = static_cast<D3D12_RESOURCE_FLAGS>(Desc.Flags);
+	ResourceDesc.Format = static_cast<DXGI_FORMAT>(Desc.Format);
+	ResourceDesc.Height = Desc.Height;
+	ResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	ResourceDesc.MipLevels = 1;
+	ResourceDesc.SampleDesc.Count = Desc.SampleCount;
+	ResourceDesc.SampleDesc.Quality = 0;
+	ResourceDesc.Width = Desc.Width;
+
+	return ResourceDesc;
+}
+
+static D3D12_RESOURCE_DESC GetBufferResourceDesc(const RenderBufferDesc& Desc)
+{
+	D3D12_RESOURCE_DESC ResourceDesc;
+	ResourceDesc.Alignment = 0;
+	ResourceDesc.DepthOrArraySize = 1;
+	ResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	ResourceDesc.Flags = static_cast<D3D12_RESOURCE_FLAGS>(Desc.Flags);
+	ResourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+	ResourceDesc.Height = 1;
+	ResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	ResourceDesc.MipLevels = 1;
+	ResourceDesc.SampleDesc.Count = 1;
+	ResourceDesc.SampleDesc.Quality = 0;
+	ResourceDesc.Width = Desc.Size;
+
+	return ResourceDesc;
+}
+
+static D3D12_HEAP_PROPERTIES GetHeapProperties(D3D12_HEAP_TYPE Type)
+{
+	D3D12_HEAP_PROPERTIES HeapProperties;
+	HeapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	HeapProperties.CreationNodeMask = 0;
+	HeapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	HeapProperties.Type = Type;
+	HeapProperties.VisibleNodeMask = 0;
+
+	return HeapProperties;
+}
+
+static D3D12_CLEAR_VALUE GetDepthClearValue(const RenderTextureDesc& Desc)
+{
+	D3D12_CLEAR_VALUE ClearValue;
+	ClearValue.DepthStencil.Depth = Desc.ClearDepth;
+	ClearValue.DepthStencil.Stencil = Desc.ClearStencil;
+	ClearValue.Format = static_cast<DXGI_FORMAT>(Desc.Format);
+
+	return ClearValue;
+}
+
+static void SetResourceName(ID3D12Resource* Object, const char* Name)
+{
+	if (Name)
+	{
+		std::wstring WideName(Name, Name + strlen(Name));
+		Object->SetName(WideName.c_str());
+	}
+}
+
+RenderResource D3D12RenderBackend::AddTexture(ComPtr<ID3D12Resource>&& Object, const RenderTextureDesc& Desc)
+{
+	Resource Texture;
+	Texture.Object = std::move(Object);
+	Texture.SampleCount = Desc.SampleCount;
+
+	SetResourceName(Texture.Object.Get(), Desc.Name);
+
+	if (Desc.Flags & RENDER_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)
+	{
+		D3D12_DEPTH_STENCIL_VIEW_DESC DSVDesc{};
+		DSVDesc.Flags = D3D12_DSV_FLAG_NONE;
+		DSVDesc.Format = static_cast<DXGI_FORMAT>(Desc.Format);
+		DSVDesc.ViewDimension = Desc.SampleCount > 1 ? D3D12_DSV_DIMENSION_TEXTURE2DMS : D3D12_DSV_DIMENSION_TEXTURE2D;
+
+		Texture.DSVIndex = AllocateDescriptor(DSVDescriptors, "depth-stencil");
+		Texture.DSV.ptr = DSVDescriptors.GetPersistentHandle(Texture.DSVIndex);
+		Device->CreateDepthStencilView(Texture.Object.Get(), &DSVDesc, Texture.DSV);
+	}
+
+	if (Desc.Flags & RENDER_RESOURCE_FLAG_ALLOW_RENDER_TARGET)
+	{
+		Texture.RTVIndex = AllocateDescriptor(RTVDescriptors, "render target");
+		Texture.RTV.ptr = RTVDescriptors.GetPersistentHandle(Texture.RTVIndex);
+		Device->CreateRenderTargetView(Texture.Object.Get(), nullptr, Texture.RTV);
+	}
+
+	return AddResource(std::move(Texture));
+}
+
+RenderResource D3D12RenderBackend::AddBuffer(ComPtr<ID3D12Resource>&& Object, const RenderBufferDesc& Desc)
+{
+	Resource Buffer;
+	Buffer.Object = std::move(Object);
+	Buffer.StructureStride = Desc.StructureStride;
+	Buffer.Size = Desc.Size;
+
+	SetResourceName(Buffer.Object.Get(), Desc.Name);
+
+	return AddResource(std::move(Buffer));
+}
+
+RenderResource D3D12RenderBackend::CreateTexture(const RenderTextureDesc& Desc)
+{
+	const D3D12_RESOURCE_DESC ResourceDesc = GetTextureResourceDesc(Desc);
+	const D3D12_HEAP_PROPERTIES HeapProperties = GetHeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+	const D3D12_CLEAR_VALUE ClearValue = GetDepthClearValue(Desc);
+	const bool DepthStencil = (Desc.Flags & RENDER_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL) != 0;
+
+	ComPtr<ID3D12Resource> Object;
+	SAFE_DX(Device->CreateCommittedResource(&HeapProperties, D3D12_HEAP_FLAG_NONE, &ResourceDesc, static_cast<D3D12_RESOURCE_STATES>(Desc.InitialState), DepthStencil ? &ClearValue : nullptr, IID_PPV_ARGS(Object.ReleaseAndGetAddressOf())));
+
+	return AddTexture(std::move(Object), Desc);
+}
+
+RenderResource D3D12RenderBackend::CreateBuffer(const RenderBufferDesc& Desc)
+{
+	const D3D12_RESOURCE_DESC ResourceDesc = GetBufferResourceDesc(Desc);
+	const D3D12_HEAP_PROPERTIES HeapProperties = GetHeapProperties(static_cast<D3D12_HEAP_TYPE>(Desc.HeapType));
+
+	ComPtr<ID3D12Resource> Object;
+	SAFE_DX(Device->CreateCommittedResource(&HeapProperties, D3D12_HEAP_FLAG_NONE, &ResourceDesc, static_cast<D3D12_RESOURCE_STATES>(Desc.InitialState), nullptr, IID_PPV_ARGS(Object.ReleaseAndGetAddressOf())));
+
+	return AddBuffer(std::move(Object), Desc);
+}
+
+void D3D12RenderBackend::WriteBuffer(RenderResource Buffer, uint64_t Offset, const void* Data, size_t Size)
+{
+	memcpy(static_cast<uint8_t*>(MapBuffer(Buffer)) + Offset, Data, Size);
+}
+
+void* D3D12RenderBackend::MapBuffer(RenderResource Buffer)
+{
+	Resource& Mapped = Resources[Buffer - 1];
+
+	// Upload and readback heaps may stay mapped while the GPU uses them, so each buffer is mapped once
+	if (!Mapped.MappedData)
+		SAFE_DX(Mapped.Object->Map(0, nullptr, &Mapped.MappedData));
+
+	return Mapped.MappedData;
+}
+
+RenderAllocationInfo D3D12RenderBackend::GetTextureAllocationInfo(const RenderTextureDesc& Desc)
+{
+	const D3D12_RESOURCE_DESC ResourceDesc = GetTextureResourceDesc(Desc);
+	const D3D12_RESOURCE_ALLOCATION_INFO Info = Device->GetResourceAllocationInfo(0, 1, &ResourceDesc);
+
+	return { Info.SizeInBytes, Info.Alignment };
+}
+
+RenderAllocationInfo D3D12RenderBackend::GetBufferAllocationInfo(const RenderBufferDesc& Desc)
+{
+	const D3D12_RESOURCE_DESC ResourceDesc = GetBufferResourceDesc(Desc);
+	const D3D12_RESOURCE_ALLOCATION_INFO Info = Device->GetResourceAllocationInfo(0, 1, &ResourceDesc);
+
+	return { Info.SizeInBytes, Info.Alignment };
+}
+
+RenderHeap D3D12RenderBackend::CreateHeap(RenderHeapKind Kind, uint64_t Size, uint64_t Alignment)
+{
+	D3D12_HEAP_DESC HeapDesc;
+	HeapDesc.SizeInBytes = Size;
+	HeapDesc.Properties = GetHeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+	HeapDesc.Alignment = Alignment;
+	HeapDesc.Flags = Kind == RENDER_HEAP_KIND_BUFFERS ? D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS :
+		Kind == RENDER_HEAP_KIND_TARGET_TEXTURES ? D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES : D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+
+	ComPtr<ID3D12Heap> Heap;
+	SAFE_DX(Device->CreateHeap(&HeapDesc, IID_PPV_ARGS(Heap.ReleaseAndGetAddressOf())));
+
+	Heaps.push_back(std::move(Heap));
+	return static_cast<RenderHeap>(Heaps.size());
+}
+
+RenderResource D3D12RenderBackend::CreatePlacedTexture(RenderHeap Heap, uint64_t Offset, const RenderTextureDesc& Desc)
+{
+	const D3D12_RESOURCE_DESC ResourceDesc = GetTextureResourceDesc(Desc);
+	const D3D12_CLEAR_VALUE ClearValue = GetDepthClearValue(Desc);
+	const bool DepthStencil = (Desc.Flags & RENDER_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL) != 0;
+
+	ComPtr<ID3D12Resource> Object;
+	SAFE_DX(Device->CreatePlacedResource(Heaps[Heap - 1].Get(), Offset, &ResourceDesc, static_cast<D3D12_RESOURCE_STATES>(Desc.InitialState), DepthStencil ? &ClearValue : nullptr, IID_PPV_ARGS(Object.ReleaseAndGetAddressOf())));
+
+	return AddTexture(std::move(Object), Desc);
+}
+
+RenderResource D3D12RenderBackend::CreatePlacedBuffer(RenderHeap Heap, uint64_t Offset, const RenderBufferDesc& Desc)
+{
+	const D3D12_RESOURCE_DESC ResourceDesc = GetBufferResourceDesc(Desc);
+
+	ComPtr<ID3D12Resource> Object;
+	SAFE_DX(Device->CreatePlacedResource(Heaps[Heap - 1].Get(), Offset, &ResourceDesc, static_cast<D3D12_RESOURCE_STATES>(Desc.InitialState), nullptr, IID_PPV_ARGS(Object.ReleaseAndGetAddressOf())));
+
+	return AddBuffer(std::move(Object), Desc);
+}
+
+void D3D12RenderBackend::ReleaseResource(RenderResource Resource)
+{
+	D3D12RenderBackend::Resource& Released = Resources[Resource - 1];
+
+	// Render target and depth-stencil views are copied into the command list when they are set
+	if (Released.RTVIndex != DescriptorAllocator::InvalidIndex)
+		RTVDescriptors.FreePersistent(Released.RTVIndex);
+
+	if (Released.DSVIndex != DescriptorAllocator::InvalidIndex)
+		DSVDescriptors.FreePersistent(Released.DSVIndex);
+
+	if (Released.MappedData)
+		Released.Object->Unmap(0, nullptr);
+
+	ReleasedObjects.push_back({ Scheduler.GetFrameNumber(), std::move(Released.Object) });
+	Released = D3D12RenderBackend::Resource();
+}
+
+void D3D12RenderBackend::ReleaseHeap(RenderHeap Heap)
+{
+	ReleasedObjects.push_back({ Scheduler.GetFrameNumber(), std::move(Heaps[Heap - 1]) });
+}
+
+RenderView D3D12RenderBackend::CreateConstantBufferView(RenderResource Buffer, uint32_t Size)
+{
+	const RenderView View = AllocateShaderView();
+
+	D3D12_CONSTANT_BUFFER_VIEW_DESC CBVDesc;
+	CBVDesc.BufferLocation = Resources[Buffer - 1].Object->GetGPUVirtualAddress();
+	CBVDesc.SizeInBytes = Size;
+
+	Device->CreateConstantBufferView(&CBVDesc, GetShaderViewHandle(View));
+
+	return View;
+}
+
+RenderView D3D12RenderBackend::CreateShaderResourceView(RenderResource Resource, RenderFormat Format)
+{
+	const RenderView View = AllocateShaderView();
+	UpdateShaderResourceView(View, Resource, Format);
+
+	return View;
+}
+
+void D3D12RenderBackend::UpdateShaderResourceView(RenderView View, RenderResource Resource, RenderFormat Format)
+{
+	const D3D12RenderBackend::Resource& Target = Resources[Resource - 1];
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc{};
+	SRVDesc.Format = static_cast<DXGI_FORMAT>(Format);
+	SRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+
+	if (Target.StructureStride != 0)
+	{
+		SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+		SRVDesc.Buffer.NumElements = static_cast<UINT>(Target.Size / Target.StructureStride);
+		SRVDesc.Buffer.StructureByteStride = Target.StructureStride;
+	}
+	else if (Target.SampleCount > 1)
+	{
+		SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DMS;
+	}
+	else
+	{
+		SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+		SRVDesc.Texture2D.MipLevels = 1;
+		SRVDesc.Texture2D.PlaneSlice = GetRenderFormatPlaneSlice(Format);
+	}
+
+	Device->CreateShaderResourceView(Target.Object.Get(), &SRVDesc, GetShaderViewHandle(View));
+}
+
+RenderView D3D12RenderBackend::CreateUnorderedAccessView(RenderResource Resource, RenderFormat Format)
+{
+	const RenderView View = AllocateShaderView();
+	UpdateUnorderedAccessView(View, Resource, Format);
+
+	return View;
+}
+
+void D3D12RenderBackend::UpdateUnorderedAccessView(RenderView View, RenderResource Resource, RenderFormat Format)
+{
+	const D3D12RenderBackend::Resource& Target = Resources[Resource - 1];
+
+	D3D12_UNORDERED_ACCESS_VIEW_DESC UAVDesc{};
+	UAVDesc.Format = static_cast<DXGI_FORMAT>(Format);
+
+	if (Target.StructureStride != 0)
+	{
+		UAVDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+		UAVDesc.Buffer.NumElements = static_cast<UINT>(Target.Size / Target.StructureStride);
+		UAVDesc.Buffer.StructureByteStride = Target.StructureStride;
+	}
+	else
+	{
+		UAVDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+	}
+
+	Device->CreateUnorderedAccessView(Target.Object.Get(), nullptr, &UAVDesc, GetShaderViewHandle(View));
+}
+
+void D3D12RenderBackend::ReleaseView(RenderView View)
+{
+	ShaderViewDescriptors.FreePersistent(View - 1);
+}
+
+static void SerializeRootSignature(const RenderRootSignatureDesc& Desc, ComPtr<ID3DBlob>& RootSignatureBlob)
+{
+	std::vector<D3D12_DESCRIPTOR_RANGE> DescriptorRanges;
+	std::vector<D3D12_ROOT_PARAMETER> RootParameters(Desc.ParameterCount);
+
+	for (uint32_t i = 0; i < Desc.ParameterCount; ++i)
+	{
+		for (uint32_t j = 0; j < Desc.Parameters[i].RangeCount; ++j)
+		{
+			const RenderDescriptorRange& Range = Desc.Parameters[i].Ranges[j];
+			DescriptorRanges.push_back({ static_cast<D3D12_DESCRIPTOR_RANGE_TYPE>(Range.Type), Range.Count, Range.BaseRegister, 0, D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND });
+		}
+	}
+
+	const D3D12_DESCRIPTOR_RANGE* NextRange = DescriptorRanges.data();
+
+	for (uint32_t i = 0; i < Desc.ParameterCount; ++i)
+	{
+		const RenderRootParameter& Parameter = Desc.Parameters[i];
+		const D3D12_SHADER_VISIBILITY Visibility = static_cast<D3D12_SHADER_VISIBILITY>(Parameter.Visibility);
+
+		if (Parameter.RangeCount > 0)
+		{
+			RootParameters[i] = { .ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE, .DescriptorTable = { Parameter.RangeCount, NextRange }, .ShaderVisibility = Visibility };
+			NextRange += Parameter.RangeCount;
+		}
+		else if (Parameter.ConstantBuffer)
+		{
+			RootParameters[i] = { .ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV, .Descriptor = { Parameter.ConstantRegister, 0 }, .ShaderVisibility = Visibility };
+		}
+		else
+		{
+			RootParameters[i] = { .ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS, .Constants = { Parameter.ConstantRegister, 0, Parameter.Constants32Bit }, .ShaderVisibility = Visibility };
+		}
+	}
+
+	D3D12_ROOT_SIGNATURE_DESC RootSignatureDesc;
+	RootSignatureDesc.Flags = Desc.AllowInputLayout ? D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT : D3D12_ROOT_SIGNATURE_FLAG_NONE;
+	RootSignatureDesc.NumParameters = Desc.ParameterCount;
+	RootSignatureDesc.NumStaticSamplers = 0;
+	RootSignatureDesc.pParameters = RootParameters.data();
+	RootSignatureDesc.pStaticSamplers = nullptr;
+
+	ComPtr<ID3DBlob> ErrorBlob;
+	SAFE_DX(D3D12SerializeRootSignature(&RootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1_0, &RootSignatureBlob, &ErrorBlob));
+}
+
+RenderRootSignature D3D12RenderBackend::CreateRootSignature(const RenderRootSignatureDesc& Desc)
+{
+	PipelineCacheHasher Hasher;
+	Hasher.AddString("RootSignature");
+	Hasher.AddValue(Desc.ParameterCount);
+	Hasher.AddValue(Desc.AllowInputLayout);
+
+	for (uint32_t i = 0; i < Desc.ParameterCount; ++i)
+	{
+		const RenderRootParameter& Parameter = Desc.Parameters[i];
+
+		Hasher.AddValue(Parameter.RangeCount);
+		Hasher.AddValue(Parameter.Constants32Bit);
+		Hasher.AddValue(Parameter.ConstantRegister);
+		Hasher.AddValue(Parameter.Visibility);
+		Hasher.AddValue(Parameter.ConstantBuffer);
+
+		for (uint32_t j = 0; j < Parameter.RangeCount; ++j)
+			Hasher.AddValue(Parameter.Ranges[j]);
+	}
+
+	RootSignature NewRootSignature;
+	NewRootSignature.Hash = Hasher.GetHash();
+
+	PipelineCacheBlob Blob;
+
+	if (!Cache.Find(NewRootSignature.Hash, Blob))
+	{
+		ComPtr<ID3DBlob> RootSignatureBlob;
+		SerializeRootSignature(Desc, RootSignatureBlob);
+
+		Blob = Cache.Store(NewRootSignature.Hash, RootSignatureBlob->GetBufferPointer(), RootSignatureBlob->GetBufferSize(), false);
+	}
+
+	SAFE_DX(Device->CreateRootSignature(0, Blob.Data, Blob.Size, IID_PPV_ARGS(NewRootSignature.Object.ReleaseAndGetAddressOf())));
+
+	for (uint32_t i = 0; i < Desc.ParameterCount; ++i)
+	{
+		uint32_t TableSize = 0;
+
+		for (uint32_t j = 0; j < Desc.Parameters[i].RangeCount; ++j)
+			TableSize += Desc.Parameters[i].Ranges[j].Count;
+
+		NewRootSignature.TableSizes.push_back(TableSize);
+	}
+
+	RootSignatures.push_back(std::move(NewRootSignature));
+	return static_cast<RenderRootSignature>(RootSignatures.size());
+}
+
+D3D12RenderBackend::PendingShader D3D12RenderBackend::RequestShader(const char* ShaderSource, const char* ShaderName, const char* EntryPoint, const char* ShaderModel)
+{
+	PipelineCacheHasher Hasher;
+	Hasher.AddString("Shader");
+	Hasher.AddString(ShaderSource);
+	Hasher.AddString(EntryPoint);
+	Hasher.AddString(ShaderModel);
+	Hasher.AddValue(ShaderCompileFlags);
+	Hasher.AddValue(D3D_COMPILER_VERSION);
+
+	for (const D3D_SHADER_MACRO* Define = ShaderDefines; Define && Define->Name; ++Define)
+	{
+		Hasher.AddString(Define->Name);
+		Hasher.AddString(Define->Definition);
+	}
+
+	PendingShader Shader{ Hasher.GetHash(), false };
+	PipelineCacheBlob Blob;
+
+	if (Cache.Find(Shader.Key, Blob))
+	{
+		ShaderCompileResult Result;
+		Result.Succeeded = true;
+		Result.Bytecode.assign(static_cast<const uint8_t*>(Blob.Data), static_cast<const uint8_t*>(Blob.Data) + Blob.Size);
+
+		std::promise<ShaderCompileResult> CachedResult;
+		CachedResult.set_value(std::move(Result));
+
+		Shader.Cached = true;
+		Shader.Result = CachedResult.get_future().share();
+		return Shader;
+	}
+
+	Shader.Result = ShaderCompiler.Compile({ ShaderSource, ShaderName ? ShaderName : "", EntryPoint, ShaderModel });
+	return Shader;
+}
+
+ComPtr<ID3D12PipelineState> D3D12RenderBackend::CreatePipelineState(uint64_t Key, const D3D12_GRAPHICS_PIPELINE_STATE_DESC* GraphicsDesc, const D3D12_COMPUTE_PIPELINE_STATE_DESC* ComputeDesc)
+{
+	ComPtr<ID3D12PipelineState> PipelineState;
+	PipelineCacheBlob Blob;
+
+	if (Cache.Find(Key, Blob))
+	{
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC CachedGraphicsDesc;
+		D3D12_COMPUTE_PIPELINE_STATE_DESC CachedComputeDesc;
+		HRESULT hr;
+
+		if (GraphicsDesc)
+		{
+			CachedGraphicsDesc = *GraphicsDesc;
+			CachedGraphicsDesc.CachedPSO = { Blob.Data, Blob.Size };
+			hr = Device->CreateGraphicsPipelineState(&CachedGraphicsDesc, IID_PPV_ARGS(PipelineState.ReleaseAndGetAddressOf()));
+		}
+		else
+		{
+			CachedComputeDesc = *ComputeDesc;
+			CachedComputeDesc.CachedPSO = { Blob.Data, Blob.Size };
+			hr = Device->CreateComputePipelineState(&CachedComputeDesc, IID_PPV_ARGS(PipelineState.ReleaseAndGetAddressOf()));
+		}
+
+		if (SUCCEEDED(hr))
+			return PipelineState;
+
+		// Written by another driver or adapter than the device hash tells apart: build from the bytecode
+		Cache.Remove(Key);
+	}
+
+	if (GraphicsDesc)
+		SAFE_DX(Device->CreateGraphicsPipelineState(GraphicsDesc, IID_PPV_ARGS(PipelineState.ReleaseAndGetAddressOf())));
+	else
+		SAFE_DX(Device->CreateComputePipelineState(ComputeDesc, IID_PPV_ARGS(PipelineState.ReleaseAndGetAddressOf())));
+
+	ComPtr<ID3DBlob> PipelineBlob;
+
+	if (SUCCEEDED(PipelineState->GetCachedBlob(&PipelineBlob)))
+		Cache.Store(Key, PipelineBlob->GetBufferPointer(), PipelineBlob->GetBufferSize(), true);
+
+	return PipelineState;
+}
+
+static void AddShaderHash(PipelineCacheHasher& Hasher, const D3D12_SHADER_BYTECODE& ShaderByteCode)
+{
+	Hasher.AddValue(ShaderByteCode.BytecodeLength);
+	Hasher.Add(ShaderByteCode.pShaderBytecode, ShaderByteCode.BytecodeLength);
+}
+
+ComPtr<ID3D12PipelineState> D3D12RenderBackend::CreateGraphicsPipelineState(const RenderGraphicsPipelineDesc& Desc, const D3D12_SHADER_BYTECODE& VertexShader, const D3D12_SHADER_BYTECODE& PixelShader)
+{
+	D3D12_INPUT_ELEMENT_DESC InputElementDesc =
+	{
+		"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+	};
+
+	const RootSignature& PipelineRootSignature = RootSignatures[Desc.RootSignature - 1];
+
+	// Zeroed first and filled in field by field, so the padding of the description hashes the same every time
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC GraphicsPipelineStateDesc;
+	ZeroMemory(&GraphicsPipelineStateDesc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
+	GraphicsPipelineStateDesc.BlendState.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+
+	if (Desc.DepthEnable)
+	{
+		GraphicsPipelineStateDesc.DepthStencilState.DepthEnable = TRUE;
+		GraphicsPipelineStateDesc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+		GraphicsPipelineStateDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+	}
+
+	GraphicsPipelineStateDesc.DSVFormat = static_cast<DXGI_FORMAT>(Desc.DepthStencilFormat);
+	GraphicsPipelineStateDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+
+	if (Desc.PositionInput)
+		GraphicsPipelineStateDesc.InputLayout.NumElements = 1;
+
+	if (Desc.RenderTargetFormat != RENDER_FORMAT_UNKNOWN)
+	{
+		GraphicsPipelineStateDesc.NumRenderTargets = 1;
+		GraphicsPipelineStateDesc.RTVFormats[0] = static_cast<DXGI_FORMAT>(Desc.RenderTargetFormat);
+	}
+
+	GraphicsPipelineStateDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+	GraphicsPipelineStateDesc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+	GraphicsPipelineStateDesc.RasterizerState.CullMode = static_cast<D3D12_CULL_MODE>(Desc.CullMode);
+	GraphicsPipelineStateDesc.SampleDesc.Count = Desc.SampleCount;
+	GraphicsPipelineStateDesc.SampleMask = D3D12_DEFAULT_SAMPLE_MASK;
+
+	// The key holds the description with its pointers left out, then what they point to
+	PipelineCacheHasher Hasher;
+	Hasher.AddString("GraphicsPipeline");
+	Hasher.AddValue(GraphicsPipelineStateDesc);
+	Hasher.AddValue(PipelineRootSignature.Hash);
+
+	GraphicsPipelineStateDesc.pRootSignature = PipelineRootSignature.Object.Get();
+	GraphicsPipelineStateDesc.VS = VertexShader;
+	GraphicsPipelineStateDesc.PS = PixelShader;
+	GraphicsPipelineStateDesc.InputLayout.pInputElementDescs = Desc.PositionInput ? &InputElementDesc : nullptr;
+
+	AddShaderHash(Hasher, GraphicsPipelineStateDesc.VS);
+	AddShaderHash(Hasher, GraphicsPipelineStateDesc.PS);
+
+	for (UINT i = 0; i < GraphicsPipelineStateDesc.InputLayout.NumElements; ++i)
+	{
+		const D3D12_INPUT_ELEMENT_DESC& Element = GraphicsPipelineStateDesc.InputLayout.pInputElementDescs[i];
+
+		Hasher.AddString(Element.SemanticName);
+		Hasher.AddValue(Element.SemanticIndex);
+		Hasher.AddValue(Element.Format);
+		Hasher.AddValue(Element.InputSlot);
+		Hasher.AddValue(Element.AlignedByteOffset);
+		Hasher.AddValue(Element.InputSlotClass);
+		Hasher.AddValue(Element.InstanceDataStepRate);
+	}
+
+	return CreatePipelineState(Hasher.GetHash(), &GraphicsPipelineStateDesc, nullptr);
+}
+
+ComPtr<ID3D12PipelineState> D3D12RenderBackend::CreateComputePipelineState(RenderRootSignature Signature, const D3D12_SHADER_BYTECODE& ComputeShader)
+{
+	const RootSignature& PipelineRootSignature = RootSignatures[Signature - 1];
+
+	D3D12_COMPUTE_PIPELINE_STATE_DESC ComputePipelineStateDesc{};
+	ComputePipelineStateDesc.pRootSignature = PipelineRootSignature.Object.Get();
+	ComputePipelineStateDesc.CS = ComputeShader;
+
+	PipelineCacheHasher Hasher;
+	Hasher.AddString("ComputePipeline");
+	Hasher.AddValue(PipelineRootSignature.Hash);
+	AddShaderHash(Hasher, ComputePipelineStateDesc.CS);
+
+	return CreatePipelineState(Hasher.GetHash(), nullptr, &ComputePipelineStateDesc);
+}
+
+RenderPipeline D3D12RenderBackend::CreateGraphicsPipeline(const RenderGraphicsPipelineDesc& Desc)
+{
+	PendingPipeline NewPendingPipeline{ RenderNullHandle, Desc.Name ? Desc.Name : "", Desc };
+	NewPendingPipeline.Shaders[0] = RequestShader(Desc.VertexShaderSource, Desc.Name, Desc.VertexShaderEntry, "vs_5_0");
+	NewPendingPipeline.ShaderCount = 1;
+
+	if (Desc.PixelShaderSource)
+		NewPendingPipeline.Shaders[NewPendingPipeline.ShaderCount++] = RequestShader(Desc.PixelShaderSource, Desc.Name, Desc.PixelShaderEntry, "ps_5_0");
+
+	NewPendingPipeline.GraphicsDesc.Name = nullptr;
+	NewPendingPipeline.GraphicsDesc.VertexShaderSource = nullptr;
+	NewPendingPipeline.GraphicsDesc.PixelShaderSource = nullptr;
+	NewPendingPipeline.GraphicsDesc.VertexShaderEntry = nullptr;
+	NewPendingPipeline.GraphicsDesc.PixelShaderEntry = nullptr;
+
+	Pipelines.push_back({ nullptr, Desc.RootSignature, false, RENDER_PIPELINE_STATUS_PENDING });
+	NewPendingPipeline.Pipeline = static_cast<RenderPipeline>(Pipelines.size());
+
+	PendingPipelines.push_back(std::move(NewPendingPipeline));
+
+	// Ready right away when every shader came from the cache
+	UpdatePendingPipelines();
+
+	return static_cast<RenderPipeline>(Pipelines.size());
+}
+
+RenderPipeline D3D12RenderBackend::CreateComputePipeline(const RenderComputePipelineDesc& Desc)
+{
+	PendingPipeline NewPendingPipeline{ RenderNullHandle, Desc.Name ? Desc.Name : "" };
+	NewPendingPipeline.Shaders[0] = RequestShader(Desc.ShaderSource, Desc.Name, Desc.ShaderEntry, "cs_5_0");
+	NewPendingPipeline.ShaderCount = 1;
+
+	Pipelines.push_back({ nullptr, Desc.RootSignature, true, RENDER_PIPELINE_STATUS_PENDING });
+	NewPendingPipeline.Pipeline = static_cast<RenderPipeline>(Pipelines.size());
+
+	PendingPipelines.push_back(std::move(NewPendingPipeline));
+
+	UpdatePendingPipelines();
+
+	return static_cast<RenderPipeline>(Pipelines.size());
+}
+
+void D3D12RenderBackend::UpdatePendingPipelines()
+{
+	for (size_t i = 0; i < PendingPipelines.size();)
+	{
+		PendingPipeline& Current = PendingPipelines[i];
+		bool Compiled = true;
+
+		for (uint32_t j = 0; j < Current.ShaderCount; ++j)
+			Compiled &= Current.Shaders[j].Result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+
+		if (!Compiled)
+		{
+			++i;
+			continue;
+		}
+
+		Pipeline& Target = Pipelines[Current.Pipeline - 1];
+		D3D12_SHADER_BYTECODE ShaderByteCode[2] = {};
+		bool Succeeded = true;
+
+		for (uint32_t j = 0; j < Current.ShaderCount; ++j)
+		{
+			const ShaderCompileResult& Result = Current.Shaders[j].Result.get();
+
+			Target.Messages.insert(Target.Messages.end(), Result.Messages.begin(), Result.Messages.end());
+
+			if (!Result.Succeeded)
+			{
+				printf("Pipeline %s: shader compilation failed\n%s\n", Current.Name.c_str(), Result.Log.c_str());
+				Succeeded = false;
+				continue;
+			}
+
+			if (!Current.Shaders[j].Cached)
+				Cache.Store(Current.Shaders[j].Key, Result.Bytecode.data(), Result.Bytecode.size(), false);
+
+			ShaderByteCode[j] = { Result.Bytecode.data(), Result.Bytecode.size() };
+		}
+
+		if (Succeeded)
+		{
+			Target.Object = Target.Compute ? CreateComputePipelineState(Target.RootSignature, ShaderByteCode[0]) : CreateGraphicsPipelineState(Current.GraphicsDesc, ShaderByteCode[0], ShaderByteCode[1]);
+			Target.Status = RENDER_PIPELINE_STATUS_READY;
+		}
+		else
+		{
+			Target.Status = RENDER_PIPELINE_STATUS_FAILED;
+		}
+
+		PendingPipelines.erase(PendingPipelines.begin() + i);
+	}
+}
+
+RenderPipelineStatus D3D12RenderBackend::GetPipelineStatus(RenderPipeline Pipeline)
+{
+	return Pipelines[Pipeline - 1].Status;
+}
+
+RenderCommandList* D3D12RenderBackend::BeginFrame()
+{
+	{
+		ProfileScope Scope("PresentWait");
+		WaitForSingleObjectEx(FrameLatencyWaitableObject, 1000, TRUE);
+	}
+
+	const uint32_t Slot = Scheduler.BeginFrame();
+
+	ShaderViewDescriptors.Reclaim(Scheduler.GetCompletedFrame());
+	UpdatePendingPipelines();
+
+	const uint64_t CompletedFrame = Scheduler.GetCompletedFrame();
+	ReleasedObjects.erase(std::remove_if(ReleasedObjects.begin(), ReleasedObjects.end(), [&](const ReleasedObject& Released) { return Released.FrameNumber <= CompletedFrame; }), ReleasedObjects.end());
+
+	SAFE_DX(CommandAllocators[Slot]->Reset());
+	CommandList.Begin(CommandAllocators[Slot].Get());
+
+	return &CommandList;
+}
+
+void D3D12RenderBackend::EndFrame()
+{
+	SAFE_DX(CommandList.CommandList->Close());
+
+	{
+		ProfileScope Scope("Submit");
+
+		ID3D12CommandList* ppCommandLists[] = { CommandList.CommandList.Get() };
+		CommandQueue->ExecuteCommandLists(1, ppCommandLists);
+	}
+
+	{
+		ProfileScope Scope("Present");
+		SAFE_DX(SwapChain->Present(SyncInterval, 0));
+	}
+
+	ShaderViewDescriptors.FinishFrame(Scheduler.GetFrameNumber());
+	Scheduler.EndFrame();
+
+	for (uint32_t ListIndex : SubmittedLists)
+		SecondaryLists.Release(ListIndex, Scheduler.GetFrameNumber());
+
+	SubmittedLists.clear();
+
+	CurrentBackBufferIndex = SwapChain->GetCurrentBackBufferIndex();
+}
+
+RenderCommandList* D3D12RenderBackend::AcquireCommandList()
+{
+	const uint32_t ListIndex = SecondaryLists.Acquire(Fence.GetCompletedValue());
+
+	if (ListIndex == SecondaryLists.InvalidIndex)
+		return nullptr;
+
+	SecondaryCommandList& List = SecondaryLists[ListIndex];
+
+	if (!List.CommandAllocator)
+	{
+		SAFE_DX(Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(List.CommandAllocator.ReleaseAndGetAddressOf())));
+		SAFE_DX(Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, List.CommandAllocator.Get(), nullptr, IID_PPV_ARGS(List.CommandList.CommandList.ReleaseAndGetAddressOf())));
+		SAFE_DX(List.CommandList.CommandList->Close());
+		SAFE_DX(List.CommandList.CommandList->QueryInterface<ID3D12GraphicsCommandList1>(List.CommandList.CommandList1.ReleaseAndGetAddressOf()));
+
+		List.CommandList.Backend = this;
+		List.CommandList.PoolIndex = ListIndex;
+	}
+
+	SAFE_DX(List.CommandAllocator->Reset());
+	List.CommandList.Begin(List.CommandAllocator.Get());
+
+	return &List.CommandList;
+}
+
+void D3D12RenderBackend::SubmitCommandLists(uint32_t Count, RenderCommandList* const* Lists)
+{
+	constexpr uint32_t MaxBatch = RenderMaxAcquiredCommandLists + 1;
+	ID3D12CommandList* ppCommandLists[MaxBatch];
+	uint32_t BatchCount = 0;
+
+	// The frame's list so far goes first, then it is reset onto the same allocator to record what follows
+	SAFE_DX(CommandList.CommandList->Close());
+	ppCommandLists[BatchCount++] = CommandList.CommandList.Get();
+
+	for (uint32_t i = 0; i < Count && BatchCount < MaxBatch; ++i)
+	{
+		D3D12RenderCommandList* List = static_cast<D3D12RenderCommandList*>(Lists[i]);
+
+		SAFE_DX(List->CommandList->Close());
+		ppCommandLists[BatchCount++] = List->CommandList.Get();
+		SubmittedLists.push_back(List->PoolIndex);
+	}
+
+	CommandQueue->ExecuteCommandLists(BatchCount, ppCommandLists);
+
+	CommandList.Begin(CommandAllocators[Scheduler.GetFrameSlot()].Get());
+}
+
+void D3D12RenderBackend::WaitIdle()
+{
+	Scheduler.WaitIdle();
+}
+
+void D3D12RenderBackend::ResizeSwapChain(uint32_t NewWidth, uint32_t NewHeight)
+{
+	// ResizeBuffers fails while anything still references the old buffers
+	WaitIdle();
+	ReleasedObjects.clear();
+
+	const uint32_t FramesInFlight = Scheduler.GetFramesInFlight();
+
+	for (uint32_t i = 0; i < FramesInFlight; ++i)
+		Resources[BackBuffers[i] - 1].Object.Reset();
+
+	SAFE_DX(SwapChain->ResizeBuffers(0, NewWidth, NewHeight, DXGI_FORMAT_UNKNOWN, DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT));
+
+	Width = NewWidth;
+	Height = NewHeight;
+
+	D3D12_RENDER_TARGET_VIEW_DESC RTVDesc{};
+	RTVDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+	RTVDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D;
+
+	// Same handles and render target view descriptors, new buffers behind them
+	for (uint32_t i = 0; i < FramesInFlight; ++i)
+	{
+		Resource& BackBuffer = Resources[BackBuffers[i] - 1];
+		SAFE_DX(SwapChain->GetBuffer(i, IID_PPV_ARGS(BackBuffer.Object.GetAddressOf())));
+		Device->CreateRenderTargetView(BackBuffer.Object.Get(), &RTVDesc, BackBuffer.RTV);
+	}
+
+	CurrentBackBufferIndex = SwapChain->GetCurrentBackBufferIndex();
+}
+
+uint64_t D3D12RenderBackend::GetTimestampFrequency()
+{
+	UINT64 Frequency = 0;
+	return SUCCEEDED(CommandQueue->GetTimestampFrequency(&Frequency)) ? Frequency : 0;
+}
+
+RenderQueryHeap D3D12RenderBackend::CreateTimestampQueryHeap(uint32_t Count)
+{
+	D3D12_QUERY_HEAP_DESC QueryHeapDesc{};
+	QueryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	QueryHeapDesc.Count = Count;
+
+	ComPtr<ID3D12QueryHeap> QueryHeap;
+	SAFE_DX(Device->CreateQueryHeap(&QueryHeapDesc, IID_PPV_ARGS(QueryHeap.ReleaseAndGetAddressOf())));
+
+	QueryHeaps.push_back(std::move(QueryHeap));
+	return static_cast<RenderQueryHeap>(QueryHeaps.size());
+}
+
+bool D3D12RenderBackend::GetTimestampCalibration(uint64_t& GPUTimestamp, uint64_t& CPUNanoseconds)
+{
+	UINT64 QPCTimestamp = 0;
+	LARGE_INTEGER QPCFrequency;
+
+	if (FAILED(CommandQueue->GetClockCalibration(&GPUTimestamp, &QPCTimestamp)) || !QueryPerformanceFrequency(&QPCFrequency))
+		return false;
+
+	// steady_clock counts QueryPerformanceCounter ticks, converted to nanoseconds the same way
+	const uint64_t Frequency = static_cast<uint64_t>(QPCFrequency.QuadPart);
+	CPUNanoseconds = QPCTimestamp / Frequency * 1000000000 + QPCTimestamp % Frequency * 1000000000 / Frequency;
+	return true;
+}
+
+void D3D12RenderCommandList::Begin(ID3D12CommandAllocator* CommandAllocator)
+{
+	SAFE_DX(CommandList->Reset(CommandAllocator, nullptr));
+
+	ID3D12DescriptorHeap* ppCB = { Backend->CBSRUAStagingHeap.Get() };
+	CommandList->SetDescriptorHeaps(1, &ppCB);
+
+	GraphicsRootSignature = RenderNullHandle;
+	ComputeRootSignature = RenderNullHandle;
+	ComputePipelineSet = false;
+}
+
+void D3D12RenderCommandList::ResourceBarrier(uint32_t Count, const RenderBarrier* Barriers)
+{
+	constexpr uint32_t BatchSize = 16;
+	D3D12_RESOURCE_BARRIER ResourceBarriers[BatchSize];
+
+	for (uint32_t First = 0; First < Count; First += BatchSize)
+	{
+		const uint32_t BatchCount = std::min(BatchSize, Count - First);
+
+		for (uint32_t i = 0; i < BatchCount; ++i)
+		{
+			const RenderBarrier& Barrier = Barriers[First + i];
+			ID3D12Resource* Object = Backend->Resources[Barrier.Resource - 1].Object.Get();
+
+			ResourceBarriers[i].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+
+			if (Barrier.Type == RenderBarrier::UAV)
+			{
+				ResourceBarriers[i].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+				ResourceBarriers[i].UAV.pResource = Object;
+			}
+			else if (Barrier.Type == RenderBarrier::ALIASING)
+			{
+				// No before resource: every resource overlapping Object is deactivated
+				ResourceBarriers[i].Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+				ResourceBarriers[i].Aliasing = { nullptr, Object };
+			}
+			else
+			{
+				ResourceBarriers[i].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+				ResourceBarriers[i].Transition = { Object, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, static_cast<D3D12_RESOURCE_STATES>(Barrier.Before), static_cast<D3D12_RESOURCE_STATES>(Barrier.After) };
+			}
+		}
+
+		CommandList->ResourceBarrier(BatchCount, ResourceBarriers);
+	}
+}
+
+void D3D12RenderCommandList::DiscardResource(RenderResource Resource)
+{
+	CommandList->DiscardResource(Backend->Resources[Resource - 1].Object.Get(), nullptr);
+}
+
+void D3D12RenderCommandList::ClearDepthStencil(RenderResource DepthTarget, float Depth, uint8_t Stencil)
+{
+	CommandList->ClearDepthStencilView(Backend->Resources[DepthTarget - 1].DSV, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, Depth, Stencil, 0, nullptr);
+}
+
+void D3D12RenderCommandList::SetRenderTargets(RenderResource RenderTarget, RenderResource DepthTarget)
+{
+	const D3D12_CPU_DESCRIPTOR_HANDLE* RTV = RenderTarget != RenderNullHandle ? &Backend->Resources[RenderTarget - 1].RTV : nullptr;
+	const D3D12_CPU_DESCRIPTOR_HANDLE* DSV = DepthTarget != RenderNullHandle ? &Backend->Resources[DepthTarget - 1].DSV : nullptr;
+
+	CommandList->OMSetRenderTargets(RTV ? 1 : 0, RTV, FALSE, DSV);
+}
+
+void D3D12RenderCommandList::SetViewport(uint32_t Width, uint32_t Height)
+{
+	D3D12_VIEWPORT Viewport = { 0.0f, 0.0f, static_cast<float>(Width), static_cast<float>(Height), 0.0f, 1.0f };
+	D3D12_RECT ScissorRect = { 0, 0, static_cast<LONG>(Width), static_cast<LONG>(Height) };
+
+	CommandList->RSSetViewports(1, &Viewport);
+	CommandList->RSSetScissorRects(1, &ScissorRect);
+}
+
+void D3D12RenderCommandList::SetPipeline(RenderPipeline Pipeline)
+{
+	const D3D12RenderBackend::Pipeline& Target = Backend->Pipelines[Pipeline - 1];
+
+	CommandList->SetPipelineState(Target.Object.Get());
+
+	// Binding the root signature again would drop the tables and constants already set
+	if (Target.Compute && ComputeRootSignature != Target.RootSignature)
+	{
+		CommandList->SetComputeRootSignature(Backend->RootSignatures[Target.RootSignature - 1].Object.Get());
+		ComputeRootSignature = Target.RootSignature;
+	}
+	else if (!Target.Compute && GraphicsRootSignature != Target.RootSignature)
+	{
+		CommandList->SetGraphicsRootSignature(Backend->RootSignatures[Target.RootSignature - 1].Object.Get());
+		GraphicsRootSignature = Target.RootSignature;
+	}
+
+	ComputePipelineSet = Target.Compute;
+}
+
+void D3D12RenderCommandList::SetDescriptorTable(uint32_t RootParameter, RenderView FirstView)
+{
+	const RenderRootSignature RootSignature = ComputePipelineSet ? ComputeRootSignature : GraphicsRootSignature;
+	const D3D12_GPU_DESCRIPTOR_HANDLE Handle = Backend->StageShaderViews(FirstView, Backend->RootSignatures[RootSignature - 1].TableSizes[RootParameter]);
+
+	if (ComputePipelineSet)
+		CommandList->SetComputeRootDescriptorTable(RootParameter, Handle);
+	else
+		CommandList->SetGraphicsRootDescriptorTable(RootParameter, Handle);
+}
+
+void D3D12RenderCommandList::SetRootConstants(uint32_t RootParameter, uint32_t Count, const void* Data)
+{
+	if (ComputePipelineSet)
+		CommandList->SetComputeRoot32BitConstants(RootParameter, Count, Data, 0);
+	else
+		CommandList->SetGraphicsRoot32BitConstants(RootParameter, Count, Data, 0);
+}
+
+void D3D12RenderCommandList::SetRootConstantBuffer(uint32_t RootParameter, RenderResource Buffer, uint64_t Offset)
+{
+	const D3D12_GPU_VIRTUAL_ADDRESS Address = Backend->Resources[Buffer - 1].Object->GetGPUVirtualAddress() + Offset;
+
+	if (ComputePipelineSet)
+		CommandList->SetComputeRootConstantBufferView(RootParameter, Address);
+	else
+		CommandList->SetGraphicsRootConstantBufferView(RootParameter, Address);
+}
+
+void D3D12RenderCommandList::SetPrimitiveTopology(RenderPrimitiveTopology Topology)
+{
+	CommandList->IASetPrimitiveTopology(static_cast<D3D_PRIMITIVE_TOPOLOGY>(Topology));
+}
+
+void D3D12RenderCommandList::SetVertexBuffer(RenderResource Buffer, uint32_t Size, uint32_t Stride)
+{
+	D3D12_VERTEX_BUFFER_VIEW VertexBufferView;
+	VertexBufferView.BufferLocation = Backend->Resources[Buffer - 1].Object->GetGPUVirtualAddress();
+	VertexBufferView.SizeInBytes = Size;
+	VertexBufferView.StrideInBytes = Stride;
+
+	CommandList->IASetVertexBuffers(0, 1, &VertexBufferView);
+}
+
+void D3D12RenderCommandList::SetIndexBuffer(RenderResource Buffer, uint32_t Size, RenderFormat Format)
+{
+	D3D12_INDEX_BUFFER_VIEW IndexBufferView;
+	IndexBufferView.BufferLocation = Backend->Resources[Buffer - 1].Object->GetGPUVirtualAddress();
+	IndexBufferView.Format = static_cast<DXGI_FORMAT>(Format);
+	IndexBufferView.SizeInBytes = Size;
+
+	CommandList->IASetIndexBuffer(&IndexBufferView);
+}
+
+void D3D12RenderCommandList::Draw(uint32_t VertexCount, uint32_t InstanceCount)
+{
+	CommandList->DrawInstanced(VertexCount, InstanceCount, 0, 0);
+}
+
+void D3D12RenderCommandList::DrawIndexed(uint32_t IndexCount, uint32_t InstanceCount)
+{
+	CommandList->DrawIndexedInstanced(IndexCount, InstanceCount, 0, 0, 0);
+}
+
+void D3D12RenderCommandList::Dispatch(uint32_t GroupsX, uint32_t GroupsY, uint32_t GroupsZ)
+{
+	CommandList->Dispatch(GroupsX, GroupsY, GroupsZ);
+}
+
+void D3D12RenderCommandList::WriteTimestamp(RenderQueryHeap Heap, uint32_t Index)
+{
+	CommandList->EndQuery(Backend->QueryHeaps[Heap - 1].Get(), D3D12_QUERY_TYPE_TIMESTAMP, Index);
+}
+
+void D3D12RenderCommandList::ResolveTimestamps(RenderQueryHeap Heap, uint32_t FirstIndex, uint32_t Count, RenderResource Destination, uint64_t Offset)
+{
+	CommandList->ResolveQueryData(Backend->QueryHeaps[Heap - 1].Get(), D3D12_QUERY_TYPE_TIMESTAMP, FirstIndex, Count, Backend->Resources[Destination - 1].Object.Get(), Offset);
+}
+
+void D3D12RenderCommandList::ResolveSubresourceRegion(RenderResource Destination, uint32_t DstX, uint32_t DstY, RenderResource Source, const RenderRect* SourceRect, RenderFormat Format, RenderResolveMode Mode)
+{
+	// One mip and one array slice, so the subresource index is the plane slice
+	const UINT Subresource = GetRenderFormatPlaneSlice(Format);
+
+	CommandList1->ResolveSubresourceRegion(Backend->Resources[Destination - 1].Object.Get(), Subresource, DstX, DstY, Backend->Resources[Source - 1].Object.Get(), Subresource, reinterpret_cast<D3D12_RECT*>(const_cast<RenderRect*>(SourceRect)), static_cast<DXGI_FORMAT>(Format), static_cast<D3D12_RESOLVE_MODE>(Mode));
+}
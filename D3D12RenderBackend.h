@@ -0,0 +1,285 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <d3d12.h>
+#include <dxgi1_6.h>
+#include <wrl.h>
+
+#include "RenderBackend.h"
+#include "FrameScheduler.h"
+#include "FencedObjectPool.h"
+#include "DescriptorAllocator.h"
+#include "PipelineCache.h"
+#include "ShaderCompileService.h"
+
+class D3D12RenderBackend;
+
+class D3D12RenderCommandList : public RenderCommandList
+{
+public:
+	void ResourceBarrier(uint32_t Count, const RenderBarrier* Barriers) override;
+	void DiscardResource(RenderResource Resource) override;
+
+	void ClearDepthStencil(RenderResource DepthTarget, float Depth, uint8_t Stencil) override;
+	void SetRenderTargets(RenderResource RenderTarget, RenderResource DepthTarget) override;
+	void SetViewport(uint32_t Width, uint32_t Height) override;
+
+	void SetPipeline(RenderPipeline Pipeline) override;
+	void SetDescriptorTable(uint32_t RootParameter, RenderView FirstView) override;
+	void SetRootConstants(uint32_t RootParameter, uint32_t Count, const void* Data) override;
+	void SetRootConstantBuffer(uint32_t RootParameter, RenderResource Buffer, uint64_t Offset) override;
+
+	void SetPrimitiveTopology(RenderPrimitiveTopology Topology) override;
+	void SetVertexBuffer(RenderResource Buffer, uint32_t Size, uint32_t Stride) override;
+	void SetIndexBuffer(RenderResource Buffer, uint32_t Size, RenderFormat Format) override;
+
+	void Draw(uint32_t VertexCount, uint32_t InstanceCount) override;
+	void DrawIndexed(uint32_t IndexCount, uint32_t InstanceCount) override;
+	void Dispatch(uint32_t GroupsX, uint32_t GroupsY, uint32_t GroupsZ) override;
+
+	void ResolveSubresourceRegion(RenderResource Destination, uint32_t DstX, uint32_t DstY, RenderResource Source, const RenderRect* SourceRect, RenderFormat Format, RenderResolveMode Mode) override;
+
+	void WriteTimestamp(RenderQueryHeap Heap, uint32_t Index) override;
+	void ResolveTimestamps(RenderQueryHeap Heap, uint32_t FirstIndex, uint32_t Count, RenderResource Destination, uint64_t Offset) override;
+
+private:
+	friend class D3D12RenderBackend;
+
+	void Begin(ID3D12CommandAllocator* CommandAllocator);
+
+	D3D12RenderBackend* Backend = nullptr;
+	uint32_t PoolIndex = 0; // lists from AcquireCommandList
+
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> CommandList;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList1> CommandList1;
+
+	// Root signature bound on the graphics or compute side, reset every frame
+	RenderRootSignature GraphicsRootSignature = RenderNullHandle;
+	RenderRootSignature ComputeRootSignature = RenderNullHandle;
+	bool ComputePipelineSet = false;
+};
+
+// ID3D12Fence signaled on the queue and waited on with an event
+class D3D12FrameFence : public FrameFence
+{
+public:
+	~D3D12FrameFence() override;
+
+	void Initialize(ID3D12Device* Device, ID3D12CommandQueue* CommandQueue);
+
+	uint64_t GetCompletedValue() override { return Fence->GetCompletedValue(); }
+	void Signal(uint64_t Value) override;
+	void Wait(uint64_t Value) override;
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Fence> Fence;
+	ID3D12CommandQueue* CommandQueue = nullptr;
+	HANDLE Event = nullptr;
+};
+
+class D3D12RenderBackend : public RenderBackend
+{
+public:
+	// Selects the adapter from -adapterindex=N / -adaptervendor=Name and enables the debug layer with -dxdebug.
+	// -framesinflight=N (2 by default) sets the frames recorded or executing at once, -framelatency=N the frames
+	// queued for presentation the swap chain lets through (FramesInFlight by default), -novsync presents immediately.
+	// Shaders and pipelines come from PipelineCache.bin in the working directory unless -nopipelinecache is given,
+	// shaders missing from it are compiled on -shaderthreads=N threads (one per core by default).
+	D3D12RenderBackend(HWND Window, uint32_t Width, uint32_t Height, const std::string& CommandLine);
+	~D3D12RenderBackend() override;
+
+	const char* GetName() const override { return "D3D12"; }
+
+	RenderResource CreateTexture(const RenderTextureDesc& Desc) override;
+	RenderResource CreateBuffer(const RenderBufferDesc& Desc) override;
+	// Writes through the persistent mapping of MapBuffer
+	void WriteBuffer(RenderResource Buffer, uint64_t Offset, const void* Data, size_t Size) override;
+	void* MapBuffer(RenderResource Buffer) override;
+
+	RenderAllocationInfo GetTextureAllocationInfo(const RenderTextureDesc& Desc) override;
+	RenderAllocationInfo GetBufferAllocationInfo(const RenderBufferDesc& Desc) override;
+	RenderHeap CreateHeap(RenderHeapKind Kind, uint64_t Size, uint64_t Alignment) override;
+	RenderResource CreatePlacedTexture(RenderHeap Heap, uint64_t Offset, const RenderTextureDesc& Desc) override;
+	RenderResource CreatePlacedBuffer(RenderHeap Heap, uint64_t Offset, const RenderBufferDesc& Desc) override;
+	void ReleaseResource(RenderResource Resource) override;
+	void ReleaseHeap(RenderHeap Heap) override;
+
+	RenderView CreateConstantBufferView(RenderResource Buffer, uint32_t Size) override;
+	RenderView CreateShaderResourceView(RenderResource Resource, RenderFormat Format) override;
+	RenderView CreateUnorderedAccessView(RenderResource Resource, RenderFormat Format) override;
+	void UpdateShaderResourceView(RenderView View, RenderResource Resource, RenderFormat Format) override;
+	void UpdateUnorderedAccessView(RenderView View, RenderResource Resource, RenderFormat Format) override;
+	void ReleaseView(RenderView View) override;
+
+	RenderRootSignature CreateRootSignature(const RenderRootSignatureDesc& Desc) override;
+	RenderPipeline CreateGraphicsPipeline(const RenderGraphicsPipelineDesc& Desc) override;
+	RenderPipeline CreateComputePipeline(const RenderComputePipelineDesc& Desc) override;
+	RenderPipelineStatus GetPipelineStatus(RenderPipeline Pipeline) override;
+	// Compiler errors and warnings of the pipeline's shaders, filled in when it is no longer pending
+	const std::vector<ShaderCompileMessage>& GetPipelineMessages(RenderPipeline Pipeline) const { return Pipelines[Pipeline - 1].Messages; }
+
+	uint32_t GetWidth() const override { return Width; }
+	uint32_t GetHeight() const override { return Height; }
+	RenderResource GetBackBuffer() override { return BackBuffers[CurrentBackBufferIndex]; }
+	void ResizeSwapChain(uint32_t Width, uint32_t Height) override;
+
+	RenderCommandList* BeginFrame() override;
+	void EndFrame() override;
+	uint32_t GetFramesInFlight() const override { return Scheduler.GetFramesInFlight(); }
+	uint32_t GetFrameSlot() const override { return Scheduler.GetFrameSlot(); }
+	uint64_t GetFrameNumber() const override { return Scheduler.GetFrameNumber(); }
+	uint64_t GetCompletedFrame() const override { return Scheduler.GetCompletedFrame(); }
+
+	RenderCommandList* AcquireCommandList() override;
+	void SubmitCommandLists(uint32_t Count, RenderCommandList* const* Lists) override;
+
+	void WaitIdle() override;
+
+	// Of the direct queue
+	uint64_t GetTimestampFrequency() override;
+	RenderQueryHeap CreateTimestampQueryHeap(uint32_t Count) override;
+	bool GetTimestampCalibration(uint64_t& GPUTimestamp, uint64_t& CPUNanoseconds) override;
+
+	ID3D12Device* GetDevice() const { return Device.Get(); }
+
+	// Writes the shaders, root signatures and pipeline state blobs created so far to the cache file
+	void SavePipelineCache();
+	const PipelineCache& GetPipelineCache() const { return Cache; }
+
+private:
+	friend class D3D12RenderCommandList;
+
+	struct Resource
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Object;
+		uint32_t SampleCount = 1;
+		uint32_t StructureStride = 0;
+		uint64_t Size = 0;
+		void* MappedData = nullptr; // upload and readback buffers, mapped on first use until released
+		D3D12_CPU_DESCRIPTOR_HANDLE RTV{};
+		D3D12_CPU_DESCRIPTOR_HANDLE DSV{};
+		uint32_t RTVIndex = DescriptorAllocator::InvalidIndex;
+		uint32_t DSVIndex = DescriptorAllocator::InvalidIndex;
+	};
+
+	// Released resource or heap and the frame that may still use it
+	struct ReleasedObject
+	{
+		uint64_t FrameNumber;
+		Microsoft::WRL::ComPtr<ID3D12Pageable> Object;
+	};
+
+	struct RootSignature
+	{
+		Microsoft::WRL::ComPtr<ID3D12RootSignature> Object;
+		std::vector<uint32_t> TableSizes; // descriptors in each root parameter's table, 0 for other parameters
+		uint64_t Hash;                     // pipeline cache key of the serialized root signature
+	};
+
+	struct Pipeline
+	{
+		Microsoft::WRL::ComPtr<ID3D12PipelineState> Object; // set once READY
+		RenderRootSignature RootSignature;
+		bool Compute;
+		RenderPipelineStatus Status;
+		std::vector<ShaderCompileMessage> Messages;
+	};
+
+	// Bytecode from the pipeline cache, ready at once, or compiling on the ShaderCompiler threads
+	struct PendingShader
+	{
+		uint64_t Key;
+		bool Cached;
+		std::shared_future<ShaderCompileResult> Result;
+	};
+
+	// Pipeline created when all its shaders are compiled, VS and PS, or CS
+	struct PendingPipeline
+	{
+		RenderPipeline Pipeline;
+		std::string Name;
+		RenderGraphicsPipelineDesc GraphicsDesc; // shader pointers cleared
+		PendingShader Shaders[2];
+		uint32_t ShaderCount;
+	};
+
+	// Command list recorded on a worker thread with an allocator of its own, created on first use
+	struct SecondaryCommandList
+	{
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CommandAllocator;
+		D3D12RenderCommandList CommandList;
+	};
+
+	static constexpr uint32_t MaxRenderTargetViews = 1024;
+	static constexpr uint32_t MaxDepthStencilViews = 1024;
+	// Descriptors of the tables set by the frames in flight
+	static constexpr uint32_t MaxStagedShaderViews = 64 * 1024;
+
+	// Looks the shader up in the pipeline cache, submits it to the ShaderCompiler on a miss
+	PendingShader RequestShader(const char* ShaderSource, const char* ShaderName, const char* EntryPoint, const char* ShaderModel);
+	// Creates the pending pipelines whose shaders are all compiled, or marks them FAILED
+	void UpdatePendingPipelines();
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> CreateGraphicsPipelineState(const RenderGraphicsPipelineDesc& Desc, const D3D12_SHADER_BYTECODE& VertexShader, const D3D12_SHADER_BYTECODE& PixelShader);
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> CreateComputePipelineState(RenderRootSignature Signature, const D3D12_SHADER_BYTECODE& ComputeShader);
+	// From the cached pipeline state blob when the driver takes it, else from scratch, storing the new blob
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> CreatePipelineState(uint64_t Key, const D3D12_GRAPHICS_PIPELINE_STATE_DESC* GraphicsDesc, const D3D12_COMPUTE_PIPELINE_STATE_DESC* ComputeDesc);
+
+	RenderResource AddResource(Resource&& NewResource);
+	// Names the resource and creates its render target and depth-stencil views
+	RenderResource AddTexture(Microsoft::WRL::ComPtr<ID3D12Resource>&& Object, const RenderTextureDesc& Desc);
+	RenderResource AddBuffer(Microsoft::WRL::ComPtr<ID3D12Resource>&& Object, const RenderBufferDesc& Desc);
+	// Persistent descriptor index, exits when the heap is full
+	uint32_t AllocateDescriptor(DescriptorAllocator& Allocator, const char* Kind);
+	RenderView AllocateShaderView();
+	D3D12_CPU_DESCRIPTOR_HANDLE GetShaderViewHandle(RenderView View) const;
+	// Copies Count views starting at FirstView into the shader visible heap, returns the table's GPU handle
+	D3D12_GPU_DESCRIPTOR_HANDLE StageShaderViews(RenderView FirstView, uint32_t Count);
+
+	uint32_t Width;
+	uint32_t Height;
+
+	Microsoft::WRL::ComPtr<IDXGIFactory6> Factory;
+	Microsoft::WRL::ComPtr<ID3D12Device> Device;
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> CommandQueue;
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CommandAllocators[FrameScheduler::MaxFramesInFlight];
+	Microsoft::WRL::ComPtr<IDXGISwapChain3> SwapChain;
+	HANDLE FrameLatencyWaitableObject = nullptr;
+	UINT SyncInterval = 1;
+
+	D3D12FrameFence Fence;
+	FrameScheduler Scheduler;
+
+	PipelineCache Cache;
+	ShaderCompileService ShaderCompiler;
+	std::vector<PendingPipeline> PendingPipelines;
+
+	// Views live in CPU-only heaps, tables are staged into the shader visible CBSRUAStagingHeap when set
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> RTDescriptorHeap;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> DSDescriptorHeap;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CBSRUADescriptorHeap;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CBSRUAStagingHeap;
+	DescriptorAllocator RTVDescriptors{ MaxRenderTargetViews, 0 };
+	DescriptorAllocator DSVDescriptors{ MaxDepthStencilViews, 0 };
+	DescriptorAllocator ShaderViewDescriptors{ RenderMaxViews, MaxStagedShaderViews };
+
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Heap>> Heaps;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12QueryHeap>> QueryHeaps;
+	std::vector<Resource> Resources;
+	std::vector<RootSignature> RootSignatures;
+	std::vector<Pipeline> Pipelines;
+
+	RenderResource BackBuffers[FrameScheduler::MaxFramesInFlight];
+	// Destroyed in BeginFrame once their frame has completed
+	std::vector<ReleasedObject> ReleasedObjects;
+
+	D3D12RenderCommandList CommandList;
+
+	FencedObjectPool<SecondaryCommandList, RenderMaxAcquiredCommandLists> SecondaryLists;
+	// Pool indices released when the frame ends
+	std::vector<uint32_t> SubmittedLists;
+
+	UINT CurrentBackBufferIndex = 0;
+};
@@ -0,0 +1,226 @@
+#include "D3D12ResolveBenchmark.h"
+
+#include <algorithm>
+
+#include <dxgi1_6.h>
+
+#include "DXHelpers.h"
+
+using namespace Microsoft::WRL;
+
+D3D12ResolveBenchmarkEngine::D3D12ResolveBenchmarkEngine()
+{
+	if (FAILED(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(Device.ReleaseAndGetAddressOf()))))
+	{
+		Device.Reset();
+		return;
+	}
+
+	ComPtr<IDXGIFactory4> Factory;
+	ComPtr<IDXGIAdapter1> Adapter;
+	DXGI_ADAPTER_DESC1 AdapterDesc;
+
+	if (SUCCEEDED(CreateDXGIFactory2(0, IID_PPV_ARGS(Factory.ReleaseAndGetAddressOf()))) && SUCCEEDED(Factory->EnumAdapterByLuid(Device->GetAdapterLuid(), IID_PPV_ARGS(Adapter.ReleaseAndGetAddressOf()))) && SUCCEEDED(Adapter->GetDesc1(&AdapterDesc)))
+	{
+		// Adapter names are ASCII
+		Name += " ";
+
+		for (const wchar_t* Character = AdapterDesc.Description; *Character; ++Character)
+			Name += static_cast<char>(*Character);
+	}
+
+	const D3D12_COMMAND_QUEUE_DESC QueueDesc = { D3D12_COMMAND_LIST_TYPE_DIRECT };
+	SAFE_DX(Device->CreateCommandQueue(&QueueDesc, IID_PPV_ARGS(CommandQueue.ReleaseAndGetAddressOf())));
+	SAFE_DX(Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(CommandAllocator.ReleaseAndGetAddressOf())));
+	SAFE_DX(Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, CommandAllocator.Get(), nullptr, IID_PPV_ARGS(CommandList.ReleaseAndGetAddressOf())));
+	SAFE_DX(CommandList->Close());
+
+	SAFE_DX(Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(Fence.ReleaseAndGetAddressOf())));
+	Event = CreateEvent(nullptr, FALSE, FALSE, L"ResolveBenchmarkEvent");
+
+	const D3D12_QUERY_HEAP_DESC QueryHeapDesc = { D3D12_QUERY_HEAP_TYPE_TIMESTAMP, 2 };
+	SAFE_DX(Device->CreateQueryHeap(&QueryHeapDesc, IID_PPV_ARGS(TimestampHeap.ReleaseAndGetAddressOf())));
+	SAFE_DX(CommandQueue->GetTimestampFrequency(&TimestampFrequency));
+
+	D3D12_HEAP_PROPERTIES ReadbackHeap = {};
+	ReadbackHeap.Type = D3D12_HEAP_TYPE_READBACK;
+
+	D3D12_RESOURCE_DESC BufferDesc = {};
+	BufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	BufferDesc.Width = 2 * sizeof(uint64_t);
+	BufferDesc.Height = 1;
+	BufferDesc.DepthOrArraySize = 1;
+	BufferDesc.MipLevels = 1;
+	BufferDesc.SampleDesc.Count = 1;
+	BufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+	SAFE_DX(Device->CreateCommittedResource(&ReadbackHeap, D3D12_HEAP_FLAG_NONE, &BufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(TimestampReadback.ReleaseAndGetAddressOf())));
+
+	const D3D12_DESCRIPTOR_HEAP_DESC DSVHeapDesc = { D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1 };
+	SAFE_DX(Device->CreateDescriptorHeap(&DSVHeapDesc, IID_PPV_ARGS(DSVHeap.ReleaseAndGetAddressOf())));
+}
+
+D3D12ResolveBenchmarkEngine::~D3D12ResolveBenchmarkEngine()
+{
+	if (Event)
+		CloseHandle(Event);
+}
+
+void D3D12ResolveBenchmarkEngine::ExecuteAndWait()
+{
+	SAFE_DX(CommandList->Close());
+
+	ID3D12CommandList* Lists[] = { CommandList.Get() };
+	CommandQueue->ExecuteCommandLists(1, Lists);
+
+	SAFE_DX(CommandQueue->Signal(Fence.Get(), ++FenceValue));
+	SAFE_DX(Fence->SetEventOnCompletion(FenceValue, Event));
+	WaitForSingleObject(Event, INFINITE);
+}
+
+bool D3D12ResolveBenchmarkEngine::IsSupported(const ResolveBenchmarkConfig& Config, const char*& Why)
+{
+	// Depth formats resolve with MIN and MAX only
+	if (Config.Mode != RENDER_RESOLVE_MODE_MIN && Config.Mode != RENDER_RESOLVE_MODE_MAX)
+	{
+		Why = "mode";
+		return false;
+	}
+
+	D3D12_FEATURE_DATA_D3D12_OPTIONS2 Options2 = {};
+
+	if (FAILED(Device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS2, &Options2, sizeof(Options2))) || Options2.ProgrammableSamplePositionsTier < D3D12_PROGRAMMABLE_SAMPLE_POSITIONS_TIER_2)
+	{
+		Why = "device";
+		return false;
+	}
+
+	D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS QualityLevels = {};
+	QualityLevels.Format = static_cast<DXGI_FORMAT>(Config.Format);
+	QualityLevels.SampleCount = Config.SampleCount;
+
+	if (FAILED(Device->CheckFeatureSupport(D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS, &QualityLevels, sizeof(QualityLevels))) || QualityLevels.NumQualityLevels == 0)
+	{
+		Why = "sample count";
+		return false;
+	}
+
+	return true;
+}
+
+bool D3D12ResolveBenchmarkEngine::Prepare(const ResolveBenchmarkConfig& NewConfig)
+{
+	const bool SameSource = Source && Config.Width == NewConfig.Width && Config.Height == NewConfig.Height && Config.SampleCount == NewConfig.SampleCount && Config.Format == NewConfig.Format;
+	Config = NewConfig;
+
+	if (SameSource)
+		return true;
+
+	Source.Reset();
+	Destination.Reset();
+
+	D3D12_HEAP_PROPERTIES DefaultHeap = {};
+	DefaultHeap.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+	D3D12_RESOURCE_DESC TextureDesc = {};
+	TextureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	TextureDesc.Width = Config.Width;
+	TextureDesc.Height = Config.Height;
+	TextureDesc.DepthOrArraySize = 1;
+	TextureDesc.MipLevels = 1;
+	TextureDesc.Format = static_cast<DXGI_FORMAT>(Config.Format);
+	TextureDesc.SampleDesc.Count = Config.SampleCount;
+	TextureDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+
+	D3D12_CLEAR_VALUE ClearValue = {};
+	ClearValue.Format = TextureDesc.Format;
+	ClearValue.DepthStencil.Depth = 0.5f;
+
+	if (FAILED(Device->CreateCommittedResource(&DefaultHeap, D3D12_HEAP_FLAG_NONE, &TextureDesc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &ClearValue, IID_PPV_ARGS(Source.ReleaseAndGetAddressOf()))))
+	{
+		Source.Reset();
+		return false;
+	}
+
+	TextureDesc.SampleDesc.Count = 1;
+
+	if (FAILED(Device->CreateCommittedResource(&DefaultHeap, D3D12_HEAP_FLAG_NONE, &TextureDesc, D3D12_RESOURCE_STATE_RESOLVE_DEST, nullptr, IID_PPV_ARGS(Destination.ReleaseAndGetAddressOf()))))
+	{
+		Source.Reset();
+		Destination.Reset();
+		return false;
+	}
+
+	D3D12_DEPTH_STENCIL_VIEW_DESC DSVDesc = {};
+	DSVDesc.Format = TextureDesc.Format;
+	DSVDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2DMS;
+
+	const D3D12_CPU_DESCRIPTOR_HANDLE DSV = DSVHeap->GetCPUDescriptorHandleForHeapStart();
+	Device->CreateDepthStencilView(Source.Get(), &DSVDesc, DSV);
+
+	SAFE_DX(CommandAllocator->Reset());
+	SAFE_DX(CommandList->Reset(CommandAllocator.Get(), nullptr));
+
+	CommandList->ClearDepthStencilView(DSV, D3D12_CLEAR_FLAG_DEPTH, 0.5f, 0, 0, nullptr);
+
+	D3D12_RESOURCE_BARRIER Barrier = {};
+	Barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+	Barrier.Transition.pResource = Source.Get();
+	Barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+	Barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+	Barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_RESOLVE_SOURCE;
+	CommandList->ResourceBarrier(1, &Barrier);
+
+	ExecuteAndWait();
+
+	return true;
+}
+
+double D3D12ResolveBenchmarkEngine::Resolve()
+{
+	// The depth plane, the format ResolveSubresourceRegion reads it as
+	const DXGI_FORMAT Format = static_cast<DXGI_FORMAT>(GetRenderDepthFormatInfo(Config.Format)->DepthPlaneFormat);
+	const D3D12_RESOLVE_MODE Mode = static_cast<D3D12_RESOLVE_MODE>(Config.Mode);
+
+	SAFE_DX(CommandAllocator->Reset());
+	SAFE_DX(CommandList->Reset(CommandAllocator.Get(), nullptr));
+
+	CommandList->EndQuery(TimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0);
+
+	if (!Config.Regions)
+	{
+		CommandList->ResolveSubresourceRegion(Destination.Get(), 0, 0, 0, Source.Get(), 0, nullptr, Format, Mode);
+	}
+	else
+	{
+		for (uint32_t y = 0; y < Config.Height; y += ResolveBenchmarkRegionSize)
+		{
+			for (uint32_t x = 0; x < Config.Width; x += ResolveBenchmarkRegionSize)
+			{
+				D3D12_RECT Rect = { static_cast<LONG>(x), static_cast<LONG>(y), static_cast<LONG>(std::min(x + ResolveBenchmarkRegionSize, Config.Width)), static_cast<LONG>(std::min(y + ResolveBenchmarkRegionSize, Config.Height)) };
+				CommandList->ResolveSubresourceRegion(Destination.Get(), 0, x, y, Source.Get(), 0, &Rect, Format, Mode);
+			}
+		}
+	}
+
+	CommandList->EndQuery(TimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 1);
+	CommandList->ResolveQueryData(TimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0, 2, TimestampReadback.Get(), 0);
+
+	ExecuteAndWait();
+
+	uint64_t* Timestamps = nullptr;
+	const D3D12_RANGE ReadRange = { 0, 2 * sizeof(uint64_t) };
+	const D3D12_RANGE WrittenRange = { 0, 0 };
+
+	SAFE_DX(TimestampReadback->Map(0, &ReadRange, reinterpret_cast<void**>(&Timestamps)));
+	const double Milliseconds = static_cast<double>(Timestamps[1] - Timestamps[0]) * 1000.0 / static_cast<double>(TimestampFrequency);
+	TimestampReadback->Unmap(0, &WrittenRange);
+
+	return Milliseconds;
+}
+
+uint64_t D3D12ResolveBenchmarkEngine::GetTrafficBytes(const ResolveBenchmarkConfig& Config) const
+{
+	const uint64_t PixelCount = static_cast<uint64_t>(Config.Width) * Config.Height;
+	return PixelCount * (Config.SampleCount + 1) * GetDepthFormatSampleSize(Config.Format);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include "ResolveBenchmark.h"
+
+// ResolveSubresourceRegion on a device of its own, on the default adapter, timed with timestamp queries around the
+// resolve. The source is cleared rather than drawn, so hardware that keeps cleared depth compressed may resolve it
+// faster than a rendered frame.
+class D3D12ResolveBenchmarkEngine : public ResolveBenchmarkEngine
+{
+public:
+	D3D12ResolveBenchmarkEngine();
+	~D3D12ResolveBenchmarkEngine() override;
+
+	// False when there is no D3D12 device to run on
+	bool IsAvailable() const { return Device != nullptr; }
+
+	const char* GetName() const override { return Name.c_str(); }
+	bool IsSupported(const ResolveBenchmarkConfig& Config, const char*& Why) override;
+	bool Prepare(const ResolveBenchmarkConfig& Config) override;
+	double Resolve() override;
+	uint64_t GetTrafficBytes(const ResolveBenchmarkConfig& Config) const override;
+
+private:
+	void ExecuteAndWait();
+
+	std::string Name = "D3D12";
+
+	Microsoft::WRL::ComPtr<ID3D12Device> Device;
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> CommandQueue;
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CommandAllocator;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList1> CommandList;
+	Microsoft::WRL::ComPtr<ID3D12Fence> Fence;
+	HANDLE Event = nullptr;
+	uint64_t FenceValue = 0;
+
+	Microsoft::WRL::ComPtr<ID3D12QueryHeap> TimestampHeap;
+	Microsoft::WRL::ComPtr<ID3D12Resource> TimestampReadback;
+	uint64_t TimestampFrequency = 1;
+
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> DSVHeap;
+
+	ResolveBenchmarkConfig Config = {};
+	Microsoft::WRL::ComPtr<ID3D12Resource> Source;
+	Microsoft::WRL::ComPtr<ID3D12Resource> Destination;
+};
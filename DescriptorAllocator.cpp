@@ -0,0 +1,70 @@
+#include "DescriptorAllocator.h"
+
+DescriptorFreeList::DescriptorFreeList(uint32_t Capacity) : NextFree(Capacity, InvalidIndex)
+{
+}
+
+uint32_t DescriptorFreeList::Allocate()
+{
+	uint32_t Index;
+
+	if (FirstFree != InvalidIndex)
+	{
+		Index = FirstFree;
+		FirstFree = NextFree[Index];
+	}
+	else if (NextUnused < NextFree.size())
+	{
+		Index = NextUnused++;
+	}
+	else
+	{
+		return InvalidIndex;
+	}
+
+	++AllocatedCount;
+	return Index;
+}
+
+void DescriptorFreeList::Free(uint32_t Index)
+{
+	NextFree[Index] = FirstFree;
+	FirstFree = Index;
+	--AllocatedCount;
+}
+
+DescriptorAllocator::DescriptorAllocator(uint32_t PersistentCapacity, uint32_t StagingCapacity) : PersistentIndices(PersistentCapacity), StagingRing(StagingCapacity)
+{
+}
+
+void DescriptorAllocator::SetLayouts(const DescriptorHeapLayout& Persistent, const DescriptorHeapLayout& Staging)
+{
+	PersistentLayout = Persistent;
+	StagingLayout = Staging;
+}
+
+uint32_t DescriptorAllocator::AllocateStaging(uint32_t Count)
+{
+	std::lock_guard<std::mutex> Lock(StagingMutex);
+
+	const uint64_t Index = StagingRing.Allocate(Count, 1);
+	return Index == UploadRing::InvalidOffset ? InvalidIndex : static_cast<uint32_t>(Index);
+}
+
+void DescriptorAllocator::FinishFrame(uint64_t FenceValue)
+{
+	std::lock_guard<std::mutex> Lock(StagingMutex);
+	StagingRing.FinishFrame(FenceValue);
+}
+
+void DescriptorAllocator::Reclaim(uint64_t CompletedValue)
+{
+	std::lock_guard<std::mutex> Lock(StagingMutex);
+	StagingRing.Reclaim(CompletedValue);
+}
+
+uint32_t DescriptorAllocator::GetStagedCount() const
+{
+	std::lock_guard<std::mutex> Lock(StagingMutex);
+	return static_cast<uint32_t>(StagingRing.GetUsedSize());
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "UploadRingAllocator.h"
+
+// Descriptor i of a heap lives at Start + i * IncrementSize; D3D12 handles are plain integers, so the layout is
+// filled in once from the heap and GetDescriptorHandleIncrementSize and never queried again
+struct DescriptorHeapLayout
+{
+	uint64_t CPUStart = 0;
+	uint64_t GPUStart = 0; // shader visible heaps only
+	uint32_t IncrementSize = 0;
+
+	uint64_t GetCPUHandle(uint32_t Index) const { return CPUStart + static_cast<uint64_t>(Index) * IncrementSize; }
+	uint64_t GetGPUHandle(uint32_t Index) const { return GPUStart + static_cast<uint64_t>(Index) * IncrementSize; }
+};
+
+// Indices of a fixed capacity heap. Freed indices are chained through an array sized up front, so allocating and
+// freeing are O(1) and never allocate. Indices are handed out in order until the first one is freed, after that
+// the most recently freed comes first.
+class DescriptorFreeList
+{
+public:
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+	explicit DescriptorFreeList(uint32_t Capacity);
+
+	// InvalidIndex when every index is allocated
+	uint32_t Allocate();
+	void Free(uint32_t Index);
+
+	uint32_t GetCapacity() const { return static_cast<uint32_t>(NextFree.size()); }
+	uint32_t GetAllocatedCount() const { return AllocatedCount; }
+
+private:
+	std::vector<uint32_t> NextFree;
+	uint32_t FirstFree = InvalidIndex;
+	uint32_t NextUnused = 0;
+	uint32_t AllocatedCount = 0;
+};
+
+// Descriptors of one heap type: a persistent CPU-only heap views are created in, and a shader visible ring that
+// the descriptor tables of a frame are copied into when they are set. Staged descriptors are reclaimed by fence
+// value like UploadRing memory, so persistent ones can be freed or overwritten as soon as no table is set from
+// them anymore.
+class DescriptorAllocator
+{
+public:
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+	DescriptorAllocator(uint32_t PersistentCapacity, uint32_t StagingCapacity);
+
+	void SetLayouts(const DescriptorHeapLayout& Persistent, const DescriptorHeapLayout& Staging);
+
+	uint32_t AllocatePersistent() { return PersistentIndices.Allocate(); }
+	void FreePersistent(uint32_t Index) { PersistentIndices.Free(Index); }
+
+	// Count contiguous staging descriptors, InvalidIndex when the frames in flight use the whole ring. Callable
+	// from any thread.
+	uint32_t AllocateStaging(uint32_t Count);
+	// Everything staged since the last call is in use until FenceValue completes
+	void FinishFrame(uint64_t FenceValue);
+	void Reclaim(uint64_t CompletedValue);
+
+	uint64_t GetPersistentHandle(uint32_t Index) const { return PersistentLayout.GetCPUHandle(Index); }
+	uint64_t GetStagingCPUHandle(uint32_t Index) const { return StagingLayout.GetCPUHandle(Index); }
+	uint64_t GetStagingGPUHandle(uint32_t Index) const { return StagingLayout.GetGPUHandle(Index); }
+
+	uint32_t GetPersistentCapacity() const { return PersistentIndices.GetCapacity(); }
+	uint32_t GetStagingCapacity() const { return static_cast<uint32_t>(StagingRing.GetCapacity()); }
+	uint32_t GetPersistentCount() const { return PersistentIndices.GetAllocatedCount(); }
+	uint32_t GetStagedCount() const;
+
+private:
+	DescriptorHeapLayout PersistentLayout;
+	DescriptorHeapLayout StagingLayout;
+
+	DescriptorFreeList PersistentIndices;
+
+	// Counts descriptors instead of bytes. Worker threads stage their tables while recording.
+	mutable std::mutex StagingMutex;
+	UploadRing StagingRing;
+};
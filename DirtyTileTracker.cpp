@@ -0,0 +1,172 @@
+#include "DirtyTileTracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+DirtyTileTracker::DirtyTileTracker(uint32_t Width, uint32_t Height, uint32_t TileSize) : Width(Width), Height(Height), TileSize(std::max(TileSize, 1u))
+{
+	TilesX = (Width + this->TileSize - 1) / this->TileSize;
+	TilesY = (Height + this->TileSize - 1) / this->TileSize;
+
+	CurrentTiles.assign(TilesX * TilesY, 0);
+	PreviousTiles.assign(TilesX * TilesY, 0);
+
+	Invalidate();
+}
+
+// True when all three positions are outside the same clip plane, then the triangle is clipped away whole
+static bool IsTriangleOutside(const CPUFloat4 Positions[3])
+{
+	bool Outside[6] = { true, true, true, true, true, true };
+
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		const CPUFloat4& p = Positions[i];
+		Outside[0] = Outside[0] && p.x < -p.w;
+		Outside[1] = Outside[1] && p.x > p.w;
+		Outside[2] = Outside[2] && p.y < -p.w;
+		Outside[3] = Outside[3] && p.y > p.w;
+		Outside[4] = Outside[4] && p.z < 0.0f;
+		Outside[5] = Outside[5] && p.z > p.w;
+	}
+
+	return std::find(Outside, Outside + 6, true) != Outside + 6;
+}
+
+void DirtyTileTracker::MarkDrawIndexed(const CPUFloat3* Vertices, const uint16_t* Indices, uint32_t IndexCount, const CPUMatrix& Transform)
+{
+	const RenderRect Screen = { 0, 0, static_cast<int32_t>(Width), static_cast<int32_t>(Height) };
+
+	for (uint32_t i = 0; i + 2 < IndexCount; i += 3)
+	{
+		CPUFloat4 Positions[3];
+
+		for (uint32_t v = 0; v < 3; ++v)
+			Positions[v] = CPUTransformPoint(Vertices[Indices[i + v]], Transform);
+
+		if (IsTriangleOutside(Positions))
+			continue;
+
+		// Behind the eye the projection flips, the clipped triangle can end up anywhere
+		if (Positions[0].w <= 0.0f || Positions[1].w <= 0.0f || Positions[2].w <= 0.0f)
+		{
+			MarkRect(Screen);
+			continue;
+		}
+
+		float MinX = INFINITY, MinY = INFINITY, MaxX = -INFINITY, MaxY = -INFINITY;
+
+		for (const CPUFloat4& p : Positions)
+		{
+			const float x = (p.x / p.w * 0.5f + 0.5f) * Width;
+			const float y = (0.5f - p.y / p.w * 0.5f) * Height;
+			MinX = std::min(MinX, x);
+			MinY = std::min(MinY, y);
+			MaxX = std::max(MaxX, x);
+			MaxY = std::max(MaxY, y);
+		}
+
+		// One pixel of margin for vertex snapping, the clamp keeps the conversions in range
+		const float Limit = static_cast<float>(std::max(Width, Height)) + 1.0f;
+		const RenderRect Bounds =
+		{
+			static_cast<int32_t>(std::floor(std::clamp(MinX, -1.0f, Limit))) - 1,
+			static_cast<int32_t>(std::floor(std::clamp(MinY, -1.0f, Limit))) - 1,
+			static_cast<int32_t>(std::ceil(std::clamp(MaxX, -1.0f, Limit))) + 1,
+			static_cast<int32_t>(std::ceil(std::clamp(MaxY, -1.0f, Limit))) + 1
+		};
+
+		MarkRect(Bounds);
+	}
+}
+
+void DirtyTileTracker::MarkRect(const RenderRect& Rect)
+{
+	const int32_t Left = std::max(Rect.Left, 0), Top = std::max(Rect.Top, 0);
+	const int32_t Right = std::min(Rect.Right, static_cast<int32_t>(Width)), Bottom = std::min(Rect.Bottom, static_cast<int32_t>(Height));
+
+	if (Left >= Right || Top >= Bottom)
+		return;
+
+	for (uint32_t TileY = Top / TileSize; TileY <= (Bottom - 1) / TileSize; ++TileY)
+		std::fill_n(&CurrentTiles[TileY * TilesX + Left / TileSize], (Right - 1) / TileSize - Left / TileSize + 1, 1);
+}
+
+void DirtyTileTracker::MarkTiles(const std::vector<uint8_t>& Tiles)
+{
+	if (Tiles.size() != CurrentTiles.size())
+		return;
+
+	for (size_t i = 0; i < Tiles.size(); ++i)
+		CurrentTiles[i] |= Tiles[i];
+}
+
+void DirtyTileTracker::Invalidate()
+{
+	std::fill(PreviousTiles.begin(), PreviousTiles.end(), 1);
+}
+
+const std::vector<RenderRect>& DirtyTileTracker::GetDirtyRects()
+{
+	DirtyRects.clear();
+
+	// Rectangles that end at the row above, the only ones a run of this row can extend
+	size_t OpenBegin = 0;
+
+	for (uint32_t TileY = 0; TileY < TilesY; ++TileY)
+	{
+		const size_t OpenEnd = DirtyRects.size();
+		const int32_t Top = TileY * TileSize;
+		const int32_t Bottom = std::min((TileY + 1) * TileSize, Height);
+
+		for (uint32_t TileX = 0; TileX < TilesX;)
+		{
+			const uint32_t Index = TileY * TilesX + TileX;
+
+			if (!CurrentTiles[Index] && !PreviousTiles[Index])
+			{
+				++TileX;
+				continue;
+			}
+
+			uint32_t End = TileX + 1;
+
+			while (End < TilesX && (CurrentTiles[TileY * TilesX + End] || PreviousTiles[TileY * TilesX + End]))
+				++End;
+
+			const int32_t Left = TileX * TileSize;
+			const int32_t Right = std::min(End * TileSize, Width);
+
+			auto Open = std::find_if(DirtyRects.begin() + OpenBegin, DirtyRects.begin() + OpenEnd, [&](const RenderRect& Rect) { return Rect.Left == Left && Rect.Right == Right; });
+
+			if (Open != DirtyRects.begin() + OpenEnd)
+				Open->Bottom = Bottom;
+			else
+				DirtyRects.push_back({ Left, Top, Right, Bottom });
+
+			TileX = End;
+		}
+
+		// Rectangles of the row above that were not extended are closed
+		std::stable_partition(DirtyRects.begin() + OpenBegin, DirtyRects.end(), [&](const RenderRect& Rect) { return Rect.Bottom != Bottom; });
+		OpenBegin = std::find_if(DirtyRects.begin() + OpenBegin, DirtyRects.end(), [&](const RenderRect& Rect) { return Rect.Bottom == Bottom; }) - DirtyRects.begin();
+	}
+
+	return DirtyRects;
+}
+
+void DirtyTileTracker::EndFrame()
+{
+	CurrentTiles.swap(PreviousTiles);
+	std::fill(CurrentTiles.begin(), CurrentTiles.end(), 0);
+}
+
+uint32_t DirtyTileTracker::GetDirtyTileCount() const
+{
+	uint32_t Count = 0;
+
+	for (size_t i = 0; i < CurrentTiles.size(); ++i)
+		Count += CurrentTiles[i] || PreviousTiles[i];
+
+	return Count;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RenderBackend.h"
+#include "CPUMath.h"
+
+// Screen tiles the geometry of the last two frames may cover, so a resolve only has to process those. A tile drawn
+// into this frame holds new samples, a tile drawn into last frame and not this one went back to the clear value and
+// is resolved once more to put the clear value back. Every other tile still holds the resolve of the clear value.
+class DirtyTileTracker
+{
+public:
+	static constexpr uint32_t DefaultTileSize = 64;
+
+	// Starts invalidated: the first frame resolves everything
+	DirtyTileTracker(uint32_t Width, uint32_t Height, uint32_t TileSize = DefaultTileSize);
+
+	// Marks the tiles covered by the screen bounds of each triangle of an indexed draw, transformed by Transform and
+	// the viewport of the whole screen. Triangles crossing the near plane mark the whole screen.
+	void MarkDrawIndexed(const CPUFloat3* Vertices, const uint16_t* Indices, uint32_t IndexCount, const CPUMatrix& Transform);
+	void MarkRect(const RenderRect& Rect);
+	// Marks the tiles set in Tiles, what GetMarkedTiles returned on a tracker of the same size and tile size
+	void MarkTiles(const std::vector<uint8_t>& Tiles);
+	// The next frame resolves everything, for when the resolved target lost its content
+	void Invalidate();
+
+	// Rectangles over the tiles marked this frame or the previous one, clamped to the screen. A run of tiles in a
+	// row is one rectangle, runs spanning the same columns in consecutive rows are merged.
+	const std::vector<RenderRect>& GetDirtyRects();
+	// This frame's tiles become the previous frame's
+	void EndFrame();
+
+	// Tiles marked this frame, one byte per tile row by row
+	const std::vector<uint8_t>& GetMarkedTiles() const { return CurrentTiles; }
+
+	uint32_t GetTileSize() const { return TileSize; }
+	uint32_t GetTileCount() const { return TilesX * TilesY; }
+	// Tiles GetDirtyRects covers
+	uint32_t GetDirtyTileCount() const;
+
+private:
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t TileSize;
+	uint32_t TilesX;
+	uint32_t TilesY;
+
+	std::vector<uint8_t> CurrentTiles;
+	std::vector<uint8_t> PreviousTiles;
+	std::vector<RenderRect> DirtyRects;
+};
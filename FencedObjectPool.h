@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Fixed set of objects handed out to any thread without locks. An object released with a fence value is handed out
+// again once the fence has completed that value. Every slot is one atomic word holding the fence value of its last
+// release and a busy bit, so acquiring is a compare-exchange on the first slot found free and completed.
+template<typename T, uint32_t Capacity>
+class FencedObjectPool
+{
+public:
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+	// Index of an object no longer used by work before CompletedValue, InvalidIndex when all are busy or in flight.
+	// The caller owns the object until Release.
+	uint32_t Acquire(uint64_t CompletedValue)
+	{
+		// Threads start the scan at different slots so they do not all fight over the first one
+		const uint32_t Start = NextScan.fetch_add(1, std::memory_order_relaxed);
+
+		for (uint32_t i = 0; i < Capacity; ++i)
+		{
+			const uint32_t Index = (Start + i) % Capacity;
+			uint64_t State = States[Index].load(std::memory_order_acquire);
+
+			if ((State & BusyBit) == 0 && (State >> 1) <= CompletedValue &&
+				States[Index].compare_exchange_strong(State, State | BusyBit, std::memory_order_acquire, std::memory_order_relaxed))
+			{
+				return Index;
+			}
+		}
+
+		return InvalidIndex;
+	}
+
+	// Work using the object completes when the fence reaches FenceValue
+	void Release(uint32_t Index, uint64_t FenceValue)
+	{
+		States[Index].store(FenceValue << 1, std::memory_order_release);
+	}
+
+	T& operator[](uint32_t Index) { return Objects[Index]; }
+	const T& operator[](uint32_t Index) const { return Objects[Index]; }
+
+	static constexpr uint32_t GetCapacity() { return Capacity; }
+
+private:
+	static constexpr uint64_t BusyBit = 1;
+
+	T Objects[Capacity];
+	std::atomic<uint64_t> States[Capacity]; // value-initialized to 0: free, completed
+	std::atomic<uint32_t> NextScan{ 0 };
+};
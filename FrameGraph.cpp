@@ -0,0 +1,476 @@
+#include "FrameGraph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <utility>
+
+#include "Profiler.h"
+#include "RenderHeapPool.h"
+
+static uint64_t AlignUp(uint64_t Value, uint64_t Alignment)
+{
+	return Alignment > 1 ? (Value + Alignment - 1) / Alignment * Alignment : Value;
+}
+
+uint64_t PlanTransientAliasing(std::vector<TransientAllocation>& Allocations)
+{
+	std::vector<uint32_t> Order(Allocations.size());
+	std::iota(Order.begin(), Order.end(), 0);
+
+	std::stable_sort(Order.begin(), Order.end(), [&](uint32_t A, uint32_t B)
+	{
+		if (Allocations[A].Size != Allocations[B].Size)
+			return Allocations[A].Size > Allocations[B].Size;
+
+		return Allocations[A].FirstPass < Allocations[B].FirstPass;
+	});
+
+	std::vector<uint32_t> Placed;
+	std::vector<std::pair<uint64_t, uint64_t>> Ranges;
+	uint64_t HeapSize = 0;
+
+	for (uint32_t Index : Order)
+	{
+		TransientAllocation& Allocation = Allocations[Index];
+
+		// Memory taken by everything already placed that is alive at the same time
+		Ranges.clear();
+
+		for (uint32_t Other : Placed)
+		{
+			const TransientAllocation& Current = Allocations[Other];
+
+			if (Current.FirstPass <= Allocation.LastPass && Allocation.FirstPass <= Current.LastPass)
+				Ranges.push_back({ Current.Offset, Current.Offset + Current.Size });
+		}
+
+		std::sort(Ranges.begin(), Ranges.end());
+
+		uint64_t Offset = 0;
+
+		for (const std::pair<uint64_t, uint64_t>& Range : Ranges)
+		{
+			if (Offset + Allocation.Size <= Range.first)
+				break;
+
+			if (Range.second > Offset)
+				Offset = AlignUp(Range.second, Allocation.Alignment);
+		}
+
+		Allocation.Offset = Offset;
+		HeapSize = std::max(HeapSize, Offset + Allocation.Size);
+		Placed.push_back(Index);
+	}
+
+	return HeapSize;
+}
+
+uint64_t GetPeakLiveSize(const std::vector<TransientAllocation>& Allocations)
+{
+	uint32_t PassCount = 0;
+
+	for (const TransientAllocation& Allocation : Allocations)
+		PassCount = std::max(PassCount, Allocation.LastPass + 1);
+
+	std::vector<uint64_t> LiveSize(PassCount, 0);
+
+	for (const TransientAllocation& Allocation : Allocations)
+	{
+		for (uint32_t Pass = Allocation.FirstPass; Pass <= Allocation.LastPass; ++Pass)
+			LiveSize[Pass] += Allocation.Size;
+	}
+
+	return LiveSize.empty() ? 0 : *std::max_element(LiveSize.begin(), LiveSize.end());
+}
+
+FrameGraphResource FrameGraph::AddResource(GraphResource&& NewResource)
+{
+	Resources.push_back(std::move(NewResource));
+	return static_cast<FrameGraphResource>(Resources.size());
+}
+
+FrameGraphResource FrameGraph::CreateTexture(const RenderTextureDesc& Desc)
+{
+	GraphResource Texture{};
+	Texture.Imported = false;
+	Texture.Buffer = false;
+	Texture.TextureDesc = Desc;
+	Texture.Name = Desc.Name;
+	Texture.InitialState = Desc.InitialState;
+	Texture.FinalState = Desc.InitialState;
+	Texture.HeapKind = (Desc.Flags & (RENDER_RESOURCE_FLAG_ALLOW_RENDER_TARGET | RENDER_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) ? RENDER_HEAP_KIND_TARGET_TEXTURES : RENDER_HEAP_KIND_OTHER_TEXTURES;
+
+	return AddResource(std::move(Texture));
+}
+
+FrameGraphResource FrameGraph::CreateBuffer(const RenderBufferDesc& Desc)
+{
+	GraphResource Buffer{};
+	Buffer.Imported = false;
+	Buffer.Buffer = true;
+	Buffer.BufferDesc = Desc;
+	Buffer.BufferDesc.HeapType = RENDER_HEAP_TYPE_DEFAULT;
+	Buffer.Name = Desc.Name;
+	Buffer.InitialState = Desc.InitialState;
+	Buffer.FinalState = Desc.InitialState;
+	Buffer.HeapKind = RENDER_HEAP_KIND_BUFFERS;
+
+	return AddResource(std::move(Buffer));
+}
+
+bool FrameGraph::SetTextureSize(FrameGraphResource Handle, uint32_t Width, uint32_t Height)
+{
+	if (Compiled || Handle == RenderNullHandle || Handle > Resources.size() || Resources[Handle - 1].Imported || Resources[Handle - 1].Buffer)
+		return false;
+
+	Resources[Handle - 1].TextureDesc.Width = Width;
+	Resources[Handle - 1].TextureDesc.Height = Height;
+	return true;
+}
+
+bool FrameGraph::SetBufferSize(FrameGraphResource Handle, uint64_t Size)
+{
+	if (Compiled || Handle == RenderNullHandle || Handle > Resources.size() || Resources[Handle - 1].Imported || !Resources[Handle - 1].Buffer)
+		return false;
+
+	Resources[Handle - 1].BufferDesc.Size = Size;
+	return true;
+}
+
+FrameGraphResource FrameGraph::Import(const char* Name, RenderResource Resource, RenderResourceState InitialState, RenderResourceState FinalState)
+{
+	GraphResource Imported{};
+	Imported.Imported = true;
+	Imported.Name = Name;
+	Imported.Resource = Resource;
+	Imported.InitialState = InitialState;
+	Imported.FinalState = FinalState;
+
+	return AddResource(std::move(Imported));
+}
+
+void FrameGraph::SetImported(FrameGraphResource Handle, RenderResource Resource)
+{
+	if (Handle != RenderNullHandle && Handle <= Resources.size() && Resources[Handle - 1].Imported)
+		Resources[Handle - 1].Resource = Resource;
+}
+
+void FrameGraph::MarkOutput(FrameGraphResource Handle)
+{
+	if (Handle != RenderNullHandle && Handle <= Resources.size())
+		Resources[Handle - 1].Output = true;
+}
+
+uint32_t FrameGraph::AddPass(const char* Name, PassFunction Execute)
+{
+	Pass NewPass;
+	NewPass.Name = Name;
+	NewPass.Execute = std::move(Execute);
+
+	Passes.push_back(std::move(NewPass));
+	return static_cast<uint32_t>(Passes.size() - 1);
+}
+
+bool FrameGraph::AddUse(uint32_t Pass, FrameGraphResource Handle, RenderResourceState State, bool Write)
+{
+	if (Compiled || Pass >= Passes.size() || Handle == RenderNullHandle || Handle > Resources.size())
+		return false;
+
+	Passes[Pass].Uses.push_back({ Handle, State, Write });
+	return true;
+}
+
+bool FrameGraph::Read(uint32_t Pass, FrameGraphResource Handle, RenderResourceState State)
+{
+	return AddUse(Pass, Handle, State, false);
+}
+
+bool FrameGraph::Write(uint32_t Pass, FrameGraphResource Handle, RenderResourceState State)
+{
+	return AddUse(Pass, Handle, State, true);
+}
+
+void FrameGraph::CullPasses()
+{
+	// Walking backwards, a pass survives when it writes something observed after it
+	std::vector<bool> Needed(Resources.size());
+
+	for (size_t i = 0; i < Resources.size(); ++i)
+		Needed[i] = Resources[i].Imported || Resources[i].Output;
+
+	for (size_t i = Passes.size(); i-- > 0;)
+	{
+		Pass& Current = Passes[i];
+		Current.Culled = true;
+
+		for (const ResourceUse& Use : Current.Uses)
+		{
+			if (Use.Write && Needed[Use.Handle - 1])
+				Current.Culled = false;
+		}
+
+		if (Current.Culled)
+			continue;
+
+		for (const ResourceUse& Use : Current.Uses)
+		{
+			if (!Use.Write)
+				Needed[Use.Handle - 1] = true;
+		}
+	}
+}
+
+bool FrameGraph::Compile(RenderBackend& Backend, ResourceStateTracker& Tracker, RenderHeapPool* HeapPool)
+{
+	if (Compiled)
+		return false;
+
+	Compiled = true;
+
+	CullPasses();
+
+	Report = FrameGraphMemoryReport();
+	uint32_t Order = 0;
+
+	for (Pass& Current : Passes)
+	{
+		if (Current.Culled)
+		{
+			++Report.CulledPassCount;
+			continue;
+		}
+
+		Current.Order = Order;
+
+		for (const ResourceUse& Use : Current.Uses)
+		{
+			GraphResource& Resource = Resources[Use.Handle - 1];
+
+			if (!Resource.Used)
+				Resource.FirstPass = Order;
+
+			Resource.Used = true;
+			Resource.LastPass = Order;
+		}
+
+		++Order;
+	}
+
+	Report.PassCount = static_cast<uint32_t>(Passes.size());
+
+	const RenderHeapKind HeapKinds[3] = { RENDER_HEAP_KIND_TARGET_TEXTURES, RENDER_HEAP_KIND_OTHER_TEXTURES, RENDER_HEAP_KIND_BUFFERS };
+
+	for (RenderHeapKind Kind : HeapKinds)
+	{
+		std::vector<uint32_t> Indices;
+		std::vector<TransientAllocation> Allocations;
+		uint64_t HeapAlignment = 0;
+
+		for (uint32_t i = 0; i < Resources.size(); ++i)
+		{
+			GraphResource& Resource = Resources[i];
+
+			if (Resource.Imported || Resource.HeapKind != Kind)
+				continue;
+
+			if (!Resource.Used)
+			{
+				++Report.CulledTransientCount;
+				continue;
+			}
+
+			// Read after the frame, so nothing later in it may take the memory
+			if (Resource.Output && Order > 0)
+				Resource.LastPass = Order - 1;
+
+			Resource.Allocation = Resource.Buffer ? Backend.GetBufferAllocationInfo(Resource.BufferDesc) : Backend.GetTextureAllocationInfo(Resource.TextureDesc);
+
+			Indices.push_back(i);
+			Allocations.push_back({ Resource.Allocation.Size, Resource.Allocation.Alignment, Resource.FirstPass, Resource.LastPass });
+			HeapAlignment = std::max(HeapAlignment, Resource.Allocation.Alignment);
+		}
+
+		if (Allocations.empty())
+			continue;
+
+		const uint64_t HeapSize = PlanTransientAliasing(Allocations);
+		const RenderHeap Heap = HeapPool ? HeapPool->Acquire(Kind, HeapSize, HeapAlignment) : Backend.CreateHeap(Kind, HeapSize, HeapAlignment);
+
+		if (Heap == RenderNullHandle)
+			return false;
+
+		Heaps.push_back(Heap);
+
+		Report.TransientCount += static_cast<uint32_t>(Allocations.size());
+		Report.HeapSize += HeapSize;
+		Report.PeakLiveSize += GetPeakLiveSize(Allocations);
+		++Report.HeapCount;
+
+		for (size_t i = 0; i < Allocations.size(); ++i)
+		{
+			GraphResource& Resource = Resources[Indices[i]];
+			Resource.Offset = Allocations[i].Offset;
+			Report.UnaliasedSize += Allocations[i].Size;
+
+			for (size_t j = 0; j < Allocations.size(); ++j)
+			{
+				if (j != i && Allocations[j].Offset < Allocations[i].Offset + Allocations[i].Size && Allocations[i].Offset < Allocations[j].Offset + Allocations[j].Size)
+					Resource.Aliased = true;
+			}
+
+			Resource.Resource = Resource.Buffer ? Backend.CreatePlacedBuffer(Heap, Resource.Offset, Resource.BufferDesc) : Backend.CreatePlacedTexture(Heap, Resource.Offset, Resource.TextureDesc);
+
+			if (Resource.Resource == RenderNullHandle)
+				return false;
+
+			Resource.Uninitialized = !Resource.Buffer && (Resource.TextureDesc.Flags & (RENDER_RESOURCE_FLAG_ALLOW_RENDER_TARGET | RENDER_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0;
+			Tracker.Track(Resource.Resource, Resource.InitialState);
+		}
+	}
+
+	return true;
+}
+
+void FrameGraph::Release(RenderBackend& Backend, ResourceStateTracker& Tracker, RenderHeapPool* HeapPool)
+{
+	if (!Compiled)
+		return;
+
+	for (GraphResource& Resource : Resources)
+	{
+		if (Resource.Imported)
+			continue;
+
+		if (Resource.Resource != RenderNullHandle)
+		{
+			Tracker.Untrack(Resource.Resource);
+			Backend.ReleaseResource(Resource.Resource);
+		}
+
+		Resource.Resource = RenderNullHandle;
+		Resource.Used = false;
+		Resource.FirstPass = 0;
+		Resource.LastPass = 0;
+		Resource.Allocation = {};
+		Resource.Offset = 0;
+		Resource.Aliased = false;
+		Resource.Uninitialized = false;
+	}
+
+	for (RenderHeap Heap : Heaps)
+	{
+		if (HeapPool)
+			HeapPool->Release(Heap);
+		else
+			Backend.ReleaseHeap(Heap);
+	}
+
+	Heaps.clear();
+	Compiled = false;
+}
+
+RenderResource FrameGraph::GetResource(FrameGraphResource Handle) const
+{
+	return Handle != RenderNullHandle && Handle <= Resources.size() ? Resources[Handle - 1].Resource : RenderNullHandle;
+}
+
+void FrameGraph::Execute(RenderCommandList& CommandList, ResourceStateTracker& Tracker, Profiler* Profiling)
+{
+	for (const GraphResource& Resource : Resources)
+	{
+		if (Resource.Imported && Resource.Resource != RenderNullHandle && !Tracker.IsTracked(Resource.Resource))
+			Tracker.Track(Resource.Resource, Resource.InitialState);
+	}
+
+	std::vector<RenderResource> Activated;
+	std::vector<RenderResource> Discards;
+
+	for (const Pass& Current : Passes)
+	{
+		if (Current.Culled)
+			continue;
+
+		const auto RecordBegin = std::chrono::steady_clock::now();
+
+		if (Profiling)
+			Profiling->BeginGPUScope(CommandList, Current.Name);
+
+		// Aliased transients hold whatever the last resource in their memory left, and targets placed by the last
+		// Compile hold nothing valid yet; targets need a discard before use, the first ones only once
+		Activated.clear();
+		Discards.clear();
+
+		for (const ResourceUse& Use : Current.Uses)
+		{
+			GraphResource& Resource = Resources[Use.Handle - 1];
+
+			if (Resource.Imported || (!Resource.Aliased && !Resource.Uninitialized) || Resource.FirstPass != Current.Order)
+				continue;
+
+			if (std::find(Activated.begin(), Activated.end(), Resource.Resource) != Activated.end())
+				continue;
+
+			Activated.push_back(Resource.Resource);
+			Resource.Uninitialized = false;
+
+			if (Resource.Aliased)
+				Tracker.AliasingBarrier(Resource.Resource);
+
+			if (!Resource.Buffer && (Resource.TextureDesc.Flags & RENDER_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+				Tracker.Transition(Resource.Resource, RENDER_RESOURCE_STATE_DEPTH_WRITE);
+			else if (!Resource.Buffer && (Resource.TextureDesc.Flags & RENDER_RESOURCE_FLAG_ALLOW_RENDER_TARGET))
+				Tracker.Transition(Resource.Resource, RENDER_RESOURCE_STATE_RENDER_TARGET);
+			else
+				continue;
+
+			Discards.push_back(Resource.Resource);
+		}
+
+		if (!Discards.empty())
+		{
+			Tracker.Flush(CommandList);
+
+			for (RenderResource Resource : Discards)
+				CommandList.DiscardResource(Resource);
+		}
+
+		for (const ResourceUse& Use : Current.Uses)
+			Tracker.Transition(Resources[Use.Handle - 1].Resource, Use.State);
+
+		Tracker.Flush(CommandList);
+
+		Current.Execute(CommandList);
+
+		if (Profiling)
+		{
+			Profiling->EndGPUScope(CommandList);
+			Profiling->AddCPUEvent(Current.Name, RecordBegin, std::chrono::steady_clock::now());
+		}
+	}
+
+	for (const GraphResource& Resource : Resources)
+	{
+		if (Resource.Imported && Resource.Used)
+			Tracker.Transition(Resource.Resource, Resource.FinalState);
+	}
+
+	Tracker.Flush(CommandList);
+}
+
+void FrameGraph::PrintMemoryReport() const
+{
+	constexpr double MB = 1024.0 * 1024.0;
+
+	printf("Frame graph: %u passes (%u culled), %u transients (%u culled)\n", Report.PassCount, Report.CulledPassCount, Report.TransientCount, Report.CulledTransientCount);
+	printf("Transient memory: %.1f MB in %u heaps, %.1f MB without aliasing, %.1f MB peak live\n", Report.HeapSize / MB, Report.HeapCount, Report.UnaliasedSize / MB, Report.PeakLiveSize / MB);
+
+	for (const GraphResource& Resource : Resources)
+	{
+		if (Resource.Imported || !Resource.Used)
+			continue;
+
+		printf("  %-28s %8.1f MB at %8.1f MB, passes %u-%u%s\n", Resource.Name ? Resource.Name : "", Resource.Allocation.Size / MB, Resource.Offset / MB, Resource.FirstPass, Resource.LastPass, Resource.Aliased ? ", aliased" : "");
+	}
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "RenderBackend.h"
+#include "ResourceStateTracker.h"
+
+class Profiler;
+class RenderHeapPool;
+
+// Transient allocation for the aliasing planner; the lifetime is the range of passes using it, both ends included
+struct TransientAllocation
+{
+	uint64_t Size;
+	uint64_t Alignment;
+	uint32_t FirstPass;
+	uint32_t LastPass;
+	uint64_t Offset = 0; // set by PlanTransientAliasing
+};
+
+// Places the allocations in one heap so that two of them only share memory when their lifetimes do not overlap.
+// Largest first, each at the lowest aligned offset that clears every placed allocation alive at the same time.
+// Returns the heap size.
+uint64_t PlanTransientAliasing(std::vector<TransientAllocation>& Allocations);
+
+// Largest sum of the sizes alive during one pass, no placement needs less
+uint64_t GetPeakLiveSize(const std::vector<TransientAllocation>& Allocations);
+
+typedef uint32_t FrameGraphResource; // RenderNullHandle for none
+
+struct FrameGraphMemoryReport
+{
+	uint32_t PassCount = 0;
+	uint32_t CulledPassCount = 0;
+	uint32_t TransientCount = 0;
+	uint32_t CulledTransientCount = 0;
+	uint32_t HeapCount = 0;
+	uint64_t UnaliasedSize = 0; // every transient in an allocation of its own
+	uint64_t HeapSize = 0;      // all heaps after aliasing
+	uint64_t PeakLiveSize = 0;  // sum over the heaps of GetPeakLiveSize
+};
+
+// Passes in execution order declaring the resources they read and write. Compile culls the passes nothing observes,
+// computes the lifetime of every transient resource and places the transients in placed-resource heaps, one per
+// RenderHeapKind, aliasing memory between resources whose lifetimes do not overlap. Execute requests the declared
+// states from the tracker before each pass, activates aliased resources on their first use (aliasing barrier, and a
+// DiscardResource for render and depth-stencil targets), discards the other targets on their first use after Compile
+// and leaves imported resources in their final state.
+class FrameGraph
+{
+public:
+	typedef std::function<void(RenderCommandList&)> PassFunction;
+
+	FrameGraphResource CreateTexture(const RenderTextureDesc& Desc);
+	FrameGraphResource CreateBuffer(const RenderBufferDesc& Desc);
+	// Before Compile, or after Release; false for imported resources or the wrong kind
+	bool SetTextureSize(FrameGraphResource Handle, uint32_t Width, uint32_t Height);
+	bool SetBufferSize(FrameGraphResource Handle, uint64_t Size);
+
+	// Resource owned outside the graph, tracked in InitialState the first time it is seen and transitioned to
+	// FinalState after the last pass. Writing it keeps the writer alive. SetImported swaps it between frames.
+	FrameGraphResource Import(const char* Name, RenderResource Resource, RenderResourceState InitialState, RenderResourceState FinalState);
+	void SetImported(FrameGraphResource Handle, RenderResource Resource);
+
+	// Transient read after the frame: keeps its writers alive and its memory reserved until the last pass
+	void MarkOutput(FrameGraphResource Handle);
+
+	uint32_t AddPass(const char* Name, PassFunction Execute);
+	// Both return false for unknown passes or resources
+	bool Read(uint32_t Pass, FrameGraphResource Handle, RenderResourceState State);
+	bool Write(uint32_t Pass, FrameGraphResource Handle, RenderResourceState State);
+
+	// Creates the heaps and placed resources and tracks them in their initial states. Only the memory planning runs
+	// through the backend, so any backend gives the report. Returns false when already compiled or a heap or placement fails.
+	// The heaps come from HeapPool when there is one.
+	bool Compile(RenderBackend& Backend, ResourceStateTracker& Tracker, RenderHeapPool* HeapPool = nullptr);
+	// Releases the placed resources, stops tracking them and gives the heaps back to HeapPool, or to the backend
+	// without one, so the graph can be compiled again, at other sizes. The passes and handles stay.
+	void Release(RenderBackend& Backend, ResourceStateTracker& Tracker, RenderHeapPool* HeapPool = nullptr);
+
+	// Resource behind a handle, RenderNullHandle for culled transients or before Compile
+	RenderResource GetResource(FrameGraphResource Handle) const;
+	bool IsPassCulled(uint32_t Pass) const { return Pass < Passes.size() && Passes[Pass].Culled; }
+	// Transient sharing memory with another one, its content does not survive from one frame to the next
+	bool IsAliased(FrameGraphResource Handle) const { return Handle != RenderNullHandle && Handle <= Resources.size() && Resources[Handle - 1].Aliased; }
+
+	// Profiling times every pass, its barriers included, on the CPU and the GPU under the pass name
+	void Execute(RenderCommandList& CommandList, ResourceStateTracker& Tracker, Profiler* Profiling = nullptr);
+
+	const FrameGraphMemoryReport& GetMemoryReport() const { return Report; }
+	// Report and the placement of every transient on stdout
+	void PrintMemoryReport() const;
+
+private:
+	struct ResourceUse
+	{
+		FrameGraphResource Handle;
+		RenderResourceState State;
+		bool Write;
+	};
+
+	struct Pass
+	{
+		const char* Name;
+		PassFunction Execute;
+		std::vector<ResourceUse> Uses;
+		bool Culled = false;
+		uint32_t Order = 0; // index among the passes kept
+	};
+
+	struct GraphResource
+	{
+		bool Imported;
+		bool Buffer;
+		bool Output = false;
+		RenderTextureDesc TextureDesc;
+		RenderBufferDesc BufferDesc;
+		const char* Name;
+		RenderResource Resource = RenderNullHandle;
+		RenderResourceState InitialState;
+		RenderResourceState FinalState;
+
+		// Transients after Compile
+		bool Used = false;
+		uint32_t FirstPass = 0; // position among the passes kept
+		uint32_t LastPass = 0;
+		RenderHeapKind HeapKind = RENDER_HEAP_KIND_BUFFERS;
+		RenderAllocationInfo Allocation = {};
+		uint64_t Offset = 0;
+		bool Aliased = false;   // shares memory with another transient
+		bool Uninitialized = false; // render or depth-stencil target placed by Compile and not discarded yet
+	};
+
+	FrameGraphResource AddResource(GraphResource&& NewResource);
+	bool AddUse(uint32_t Pass, FrameGraphResource Handle, RenderResourceState State, bool Write);
+	void CullPasses();
+
+	std::vector<Pass> Passes;
+	std::vector<GraphResource> Resources;
+	std::vector<RenderHeap> Heaps;
+	bool Compiled = false;
+	FrameGraphMemoryReport Report;
+};
@@ -0,0 +1,557 @@
+#include "FrameRenderer.h"
+#include "CubeMesh.h"
+#include "HiZShaders.h"
+#include "ComputeResolveShaders.h"
+#include "CPUDepthClassification.h"
+
+#include <algorithm>
+
+constexpr auto CubeVertexShaderSource = R"(
+cbuffer cb : register(b0)
+{
+	float4x4 ViewProjectionMatrix;
+};
+
+StructuredBuffer<row_major float4x4> InstanceTransforms : register(t1);
+
+float4 VS(float3 Position : POSITION, uint InstanceID : SV_InstanceID) : SV_Position
+{
+	return mul(mul(float4(Position, 1.0f), InstanceTransforms[InstanceID]), ViewProjectionMatrix);
+})";
+
+constexpr auto FSQuadVertexShaderSource = R"(
+float4 VS(uint VertexID : SV_VertexID) : SV_Position
+{
+	return float4(-1.0f + 2.0f * (VertexID % 2), 1.0f - 2.0f * (VertexID / 2), 0.0f, 1.0f);
+})";
+
+constexpr auto FSQuadPixelShaderSource = R"(
+Texture2D<float> DepthBufferTexture : register(t0);
+
+float4 PS(float4 Position : SV_Position) : SV_Target
+{
+	float PixelDepth = DepthBufferTexture.Load(int3(Position.xy, 0)).x;
+	return float4(PixelDepth == 0.0f ? 1.0f : 0.0f, PixelDepth == 1.0f ? 1.0f : 0.0f, (PixelDepth > 0.0f) && (PixelDepth < 1.0f) ? 1.0f : 0.0f, 1.0f);
+})";
+
+uint32_t FSQuadPixelShaderCPU(float PixelDepth)
+{
+	return CPUDepthClassColors[CPUGetDepthClass(PixelDepth)];
+}
+
+static uint64_t GetHiZBufferSize(const std::vector<CPUHiZLevel>& Levels)
+{
+	return (Levels.back().Offset + 1) * sizeof(CPUHiZTexel);
+}
+
+// Far more than the 256 bytes of constants each of at most FrameScheduler::MaxFramesInFlight frames holds
+constexpr uint64_t UploadRingSize = 64 * 1024;
+
+FrameRenderer::FrameRenderer(RenderBackend& Backend, const FrameRendererSettings& Settings) : Backend(Backend), Settings(Settings), DirtyTiles(Backend.GetWidth(), Backend.GetHeight()), HeapPool(Backend), UploadRing(Backend, UploadRingSize)
+{
+	Width = Backend.GetWidth();
+	Height = Backend.GetHeight();
+
+	DepthFormat = GetRenderDepthFormatInfo(Settings.DepthFormat);
+
+	// The HiZ resolve takes precedence over the plain compute resolve
+	const bool ComputeResolve = Settings.ComputeResolve && !Settings.ComputeHiZ;
+	const bool FuseVisualize = ComputeResolve && Settings.FuseVisualize;
+	this->Settings.ComputeResolve = ComputeResolve;
+	this->Settings.FuseVisualize = FuseVisualize;
+
+	if (!DepthFormat)
+		DepthFormat = GetRenderDepthFormatInfo(RENDER_FORMAT_D32_FLOAT_S8X24_UINT);
+
+	// Depth targets live in the frame graph heaps, the back buffer comes from the backend every frame
+	RenderTextureDesc TextureDesc;
+	TextureDesc.Width = Width;
+	TextureDesc.Height = Height;
+	TextureDesc.SampleCount = Settings.SampleCount;
+	TextureDesc.Format = DepthFormat->Format;
+	TextureDesc.Flags = RENDER_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+	TextureDesc.InitialState = RENDER_RESOURCE_STATE_DEPTH_WRITE;
+	TextureDesc.Name = "DepthBufferTexture";
+
+	DepthBuffer = Graph.CreateTexture(TextureDesc);
+
+	TextureDesc.SampleCount = 1;
+	TextureDesc.InitialState = RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+	TextureDesc.Name = "ResolvedDepthBufferTexture";
+
+	ResolvedDepthBuffer = Graph.CreateTexture(TextureDesc);
+
+	TextureDesc.Format = RENDER_FORMAT_R32_FLOAT;
+	TextureDesc.Flags = RENDER_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+	TextureDesc.Name = "ComputeResolvedDepthTexture";
+
+	ComputeResolvedDepth = Graph.CreateTexture(TextureDesc);
+
+	if (Settings.ComputeHiZ)
+		HiZLevels = GetHiZLevelLayout(Width, Height);
+
+	RenderBufferDesc BufferDesc;
+	BufferDesc.Size = Settings.ComputeHiZ ? GetHiZBufferSize(HiZLevels) : sizeof(CPUHiZTexel);
+	BufferDesc.Flags = RENDER_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+	BufferDesc.InitialState = RENDER_RESOURCE_STATE_UNORDERED_ACCESS;
+	BufferDesc.StructureStride = sizeof(CPUHiZTexel);
+	BufferDesc.Name = "HiZBuffer";
+
+	HiZ = Graph.CreateBuffer(BufferDesc);
+	Graph.MarkOutput(HiZ);
+
+	BackBufferHandle = Graph.Import("BackBuffer", RenderNullHandle, RENDER_RESOURCE_STATE_PRESENT, RENDER_RESOURCE_STATE_PRESENT);
+
+	const uint32_t DepthPass = Graph.AddPass("Depth", [this](RenderCommandList& CommandList) { RecordDepthPass(CommandList); });
+	Graph.Write(DepthPass, DepthBuffer, RENDER_RESOURCE_STATE_DEPTH_WRITE);
+
+	// Only the resolve path selected is declared, the other one's resources are culled and never allocated
+	const uint32_t ResolvePass = Graph.AddPass("Resolve", [this](RenderCommandList& CommandList) { RecordResolvePass(CommandList); });
+	const uint32_t HiZPass = Graph.AddPass("ResolveHiZ", [this](RenderCommandList& CommandList) { RecordComputeHiZ(CommandList); });
+	const uint32_t ComputeResolvePass = Graph.AddPass("ComputeResolve", [this](RenderCommandList& CommandList) { RecordComputeResolve(CommandList); });
+	const uint32_t VisualizePass = Graph.AddPass("Visualize", [this](RenderCommandList& CommandList) { RecordVisualizePass(CommandList); });
+
+	if (Settings.ComputeHiZ)
+	{
+		// The compute resolve reads the samples through a Texture2DMS SRV
+		Graph.Read(HiZPass, DepthBuffer, RENDER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		Graph.Write(HiZPass, ComputeResolvedDepth, RENDER_RESOURCE_STATE_UNORDERED_ACCESS);
+		Graph.Write(HiZPass, HiZ, RENDER_RESOURCE_STATE_UNORDERED_ACCESS);
+		Graph.Read(VisualizePass, ComputeResolvedDepth, RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	}
+	else if (FuseVisualize)
+	{
+		// Nothing reads a resolved texture, the Visualize pass writes nothing and is culled
+		Graph.Read(ComputeResolvePass, DepthBuffer, RENDER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		Graph.Write(ComputeResolvePass, BackBufferHandle, RENDER_RESOURCE_STATE_UNORDERED_ACCESS);
+	}
+	else if (ComputeResolve)
+	{
+		Graph.Read(ComputeResolvePass, DepthBuffer, RENDER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		Graph.Write(ComputeResolvePass, ComputeResolvedDepth, RENDER_RESOURCE_STATE_UNORDERED_ACCESS);
+		Graph.Read(VisualizePass, ComputeResolvedDepth, RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	}
+	else
+	{
+		Graph.Read(ResolvePass, DepthBuffer, RENDER_RESOURCE_STATE_RESOLVE_SOURCE);
+		Graph.Write(ResolvePass, ResolvedDepthBuffer, RENDER_RESOURCE_STATE_RESOLVE_DEST);
+		Graph.Read(VisualizePass, ResolvedDepthBuffer, RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	}
+
+	if (!FuseVisualize)
+		Graph.Write(VisualizePass, BackBufferHandle, RENDER_RESOURCE_STATE_RENDER_TARGET);
+
+	TargetsPlaced = Graph.Compile(Backend, StateTracker, &HeapPool);
+	GetGraphResources();
+
+	BufferDesc = RenderBufferDesc();
+	BufferDesc.HeapType = RENDER_HEAP_TYPE_UPLOAD;
+	BufferDesc.InitialState = RENDER_RESOURCE_STATE_GENERIC_READ;
+
+	BufferDesc.Size = sizeof(CubeVertices);
+	BufferDesc.Name = "VertexBuffer";
+	VertexBuffer = Backend.CreateBuffer(BufferDesc);
+
+	BufferDesc.Size = sizeof(CubeIndices);
+	BufferDesc.Name = "IndexBuffer";
+	IndexBuffer = Backend.CreateBuffer(BufferDesc);
+
+	Backend.WriteBuffer(VertexBuffer, 0, CubeVertices, sizeof(CubeVertices));
+	Backend.WriteBuffer(IndexBuffer, 0, CubeIndices, sizeof(CubeIndices));
+
+	Scene = GenerateStressScene(Settings.Scene, static_cast<float>(Width) / Height);
+	UpdateSceneTiles();
+
+	BufferDesc.Size = Scene.InstanceTransforms.size() * sizeof(CPUMatrix);
+	BufferDesc.StructureStride = sizeof(CPUMatrix);
+	BufferDesc.Name = "InstanceBuffer";
+	InstanceBuffer = Backend.CreateBuffer(BufferDesc);
+
+	Backend.WriteBuffer(InstanceBuffer, 0, Scene.InstanceTransforms.data(), BufferDesc.Size);
+	InstanceBufferSRV = Backend.CreateShaderResourceView(InstanceBuffer, RENDER_FORMAT_UNKNOWN);
+
+	if (Settings.ComputeHiZ)
+	{
+		// The full screen quad shows the compute result instead
+		ResolvedDepthBufferSRV = Backend.CreateShaderResourceView(ComputeResolvedDepthTexture, RENDER_FORMAT_R32_FLOAT);
+
+		HiZViews = Backend.CreateShaderResourceView(DepthBufferTexture, DepthFormat->DepthPlaneFormat);
+		Backend.CreateUnorderedAccessView(ComputeResolvedDepthTexture, RENDER_FORMAT_R32_FLOAT);
+		Backend.CreateUnorderedAccessView(HiZBuffer, RENDER_FORMAT_UNKNOWN);
+	}
+	else if (ComputeResolve)
+	{
+		// The fused kernel's tables are made per back buffer when it is first drawn to
+		if (!FuseVisualize)
+		{
+			ResolvedDepthBufferSRV = Backend.CreateShaderResourceView(ComputeResolvedDepthTexture, RENDER_FORMAT_R32_FLOAT);
+
+			ComputeResolveViews = Backend.CreateShaderResourceView(DepthBufferTexture, DepthFormat->DepthPlaneFormat);
+			Backend.CreateUnorderedAccessView(ComputeResolvedDepthTexture, RENDER_FORMAT_R32_FLOAT);
+		}
+	}
+	else
+	{
+		ResolvedDepthBufferSRV = Backend.CreateShaderResourceView(ResolvedDepthBufferTexture, DepthFormat->DepthPlaneFormat);
+	}
+
+	const RenderDescriptorRange DescriptorRange = { RENDER_DESCRIPTOR_TYPE_SRV, 1, 0 };
+	const RenderDescriptorRange InstanceDescriptorRange = { RENDER_DESCRIPTOR_TYPE_SRV, 1, 1 };
+
+	RenderRootParameter RootParameters[3];
+	RootParameters[0] = { .ConstantRegister = 0, .Visibility = RENDER_SHADER_VISIBILITY_VERTEX, .ConstantBuffer = true };
+	RootParameters[1] = { .Ranges = &DescriptorRange, .RangeCount = 1, .Visibility = RENDER_SHADER_VISIBILITY_PIXEL };
+	RootParameters[2] = { .Ranges = &InstanceDescriptorRange, .RangeCount = 1, .Visibility = RENDER_SHADER_VISIBILITY_VERTEX };
+
+	RootSignature = Backend.CreateRootSignature({ RootParameters, 3, true });
+
+	RenderGraphicsPipelineDesc PipelineDesc;
+	PipelineDesc.RootSignature = RootSignature;
+	PipelineDesc.Name = "CubeVertexShader";
+	PipelineDesc.VertexShaderSource = CubeVertexShaderSource;
+	PipelineDesc.PositionInput = true;
+	PipelineDesc.DepthEnable = true;
+	PipelineDesc.CullMode = RENDER_CULL_MODE_BACK;
+	PipelineDesc.DepthStencilFormat = DepthFormat->Format;
+	PipelineDesc.SampleCount = Settings.SampleCount;
+
+	CubeDrawPipeline = Backend.CreateGraphicsPipeline(PipelineDesc);
+
+	PipelineDesc = RenderGraphicsPipelineDesc();
+	PipelineDesc.RootSignature = RootSignature;
+	PipelineDesc.Name = "FSQuad";
+	PipelineDesc.VertexShaderSource = FSQuadVertexShaderSource;
+	PipelineDesc.PixelShaderSource = FSQuadPixelShaderSource;
+	PipelineDesc.CullMode = RENDER_CULL_MODE_BACK;
+	PipelineDesc.RenderTargetFormat = RENDER_FORMAT_R8G8B8A8_UNORM_SRGB;
+	PipelineDesc.CPUDepthPixelShader = FSQuadPixelShaderCPU;
+
+	FSQuadDrawPipeline = Backend.CreateGraphicsPipeline(PipelineDesc);
+
+	if (Settings.ComputeHiZ)
+	{
+		const RenderDescriptorRange HiZDescriptorRanges[2] =
+		{
+			{ RENDER_DESCRIPTOR_TYPE_SRV, 1, 0 },
+			{ RENDER_DESCRIPTOR_TYPE_UAV, 2, 0 }
+		};
+
+		RenderRootParameter HiZRootParameters[2];
+		HiZRootParameters[0] = { .Ranges = HiZDescriptorRanges, .RangeCount = 2 };
+		HiZRootParameters[1] = { .Constants32Bit = sizeof(HiZShaderConstants) / 4, .ConstantRegister = 0 };
+
+		HiZRootSignature = Backend.CreateRootSignature({ HiZRootParameters, 2, false });
+
+		RenderComputePipelineDesc ComputePipelineDesc;
+		ComputePipelineDesc.RootSignature = HiZRootSignature;
+		ComputePipelineDesc.ShaderSource = HiZComputeShaderSource;
+
+		ComputePipelineDesc.Name = "ResolveHiZShader";
+		ComputePipelineDesc.ShaderEntry = "ResolveHiZCS";
+		ComputePipelineDesc.CPUHiZKernel = RENDER_CPU_HIZ_KERNEL_RESOLVE;
+		ResolveHiZPipeline = Backend.CreateComputePipeline(ComputePipelineDesc);
+
+		ComputePipelineDesc.Name = "ReduceHiZShader";
+		ComputePipelineDesc.ShaderEntry = "ReduceHiZCS";
+		ComputePipelineDesc.CPUHiZKernel = RENDER_CPU_HIZ_KERNEL_REDUCE;
+		ReduceHiZPipeline = Backend.CreateComputePipeline(ComputePipelineDesc);
+	}
+
+	if (ComputeResolve)
+	{
+		// ResolveCS writes the resolved depth at u0, ResolveVisualizeCS the back buffer at u1
+		const RenderDescriptorRange ResolveDescriptorRanges[2] =
+		{
+			{ RENDER_DESCRIPTOR_TYPE_SRV, 1, 0 },
+			{ RENDER_DESCRIPTOR_TYPE_UAV, 1, FuseVisualize ? 1u : 0u }
+		};
+
+		RenderRootParameter ResolveRootParameters[2];
+		ResolveRootParameters[0] = { .Ranges = ResolveDescriptorRanges, .RangeCount = 2 };
+		ResolveRootParameters[1] = { .Constants32Bit = sizeof(ComputeResolveShaderConstants) / 4, .ConstantRegister = 0 };
+
+		ComputeResolveRootSignature = Backend.CreateRootSignature({ ResolveRootParameters, 2, false });
+
+		RenderComputePipelineDesc ComputePipelineDesc;
+		ComputePipelineDesc.RootSignature = ComputeResolveRootSignature;
+		ComputePipelineDesc.Name = FuseVisualize ? "ResolveVisualizeShader" : "ComputeResolveShader";
+		ComputePipelineDesc.ShaderSource = ComputeResolveShaderSource;
+		ComputePipelineDesc.ShaderEntry = FuseVisualize ? "ResolveVisualizeCS" : "ResolveCS";
+		ComputePipelineDesc.CPUResolveGroupSize = ComputeResolveGroupSize;
+		ComputePipelineDesc.CPUDepthPixelShader = FuseVisualize ? FSQuadPixelShaderCPU : nullptr;
+
+		ComputeResolvePipeline = Backend.CreateComputePipeline(ComputePipelineDesc);
+	}
+}
+
+void FrameRenderer::GetGraphResources()
+{
+	DepthBufferTexture = Graph.GetResource(DepthBuffer);
+	ResolvedDepthBufferTexture = Graph.GetResource(ResolvedDepthBuffer);
+	ComputeResolvedDepthTexture = Graph.GetResource(ComputeResolvedDepth);
+	HiZBuffer = Graph.GetResource(HiZ);
+
+	// Tiles left out of a resolve rely on the resolved texture keeping its content from the frames before
+	ResolveDirtyTiles = Settings.DirtyTileResolve && !Settings.ComputeHiZ && !Settings.ComputeResolve && !Graph.IsAliased(ResolvedDepthBuffer);
+}
+
+void FrameRenderer::UpdateViews()
+{
+	if (Settings.ComputeHiZ)
+	{
+		Backend.UpdateShaderResourceView(ResolvedDepthBufferSRV, ComputeResolvedDepthTexture, RENDER_FORMAT_R32_FLOAT);
+
+		Backend.UpdateShaderResourceView(HiZViews, DepthBufferTexture, DepthFormat->DepthPlaneFormat);
+		Backend.UpdateUnorderedAccessView(HiZViews + 1, ComputeResolvedDepthTexture, RENDER_FORMAT_R32_FLOAT);
+		Backend.UpdateUnorderedAccessView(HiZViews + 2, HiZBuffer, RENDER_FORMAT_UNKNOWN);
+	}
+	else if (Settings.ComputeResolve)
+	{
+		if (!Settings.FuseVisualize)
+		{
+			Backend.UpdateShaderResourceView(ResolvedDepthBufferSRV, ComputeResolvedDepthTexture, RENDER_FORMAT_R32_FLOAT);
+
+			Backend.UpdateShaderResourceView(ComputeResolveViews, DepthBufferTexture, DepthFormat->DepthPlaneFormat);
+			Backend.UpdateUnorderedAccessView(ComputeResolveViews + 1, ComputeResolvedDepthTexture, RENDER_FORMAT_R32_FLOAT);
+		}
+
+		// The back buffers kept their handles, not the memory behind them
+		for (const auto& [BackBuffer, Views] : BackBufferResolveViews)
+		{
+			Backend.UpdateShaderResourceView(Views, DepthBufferTexture, DepthFormat->DepthPlaneFormat);
+			Backend.UpdateUnorderedAccessView(Views + 1, BackBuffer, RENDER_FORMAT_R8G8B8A8_UNORM);
+		}
+	}
+	else
+	{
+		Backend.UpdateShaderResourceView(ResolvedDepthBufferSRV, ResolvedDepthBufferTexture, DepthFormat->DepthPlaneFormat);
+	}
+}
+
+bool FrameRenderer::Resize(uint32_t NewWidth, uint32_t NewHeight)
+{
+	if (NewWidth == 0 || NewHeight == 0 || (NewWidth == Width && NewHeight == Height))
+		return true;
+
+	Backend.ResizeSwapChain(NewWidth, NewHeight);
+
+	Width = NewWidth;
+	Height = NewHeight;
+
+	Graph.Release(Backend, StateTracker, &HeapPool);
+
+	Graph.SetTextureSize(DepthBuffer, Width, Height);
+	Graph.SetTextureSize(ResolvedDepthBuffer, Width, Height);
+	Graph.SetTextureSize(ComputeResolvedDepth, Width, Height);
+
+	if (Settings.ComputeHiZ)
+	{
+		HiZLevels = GetHiZLevelLayout(Width, Height);
+		Graph.SetBufferSize(HiZ, GetHiZBufferSize(HiZLevels));
+	}
+
+	TargetsPlaced = Graph.Compile(Backend, StateTracker, &HeapPool);
+	GetGraphResources();
+
+	if (!TargetsPlaced)
+		return false;
+
+	UpdateViews();
+
+	// Same cubes spread over the new aspect, the swap chain resize waited for the frames reading the instances
+	Scene = GenerateStressScene(Settings.Scene, static_cast<float>(Width) / Height);
+	Backend.WriteBuffer(InstanceBuffer, 0, Scene.InstanceTransforms.data(), Scene.InstanceTransforms.size() * sizeof(CPUMatrix));
+
+	// Every tile of the new resolved texture is undefined until resolved once
+	DirtyTiles = DirtyTileTracker(Width, Height);
+	UpdateSceneTiles();
+
+	return true;
+}
+
+void FrameRenderer::RenderFrame()
+{
+	RenderCommandList* CommandList = Backend.BeginFrame();
+
+	RecordFrame(*CommandList, Backend.GetBackBuffer());
+
+	Backend.EndFrame();
+}
+
+void FrameRenderer::RecordFrame(RenderCommandList& CommandList, RenderResource BackBuffer)
+{
+	ProfileScope Scope("Record");
+
+	if (Profiling)
+		Profiling->BeginFrame();
+
+	if (GetPipelineStatus() != RENDER_PIPELINE_STATUS_READY)
+		return;
+
+	HeapPool.Trim();
+
+	UploadRing.BeginFrame();
+
+	// Nothing recorded while the frames in flight hold the whole ring
+	if (!UploadRing.AllocateConstants(&Scene.ViewProjection, sizeof(Scene.ViewProjection), FrameConstants))
+		return;
+
+	Graph.SetImported(BackBufferHandle, BackBuffer);
+	Graph.Execute(CommandList, StateTracker, Profiling);
+
+	if (Profiling)
+		Profiling->EndFrame(CommandList);
+
+	UploadRing.EndFrame();
+}
+
+RenderPipelineStatus FrameRenderer::GetPipelineStatus() const
+{
+	const RenderPipeline FramePipelines[] = { CubeDrawPipeline, FSQuadDrawPipeline, ResolveHiZPipeline, ReduceHiZPipeline, ComputeResolvePipeline };
+	RenderPipelineStatus Status = RENDER_PIPELINE_STATUS_READY;
+
+	for (RenderPipeline Pipeline : FramePipelines)
+	{
+		if (Pipeline == RenderNullHandle)
+			continue;
+
+		const RenderPipelineStatus PipelineStatus = Backend.GetPipelineStatus(Pipeline);
+
+		if (PipelineStatus == RENDER_PIPELINE_STATUS_FAILED)
+			return RENDER_PIPELINE_STATUS_FAILED;
+
+		if (PipelineStatus == RENDER_PIPELINE_STATUS_PENDING)
+			Status = RENDER_PIPELINE_STATUS_PENDING;
+	}
+
+	return Status;
+}
+
+void FrameRenderer::RecordDepthPass(RenderCommandList& CommandList)
+{
+	CommandList.SetRenderTargets(RenderNullHandle, DepthBufferTexture);
+	CommandList.ClearDepthStencil(DepthBufferTexture, 1.0f, 0);
+	CommandList.SetViewport(Width, Height);
+
+	CommandList.SetPrimitiveTopology(RENDER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	CommandList.SetVertexBuffer(VertexBuffer, sizeof(CubeVertices), sizeof(CPUFloat3));
+	CommandList.SetIndexBuffer(IndexBuffer, sizeof(CubeIndices), RENDER_FORMAT_R16_UINT);
+	CommandList.SetPipeline(CubeDrawPipeline);
+	CommandList.SetRootConstantBuffer(0, FrameConstants.Buffer, FrameConstants.Offset);
+	CommandList.SetDescriptorTable(2, InstanceBufferSRV);
+	CommandList.DrawIndexed(CubeIndexCount, static_cast<uint32_t>(Scene.InstanceTransforms.size()));
+
+	if (ResolveDirtyTiles)
+		DirtyTiles.MarkTiles(SceneTiles);
+}
+
+void FrameRenderer::UpdateSceneTiles()
+{
+	DirtyTileTracker SceneTracker(Width, Height);
+
+	for (const CPUMatrix& Transform : Scene.InstanceTransforms)
+		SceneTracker.MarkDrawIndexed(CubeVertices, CubeIndices, CubeIndexCount, CPUMatrixMultiply(Transform, Scene.ViewProjection));
+
+	SceneTiles = SceneTracker.GetMarkedTiles();
+}
+
+void FrameRenderer::RecordResolvePass(RenderCommandList& CommandList)
+{
+	const RenderRect FullRect = { 0, 0, static_cast<int32_t>(Width), static_cast<int32_t>(Height) };
+	const std::vector<RenderRect> FullRects = { FullRect };
+	const std::vector<RenderRect>& Rects = ResolveDirtyTiles ? DirtyTiles.GetDirtyRects() : FullRects;
+
+	// Stencil values cannot be averaged
+	const bool ResolveStencil = Settings.ResolveStencil && DepthFormat->StencilPlaneFormat != RENDER_FORMAT_UNKNOWN;
+	const RenderResolveMode StencilMode = Settings.ResolveMode == RENDER_RESOLVE_MODE_MIN ? RENDER_RESOLVE_MODE_MIN : RENDER_RESOLVE_MODE_MAX;
+
+	for (const RenderRect& Rect : Rects)
+	{
+		CommandList.ResolveSubresourceRegion(ResolvedDepthBufferTexture, Rect.Left, Rect.Top, DepthBufferTexture, &Rect, DepthFormat->DepthPlaneFormat, Settings.ResolveMode);
+
+		if (ResolveStencil)
+			CommandList.ResolveSubresourceRegion(ResolvedDepthBufferTexture, Rect.Left, Rect.Top, DepthBufferTexture, &Rect, DepthFormat->StencilPlaneFormat, StencilMode);
+	}
+
+	if (ResolveDirtyTiles)
+	{
+		ResolvedTileCount = DirtyTiles.GetDirtyTileCount();
+		DirtyTiles.EndFrame();
+	}
+	else
+	{
+		ResolvedTileCount = DirtyTiles.GetTileCount();
+	}
+}
+
+void FrameRenderer::RecordVisualizePass(RenderCommandList& CommandList)
+{
+	CommandList.SetRenderTargets(Graph.GetResource(BackBufferHandle), RenderNullHandle);
+	CommandList.SetPrimitiveTopology(RENDER_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+	CommandList.SetPipeline(FSQuadDrawPipeline);
+	CommandList.SetDescriptorTable(1, ResolvedDepthBufferSRV);
+	CommandList.Draw(4, 1);
+}
+
+void FrameRenderer::RecordComputeHiZ(RenderCommandList& CommandList)
+{
+	// First dispatch resolves and writes six levels, every further one reads the last level written and adds six more
+	for (uint32_t FirstLevel = 0; FirstLevel < HiZLevels.size(); FirstLevel += HiZLevelsPerDispatch)
+	{
+		HiZShaderConstants Constants{};
+		Constants.SourceWidth = FirstLevel == 0 ? Width : HiZLevels[FirstLevel - 1].Width;
+		Constants.SourceHeight = FirstLevel == 0 ? Height : HiZLevels[FirstLevel - 1].Height;
+		Constants.SourceOffset = FirstLevel == 0 ? 0 : HiZLevels[FirstLevel - 1].Offset;
+		Constants.ResolveMode = Settings.ResolveMode;
+		Constants.LevelCount = std::min<uint32_t>(HiZLevelsPerDispatch, static_cast<uint32_t>(HiZLevels.size()) - FirstLevel);
+
+		for (uint32_t Level = 0; Level < Constants.LevelCount; ++Level)
+		{
+			Constants.Levels[Level][0] = HiZLevels[FirstLevel + Level].Width;
+			Constants.Levels[Level][1] = HiZLevels[FirstLevel + Level].Height;
+			Constants.Levels[Level][2] = HiZLevels[FirstLevel + Level].Offset;
+		}
+
+		if (FirstLevel != 0)
+			StateTracker.UAVBarrier(HiZBuffer);
+
+		StateTracker.Flush(CommandList);
+
+		CommandList.SetPipeline(FirstLevel == 0 ? ResolveHiZPipeline : ReduceHiZPipeline);
+		CommandList.SetDescriptorTable(0, HiZViews);
+		CommandList.SetRootConstants(1, sizeof(HiZShaderConstants) / 4, &Constants);
+		CommandList.Dispatch((Constants.SourceWidth + HiZGroupFootprint - 1) / HiZGroupFootprint, (Constants.SourceHeight + HiZGroupFootprint - 1) / HiZGroupFootprint, 1);
+	}
+}
+
+void FrameRenderer::RecordComputeResolve(RenderCommandList& CommandList)
+{
+	RenderView Views = ComputeResolveViews;
+
+	if (Settings.FuseVisualize)
+	{
+		const RenderResource BackBuffer = Graph.GetResource(BackBufferHandle);
+		auto Found = std::find_if(BackBufferResolveViews.begin(), BackBufferResolveViews.end(), [&](const std::pair<RenderResource, RenderView>& Entry) { return Entry.first == BackBuffer; });
+
+		if (Found != BackBufferResolveViews.end())
+		{
+			Views = Found->second;
+		}
+		else
+		{
+			// UNORM view of the back buffer, the 0.0 and 1.0 channels it gets are the same in sRGB
+			Views = Backend.CreateShaderResourceView(DepthBufferTexture, DepthFormat->DepthPlaneFormat);
+			Backend.CreateUnorderedAccessView(BackBuffer, RENDER_FORMAT_R8G8B8A8_UNORM);
+			BackBufferResolveViews.push_back({ BackBuffer, Views });
+		}
+	}
+
+	const ComputeResolveShaderConstants Constants = { static_cast<uint32_t>(Settings.ResolveMode), Width, Height, 0 };
+
+	CommandList.SetPipeline(ComputeResolvePipeline);
+	CommandList.SetDescriptorTable(0, Views);
+	CommandList.SetRootConstants(1, sizeof(ComputeResolveShaderConstants) / 4, &Constants);
+	CommandList.Dispatch((Width + ComputeResolveGroupSize - 1) / ComputeResolveGroupSize, (Height + ComputeResolveGroupSize - 1) / ComputeResolveGroupSize, 1);
+
+	ResolvedTileCount = DirtyTiles.GetTileCount();
+}
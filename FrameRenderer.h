@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "RenderBackend.h"
+#include "ResourceStateTracker.h"
+#include "FrameGraph.h"
+#include "RenderHeapPool.h"
+#include "UploadRingAllocator.h"
+#include "CPUMath.h"
+#include "CPUHiZ.h"
+#include "DirtyTileTracker.h"
+#include "StressScene.h"
+#include "Profiler.h"
+
+struct FrameRendererSettings
+{
+	uint32_t SampleCount = 8;
+	// One of RenderDepthFormats
+	RenderFormat DepthFormat = RENDER_FORMAT_D32_FLOAT_S8X24_UINT;
+	// Also resolve the stencil plane (MIN with RESOLVE_MODE_MIN, else MAX) when DepthFormat has one
+	bool ResolveStencil = false;
+	RenderResolveMode ResolveMode = RENDER_RESOLVE_MODE_MAX;
+	// Resolve with ResolveHiZCS instead of ResolveSubresourceRegion and build the min/max depth pyramid in the same pass
+	bool ComputeHiZ = false;
+	// Resolve with ResolveCS over a Texture2DMS SRV instead of ResolveSubresourceRegion. Ignored with ComputeHiZ.
+	bool ComputeResolve = false;
+	// With ComputeResolve, ResolveVisualizeCS classifies the depth as it resolves it and writes the back buffer, the
+	// resolved depth is neither stored nor read again and there is no Visualize pass
+	bool FuseVisualize = false;
+	// Resolve only the tiles the cube covers this frame or covered the last one, the others keep the resolved clear
+	// value. Ignored with the compute resolves, and when the resolved texture aliases other memory.
+	bool DirtyTileResolve = true;
+	// Cubes the depth pass draws, all in one instanced draw
+	StressSceneSettings Scene;
+};
+
+// The visualization shader as RGBA8: 0.0 red, 1.0 green, anything in between blue
+uint32_t FSQuadPixelShaderCPU(float PixelDepth);
+
+// The frame of the test independent of the API: instanced cube depth pass into the multisampled depth buffer, depth resolve,
+// full screen quad visualizing the resolved depth into the back buffer. The passes and their render targets are
+// declared to a FrameGraph, which owns the transient memory and the barriers between passes.
+class FrameRenderer
+{
+public:
+	FrameRenderer(RenderBackend& Backend, const FrameRendererSettings& Settings);
+
+	// BeginFrame, RecordFrame and EndFrame on the backend
+	void RenderFrame();
+
+	// Between frames: resizes the swap chain and compiles the frame graph again for the new size, its heaps coming
+	// from the pool the old ones went back to. Views keep their handles. Nothing happens for 0x0, the size of a
+	// minimized window, or the current size. False when the targets could not be placed.
+	bool Resize(uint32_t NewWidth, uint32_t NewHeight);
+
+	// Records nothing while the pipelines are not READY or the frames in flight hold the whole upload ring. The backend
+	// still submits and presents the empty frame, showing the back buffer as it is.
+	void RecordFrame(RenderCommandList& CommandList, RenderResource BackBuffer);
+
+	// Profiler created on the same backend timing the passes of every frame, nullptr for none
+	void SetProfiler(Profiler* NewProfiler) { Profiling = NewProfiler; }
+
+	// FAILED when any pipeline failed, else PENDING until all are READY
+	RenderPipelineStatus GetPipelineStatus() const;
+	// False when the frame graph could not create its heaps or place its targets, at creation or the last Resize
+	bool AreTargetsPlaced() const { return TargetsPlaced; }
+
+	RenderResource GetDepthBuffer() const { return DepthBufferTexture; }
+	// Texture the visualization reads: ResolvedDepthBufferTexture, or the compute resolve output with ComputeHiZ or
+	// ComputeResolve. RenderNullHandle with FuseVisualize, the resolved depth only exists inside the kernel.
+	RenderResource GetResolvedDepthBuffer() const { return Settings.ComputeHiZ || Settings.ComputeResolve ? ComputeResolvedDepthTexture : ResolvedDepthBufferTexture; }
+	RenderResource GetHiZBuffer() const { return HiZBuffer; }
+	// Tiles of DirtyTileTracker::DefaultTileSize the last resolve processed, and all of them
+	uint32_t GetResolvedTileCount() const { return ResolvedTileCount; }
+	uint32_t GetTileCount() const { return DirtyTiles.GetTileCount(); }
+
+	const ResourceStateTracker& GetStateTracker() const { return StateTracker; }
+	const FrameGraph& GetFrameGraph() const { return Graph; }
+	const RenderHeapPool& GetHeapPool() const { return HeapPool; }
+
+private:
+	void RecordDepthPass(RenderCommandList& CommandList);
+	void RecordResolvePass(RenderCommandList& CommandList);
+	void RecordComputeHiZ(RenderCommandList& CommandList);
+	void RecordComputeResolve(RenderCommandList& CommandList);
+	void RecordVisualizePass(RenderCommandList& CommandList);
+
+	// Placed resources of the compiled graph, and whether the resolve can skip clean tiles with them
+	void GetGraphResources();
+	// Points the views at the placed resources compiled last
+	void UpdateViews();
+	// Projects every instance of the scene into SceneTiles
+	void UpdateSceneTiles();
+
+	RenderBackend& Backend;
+	FrameRendererSettings Settings;
+
+	uint32_t Width;
+	uint32_t Height;
+	const RenderDepthFormatInfo* DepthFormat;
+
+	DirtyTileTracker DirtyTiles;
+	// Tiles the scene covers at the current size. The scene does not move between frames, so the depth pass marks
+	// these again instead of projecting every instance each frame.
+	std::vector<uint8_t> SceneTiles;
+	bool ResolveDirtyTiles = false;
+	bool TargetsPlaced = false;
+	uint32_t ResolvedTileCount = 0;
+
+	Profiler* Profiling = nullptr;
+
+	// Resources keep the state of their last use across frames, every pass requests the state it needs
+	ResourceStateTracker StateTracker;
+	FrameGraph Graph;
+	RenderHeapPool HeapPool;
+	FrameGraphResource BackBufferHandle = RenderNullHandle;
+	FrameGraphResource DepthBuffer = RenderNullHandle;
+	FrameGraphResource ResolvedDepthBuffer = RenderNullHandle;
+	FrameGraphResource ComputeResolvedDepth = RenderNullHandle;
+	FrameGraphResource HiZ = RenderNullHandle;
+
+	RenderResource DepthBufferTexture = RenderNullHandle;
+	RenderResource ResolvedDepthBufferTexture = RenderNullHandle;
+	RenderResource VertexBuffer = RenderNullHandle;
+	RenderResource IndexBuffer = RenderNullHandle;
+
+	// World matrix of every cube, a structured buffer the vertex shader indexes with SV_InstanceID
+	StressScene Scene;
+	RenderResource InstanceBuffer = RenderNullHandle;
+	RenderView InstanceBufferSRV = RenderNullHandle;
+
+	// Per-frame constants, written every frame and bound as a root constant buffer
+	UploadRingAllocator UploadRing;
+	RenderUploadAllocation FrameConstants;
+
+	RenderView ResolvedDepthBufferSRV = RenderNullHandle;
+
+	RenderRootSignature RootSignature = RenderNullHandle;
+	RenderPipeline CubeDrawPipeline = RenderNullHandle;
+	RenderPipeline FSQuadDrawPipeline = RenderNullHandle;
+
+	// Compute resolve: R32_FLOAT copy of the resolved depth (depth formats cannot be UAVs) and the packed HiZ levels
+	RenderResource ComputeResolvedDepthTexture = RenderNullHandle;
+	RenderResource HiZBuffer = RenderNullHandle;
+	RenderView HiZViews = RenderNullHandle;
+	RenderRootSignature HiZRootSignature = RenderNullHandle;
+	RenderPipeline ResolveHiZPipeline = RenderNullHandle;
+	RenderPipeline ReduceHiZPipeline = RenderNullHandle;
+	std::vector<CPUHiZLevel> HiZLevels;
+
+	// ResolveCS or ResolveVisualizeCS. The fused kernel's table is the depth SRV and a UAV of the back buffer it
+	// writes, one table per back buffer.
+	RenderView ComputeResolveViews = RenderNullHandle;
+	std::vector<std::pair<RenderResource, RenderView>> BackBufferResolveViews;
+	RenderRootSignature ComputeResolveRootSignature = RenderNullHandle;
+	RenderPipeline ComputeResolvePipeline = RenderNullHandle;
+};
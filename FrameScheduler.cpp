@@ -0,0 +1,69 @@
+#include "FrameScheduler.h"
+
+#include <algorithm>
+
+#include "Profiler.h"
+
+void SimulatedFrameFence::Signal(uint64_t Value)
+{
+	SignaledValue = std::max(SignaledValue, Value);
+}
+
+void SimulatedFrameFence::Wait(uint64_t Value)
+{
+	if (CompletedValue >= Value)
+		return;
+
+	++BlockingWaitCount;
+
+	if (Value > SignaledValue)
+		++DeadlockCount;
+
+	CompletedValue = Value;
+}
+
+void SimulatedFrameFence::Complete(uint64_t Value)
+{
+	CompletedValue = std::max(CompletedValue, std::min(Value, SignaledValue));
+}
+
+FrameScheduler::FrameScheduler(FrameFence& Fence, uint32_t FramesInFlight) : Fence(Fence)
+{
+	this->FramesInFlight = std::clamp(FramesInFlight, MinFramesInFlight, MaxFramesInFlight);
+}
+
+uint32_t FrameScheduler::BeginFrame()
+{
+	++FrameNumber;
+
+	// Frame FrameNumber - FramesInFlight used the same slot
+	if (FrameNumber > FramesInFlight)
+	{
+		const uint64_t SlotValue = FrameNumber - FramesInFlight;
+
+		if (Fence.GetCompletedValue() < SlotValue)
+		{
+			++StallCount;
+
+			ProfileScope Scope("FenceWait");
+			Fence.Wait(SlotValue);
+		}
+	}
+
+	return GetFrameSlot();
+}
+
+void FrameScheduler::EndFrame()
+{
+	Fence.Signal(FrameNumber);
+	SignaledFrame = FrameNumber;
+}
+
+void FrameScheduler::WaitIdle()
+{
+	if (Fence.GetCompletedValue() < SignaledFrame)
+	{
+		ProfileScope Scope("FenceWait");
+		Fence.Wait(SignaledFrame);
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+
+// Timeline fence of one queue: the queue signals increasing values after its work, the CPU waits for them
+class FrameFence
+{
+public:
+	virtual ~FrameFence() = default;
+
+	virtual uint64_t GetCompletedValue() = 0;
+	// Signaled once the work submitted so far completes
+	virtual void Signal(uint64_t Value) = 0;
+	// Blocks until GetCompletedValue() >= Value
+	virtual void Wait(uint64_t Value) = 0;
+};
+
+// Fence without a GPU behind it. Complete plays the GPU catching up; Wait completes up to the value waited for,
+// as the real wait would return once the GPU got there, and counts the waits that would have blocked.
+class SimulatedFrameFence : public FrameFence
+{
+public:
+	uint64_t GetCompletedValue() override { return CompletedValue; }
+	void Signal(uint64_t Value) override;
+	void Wait(uint64_t Value) override;
+
+	// Completes the signaled values up to Value
+	void Complete(uint64_t Value);
+	void CompleteAll() { Complete(SignaledValue); }
+
+	uint64_t GetSignaledValue() const { return SignaledValue; }
+	uint32_t GetBlockingWaitCount() const { return BlockingWaitCount; }
+	// Waits for a value never signaled, which would hang a real queue
+	uint32_t GetDeadlockCount() const { return DeadlockCount; }
+
+private:
+	uint64_t SignaledValue = 0;
+	uint64_t CompletedValue = 0;
+	uint32_t BlockingWaitCount = 0;
+	uint32_t DeadlockCount = 0;
+};
+
+// Keeps up to FramesInFlight frames between the start of recording and the end of GPU execution with one fence:
+// frame N signals value N, and frame N may start once frame N - FramesInFlight has completed. Per-frame resources
+// (command allocators, upload memory) come in FramesInFlight slots; the slot BeginFrame returns is free to reset.
+class FrameScheduler
+{
+public:
+	static constexpr uint32_t MinFramesInFlight = 2;
+	static constexpr uint32_t MaxFramesInFlight = 4;
+
+	// FramesInFlight is clamped to [MinFramesInFlight, MaxFramesInFlight]
+	FrameScheduler(FrameFence& Fence, uint32_t FramesInFlight);
+
+	// Waits for the frame that last used the next slot and returns that slot
+	uint32_t BeginFrame();
+	// Call after submitting the frame's work
+	void EndFrame();
+	// Waits for every frame ended so far
+	void WaitIdle();
+
+	uint32_t GetFramesInFlight() const { return FramesInFlight; }
+	// Slot of the frame being recorded
+	uint32_t GetFrameSlot() const { return static_cast<uint32_t>(FrameNumber % FramesInFlight); }
+	// Frame being recorded, counting from 1; also its fence value
+	uint64_t GetFrameNumber() const { return FrameNumber; }
+	uint64_t GetCompletedFrame() const { return Fence.GetCompletedValue(); }
+	// BeginFrame calls that found the GPU behind and had to wait
+	uint32_t GetStallCount() const { return StallCount; }
+
+private:
+	FrameFence& Fence;
+	uint32_t FramesInFlight;
+	uint64_t FrameNumber = 0;
+	uint64_t SignaledFrame = 0;
+	uint32_t StallCount = 0;
+};
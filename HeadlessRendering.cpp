@@ -0,0 +1,383 @@
+#include "HeadlessRendering.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "AsyncFileWriter.h"
+#include "CPUCompressedDepth.h"
+#include "CPUDepthClassification.h"
+#include "CPUHiZ.h"
+#include "CPUParallel.h"
+#include "CPUResolve.h"
+#include "Profiler.h"
+#include "RecordingRenderBackend.h"
+#include "ResolveBenchmark.h"
+
+// Grayscale PFM: text header, then float32 rows from the bottom up; the negative scale marks little endian
+static std::vector<uint8_t> EncodePFM(const CPUResolvedDepth& Depth)
+{
+	char Header[64];
+	const int HeaderSize = snprintf(Header, sizeof(Header), "Pf\n%u %u\n-1.0\n", Depth.Width, Depth.Height);
+	const size_t RowSize = Depth.Width * sizeof(float);
+
+	std::vector<uint8_t> Data(HeaderSize + RowSize * Depth.Height);
+	memcpy(Data.data(), Header, HeaderSize);
+
+	for (uint32_t y = 0; y < Depth.Height; ++y)
+		memcpy(&Data[HeaderSize + RowSize * (Depth.Height - 1 - y)], Depth.GetRow(y), RowSize);
+
+	return Data;
+}
+
+static std::vector<uint8_t> EncodeRaw(const CPUResolvedDepth& Depth)
+{
+	std::vector<uint8_t> Data(Depth.Depth.size() * sizeof(float));
+	memcpy(Data.data(), Depth.Depth.data(), Data.size());
+	return Data;
+}
+
+// Binary PPM of the RGB channels of RGBA8 texels
+static std::vector<uint8_t> EncodePPM(const std::vector<uint32_t>& Texels, uint32_t Width, uint32_t Height)
+{
+	char Header[64];
+	const int HeaderSize = snprintf(Header, sizeof(Header), "P6\n%u %u\n255\n", Width, Height);
+
+	std::vector<uint8_t> Data(HeaderSize + static_cast<size_t>(Width) * Height * 3);
+	memcpy(Data.data(), Header, HeaderSize);
+
+	uint8_t* Pixel = &Data[HeaderSize];
+
+	for (uint32_t Texel : Texels)
+	{
+		*Pixel++ = static_cast<uint8_t>(Texel);
+		*Pixel++ = static_cast<uint8_t>(Texel >> 8);
+		*Pixel++ = static_cast<uint8_t>(Texel >> 16);
+	}
+
+	return Data;
+}
+
+static CPUResolveMode GetCPUResolveMode(RenderResolveMode Mode)
+{
+	return Mode == RENDER_RESOLVE_MODE_MIN ? CPU_RESOLVE_MODE_MIN : (Mode == RENDER_RESOLVE_MODE_MAX ? CPU_RESOLVE_MODE_MAX : CPU_RESOLVE_MODE_AVERAGE);
+}
+
+// Texels of the resolved depth that are not the CPU resolve of their samples, plus pixels of the visualization that
+// are not the color CPUClassifyDepth gives their texel. Without a resolved depth (FuseVisualize) the visualization is
+// checked against the CPU resolve instead. Every texel counts when a texture is missing.
+static uint64_t CountMismatches(const CPUDepthSurface* DepthSurface, const CPUResolvedDepth* ResolvedDepth, const std::vector<uint32_t>* Visualization, RenderResolveMode Mode, bool FusedVisualization, uint32_t Width, uint32_t Height, CPUDepthClassification& Classification)
+{
+	if (!DepthSurface || (!ResolvedDepth && !FusedVisualization) || !Visualization)
+		return static_cast<uint64_t>(Width) * Height;
+
+	const CPUResolveMode CPUMode = GetCPUResolveMode(Mode);
+	CPUResolvedDepth ReferenceDepth;
+
+	if (!ResolvedDepth)
+	{
+		ReferenceDepth.Allocate(Width, Height);
+
+		for (uint32_t y = 0; y < Height; ++y)
+		{
+			for (uint32_t x = 0; x < Width; ++x)
+				ReferenceDepth.GetRow(y)[x] = ResolveDepthPixel(*DepthSurface, x, y, CPUMode);
+		}
+	}
+
+	std::vector<uint32_t> ExpectedVisualization(Visualization->size());
+	Classification = CPUClassifyDepth(ResolvedDepth ? *ResolvedDepth : ReferenceDepth, ExpectedVisualization.data());
+
+	uint64_t MismatchCount = 0;
+
+	for (size_t i = 0; i < ExpectedVisualization.size(); ++i)
+		MismatchCount += (*Visualization)[i] != ExpectedVisualization[i];
+
+	// DECOMPRESS leaves a multisampled target, nothing is resolved to compare with
+	if (Mode == RENDER_RESOLVE_MODE_DECOMPRESS || !ResolvedDepth)
+		return MismatchCount;
+
+	for (uint32_t y = 0; y < Height; ++y)
+	{
+		const float* Row = ResolvedDepth->GetRow(y);
+
+		for (uint32_t x = 0; x < Width; ++x)
+		{
+			const float Expected = ResolveDepthPixel(*DepthSurface, x, y, CPUMode);
+			MismatchCount += memcmp(&Expected, &Row[x], sizeof(float)) != 0;
+		}
+	}
+
+	return MismatchCount;
+}
+
+// Texels of the HiZ buffer that differ from the pyramid CPUBuildHiZPyramid builds over the resolved depth, every
+// texel when either is missing
+static uint64_t CountHiZMismatches(const std::vector<uint8_t>* HiZBuffer, const CPUResolvedDepth* ResolvedDepth)
+{
+	if (!ResolvedDepth)
+		return HiZBuffer ? HiZBuffer->size() / sizeof(CPUHiZTexel) : 1;
+
+	CPUHiZPyramid Reference;
+	CPUBuildHiZPyramid(Reference, *ResolvedDepth, nullptr);
+
+	if (!HiZBuffer || HiZBuffer->size() < Reference.Texels.size() * sizeof(CPUHiZTexel))
+		return Reference.Texels.size();
+
+	const CPUHiZTexel* Texels = reinterpret_cast<const CPUHiZTexel*>(HiZBuffer->data());
+	uint64_t MismatchCount = 0;
+
+	for (size_t i = 0; i < Reference.Texels.size(); ++i)
+		MismatchCount += memcmp(&Texels[i], &Reference.Texels[i], sizeof(CPUHiZTexel)) != 0;
+
+	return MismatchCount;
+}
+
+// Samples of the decompressed surface whose depth differs from the uncompressed one, plus texels of its compressed
+// domain resolve and of CPUResolveDepthRegion over the decompressed samples that differ from the uncompressed resolve.
+// Every texel counts when a surface is missing.
+static uint64_t CountCompressedMismatches(const CPUCompressedDepthSurface* Compressed, const CPUDepthSurface* DepthSurface, RenderResolveMode Mode, uint32_t Width, uint32_t Height)
+{
+	if (!Compressed || !DepthSurface || DepthSurface->Format != CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT)
+		return static_cast<uint64_t>(Width) * Height;
+
+	CPUDepthSurface Decompressed;
+	Compressed->Decompress(Decompressed);
+
+	uint64_t MismatchCount = 0;
+
+	for (uint32_t y = 0; y < Height; ++y)
+	{
+		for (uint32_t x = 0; x < Width; ++x)
+		{
+			const CPUDepthStencilSample* Expected = DepthSurface->GetPixel(x, y);
+			const CPUDepthStencilSample* Samples = Decompressed.GetPixel(x, y);
+
+			for (uint32_t i = 0; i < DepthSurface->SampleCount; ++i)
+				MismatchCount += memcmp(&Expected[i].Depth, &Samples[i].Depth, sizeof(float)) != 0;
+		}
+	}
+
+	// DECOMPRESS resolves nothing
+	if (Mode == RENDER_RESOLVE_MODE_DECOMPRESS)
+		return MismatchCount;
+
+	const CPUResolveMode CPUMode = GetCPUResolveMode(Mode);
+	CPUResolvedDepth Reference;
+	CPUResolvedDepth CompressedResolve;
+	CPUResolvedDepth DecompressedResolve;
+	Reference.Allocate(Width, Height);
+	CompressedResolve.Allocate(Width, Height);
+	DecompressedResolve.Allocate(Width, Height);
+
+	if (!CPUResolveDepthRegion(Reference, 0, 0, *DepthSurface, nullptr, CPUMode) || !CPUResolveCompressedDepthRegion(CompressedResolve, 0, 0, *Compressed, nullptr, CPUMode) ||
+		!CPUResolveDepthRegion(DecompressedResolve, 0, 0, Decompressed, nullptr, CPUMode))
+		return MismatchCount + static_cast<uint64_t>(Width) * Height;
+
+	for (size_t i = 0; i < Reference.Depth.size(); ++i)
+	{
+		MismatchCount += memcmp(&Reference.Depth[i], &CompressedResolve.Depth[i], sizeof(float)) != 0;
+		MismatchCount += memcmp(&Reference.Depth[i], &DecompressedResolve.Depth[i], sizeof(float)) != 0;
+	}
+
+	return MismatchCount;
+}
+
+// Texels of the resolved stencil plane that are not the MIN (with RESOLVE_MODE_MIN) or MAX of the stencil values of
+// their samples, every texel when the plane is missing
+static uint64_t CountStencilMismatches(const CPUDepthSurface* DepthSurface, const CPUResolvedStencil* ResolvedStencil, RenderResolveMode Mode, uint32_t Width, uint32_t Height)
+{
+	CPUResolvedStencil Reference;
+	Reference.Allocate(Width, Height);
+
+	if (!DepthSurface || !ResolvedStencil || ResolvedStencil->Stencil.size() != Reference.Stencil.size() ||
+		!CPUResolveStencilRegion(Reference, 0, 0, *DepthSurface, nullptr, Mode == RENDER_RESOLVE_MODE_MIN ? CPU_RESOLVE_MODE_MIN : CPU_RESOLVE_MODE_MAX))
+		return static_cast<uint64_t>(Width) * Height;
+
+	uint64_t MismatchCount = 0;
+
+	for (size_t i = 0; i < Reference.Stencil.size(); ++i)
+		MismatchCount += Reference.Stencil[i] != ResolvedStencil->Stencil[i];
+
+	return MismatchCount;
+}
+
+// Size of resize N, stepping in and back out over 32 resizes; the odd steps keep crossing tile boundaries
+static void GetDraggedSize(const HeadlessSettings& Settings, uint32_t ResizeIndex, uint32_t& Width, uint32_t& Height)
+{
+	const uint32_t Phase = ResizeIndex % 32;
+	const uint32_t Step = Phase < 16 ? Phase : 32 - Phase;
+
+	Width = Settings.Width > Step * 7 ? Settings.Width - Step * 7 : 1;
+	Height = Settings.Height > Step * 5 ? Settings.Height - Step * 5 : 1;
+}
+
+int RunHeadless(const HeadlessSettings& Settings, const FrameRendererSettings& RendererSettings)
+{
+	std::error_code Error;
+	std::filesystem::create_directories(Settings.OutputDirectory, Error);
+
+	RecordingRenderBackend Backend(Settings.Width, Settings.Height, true, &CPUThreadPool::GetDefault());
+	Backend.SetUniformPixelTracking(Settings.UniformPixels);
+	Backend.SetCompressedDepth(Settings.CompressedDepth);
+
+	FrameRenderer Renderer(Backend, RendererSettings);
+	AsyncFileWriter Writer;
+
+	if (!Renderer.AreTargetsPlaced())
+	{
+		printf("Headless: could not place the render targets at %ux%u\n", Settings.Width, Settings.Height);
+		return HEADLESS_RESULT_RESOURCE_CREATION_FAILED;
+	}
+
+	std::unique_ptr<Profiler> Profiling;
+
+	if (Settings.Profile)
+	{
+		Profiling = std::make_unique<Profiler>(&Backend);
+		Profiler::SetActive(Profiling.get());
+		Renderer.SetProfiler(Profiling.get());
+	}
+
+	const std::filesystem::path OutputDirectory(Settings.OutputDirectory);
+	double RenderMilliseconds = 0.0;
+	uint64_t MismatchCount = 0;
+	CPUDepthClassification Classification;
+	uint32_t ResizeCount = 0;
+
+	// Only the resolve pass resolves the stencil plane, the compute resolves leave it alone
+	const RenderDepthFormatInfo* DepthFormat = GetRenderDepthFormatInfo(RendererSettings.DepthFormat);
+	const bool ResolvesStencil = RendererSettings.ResolveStencil && DepthFormat && DepthFormat->StencilPlaneFormat != RENDER_FORMAT_UNKNOWN &&
+		!RendererSettings.ComputeHiZ && !RendererSettings.ComputeResolve && RendererSettings.ResolveMode != RENDER_RESOLVE_MODE_DECOMPRESS;
+
+	for (uint32_t Frame = 0; Frame < Settings.FrameCount; ++Frame)
+	{
+		const auto FrameBegin = std::chrono::high_resolution_clock::now();
+
+		if (Settings.ResizeInterval != 0 && Frame != 0 && Frame % Settings.ResizeInterval == 0)
+		{
+			uint32_t Width = 0;
+			uint32_t Height = 0;
+			GetDraggedSize(Settings, ++ResizeCount, Width, Height);
+
+			if (!Renderer.Resize(Width, Height))
+			{
+				printf("Headless: could not place the render targets at %ux%u\n", Width, Height);
+				return HEADLESS_RESULT_RESOURCE_CREATION_FAILED;
+			}
+		}
+
+		RenderCommandList* CommandList = Backend.BeginFrame();
+		const RenderResource BackBuffer = Backend.GetBackBuffer();
+
+		Renderer.RecordFrame(*CommandList, BackBuffer);
+
+		// Replays the frame
+		Backend.EndFrame();
+
+		RenderMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - FrameBegin).count();
+
+		if (Frame + 1 != Settings.FrameCount && (Settings.DumpInterval == 0 || Frame % Settings.DumpInterval != 0))
+			continue;
+
+		const bool FusedVisualization = Renderer.GetResolvedDepthBuffer() == RenderNullHandle;
+		const CPUResolvedDepth* ResolvedDepth = FusedVisualization ? nullptr : Backend.GetResolvedDepth(Renderer.GetResolvedDepthBuffer());
+		const std::vector<uint32_t>* Visualization = Backend.GetColorTexture(BackBuffer);
+
+		MismatchCount += CountMismatches(Backend.GetDepthSurface(Renderer.GetDepthBuffer()), ResolvedDepth, Visualization, RendererSettings.ResolveMode, FusedVisualization, Backend.GetWidth(), Backend.GetHeight(), Classification);
+
+		if (RendererSettings.ComputeHiZ)
+			MismatchCount += CountHiZMismatches(Backend.GetBufferData(Renderer.GetHiZBuffer()), ResolvedDepth);
+
+		if (ResolvesStencil && ResolvedDepth)
+			MismatchCount += CountStencilMismatches(Backend.GetDepthSurface(Renderer.GetDepthBuffer()), Backend.GetResolvedStencil(Renderer.GetResolvedDepthBuffer()), RendererSettings.ResolveMode, Backend.GetWidth(), Backend.GetHeight());
+
+		if (Settings.CompressedDepth)
+			MismatchCount += CountCompressedMismatches(Backend.GetCompressedDepthSurface(Renderer.GetDepthBuffer()), Backend.GetDepthSurface(Renderer.GetDepthBuffer()), RendererSettings.ResolveMode, Backend.GetWidth(), Backend.GetHeight());
+
+		char FileName[64];
+
+		if (ResolvedDepth)
+		{
+			snprintf(FileName, sizeof(FileName), Settings.RawDepth ? "ResolvedDepth_%04u.raw" : "ResolvedDepth_%04u.pfm", Frame);
+			Writer.Write((OutputDirectory / FileName).string(), Settings.RawDepth ? EncodeRaw(*ResolvedDepth) : EncodePFM(*ResolvedDepth));
+		}
+
+		if (Visualization)
+		{
+			snprintf(FileName, sizeof(FileName), "Visualization_%04u.ppm", Frame);
+			Writer.Write((OutputDirectory / FileName).string(), EncodePPM(*Visualization, Backend.GetWidth(), Backend.GetHeight()));
+		}
+	}
+
+	Writer.Flush();
+
+	bool ProfileWritten = true;
+
+	if (Profiling)
+	{
+		Backend.WaitIdle();
+		Profiling->Flush();
+		Profiler::SetActive(nullptr);
+
+		Profiling->PrintSummary();
+
+		ProfileWritten = Profiling->WriteChromeTrace(Settings.ProfilePath);
+
+		if (ProfileWritten)
+			printf("Profile written to %s\n", Settings.ProfilePath.c_str());
+	}
+
+	printf("Headless: %u frames of %ux%u on %s, %.3f ms/frame, %u files (%.1f MB) written to %s\n", Settings.FrameCount, Settings.Width, Settings.Height, Backend.GetName(),
+		Settings.FrameCount ? RenderMilliseconds / Settings.FrameCount : 0.0, Writer.GetWrittenCount(), Writer.GetWrittenBytes() / (1024.0 * 1024.0), Settings.OutputDirectory.c_str());
+
+	const CPURect& Covered = Classification.CoveredRect;
+	printf("Headless: last dumped frame has %llu texels at 0.0, %llu at 1.0, %llu between, %llu invalid, covered rect (%d, %d)-(%d, %d)\n",
+		static_cast<unsigned long long>(Classification.Counts[CPU_DEPTH_CLASS_ZERO]), static_cast<unsigned long long>(Classification.Counts[CPU_DEPTH_CLASS_ONE]),
+		static_cast<unsigned long long>(Classification.Counts[CPU_DEPTH_CLASS_BETWEEN]), static_cast<unsigned long long>(Classification.Counts[CPU_DEPTH_CLASS_OTHER]),
+		Covered.Left, Covered.Top, Covered.Right, Covered.Bottom);
+	printf("Headless: last frame resolved %u of %u tiles\n", Renderer.GetResolvedTileCount(), Renderer.GetTileCount());
+
+	if (Settings.ResizeInterval != 0)
+	{
+		const RenderHeapPool::Stats& PoolStats = Renderer.GetHeapPool().GetStats();
+		printf("Headless: %u resizes, last at %ux%u, transient heaps %u reused from the pool, %u created (%.1f MB), %.1f MB pooled\n", ResizeCount, Backend.GetWidth(), Backend.GetHeight(),
+			PoolStats.HitCount, PoolStats.MissCount, PoolStats.CreatedSize / (1024.0 * 1024.0), (Renderer.GetHeapPool().GetUsedSize() + Renderer.GetHeapPool().GetFreeSize()) / (1024.0 * 1024.0));
+	}
+
+	if (const CPUCompressedDepthSurface* Compressed = Backend.GetCompressedDepthSurface(Renderer.GetDepthBuffer()))
+	{
+		const CPUCompressedDepthStats CompressedStats = Compressed->GetStats();
+		printf("Headless: last frame compressed to %u plane tiles and %u raw tiles, %.1f MB of %.1f MB (%.2fx)\n", CompressedStats.PlaneTiles, CompressedStats.RawTiles,
+			CompressedStats.CompressedBytes / (1024.0 * 1024.0), CompressedStats.UncompressedBytes / (1024.0 * 1024.0), static_cast<double>(CompressedStats.UncompressedBytes) / std::max<uint64_t>(CompressedStats.CompressedBytes, 1));
+	}
+
+	UniformResolveReport Uniform;
+	const CPUDepthSurface* DepthSurface = Backend.GetDepthSurface(Renderer.GetDepthBuffer());
+
+	// DECOMPRESS resolves nothing to save time on
+	if (DepthSurface && RendererSettings.ResolveMode != RENDER_RESOLVE_MODE_DECOMPRESS && MeasureUniformResolve(*DepthSurface, GetCPUResolveMode(RendererSettings.ResolveMode), 10, CPUThreadPool::GetDefault(), Uniform))
+	{
+		// Signed, the classification costs more than it saves when most pixels are edges
+		const double DeltaMilliseconds = Uniform.UniformMilliseconds - Uniform.FullMilliseconds;
+
+		printf("Headless: last frame has %llu edge pixels of %llu (%.1f%%), a full resolve takes %.3f ms, %.3f ms reading one sample of the others (%+.3f ms, %s)\n",
+			static_cast<unsigned long long>(Uniform.EdgePixelCount), static_cast<unsigned long long>(Uniform.PixelCount), 100.0 * Uniform.EdgePixelCount / std::max<uint64_t>(Uniform.PixelCount, 1),
+			Uniform.FullMilliseconds, Uniform.UniformMilliseconds, DeltaMilliseconds, DeltaMilliseconds <= 0.0 ? "faster" : "slower");
+	}
+
+	if (MismatchCount > 0)
+	{
+		printf("Headless: %llu texels differ from the reference\n", static_cast<unsigned long long>(MismatchCount));
+		return HEADLESS_RESULT_VALIDATION_FAILED;
+	}
+
+	if (Writer.GetFailedCount() > 0 || !ProfileWritten)
+		return HEADLESS_RESULT_WRITE_FAILED;
+
+	return HEADLESS_RESULT_SUCCEEDED;
+}
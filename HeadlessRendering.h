@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "FrameRenderer.h"
+
+struct HeadlessSettings
+{
+	uint32_t Width = 1280;
+	uint32_t Height = 720;
+	uint32_t FrameCount = 60;
+	// Frames DumpInterval apart, counting from the first, are written as well as the last one; 0 writes the last only
+	uint32_t DumpInterval = 0;
+	// ResolvedDepth_N.raw (row-major float32, top row first) instead of ResolvedDepth_N.pfm
+	bool RawDepth = false;
+	std::string OutputDirectory = ".";
+	// Chrome trace of the CPU scopes and the GPU passes to ProfilePath, and their summary on stdout
+	bool Profile = false;
+	std::string ProfilePath = "Profile.json";
+	// Depth targets track their uniform pixels, the resolves read one sample of those; see MeasureUniformResolve
+	bool UniformPixels = true;
+	// Every ResizeInterval frames the size changes the way a window edge being dragged changes it, shrinking and
+	// growing again by a few pixels at a time; 0 keeps Width x Height
+	uint32_t ResizeInterval = 0;
+	// The depth target is also rasterized into a CPUCompressedDepthSurface; dumped frames check that it decompresses
+	// to the same samples and resolves to the same texels, and the compression ratio is printed. D32_FLOAT_S8X24_UINT only.
+	bool CompressedDepth = false;
+};
+
+// Exit codes of RunHeadless
+enum HeadlessResult
+{
+	HEADLESS_RESULT_SUCCEEDED = 0,
+	HEADLESS_RESULT_VALIDATION_FAILED = 2, // resolved depth, stencil or visualization differs from the reference
+	HEADLESS_RESULT_WRITE_FAILED = 3,
+	HEADLESS_RESULT_RESOURCE_CREATION_FAILED = 4 // the render targets could not be placed, at creation or a resize
+};
+
+// Renders FrameCount frames on the CPU backend, without a window or a device. Dumped frames write the resolved depth
+// and the visualization (Visualization_N.ppm) through an AsyncFileWriter, and are checked against the reference:
+// every resolved texel must be the CPU resolve of its samples and every visualized pixel the color CPUClassifyDepth
+// gives its texel; with ComputeHiZ every pyramid texel must also be the one CPUBuildHiZPyramid builds from the
+// resolved depth, with CompressedDepth every sample and resolved texel of the compressed copy the uncompressed one. The compute resolves run through their CPU counterparts. Prints the frame time and the
+// classification of the last dumped frame, with UniformPixels the edge pixels of the last frame and the resolve time the others save, with ResizeInterval the resizes and the heaps they reused,
+// returns a HeadlessResult.
+int RunHeadless(const HeadlessSettings& Settings, const FrameRendererSettings& RendererSettings);
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+
+// Root constants of ResolveHiZCS and ReduceHiZCS, laid out like the HiZConstants cbuffer below
+struct HiZShaderConstants
+{
+	uint32_t SourceWidth;
+	uint32_t SourceHeight;
+	uint32_t SourceOffset; // ReduceHiZCS: first texel of the level read
+	uint32_t ResolveMode;  // ResolveHiZCS: D3D12_RESOLVE_MODE_MIN, _MAX or _AVERAGE
+	uint32_t LevelCount;   // levels written by the dispatch, at most HiZLevelsPerDispatch
+	uint32_t Padding[3];
+	uint32_t Levels[6][4]; // Width, Height, Offset, unused
+};
+
+constexpr uint32_t HiZLevelsPerDispatch = 6;
+constexpr uint32_t HiZGroupFootprint = 64;
+
+// Compute variant of the resolve: every group resolves a 64x64 block of DepthBuffer into ResolvedDepth and reduces it
+// into the first six levels of the min/max pyramid in group shared memory. ReduceHiZCS continues from the last level
+// written, six levels per dispatch. The pyramid is one float2 buffer with the CPUHiZPyramid layout; NaN doubles as
+// the empty value since min and max return the other operand when one of them is NaN.
+constexpr auto HiZComputeShaderSource = R"(
+Texture2DMS<float> DepthBuffer : register(t0);
+RWTexture2D<float> ResolvedDepth : register(u0);
+RWStructuredBuffer<float2> HiZ : register(u1);
+
+cbuffer HiZConstants : register(b0)
+{
+	uint2 SourceSize;
+	uint SourceOffset;
+	uint ResolveMode;
+	uint LevelCount;
+	uint3 Padding;
+	uint4 Levels[6];
+};
+
+groupshared float2 Texels[32 * 32];
+
+float2 GetEmptyTexel()
+{
+	return asfloat(uint2(0x7FC00000, 0x7FC00000));
+}
+
+float2 CombineTexels(float2 a, float2 b)
+{
+	return float2(min(a.x, b.x), max(a.y, b.y));
+}
+
+void StoreTexel(uint Level, uint2 Position, float2 Texel)
+{
+	if (all(Position < Levels[Level].xy))
+		HiZ[Levels[Level].z + Position.y * Levels[Level].x + Position.x] = Texel;
+}
+
+// Writes level 0 texel of every thread, then halves the 32x32 texels of the group LevelCount - 1 times
+void ReduceGroup(uint2 GroupId, uint2 ThreadId, uint ThreadIndex, float2 Texel)
+{
+	StoreTexel(0, GroupId * 32 + ThreadId, Texel);
+	Texels[ThreadIndex] = Texel;
+
+	uint Size = 32;
+
+	for (uint Level = 1; Level < LevelCount; ++Level)
+	{
+		GroupMemoryBarrierWithGroupSync();
+
+		Size /= 2;
+		const bool Active = all(ThreadId < Size);
+
+		if (Active)
+		{
+			const uint Index = ThreadId.y * 64 + ThreadId.x * 2;
+			Texel = CombineTexels(CombineTexels(Texels[Index], Texels[Index + 1]), CombineTexels(Texels[Index + 32], Texels[Index + 33]));
+		}
+
+		GroupMemoryBarrierWithGroupSync();
+
+		if (Active)
+		{
+			Texels[ThreadId.y * 32 + ThreadId.x] = Texel;
+			StoreTexel(Level, GroupId * Size + ThreadId, Texel);
+		}
+	}
+}
+
+float ResolvePixel(uint2 Position)
+{
+	uint Width, Height, SampleCount;
+	DepthBuffer.GetDimensions(Width, Height, SampleCount);
+
+	float Result = DepthBuffer.Load(Position, 0);
+
+	for (uint s = 1; s < SampleCount; ++s)
+	{
+		const float Depth = DepthBuffer.Load(Position, s);
+		Result = ResolveMode == 3 ? Result + Depth : (ResolveMode == 2 ? max(Result, Depth) : min(Result, Depth));
+	}
+
+	return ResolveMode == 3 ? Result / SampleCount : Result;
+}
+
+[numthreads(32, 32, 1)]
+void ResolveHiZCS(uint3 GroupId : SV_GroupID, uint3 ThreadId : SV_GroupThreadID, uint ThreadIndex : SV_GroupIndex)
+{
+	const uint2 Base = (GroupId.xy * 32 + ThreadId.xy) * 2;
+	float2 Texel = GetEmptyTexel();
+
+	for (uint i = 0; i < 4; ++i)
+	{
+		const uint2 Position = Base + uint2(i & 1, i >> 1);
+
+		if (all(Position < SourceSize))
+		{
+			const float Depth = ResolvePixel(Position);
+			ResolvedDepth[Position] = Depth;
+			Texel = CombineTexels(Texel, Depth.xx);
+		}
+	}
+
+	ReduceGroup(GroupId.xy, ThreadId.xy, ThreadIndex, Texel);
+}
+
+[numthreads(32, 32, 1)]
+void ReduceHiZCS(uint3 GroupId : SV_GroupID, uint3 ThreadId : SV_GroupThreadID, uint ThreadIndex : SV_GroupIndex)
+{
+	const uint2 Base = (GroupId.xy * 32 + ThreadId.xy) * 2;
+	float2 Texel = GetEmptyTexel();
+
+	for (uint i = 0; i < 4; ++i)
+	{
+		const uint2 Position = Base + uint2(i & 1, i >> 1);
+
+		if (all(Position < SourceSize))
+			Texel = CombineTexels(Texel, HiZ[SourceOffset + Position.y * SourceSize.x + Position.x]);
+	}
+
+	ReduceGroup(GroupId.xy, ThreadId.xy, ThreadIndex, Texel);
+}
+)";
@@ -0,0 +1,119 @@
+#include "ParallelRecording.h"
+#include "RecordingRenderBackend.h"
+#include "CPUParallel.h"
+#include "CubeMesh.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+void RecordParallel(RenderBackend& Backend, RenderCommandList& FrameCommandList, CPUThreadPool& Pool, uint32_t JobCount,
+	const std::function<void(RenderCommandList&, uint32_t)>& RecordJob)
+{
+	std::vector<RenderCommandList*> Lists(JobCount, nullptr);
+	uint32_t ListCount = 0;
+
+	while (ListCount < JobCount && (Lists[ListCount] = Backend.AcquireCommandList()) != nullptr)
+		++ListCount;
+
+	Pool.ParallelFor(ListCount, [&](uint32_t Job) { RecordJob(*Lists[Job], Job); });
+
+	Backend.SubmitCommandLists(ListCount, Lists.data());
+
+	for (uint32_t Job = ListCount; Job < JobCount; ++Job)
+		RecordJob(FrameCommandList, Job);
+}
+
+std::vector<RecordingScalingResult> RunRecordingScalingBenchmark(uint32_t DrawCount, uint32_t MaxThreadCount)
+{
+	constexpr uint32_t FrameCount = 20;
+	constexpr uint32_t JobsPerThread = 4;
+
+	if (MaxThreadCount == 0)
+		MaxThreadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	RecordingRenderBackend Backend(64, 64);
+
+	RenderBufferDesc BufferDesc;
+	BufferDesc.HeapType = RENDER_HEAP_TYPE_UPLOAD;
+	BufferDesc.InitialState = RENDER_RESOURCE_STATE_GENERIC_READ;
+	BufferDesc.Size = sizeof(CubeVertices);
+	const RenderResource VertexBuffer = Backend.CreateBuffer(BufferDesc);
+	BufferDesc.Size = sizeof(CubeIndices);
+	const RenderResource IndexBuffer = Backend.CreateBuffer(BufferDesc);
+	BufferDesc.Size = 256;
+	const RenderResource ConstantBuffer = Backend.CreateBuffer(BufferDesc);
+	const RenderView ConstantBufferView = Backend.CreateConstantBufferView(ConstantBuffer, 256);
+
+	const RenderDescriptorRange DescriptorRange = { RENDER_DESCRIPTOR_TYPE_CBV, 1, 0 };
+
+	RenderRootParameter RootParameters[2];
+	RootParameters[0] = { .Ranges = &DescriptorRange, .RangeCount = 1, .Visibility = RENDER_SHADER_VISIBILITY_VERTEX };
+	RootParameters[1] = { .Constants32Bit = 4, .ConstantRegister = 1, .Visibility = RENDER_SHADER_VISIBILITY_VERTEX };
+
+	RenderGraphicsPipelineDesc PipelineDesc;
+	PipelineDesc.RootSignature = Backend.CreateRootSignature({ RootParameters, 2, true });
+	PipelineDesc.PositionInput = true;
+	PipelineDesc.DepthEnable = true;
+	PipelineDesc.DepthStencilFormat = RENDER_FORMAT_D32_FLOAT_S8X24_UINT;
+
+	const RenderPipeline Pipeline = Backend.CreateGraphicsPipeline(PipelineDesc);
+
+	std::vector<uint32_t> ThreadCounts;
+
+	for (uint32_t ThreadCount = 1; ThreadCount < MaxThreadCount; ThreadCount *= 2)
+		ThreadCounts.push_back(ThreadCount);
+
+	ThreadCounts.push_back(MaxThreadCount);
+
+	std::vector<RecordingScalingResult> Results;
+
+	for (uint32_t ThreadCount : ThreadCounts)
+	{
+		CPUThreadPool Pool(ThreadCount);
+
+		const uint32_t JobCount = ThreadCount == 1 ? 1 : std::min(ThreadCount * JobsPerThread, RenderMaxAcquiredCommandLists);
+		const uint32_t DrawsPerJob = (DrawCount + JobCount - 1) / JobCount;
+
+		auto RecordJob = [&](RenderCommandList& CommandList, uint32_t Job)
+		{
+			CommandList.SetPipeline(Pipeline);
+			CommandList.SetDescriptorTable(0, ConstantBufferView);
+			CommandList.SetPrimitiveTopology(RENDER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			CommandList.SetVertexBuffer(VertexBuffer, sizeof(CubeVertices), sizeof(CPUFloat3));
+			CommandList.SetIndexBuffer(IndexBuffer, sizeof(CubeIndices), RENDER_FORMAT_R16_UINT);
+
+			const uint32_t FirstDraw = Job * DrawsPerJob;
+			const uint32_t LastDraw = std::min(FirstDraw + DrawsPerJob, DrawCount);
+
+			for (uint32_t Draw = FirstDraw; Draw < LastDraw; ++Draw)
+			{
+				const float Offset[4] = { static_cast<float>(Draw % 64), static_cast<float>(Draw / 64), 0.0f, 1.0f };
+
+				CommandList.SetRootConstants(1, 4, Offset);
+				CommandList.DrawIndexed(CubeIndexCount, 1);
+			}
+		};
+
+		double Milliseconds = 0.0;
+
+		// The first frames grow the command arenas, only the later ones are timed
+		for (uint32_t Frame = 0; Frame < FrameCount + 2; ++Frame)
+		{
+			RenderCommandList* CommandList = Backend.BeginFrame();
+
+			const auto Start = std::chrono::high_resolution_clock::now();
+			RecordParallel(Backend, *CommandList, Pool, JobCount, RecordJob);
+			const auto End = std::chrono::high_resolution_clock::now();
+
+			Backend.EndFrame();
+
+			if (Frame >= 2)
+				Milliseconds += std::chrono::duration<double, std::milli>(End - Start).count();
+		}
+
+		Results.push_back({ ThreadCount, static_cast<double>(DrawCount) * FrameCount / Milliseconds });
+	}
+
+	return Results;
+}
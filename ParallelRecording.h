@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "RenderBackend.h"
+
+class CPUThreadPool;
+
+// Records JobCount jobs on the pool, job i into a command list of its own, and submits the lists in job order after
+// what the frame's command list holds so far. Jobs start with no state set. Jobs left without a list when the
+// backend runs out are recorded serially into the frame's command list after the submission.
+void RecordParallel(RenderBackend& Backend, RenderCommandList& FrameCommandList, CPUThreadPool& Pool, uint32_t JobCount,
+	const std::function<void(RenderCommandList&, uint32_t)>& RecordJob);
+
+struct RecordingScalingResult
+{
+	uint32_t ThreadCount;
+	double DrawsPerMillisecond;
+};
+
+// Records frames of DrawCount cube draws (per-draw root constants, state set per job) on the recording backend with
+// 1, 2, 4 ... MaxThreadCount threads, ThreadCount == 0 meaning std::thread::hardware_concurrency()
+std::vector<RecordingScalingResult> RunRecordingScalingBenchmark(uint32_t DrawCount, uint32_t MaxThreadCount = 0);
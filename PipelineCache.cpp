@@ -0,0 +1,305 @@
+#include "PipelineCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+constexpr uint32_t PipelineCacheMagic = 0x48435050; // "PPCH"
+constexpr uint64_t PipelineCacheBlobAlignment = 16;
+
+void PipelineCacheHasher::Add(const void* Data, size_t Size)
+{
+	const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+
+	for (size_t i = 0; i < Size; ++i)
+		Hash = (Hash ^ Bytes[i]) * 1099511628211ull;
+}
+
+void PipelineCacheHasher::AddString(const char* String)
+{
+	const uint64_t Length = String ? strlen(String) : UINT64_MAX;
+
+	AddValue(Length);
+
+	if (String)
+		Add(String, Length);
+}
+
+static uint64_t GetChecksum(const void* Data, size_t Size)
+{
+	PipelineCacheHasher Hasher;
+	Hasher.Add(Data, Size);
+	return Hasher.GetHash();
+}
+
+static uint64_t AlignBlobOffset(uint64_t Offset)
+{
+	return (Offset + PipelineCacheBlobAlignment - 1) & ~(PipelineCacheBlobAlignment - 1);
+}
+
+PipelineCache::~PipelineCache()
+{
+	UnmapFile();
+}
+
+bool PipelineCache::MapFile()
+{
+#ifdef _WIN32
+	HANDLE File = CreateFileA(Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (File == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER Size;
+
+	if (!GetFileSizeEx(File, &Size) || Size.QuadPart == 0)
+	{
+		CloseHandle(File);
+		return false;
+	}
+
+	HANDLE Mapping = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* Data = Mapping ? MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+	if (!Data)
+	{
+		if (Mapping)
+			CloseHandle(Mapping);
+
+		CloseHandle(File);
+		return false;
+	}
+
+	FileHandle = File;
+	MappingHandle = Mapping;
+	MappedData = static_cast<const uint8_t*>(Data);
+	MappedSize = static_cast<size_t>(Size.QuadPart);
+#else
+	const int File = open(Path.c_str(), O_RDONLY);
+
+	if (File < 0)
+		return false;
+
+	struct stat Status;
+
+	if (fstat(File, &Status) != 0 || Status.st_size == 0)
+	{
+		close(File);
+		return false;
+	}
+
+	void* Data = mmap(nullptr, Status.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+	close(File);
+
+	if (Data == MAP_FAILED)
+		return false;
+
+	MappedData = static_cast<const uint8_t*>(Data);
+	MappedSize = static_cast<size_t>(Status.st_size);
+#endif
+
+	return true;
+}
+
+void PipelineCache::UnmapFile()
+{
+	if (!MappedData)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(MappedData);
+	CloseHandle(MappingHandle);
+	CloseHandle(FileHandle);
+	FileHandle = nullptr;
+	MappingHandle = nullptr;
+#else
+	munmap(const_cast<uint8_t*>(MappedData), MappedSize);
+#endif
+
+	MappedData = nullptr;
+	MappedSize = 0;
+}
+
+bool PipelineCache::Load(const std::string& Path, uint64_t DeviceHash)
+{
+	UnmapFile();
+	Entries.clear();
+
+	this->Path = Path;
+	this->DeviceHash = DeviceHash;
+	Dirty = false;
+	LoadedCount = 0;
+	DroppedCount = 0;
+
+	if (!MapFile())
+		return false;
+
+	FileHeader Header;
+
+	if (MappedSize < sizeof(FileHeader))
+	{
+		UnmapFile();
+		return false;
+	}
+
+	memcpy(&Header, MappedData, sizeof(FileHeader));
+
+	if (Header.Magic != PipelineCacheMagic || Header.Version != FormatVersion || Header.EntryCount > (MappedSize - sizeof(FileHeader)) / sizeof(FileEntry))
+	{
+		UnmapFile();
+		return false;
+	}
+
+	const FileEntry* FileEntries = reinterpret_cast<const FileEntry*>(MappedData + sizeof(FileHeader));
+
+	for (uint32_t i = 0; i < Header.EntryCount; ++i)
+	{
+		const FileEntry& Current = FileEntries[i];
+
+		++LoadedCount;
+
+		if (Current.Offset > MappedSize || Current.Size > MappedSize - Current.Offset || (Current.DeviceSpecific && Header.DeviceHash != DeviceHash))
+		{
+			++DroppedCount;
+			continue;
+		}
+
+		Entries[Current.Key] = { MappedData + Current.Offset, static_cast<size_t>(Current.Size), Current.Checksum, Current.DeviceSpecific != 0, false, {} };
+	}
+
+	// Rewrite the file without what was dropped
+	Dirty = DroppedCount > 0;
+
+	return true;
+}
+
+bool PipelineCache::Save()
+{
+	if (!Dirty || Path.empty())
+		return true;
+
+	// The file is replaced, so nothing may point into its mapping anymore
+	for (auto& [Key, Current] : Entries)
+	{
+		if (Current.Stored.empty() && Current.Size > 0)
+		{
+			Current.Stored.assign(Current.Data, Current.Data + Current.Size);
+			Current.Data = Current.Stored.data();
+		}
+	}
+
+	UnmapFile();
+
+	const std::string TempPath = Path + ".tmp";
+	std::ofstream File(TempPath, std::ios::binary | std::ios::trunc);
+
+	if (!File)
+		return false;
+
+	const FileHeader Header = { PipelineCacheMagic, FormatVersion, DeviceHash, static_cast<uint32_t>(Entries.size()), 0 };
+	std::vector<FileEntry> FileEntries;
+	uint64_t Offset = AlignBlobOffset(sizeof(FileHeader) + Entries.size() * sizeof(FileEntry));
+
+	for (const auto& [Key, Current] : Entries)
+	{
+		FileEntries.push_back({ Key, Offset, Current.Size, Current.Checksum, Current.DeviceSpecific ? 1u : 0u, 0 });
+		Offset = AlignBlobOffset(Offset + Current.Size);
+	}
+
+	File.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+	File.write(reinterpret_cast<const char*>(FileEntries.data()), FileEntries.size() * sizeof(FileEntry));
+
+	const char Padding[PipelineCacheBlobAlignment] = {};
+	uint64_t Position = sizeof(FileHeader) + FileEntries.size() * sizeof(FileEntry);
+	uint32_t Index = 0;
+
+	for (const auto& [Key, Current] : Entries)
+	{
+		const uint64_t BlobOffset = FileEntries[Index++].Offset;
+
+		File.write(Padding, BlobOffset - Position);
+		File.write(reinterpret_cast<const char*>(Current.Data), Current.Size);
+		Position = BlobOffset + Current.Size;
+	}
+
+	File.close();
+	const bool Written = !File.fail();
+
+	std::error_code Error;
+
+	if (Written)
+		std::filesystem::rename(TempPath, Path, Error);
+
+	if (!Written || Error)
+	{
+		std::filesystem::remove(TempPath, Error);
+		return false;
+	}
+
+	Dirty = false;
+	return true;
+}
+
+bool PipelineCache::Find(uint64_t Key, PipelineCacheBlob& Blob)
+{
+	auto Found = Entries.find(Key);
+
+	if (Found == Entries.end())
+	{
+		++MissCount;
+		return false;
+	}
+
+	Entry& Current = Found->second;
+
+	if (!Current.Verified)
+	{
+		if (GetChecksum(Current.Data, Current.Size) != Current.Checksum)
+		{
+			Entries.erase(Found);
+			++DroppedCount;
+			++MissCount;
+			Dirty = true;
+			return false;
+		}
+
+		Current.Verified = true;
+	}
+
+	Blob.Data = Current.Data;
+	Blob.Size = Current.Size;
+
+	++HitCount;
+	return true;
+}
+
+PipelineCacheBlob PipelineCache::Store(uint64_t Key, const void* Data, size_t Size, bool DeviceSpecific)
+{
+	Entry& Current = Entries[Key];
+
+	Current.Stored.assign(static_cast<const uint8_t*>(Data), static_cast<const uint8_t*>(Data) + Size);
+	Current.Data = Current.Stored.data();
+	Current.Size = Size;
+	Current.Checksum = GetChecksum(Data, Size);
+	Current.DeviceSpecific = DeviceSpecific;
+	Current.Verified = true;
+
+	Dirty = true;
+
+	return { Current.Data, Current.Size };
+}
+
+void PipelineCache::Remove(uint64_t Key)
+{
+	if (Entries.erase(Key) > 0)
+		Dirty = true;
+}
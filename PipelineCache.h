@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 64-bit FNV-1a over everything that determines a cached object: shader source, entry point, profile, defines and
+// compile flags for bytecode, the whole pipeline description with its pointers replaced by the hashes of what they
+// point to for pipelines
+class PipelineCacheHasher
+{
+public:
+	void Add(const void* Data, size_t Size);
+	// Distinguishes nullptr from "" and "ab" + "c" from "a" + "bc"
+	void AddString(const char* String);
+
+	// Plain structures only, with their padding zeroed
+	template<typename T>
+	void AddValue(const T& Value) { Add(&Value, sizeof(T)); }
+
+	uint64_t GetHash() const { return Hash; }
+
+private:
+	uint64_t Hash = 14695981039346656037ull;
+};
+
+struct PipelineCacheBlob
+{
+	const void* Data = nullptr;
+	size_t Size = 0;
+};
+
+// Blobs by content hash, persisted in one file that is memory-mapped when loaded, so a warm start reads only the
+// blobs it looks up. The file starts with a header and an entry table, blobs follow 16 byte aligned. A file with
+// another format version is ignored. Blobs stored as device specific (pipeline state blobs) are dropped when the
+// file was written for another adapter or driver. Every blob is checked against its checksum the first time it
+// is found, a corrupt one is dropped and reported as a miss.
+class PipelineCache
+{
+public:
+	static constexpr uint32_t FormatVersion = 1;
+
+	PipelineCache() = default;
+	~PipelineCache();
+
+	PipelineCache(const PipelineCache&) = delete;
+	PipelineCache& operator=(const PipelineCache&) = delete;
+
+	// DeviceHash identifies the adapter and driver. Returns false when there is no usable file, the cache then
+	// starts empty and Save creates the file.
+	bool Load(const std::string& Path, uint64_t DeviceHash);
+	// Writes every entry to the file given to Load when something was stored or removed since. Blobs found
+	// before are invalid afterwards.
+	bool Save();
+
+	// Blob valid until Save, Remove of the key or the destruction of the cache
+	bool Find(uint64_t Key, PipelineCacheBlob& Blob);
+	// Copies the blob in and returns the copy, valid like the blobs Find returns
+	PipelineCacheBlob Store(uint64_t Key, const void* Data, size_t Size, bool DeviceSpecific);
+	// For blobs the consumer turned down, like pipeline state blobs the driver no longer accepts
+	void Remove(uint64_t Key);
+
+	uint32_t GetEntryCount() const { return static_cast<uint32_t>(Entries.size()); }
+	// Entries read from the file, and those of them dropped for another device or a corrupt blob
+	uint32_t GetLoadedCount() const { return LoadedCount; }
+	uint32_t GetDroppedCount() const { return DroppedCount; }
+	uint32_t GetHitCount() const { return HitCount; }
+	uint32_t GetMissCount() const { return MissCount; }
+
+private:
+	struct FileHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t DeviceHash;
+		uint32_t EntryCount;
+		uint32_t Reserved;
+	};
+
+	struct FileEntry
+	{
+		uint64_t Key;
+		uint64_t Offset;
+		uint64_t Size;
+		uint64_t Checksum;
+		uint32_t DeviceSpecific;
+		uint32_t Reserved;
+	};
+
+	struct Entry
+	{
+		const uint8_t* Data;
+		size_t Size;
+		uint64_t Checksum;
+		bool DeviceSpecific;
+		bool Verified;
+		std::vector<uint8_t> Stored; // blobs stored since the load, the others point into the mapping
+	};
+
+	bool MapFile();
+	void UnmapFile();
+
+	std::string Path;
+	uint64_t DeviceHash = 0;
+
+	const uint8_t* MappedData = nullptr;
+	size_t MappedSize = 0;
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+
+	std::unordered_map<uint64_t, Entry> Entries;
+	bool Dirty = false;
+
+	uint32_t LoadedCount = 0;
+	uint32_t DroppedCount = 0;
+	uint32_t HitCount = 0;
+	uint32_t MissCount = 0;
+};
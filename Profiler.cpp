@@ -0,0 +1,270 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+
+Profiler::Profiler(RenderBackend* Backend) : Backend(Backend), Epoch(std::chrono::steady_clock::now())
+{
+	const uint64_t Frequency = Backend ? Backend->GetTimestampFrequency() : 0;
+	uint64_t CPUNanoseconds = 0;
+
+	if (Frequency == 0 || !Backend->GetTimestampCalibration(CalibrationGPU, CPUNanoseconds))
+		return;
+
+	// The GPU clock is assumed not to drift from the CPU clock over a run, one calibration puts both on one timeline
+	TicksPerMicrosecond = Frequency / 1000000.0;
+	CalibrationMicroseconds = (static_cast<double>(CPUNanoseconds) - std::chrono::duration_cast<std::chrono::nanoseconds>(Epoch.time_since_epoch()).count()) / 1000.0;
+
+	const uint32_t QueryCount = FrameScheduler::MaxFramesInFlight * MaxGPUScopesPerFrame * 2;
+	QueryHeap = Backend->CreateTimestampQueryHeap(QueryCount);
+
+	RenderBufferDesc BufferDesc;
+	BufferDesc.Size = QueryCount * sizeof(uint64_t);
+	BufferDesc.HeapType = RENDER_HEAP_TYPE_READBACK;
+	BufferDesc.InitialState = RENDER_RESOURCE_STATE_COPY_DEST;
+	BufferDesc.Name = "ProfilerReadback";
+	ReadbackBuffer = Backend->CreateBuffer(BufferDesc);
+
+	if (QueryHeap == RenderNullHandle || ReadbackBuffer == RenderNullHandle)
+		QueryHeap = RenderNullHandle;
+}
+
+Profiler::~Profiler()
+{
+	Profiler* Expected = this;
+	ActiveProfiler.compare_exchange_strong(Expected, nullptr);
+}
+
+double Profiler::ToMicroseconds(std::chrono::steady_clock::time_point Time) const
+{
+	return std::chrono::duration<double, std::micro>(Time - Epoch).count();
+}
+
+uint32_t Profiler::GetThreadIndex(std::thread::id Thread)
+{
+	auto Found = std::find(Threads.begin(), Threads.end(), Thread);
+
+	if (Found != Threads.end())
+		return static_cast<uint32_t>(Found - Threads.begin()) + 1;
+
+	Threads.push_back(Thread);
+	return static_cast<uint32_t>(Threads.size());
+}
+
+void Profiler::AddEvent(const ProfileEvent& Event)
+{
+	if (Events.size() >= MaxEventCount)
+	{
+		++DroppedCount;
+		return;
+	}
+
+	Events.push_back(Event);
+}
+
+void Profiler::AddCPUEvent(const char* Name, std::chrono::steady_clock::time_point Begin, std::chrono::steady_clock::time_point End)
+{
+	const double BeginMicroseconds = ToMicroseconds(Begin);
+	const double Duration = std::chrono::duration<double, std::micro>(End - Begin).count();
+
+	std::lock_guard<std::mutex> Lock(Mutex);
+	AddEvent({ Name, false, GetThreadIndex(std::this_thread::get_id()), CurrentFrame, BeginMicroseconds, Duration });
+}
+
+void Profiler::BeginFrame()
+{
+	if (!Backend)
+	{
+		++CurrentFrame;
+		return;
+	}
+
+	CurrentFrame = Backend->GetFrameNumber();
+
+	if (!HasGPUTimestamps())
+		return;
+
+	// The backend waited for the frame that last used the slot, its timestamps have landed
+	CurrentSlot = Backend->GetFrameSlot();
+	FrameSlot& Slot = Slots[CurrentSlot];
+
+	if (Slot.Resolved)
+		CollectSlot(Slot, CurrentSlot);
+
+	Slot.Frame = CurrentFrame;
+	Slot.ScopeNames.clear();
+	Slot.Resolved = false;
+	OpenScopes.clear();
+}
+
+void Profiler::BeginGPUScope(RenderCommandList& CommandList, const char* Name)
+{
+	if (!HasGPUTimestamps())
+		return;
+
+	FrameSlot& Slot = Slots[CurrentSlot];
+
+	if (Slot.ScopeNames.size() >= MaxGPUScopesPerFrame)
+	{
+		// Still pushed so the matching EndGPUScope pops it
+		OpenScopes.push_back(UINT32_MAX);
+
+		std::lock_guard<std::mutex> Lock(Mutex);
+		++DroppedCount;
+		return;
+	}
+
+	const uint32_t Scope = static_cast<uint32_t>(Slot.ScopeNames.size());
+	Slot.ScopeNames.push_back(Name);
+	OpenScopes.push_back(Scope);
+
+	CommandList.WriteTimestamp(QueryHeap, (CurrentSlot * MaxGPUScopesPerFrame + Scope) * 2);
+}
+
+void Profiler::EndGPUScope(RenderCommandList& CommandList)
+{
+	if (!HasGPUTimestamps() || OpenScopes.empty())
+		return;
+
+	const uint32_t Scope = OpenScopes.back();
+	OpenScopes.pop_back();
+
+	if (Scope != UINT32_MAX)
+		CommandList.WriteTimestamp(QueryHeap, (CurrentSlot * MaxGPUScopesPerFrame + Scope) * 2 + 1);
+}
+
+void Profiler::EndFrame(RenderCommandList& CommandList)
+{
+	if (!HasGPUTimestamps())
+		return;
+
+	// Scopes left open end with the frame
+	while (!OpenScopes.empty())
+		EndGPUScope(CommandList);
+
+	FrameSlot& Slot = Slots[CurrentSlot];
+
+	if (Slot.ScopeNames.empty())
+		return;
+
+	const uint32_t FirstQuery = CurrentSlot * MaxGPUScopesPerFrame * 2;
+	CommandList.ResolveTimestamps(QueryHeap, FirstQuery, static_cast<uint32_t>(Slot.ScopeNames.size()) * 2, ReadbackBuffer, FirstQuery * sizeof(uint64_t));
+	Slot.Resolved = true;
+}
+
+void Profiler::CollectSlot(FrameSlot& Slot, uint32_t SlotIndex)
+{
+	const uint64_t* Timestamps = static_cast<const uint64_t*>(Backend->MapBuffer(ReadbackBuffer)) + SlotIndex * MaxGPUScopesPerFrame * 2;
+
+	std::lock_guard<std::mutex> Lock(Mutex);
+
+	for (size_t i = 0; i < Slot.ScopeNames.size(); ++i)
+	{
+		const uint64_t Begin = Timestamps[i * 2];
+		const uint64_t End = Timestamps[i * 2 + 1];
+
+		// Queries that never executed, a removed device or a lost frame
+		if (End < Begin)
+			continue;
+
+		const double BeginMicroseconds = CalibrationMicroseconds + static_cast<int64_t>(Begin - CalibrationGPU) / TicksPerMicrosecond;
+		AddEvent({ Slot.ScopeNames[i], true, 0, Slot.Frame, BeginMicroseconds, (End - Begin) / TicksPerMicrosecond });
+	}
+
+	Slot.Resolved = false;
+}
+
+void Profiler::Flush()
+{
+	if (!HasGPUTimestamps())
+		return;
+
+	// Oldest frame first, so the events stay in frame order
+	std::vector<FrameSlot*> Resolved;
+
+	for (FrameSlot& Slot : Slots)
+		if (Slot.Resolved)
+			Resolved.push_back(&Slot);
+
+	std::sort(Resolved.begin(), Resolved.end(), [](const FrameSlot* a, const FrameSlot* b) { return a->Frame < b->Frame; });
+
+	for (FrameSlot* Slot : Resolved)
+		CollectSlot(*Slot, static_cast<uint32_t>(Slot - Slots));
+}
+
+std::vector<ProfileEvent> Profiler::GetEvents() const
+{
+	std::lock_guard<std::mutex> Lock(Mutex);
+	return Events;
+}
+
+void Profiler::PrintSummary() const
+{
+	struct Summary
+	{
+		uint64_t Count = 0;
+		double Total = 0.0;
+		double Longest = 0.0;
+	};
+
+	// GPU scopes after the CPU ones, each side by name
+	std::map<std::pair<bool, std::string>, Summary> Summaries;
+	uint64_t LastFrame = 0;
+
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+
+		for (const ProfileEvent& Event : Events)
+		{
+			Summary& Entry = Summaries[{ Event.GPU, Event.Name }];
+			++Entry.Count;
+			Entry.Total += Event.Duration;
+			Entry.Longest = std::max(Entry.Longest, Event.Duration);
+			LastFrame = std::max(LastFrame, Event.Frame);
+		}
+
+		printf("Profile: %llu frames, %zu events, %zu dropped%s\n", static_cast<unsigned long long>(LastFrame), Events.size(), DroppedCount,
+			HasGPUTimestamps() ? "" : ", no GPU timestamps");
+	}
+
+	for (const auto& [Key, Entry] : Summaries)
+		printf("  %s %-20s %6llu x %9.3f ms avg %9.3f ms max\n", Key.first ? "GPU" : "CPU", Key.second.c_str(), static_cast<unsigned long long>(Entry.Count),
+			Entry.Total / Entry.Count / 1000.0, Entry.Longest / 1000.0);
+}
+
+bool Profiler::WriteChromeTrace(const std::string& Path) const
+{
+	std::ofstream Stream(Path, std::ios::trunc);
+
+	// Process 1 holds a track per CPU thread, process 2 the GPU queue
+	Stream << "{\n\"displayTimeUnit\": \"ms\",\n\"traceEvents\": [\n"
+		"{ \"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": { \"name\": \"CPU\" } },\n"
+		"{ \"name\": \"process_name\", \"ph\": \"M\", \"pid\": 2, \"tid\": 0, \"args\": { \"name\": \"GPU\" } }";
+
+	char Line[512];
+
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+
+		for (const ProfileEvent& Event : Events)
+		{
+			// Scope names are ours, nothing in them needs escaping
+			snprintf(Line, sizeof(Line), ",\n{ \"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": %u, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f, \"args\": { \"frame\": %llu } }",
+				Event.Name, Event.GPU ? "gpu" : "cpu", Event.GPU ? 2u : 1u, Event.Thread, Event.Begin, Event.Duration, static_cast<unsigned long long>(Event.Frame));
+			Stream << Line;
+		}
+	}
+
+	Stream << "\n]\n}\n";
+	Stream.close();
+
+	if (Stream.fail())
+	{
+		printf("Profile: could not write %s\n", Path.c_str());
+		return false;
+	}
+
+	return true;
+}
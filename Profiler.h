@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RenderBackend.h"
+#include "FrameScheduler.h"
+
+struct ProfileEvent
+{
+	const char* Name;
+	bool GPU;
+	uint32_t Thread;   // 1 + the order CPU threads first reported in, 0 for the GPU
+	uint64_t Frame;    // backend frame number the event belongs to, 0 before the first frame
+	double Begin;      // microseconds since the profiler was created
+	double Duration;   // microseconds
+};
+
+// CPU scope timers from any thread and GPU timestamps around ranges of the frame's command list, on one timeline,
+// written out as a Chrome trace (chrome://tracing, Perfetto). GPU scopes need a backend with timestamps. Each frame
+// slot resolves its timestamps into its own part of a readback buffer, read when the slot comes around again and
+// the scheduler has already waited for it, so collecting them never stalls.
+class Profiler
+{
+public:
+	static constexpr uint32_t MaxGPUScopesPerFrame = 64;
+	// Events past this are dropped and counted
+	static constexpr size_t MaxEventCount = 4 * 1024 * 1024;
+
+	// Without a backend, or with one without timestamps, only the CPU is profiled
+	explicit Profiler(RenderBackend* Backend = nullptr);
+	~Profiler();
+
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	// Profiler ProfileScope reports to, nullptr for none
+	static void SetActive(Profiler* Active) { ActiveProfiler = Active; }
+	static Profiler* GetActive() { return ActiveProfiler; }
+
+	// Any thread
+	void AddCPUEvent(const char* Name, std::chrono::steady_clock::time_point Begin, std::chrono::steady_clock::time_point End);
+
+	// Frame thread, after RenderBackend::BeginFrame: collects the GPU scopes of the frame that last used this slot
+	void BeginFrame();
+	// Name must outlive the profiler. Scopes nest; past MaxGPUScopesPerFrame in a frame they are dropped.
+	void BeginGPUScope(RenderCommandList& CommandList, const char* Name);
+	void EndGPUScope(RenderCommandList& CommandList);
+	// Before the frame's command list is submitted: copies its timestamps to the slot's readback range
+	void EndFrame(RenderCommandList& CommandList);
+	// Collects the frames still in their slots, after RenderBackend::WaitIdle
+	void Flush();
+
+	bool HasGPUTimestamps() const { return QueryHeap != RenderNullHandle; }
+	size_t GetDroppedCount() const { return DroppedCount; }
+	std::vector<ProfileEvent> GetEvents() const;
+
+	// Average and longest duration of every scope name, GPU and CPU apart
+	void PrintSummary() const;
+	bool WriteChromeTrace(const std::string& Path) const;
+
+private:
+	// Scope i of a slot has queries 2 * i and 2 * i + 1 in the slot's range
+	struct FrameSlot
+	{
+		uint64_t Frame = 0;
+		std::vector<const char*> ScopeNames;
+		bool Resolved = false;
+	};
+
+	void AddEvent(const ProfileEvent& Event);
+	void CollectSlot(FrameSlot& Slot, uint32_t SlotIndex);
+	double ToMicroseconds(std::chrono::steady_clock::time_point Time) const;
+	uint32_t GetThreadIndex(std::thread::id Thread);
+
+	static inline std::atomic<Profiler*> ActiveProfiler = nullptr;
+
+	RenderBackend* Backend;
+	std::chrono::steady_clock::time_point Epoch;
+	std::atomic<uint64_t> CurrentFrame = 0;
+
+	// Each slot has MaxGPUScopesPerFrame * 2 queries, and readback room for them
+	RenderQueryHeap QueryHeap = RenderNullHandle;
+	RenderResource ReadbackBuffer = RenderNullHandle;
+	double TicksPerMicrosecond = 1.0;
+	uint64_t CalibrationGPU = 0;
+	double CalibrationMicroseconds = 0.0;
+	FrameSlot Slots[FrameScheduler::MaxFramesInFlight];
+	uint32_t CurrentSlot = 0;
+	std::vector<uint32_t> OpenScopes;
+
+	mutable std::mutex Mutex;
+	std::vector<ProfileEvent> Events;
+	std::vector<std::thread::id> Threads;
+	size_t DroppedCount = 0;
+};
+
+// Times its own lifetime on the calling thread into the active profiler, nothing when there is none
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* Name) : Name(Name), Target(Profiler::GetActive())
+	{
+		if (Target)
+			Begin = std::chrono::steady_clock::now();
+	}
+
+	~ProfileScope()
+	{
+		if (Target)
+			Target->AddCPUEvent(Name, Begin, std::chrono::steady_clock::now());
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* Name;
+	Profiler* Target;
+	std::chrono::steady_clock::time_point Begin;
+};
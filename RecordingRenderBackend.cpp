@@ -0,0 +1,931 @@
+#include "RecordingRenderBackend.h"
+#include "CPUResolve.h"
+#include "HiZShaders.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+void RecordingRenderCommandList::ResourceBarrier(uint32_t Count, const RenderBarrier* Barriers)
+{
+	RenderResourceBarrierCommand* Command = Arena.Allocate<RenderResourceBarrierCommand>(RENDER_COMMAND_RESOURCE_BARRIER, Count * sizeof(RenderBarrier));
+	Command->Count = Count;
+	memcpy(Command + 1, Barriers, Count * sizeof(RenderBarrier));
+}
+
+void RecordingRenderCommandList::DiscardResource(RenderResource Resource)
+{
+	Arena.Allocate<RenderDiscardResourceCommand>(RENDER_COMMAND_DISCARD_RESOURCE)->Resource = Resource;
+}
+
+void RecordingRenderCommandList::ClearDepthStencil(RenderResource DepthTarget, float Depth, uint8_t Stencil)
+{
+	RenderClearDepthStencilCommand* Command = Arena.Allocate<RenderClearDepthStencilCommand>(RENDER_COMMAND_CLEAR_DEPTH_STENCIL);
+	Command->DepthTarget = DepthTarget;
+	Command->Depth = Depth;
+	Command->Stencil = Stencil;
+}
+
+void RecordingRenderCommandList::SetRenderTargets(RenderResource RenderTarget, RenderResource DepthTarget)
+{
+	RenderSetRenderTargetsCommand* Command = Arena.Allocate<RenderSetRenderTargetsCommand>(RENDER_COMMAND_SET_RENDER_TARGETS);
+	Command->RenderTarget = RenderTarget;
+	Command->DepthTarget = DepthTarget;
+}
+
+void RecordingRenderCommandList::SetViewport(uint32_t Width, uint32_t Height)
+{
+	RenderSetViewportCommand* Command = Arena.Allocate<RenderSetViewportCommand>(RENDER_COMMAND_SET_VIEWPORT);
+	Command->Width = Width;
+	Command->Height = Height;
+}
+
+void RecordingRenderCommandList::SetPipeline(RenderPipeline Pipeline)
+{
+	Arena.Allocate<RenderSetPipelineCommand>(RENDER_COMMAND_SET_PIPELINE)->Pipeline = Pipeline;
+}
+
+void RecordingRenderCommandList::SetDescriptorTable(uint32_t RootParameter, RenderView FirstView)
+{
+	RenderSetDescriptorTableCommand* Command = Arena.Allocate<RenderSetDescriptorTableCommand>(RENDER_COMMAND_SET_DESCRIPTOR_TABLE);
+	Command->RootParameter = RootParameter;
+	Command->FirstView = FirstView;
+}
+
+void RecordingRenderCommandList::SetRootConstants(uint32_t RootParameter, uint32_t Count, const void* Data)
+{
+	RenderSetRootConstantsCommand* Command = Arena.Allocate<RenderSetRootConstantsCommand>(RENDER_COMMAND_SET_ROOT_CONSTANTS, Count * sizeof(uint32_t));
+	Command->RootParameter = RootParameter;
+	Command->Count = Count;
+	memcpy(Command + 1, Data, Count * sizeof(uint32_t));
+}
+
+void RecordingRenderCommandList::SetRootConstantBuffer(uint32_t RootParameter, RenderResource Buffer, uint64_t Offset)
+{
+	RenderSetRootConstantBufferCommand* Command = Arena.Allocate<RenderSetRootConstantBufferCommand>(RENDER_COMMAND_SET_ROOT_CONSTANT_BUFFER);
+	Command->RootParameter = RootParameter;
+	Command->Buffer = Buffer;
+	Command->Offset = Offset;
+}
+
+void RecordingRenderCommandList::SetPrimitiveTopology(RenderPrimitiveTopology Topology)
+{
+	Arena.Allocate<RenderSetPrimitiveTopologyCommand>(RENDER_COMMAND_SET_PRIMITIVE_TOPOLOGY)->Topology = Topology;
+}
+
+void RecordingRenderCommandList::SetVertexBuffer(RenderResource Buffer, uint32_t Size, uint32_t Stride)
+{
+	RenderSetVertexBufferCommand* Command = Arena.Allocate<RenderSetVertexBufferCommand>(RENDER_COMMAND_SET_VERTEX_BUFFER);
+	Command->Buffer = Buffer;
+	Command->Size = Size;
+	Command->Stride = Stride;
+}
+
+void RecordingRenderCommandList::SetIndexBuffer(RenderResource Buffer, uint32_t Size, RenderFormat Format)
+{
+	RenderSetIndexBufferCommand* Command = Arena.Allocate<RenderSetIndexBufferCommand>(RENDER_COMMAND_SET_INDEX_BUFFER);
+	Command->Buffer = Buffer;
+	Command->Size = Size;
+	Command->Format = Format;
+}
+
+void RecordingRenderCommandList::Draw(uint32_t VertexCount, uint32_t InstanceCount)
+{
+	RenderDrawCommand* Command = Arena.Allocate<RenderDrawCommand>(RENDER_COMMAND_DRAW);
+	Command->VertexCount = VertexCount;
+	Command->InstanceCount = InstanceCount;
+}
+
+void RecordingRenderCommandList::DrawIndexed(uint32_t IndexCount, uint32_t InstanceCount)
+{
+	RenderDrawIndexedCommand* Command = Arena.Allocate<RenderDrawIndexedCommand>(RENDER_COMMAND_DRAW_INDEXED);
+	Command->IndexCount = IndexCount;
+	Command->InstanceCount = InstanceCount;
+}
+
+void RecordingRenderCommandList::Dispatch(uint32_t GroupsX, uint32_t GroupsY, uint32_t GroupsZ)
+{
+	RenderDispatchCommand* Command = Arena.Allocate<RenderDispatchCommand>(RENDER_COMMAND_DISPATCH);
+	Command->GroupsX = GroupsX;
+	Command->GroupsY = GroupsY;
+	Command->GroupsZ = GroupsZ;
+}
+
+void RecordingRenderCommandList::ResolveSubresourceRegion(RenderResource Destination, uint32_t DstX, uint32_t DstY, RenderResource Source, const RenderRect* SourceRect, RenderFormat Format, RenderResolveMode Mode)
+{
+	RenderResolveSubresourceRegionCommand* Command = Arena.Allocate<RenderResolveSubresourceRegionCommand>(RENDER_COMMAND_RESOLVE_SUBRESOURCE_REGION);
+	Command->Destination = Destination;
+	Command->DstX = DstX;
+	Command->DstY = DstY;
+	Command->Source = Source;
+	Command->HasSourceRect = SourceRect != nullptr;
+	Command->SourceRect = SourceRect ? *SourceRect : RenderRect{};
+	Command->Format = Format;
+	Command->Mode = Mode;
+}
+
+void RecordingRenderCommandList::WriteTimestamp(RenderQueryHeap Heap, uint32_t Index)
+{
+	RenderWriteTimestampCommand* Command = Arena.Allocate<RenderWriteTimestampCommand>(RENDER_COMMAND_WRITE_TIMESTAMP);
+	Command->Heap = Heap;
+	Command->Index = Index;
+}
+
+void RecordingRenderCommandList::ResolveTimestamps(RenderQueryHeap Heap, uint32_t FirstIndex, uint32_t Count, RenderResource Destination, uint64_t Offset)
+{
+	RenderResolveTimestampsCommand* Command = Arena.Allocate<RenderResolveTimestampsCommand>(RENDER_COMMAND_RESOLVE_TIMESTAMPS);
+	Command->Heap = Heap;
+	Command->FirstIndex = FirstIndex;
+	Command->Count = Count;
+	Command->Destination = Destination;
+	Command->Offset = Offset;
+}
+
+RecordingRenderBackend::RecordingRenderBackend(uint32_t Width, uint32_t Height, bool Execute, CPUThreadPool* Pool)
+	: Width(Width), Height(Height), Execute(Execute), Pool(Pool), Rasterizer(Pool), Scheduler(Fence, FrameScheduler::MinFramesInFlight), CommandList(Arena)
+{
+	RenderTextureDesc BackBufferDesc;
+	BackBufferDesc.Width = Width;
+	BackBufferDesc.Height = Height;
+	BackBufferDesc.Format = RENDER_FORMAT_R8G8B8A8_UNORM;
+	BackBufferDesc.Flags = RENDER_RESOURCE_FLAG_ALLOW_RENDER_TARGET | RENDER_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+	BackBufferDesc.InitialState = RENDER_RESOURCE_STATE_PRESENT;
+	BackBufferDesc.Name = "BackBuffer";
+
+	BackBuffers[0] = CreateTexture(BackBufferDesc);
+	BackBuffers[1] = CreateTexture(BackBufferDesc);
+}
+
+void RecordingRenderBackend::ResizeSwapChain(uint32_t NewWidth, uint32_t NewHeight)
+{
+	Width = NewWidth;
+	Height = NewHeight;
+
+	for (RenderResource BackBuffer : BackBuffers)
+	{
+		Resource& Texture = Resources[BackBuffer - 1];
+		Texture.TextureDesc.Width = Width;
+		Texture.TextureDesc.Height = Height;
+
+		if (Execute)
+			Texture.Color.assign(static_cast<size_t>(Width) * Height, 0);
+	}
+}
+
+// CPU layout of a depth-stencil format, D32_FLOAT_S8X24_UINT for any other
+static CPUDepthFormat GetCPUDepthFormat(RenderFormat Format)
+{
+	switch (Format)
+	{
+		case RENDER_FORMAT_D32_FLOAT:
+			return CPU_DEPTH_FORMAT_D32_FLOAT;
+		case RENDER_FORMAT_D24_UNORM_S8_UINT:
+			return CPU_DEPTH_FORMAT_D24_UNORM_S8_UINT;
+		case RENDER_FORMAT_D16_UNORM:
+			return CPU_DEPTH_FORMAT_D16_UNORM;
+		default:
+			return CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT;
+	}
+}
+
+RenderResource RecordingRenderBackend::CreateTexture(const RenderTextureDesc& Desc)
+{
+	Resource Texture{};
+	Texture.Buffer = false;
+	Texture.TextureDesc = Desc;
+
+	if (Execute)
+	{
+		if (Desc.Format == RENDER_FORMAT_R8G8B8A8_UNORM || Desc.Format == RENDER_FORMAT_R8G8B8A8_UNORM_SRGB)
+		{
+			Texture.Color.resize(static_cast<size_t>(Desc.Width) * Desc.Height);
+		}
+		else if (Desc.SampleCount > 1)
+		{
+			Texture.DepthSurface.Allocate(Desc.Width, Desc.Height, Desc.SampleCount, GetCPUDepthFormat(Desc.Format));
+
+			if (TrackUniformPixels)
+				Texture.DepthSurface.TrackUniformPixels();
+
+			Texture.DepthSurface.Clear(Desc.ClearDepth, Desc.ClearStencil);
+
+			if (CompressDepth && Texture.DepthSurface.Format == CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT)
+			{
+				Texture.CompressedDepth.Allocate(Desc.Width, Desc.Height, Desc.SampleCount, Rasterizer.GetSamplePattern(Desc.SampleCount));
+				Texture.CompressedDepth.Clear(Desc.ClearDepth, Desc.ClearStencil);
+			}
+		}
+		else
+		{
+			Texture.ResolvedDepth.Allocate(Desc.Width, Desc.Height);
+
+			if (const RenderDepthFormatInfo* DepthFormat = GetRenderDepthFormatInfo(Desc.Format); DepthFormat && DepthFormat->StencilPlaneFormat != RENDER_FORMAT_UNKNOWN)
+				Texture.ResolvedStencil.Allocate(Desc.Width, Desc.Height);
+		}
+	}
+
+	Resources.push_back(std::move(Texture));
+	return static_cast<RenderResource>(Resources.size());
+}
+
+RenderResource RecordingRenderBackend::CreateBuffer(const RenderBufferDesc& Desc)
+{
+	Resource Buffer{};
+	Buffer.Buffer = true;
+	Buffer.BufferDesc = Desc;
+
+	// Recording alone still keeps upload data so the commands can be inspected against it
+	if (Execute || Desc.HeapType == RENDER_HEAP_TYPE_UPLOAD || Desc.HeapType == RENDER_HEAP_TYPE_READBACK)
+		Buffer.Data.resize(Desc.Size);
+
+	Resources.push_back(std::move(Buffer));
+	return static_cast<RenderResource>(Resources.size());
+}
+
+void RecordingRenderBackend::WriteBuffer(RenderResource Buffer, uint64_t Offset, const void* Data, size_t Size)
+{
+	memcpy(Resources[Buffer - 1].Data.data() + Offset, Data, Size);
+}
+
+void* RecordingRenderBackend::MapBuffer(RenderResource Buffer)
+{
+	return Resources[Buffer - 1].Data.data();
+}
+
+static uint32_t GetFormatSize(RenderFormat Format)
+{
+	switch (Format)
+	{
+		case RENDER_FORMAT_R32G32B32_FLOAT:
+			return 12;
+		case RENDER_FORMAT_D32_FLOAT_S8X24_UINT:
+		case RENDER_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+			return 8;
+		case RENDER_FORMAT_R16_UINT:
+		case RENDER_FORMAT_D16_UNORM:
+		case RENDER_FORMAT_R16_UNORM:
+			return 2;
+		default:
+			return 4;
+	}
+}
+
+static RenderHeapKind GetTextureHeapKind(const RenderTextureDesc& Desc)
+{
+	return (Desc.Flags & (RENDER_RESOURCE_FLAG_ALLOW_RENDER_TARGET | RENDER_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) ? RENDER_HEAP_KIND_TARGET_TEXTURES : RENDER_HEAP_KIND_OTHER_TEXTURES;
+}
+
+RenderAllocationInfo RecordingRenderBackend::GetTextureAllocationInfo(const RenderTextureDesc& Desc)
+{
+	const uint64_t Alignment = Desc.SampleCount > 1 ? 4 * 1024 * 1024 : 64 * 1024;
+	const uint64_t Size = static_cast<uint64_t>(Desc.Width) * Desc.Height * Desc.SampleCount * GetFormatSize(Desc.Format);
+
+	return { (Size + Alignment - 1) & ~(Alignment - 1), Alignment };
+}
+
+RenderAllocationInfo RecordingRenderBackend::GetBufferAllocationInfo(const RenderBufferDesc& Desc)
+{
+	const uint64_t Alignment = 64 * 1024;
+
+	return { (Desc.Size + Alignment - 1) & ~(Alignment - 1), Alignment };
+}
+
+RenderHeap RecordingRenderBackend::CreateHeap(RenderHeapKind Kind, uint64_t Size, uint64_t Alignment)
+{
+	Heaps.push_back({ Kind, Size, Alignment });
+	return static_cast<RenderHeap>(Heaps.size());
+}
+
+bool RecordingRenderBackend::IsPlacementValid(RenderHeap Heap, uint64_t Offset, RenderHeapKind Kind, const RenderAllocationInfo& Info) const
+{
+	if (Heap == RenderNullHandle || Heap > Heaps.size())
+		return false;
+
+	const RecordingRenderBackend::Heap& Placement = Heaps[Heap - 1];
+
+	return !Placement.Released && Placement.Kind == Kind && Info.Alignment <= Placement.Alignment && Offset % Info.Alignment == 0 && Offset + Info.Size <= Placement.Size;
+}
+
+RenderResource RecordingRenderBackend::CreatePlacedTexture(RenderHeap Heap, uint64_t Offset, const RenderTextureDesc& Desc)
+{
+	if (!IsPlacementValid(Heap, Offset, GetTextureHeapKind(Desc), GetTextureAllocationInfo(Desc)))
+		return RenderNullHandle;
+
+	return CreateTexture(Desc);
+}
+
+RenderResource RecordingRenderBackend::CreatePlacedBuffer(RenderHeap Heap, uint64_t Offset, const RenderBufferDesc& Desc)
+{
+	if (Desc.HeapType != RENDER_HEAP_TYPE_DEFAULT || !IsPlacementValid(Heap, Offset, RENDER_HEAP_KIND_BUFFERS, GetBufferAllocationInfo(Desc)))
+		return RenderNullHandle;
+
+	return CreateBuffer(Desc);
+}
+
+void RecordingRenderBackend::ReleaseResource(RenderResource Resource)
+{
+	ReleasedResources.push_back(Resource);
+}
+
+void RecordingRenderBackend::ReleaseHeap(RenderHeap Heap)
+{
+	Heaps[Heap - 1].Released = true;
+}
+
+uint64_t RecordingRenderBackend::GetHeapSize() const
+{
+	uint64_t Size = 0;
+
+	for (const Heap& Current : Heaps)
+	{
+		if (!Current.Released)
+			Size += Current.Size;
+	}
+
+	return Size;
+}
+
+RenderView RecordingRenderBackend::AddView(const View& NewView)
+{
+	const uint32_t Index = ViewIndices.Allocate();
+
+	if (Index == DescriptorFreeList::InvalidIndex)
+		return RenderNullHandle;
+
+	if (Index == Views.size())
+		Views.push_back(NewView);
+	else
+		Views[Index] = NewView;
+
+	return Index + 1;
+}
+
+RenderView RecordingRenderBackend::CreateConstantBufferView(RenderResource Buffer, uint32_t)
+{
+	return AddView({ RENDER_DESCRIPTOR_TYPE_CBV, Buffer, RENDER_FORMAT_UNKNOWN });
+}
+
+RenderView RecordingRenderBackend::CreateShaderResourceView(RenderResource Resource, RenderFormat Format)
+{
+	return AddView({ RENDER_DESCRIPTOR_TYPE_SRV, Resource, Format });
+}
+
+RenderView RecordingRenderBackend::CreateUnorderedAccessView(RenderResource Resource, RenderFormat Format)
+{
+	return AddView({ RENDER_DESCRIPTOR_TYPE_UAV, Resource, Format });
+}
+
+void RecordingRenderBackend::UpdateShaderResourceView(RenderView View, RenderResource Resource, RenderFormat Format)
+{
+	Views[View - 1] = { RENDER_DESCRIPTOR_TYPE_SRV, Resource, Format };
+}
+
+void RecordingRenderBackend::UpdateUnorderedAccessView(RenderView View, RenderResource Resource, RenderFormat Format)
+{
+	Views[View - 1] = { RENDER_DESCRIPTOR_TYPE_UAV, Resource, Format };
+}
+
+void RecordingRenderBackend::ReleaseView(RenderView View)
+{
+	ReleasedViews.push_back(View);
+}
+
+RenderRootSignature RecordingRenderBackend::CreateRootSignature(const RenderRootSignatureDesc&)
+{
+	return ++RootSignatureCount;
+}
+
+RenderPipeline RecordingRenderBackend::CreateGraphicsPipeline(const RenderGraphicsPipelineDesc& Desc)
+{
+	Pipelines.push_back({ false, Desc, RenderComputePipelineDesc() });
+	return static_cast<RenderPipeline>(Pipelines.size());
+}
+
+RenderPipeline RecordingRenderBackend::CreateComputePipeline(const RenderComputePipelineDesc& Desc)
+{
+	Pipelines.push_back({ true, RenderGraphicsPipelineDesc(), Desc });
+	return static_cast<RenderPipeline>(Pipelines.size());
+}
+
+RenderQueryHeap RecordingRenderBackend::CreateTimestampQueryHeap(uint32_t Count)
+{
+	QueryHeaps.emplace_back(Count, 0);
+	return static_cast<RenderQueryHeap>(QueryHeaps.size());
+}
+
+static uint64_t GetSteadyClockNanoseconds()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool RecordingRenderBackend::GetTimestampCalibration(uint64_t& GPUTimestamp, uint64_t& CPUNanoseconds)
+{
+	GPUTimestamp = CPUNanoseconds = GetSteadyClockNanoseconds();
+	return Execute;
+}
+
+RenderCommandList* RecordingRenderBackend::BeginFrame()
+{
+	Scheduler.BeginFrame();
+	Arena.Reset();
+	return &CommandList;
+}
+
+void RecordingRenderBackend::EndFrame()
+{
+	Stats = RecordingRenderStats();
+
+	{
+		// Replaying the frame is its submission and execution at once
+		ProfileScope Scope("Submit");
+
+		ExecutionState State;
+		Arena.ForEach([&](const RenderCommandHeader& Command) { ProcessCommand(Command, State); });
+	}
+
+	Scheduler.EndFrame();
+
+	for (uint32_t ListIndex : SubmittedLists)
+		SecondaryLists.Release(ListIndex, Scheduler.GetFrameNumber());
+
+	SubmittedLists.clear();
+	Fence.CompleteAll();
+
+	for (RenderView View : ReleasedViews)
+		ViewIndices.Free(View - 1);
+
+	ReleasedViews.clear();
+
+	for (RenderResource Released : ReleasedResources)
+	{
+		Resource& Freed = Resources[Released - 1];
+		Freed = Resource{ Freed.Buffer, Freed.TextureDesc, Freed.BufferDesc, {}, {}, {}, {}, {}, {} };
+	}
+
+	ReleasedResources.clear();
+
+	CurrentBackBufferIndex = (CurrentBackBufferIndex + 1) % 2;
+}
+
+RenderCommandList* RecordingRenderBackend::AcquireCommandList()
+{
+	const uint32_t ListIndex = SecondaryLists.Acquire(Fence.GetCompletedValue());
+
+	if (ListIndex == SecondaryLists.InvalidIndex)
+		return nullptr;
+
+	SecondaryLists[ListIndex].Arena.Reset();
+	return &SecondaryLists[ListIndex].CommandList;
+}
+
+void RecordingRenderBackend::SubmitCommandLists(uint32_t Count, RenderCommandList* const* Lists)
+{
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		for (uint32_t ListIndex = 0; ListIndex < RenderMaxAcquiredCommandLists; ++ListIndex)
+		{
+			if (Lists[i] != &SecondaryLists[ListIndex].CommandList)
+				continue;
+
+			Arena.Allocate<RenderExecuteCommandListCommand>(RENDER_COMMAND_EXECUTE_COMMAND_LIST)->ListIndex = ListIndex;
+			SubmittedLists.push_back(ListIndex);
+			break;
+		}
+	}
+}
+
+void RecordingRenderBackend::ProcessCommand(const RenderCommandHeader& Command, ExecutionState& State)
+{
+	if (Command.Type == RENDER_COMMAND_EXECUTE_COMMAND_LIST)
+	{
+		// Lists start with nothing set, and so does the frame's list after them
+		const RenderCommandArena& ListArena = SecondaryLists[reinterpret_cast<const RenderExecuteCommandListCommand&>(Command).ListIndex].Arena;
+		ExecutionState ListState;
+
+		ListArena.ForEach([&](const RenderCommandHeader& ListCommand) { ProcessCommand(ListCommand, ListState); });
+
+		State = ExecutionState();
+		++Stats.SubmittedListCount;
+		return;
+	}
+
+	++Stats.CommandCount;
+	Stats.CommandBytes += Command.Size;
+
+	switch (Command.Type)
+	{
+		case RENDER_COMMAND_RESOURCE_BARRIER:
+			++Stats.BarrierCallCount;
+			Stats.BarrierCount += reinterpret_cast<const RenderResourceBarrierCommand&>(Command).Count;
+			break;
+		case RENDER_COMMAND_DRAW:
+		case RENDER_COMMAND_DRAW_INDEXED:
+			++Stats.DrawCount;
+			break;
+		case RENDER_COMMAND_DISPATCH:
+			++Stats.DispatchCount;
+			break;
+		case RENDER_COMMAND_RESOLVE_SUBRESOURCE_REGION:
+			++Stats.ResolveCount;
+			break;
+		default:
+			break;
+	}
+
+	if (Execute)
+		ExecuteCommand(Command, State);
+}
+
+const RecordingRenderBackend::View* RecordingRenderBackend::FindBoundView(const ExecutionState& State, RenderDescriptorType Type) const
+{
+	for (RenderView Table : State.DescriptorTables)
+	{
+		if (Table != RenderNullHandle && Views[Table - 1].Type == Type)
+			return &Views[Table - 1];
+	}
+
+	return nullptr;
+}
+
+static CPUResolveMode GetCPUResolveMode(RenderResolveMode Mode)
+{
+	return Mode == RENDER_RESOLVE_MODE_MIN ? CPU_RESOLVE_MODE_MIN : (Mode == RENDER_RESOLVE_MODE_MAX ? CPU_RESOLVE_MODE_MAX : CPU_RESOLVE_MODE_AVERAGE);
+}
+
+void RecordingRenderBackend::ExecuteCommand(const RenderCommandHeader& Command, ExecutionState& State)
+{
+	switch (Command.Type)
+	{
+		case RENDER_COMMAND_CLEAR_DEPTH_STENCIL:
+		{
+			const RenderClearDepthStencilCommand& Clear = reinterpret_cast<const RenderClearDepthStencilCommand&>(Command);
+			Resource& Target = Resources[Clear.DepthTarget - 1];
+
+			if (Target.TextureDesc.SampleCount > 1)
+			{
+				Target.DepthSurface.Clear(Clear.Depth, Clear.Stencil);
+
+				if (Target.CompressedDepth.Width != 0)
+					Target.CompressedDepth.Clear(Clear.Depth, Clear.Stencil);
+			}
+			else
+			{
+				std::fill(Target.ResolvedDepth.Depth.begin(), Target.ResolvedDepth.Depth.end(), CPUQuantizeDepth(GetCPUDepthFormat(Target.TextureDesc.Format), Clear.Depth));
+				std::fill(Target.ResolvedStencil.Stencil.begin(), Target.ResolvedStencil.Stencil.end(), Clear.Stencil);
+			}
+
+			break;
+		}
+		case RENDER_COMMAND_SET_RENDER_TARGETS:
+		{
+			const RenderSetRenderTargetsCommand& SetRenderTargets = reinterpret_cast<const RenderSetRenderTargetsCommand&>(Command);
+			State.RenderTarget = SetRenderTargets.RenderTarget;
+			State.DepthTarget = SetRenderTargets.DepthTarget;
+			break;
+		}
+		case RENDER_COMMAND_SET_PIPELINE:
+		{
+			const RenderPipeline Pipeline = reinterpret_cast<const RenderSetPipelineCommand&>(Command).Pipeline;
+
+			// Tables and root constant buffers belong to the root signature of the other pipeline kind
+			if (State.Pipeline != RenderNullHandle && Pipelines[State.Pipeline - 1].Compute != Pipelines[Pipeline - 1].Compute)
+			{
+				std::fill(std::begin(State.DescriptorTables), std::end(State.DescriptorTables), RenderNullHandle);
+				std::fill(std::begin(State.RootConstantBuffers), std::end(State.RootConstantBuffers), RenderNullHandle);
+				std::fill(std::begin(State.RootConstants), std::end(State.RootConstants), nullptr);
+			}
+
+			State.Pipeline = Pipeline;
+			break;
+		}
+		case RENDER_COMMAND_SET_DESCRIPTOR_TABLE:
+		{
+			const RenderSetDescriptorTableCommand& SetTable = reinterpret_cast<const RenderSetDescriptorTableCommand&>(Command);
+
+			if (SetTable.RootParameter < ExecutionState::MaxRootParameters)
+				State.DescriptorTables[SetTable.RootParameter] = SetTable.FirstView;
+
+			break;
+		}
+		case RENDER_COMMAND_SET_ROOT_CONSTANTS:
+		{
+			const RenderSetRootConstantsCommand& SetConstants = reinterpret_cast<const RenderSetRootConstantsCommand&>(Command);
+
+			// The packet outlives the replay of the list it is in
+			if (SetConstants.RootParameter < ExecutionState::MaxRootParameters && SetConstants.Count > 0)
+				State.RootConstants[SetConstants.RootParameter] = SetConstants.GetConstants();
+
+			break;
+		}
+		case RENDER_COMMAND_SET_ROOT_CONSTANT_BUFFER:
+		{
+			const RenderSetRootConstantBufferCommand& SetBuffer = reinterpret_cast<const RenderSetRootConstantBufferCommand&>(Command);
+
+			if (SetBuffer.RootParameter < ExecutionState::MaxRootParameters)
+			{
+				State.RootConstantBuffers[SetBuffer.RootParameter] = SetBuffer.Buffer;
+				State.RootConstantBufferOffsets[SetBuffer.RootParameter] = SetBuffer.Offset;
+			}
+
+			break;
+		}
+		case RENDER_COMMAND_SET_VERTEX_BUFFER:
+		{
+			const RenderSetVertexBufferCommand& SetVertexBuffer = reinterpret_cast<const RenderSetVertexBufferCommand&>(Command);
+			State.VertexBuffer = SetVertexBuffer.Buffer;
+			State.VertexBufferSize = SetVertexBuffer.Size;
+			State.VertexStride = SetVertexBuffer.Stride;
+			break;
+		}
+		case RENDER_COMMAND_SET_INDEX_BUFFER:
+		{
+			const RenderSetIndexBufferCommand& SetIndexBuffer = reinterpret_cast<const RenderSetIndexBufferCommand&>(Command);
+			State.IndexBuffer = SetIndexBuffer.Buffer;
+			State.IndexBufferSize = SetIndexBuffer.Size;
+			break;
+		}
+		case RENDER_COMMAND_DRAW:
+			ExecuteDraw(reinterpret_cast<const RenderDrawCommand&>(Command), State);
+			break;
+		case RENDER_COMMAND_DRAW_INDEXED:
+			ExecuteDrawIndexed(reinterpret_cast<const RenderDrawIndexedCommand&>(Command), State);
+			break;
+		case RENDER_COMMAND_DISPATCH:
+			ExecuteDispatch(reinterpret_cast<const RenderDispatchCommand&>(Command), State);
+			break;
+		case RENDER_COMMAND_RESOLVE_SUBRESOURCE_REGION:
+		{
+			const RenderResolveSubresourceRegionCommand& Resolve = reinterpret_cast<const RenderResolveSubresourceRegionCommand&>(Command);
+
+			if (Resolve.Mode == RENDER_RESOLVE_MODE_DECOMPRESS)
+			{
+				++Stats.SkippedCount;
+				break;
+			}
+
+			const CPUResolveMode Mode = GetCPUResolveMode(Resolve.Mode);
+			const CPURect SourceRect = { Resolve.SourceRect.Left, Resolve.SourceRect.Top, Resolve.SourceRect.Right, Resolve.SourceRect.Bottom };
+
+			if (GetRenderFormatPlaneSlice(Resolve.Format) == 1)
+				CPUResolveStencilRegion(Resources[Resolve.Destination - 1].ResolvedStencil, Resolve.DstX, Resolve.DstY, Resources[Resolve.Source - 1].DepthSurface, Resolve.HasSourceRect ? &SourceRect : nullptr, Mode, Pool);
+			else
+				CPUResolveDepthRegion(Resources[Resolve.Destination - 1].ResolvedDepth, Resolve.DstX, Resolve.DstY, Resources[Resolve.Source - 1].DepthSurface, Resolve.HasSourceRect ? &SourceRect : nullptr, Mode, Pool);
+
+			break;
+		}
+		case RENDER_COMMAND_WRITE_TIMESTAMP:
+		{
+			const RenderWriteTimestampCommand& Write = reinterpret_cast<const RenderWriteTimestampCommand&>(Command);
+			std::vector<uint64_t>& Queries = QueryHeaps[Write.Heap - 1];
+
+			if (Write.Index < Queries.size())
+				Queries[Write.Index] = GetSteadyClockNanoseconds();
+
+			break;
+		}
+		case RENDER_COMMAND_RESOLVE_TIMESTAMPS:
+		{
+			const RenderResolveTimestampsCommand& Resolve = reinterpret_cast<const RenderResolveTimestampsCommand&>(Command);
+			const std::vector<uint64_t>& Queries = QueryHeaps[Resolve.Heap - 1];
+			std::vector<uint8_t>& Data = Resources[Resolve.Destination - 1].Data;
+
+			if (static_cast<uint64_t>(Resolve.FirstIndex) + Resolve.Count <= Queries.size() && Resolve.Offset + Resolve.Count * sizeof(uint64_t) <= Data.size())
+				memcpy(Data.data() + Resolve.Offset, Queries.data() + Resolve.FirstIndex, Resolve.Count * sizeof(uint64_t));
+
+			break;
+		}
+		default:
+			// Barriers, discards (contents stay whatever they were), viewport (always the whole target here), topology and
+			// root constants do not change the CPU result
+			break;
+	}
+}
+
+void RecordingRenderBackend::ExecuteDrawIndexed(const RenderDrawIndexedCommand& Command, const ExecutionState& State)
+{
+	const RenderGraphicsPipelineDesc& PipelineDesc = Pipelines[State.Pipeline - 1].GraphicsDesc;
+	const View* ConstantBufferView = FindBoundView(State, RENDER_DESCRIPTOR_TYPE_CBV);
+	const uint8_t* Constants = nullptr;
+
+	// The vertex shader's cbuffer comes from a root constant buffer if one is set, else from the first CBV in the tables
+	for (uint32_t i = 0; i < ExecutionState::MaxRootParameters && !Constants; ++i)
+	{
+		if (State.RootConstantBuffers[i] != RenderNullHandle)
+			Constants = Resources[State.RootConstantBuffers[i] - 1].Data.data() + State.RootConstantBufferOffsets[i];
+	}
+
+	if (!Constants && ConstantBufferView)
+		Constants = Resources[ConstantBufferView->Resource - 1].Data.data();
+
+	if (!PipelineDesc.DepthEnable || !PipelineDesc.PositionInput || State.DepthTarget == RenderNullHandle || State.VertexBuffer == RenderNullHandle || State.IndexBuffer == RenderNullHandle || !Constants)
+	{
+		++Stats.SkippedCount;
+		return;
+	}
+
+	CPUDrawIndexedDesc Draw;
+	Draw.Vertices = reinterpret_cast<const CPUFloat3*>(Resources[State.VertexBuffer - 1].Data.data());
+	Draw.VertexCount = State.VertexBufferSize / State.VertexStride;
+	Draw.Indices = reinterpret_cast<const uint16_t*>(Resources[State.IndexBuffer - 1].Data.data());
+	Draw.IndexCount = std::min<uint32_t>(Command.IndexCount, State.IndexBufferSize / sizeof(uint16_t));
+	Draw.CullMode = PipelineDesc.CullMode == RENDER_CULL_MODE_NONE ? CPU_CULL_MODE_NONE : (PipelineDesc.CullMode == RENDER_CULL_MODE_FRONT ? CPU_CULL_MODE_FRONT : CPU_CULL_MODE_BACK);
+
+	// The vertex shader's cbuffer starts with the row-major transform matrix, a structured buffer of row-major
+	// matrices bound to it holds the transforms applied before it, one per instance
+	memcpy(&Draw.TransformMatrix, Constants, sizeof(CPUMatrix));
+	Draw.InstanceCount = Command.InstanceCount;
+
+	for (RenderView Table : State.DescriptorTables)
+	{
+		if (Table == RenderNullHandle || Views[Table - 1].Type != RENDER_DESCRIPTOR_TYPE_SRV)
+			continue;
+
+		const Resource& Instances = Resources[Views[Table - 1].Resource - 1];
+
+		if (Instances.Buffer && Instances.BufferDesc.StructureStride == sizeof(CPUMatrix))
+		{
+			Draw.InstanceTransforms = reinterpret_cast<const CPUMatrix*>(Instances.Data.data());
+			Draw.InstanceCount = std::min<uint32_t>(Command.InstanceCount, static_cast<uint32_t>(Instances.Data.size() / sizeof(CPUMatrix)));
+			break;
+		}
+	}
+
+	Resource& Target = Resources[State.DepthTarget - 1];
+	Rasterizer.DrawIndexed(Target.DepthSurface, Draw);
+
+	if (Target.CompressedDepth.Width != 0)
+		Rasterizer.DrawIndexed(Target.CompressedDepth, Draw);
+}
+
+void RecordingRenderBackend::ExecuteDraw(const RenderDrawCommand& Command, const ExecutionState& State)
+{
+	const RenderGraphicsPipelineDesc& PipelineDesc = Pipelines[State.Pipeline - 1].GraphicsDesc;
+	const View* DepthView = FindBoundView(State, RENDER_DESCRIPTOR_TYPE_SRV);
+
+	// Only full screen triangle strips shading the depth texel under each pixel
+	if (!PipelineDesc.CPUDepthPixelShader || Command.VertexCount != 4 || State.RenderTarget == RenderNullHandle || !DepthView)
+	{
+		++Stats.SkippedCount;
+		return;
+	}
+
+	Resource& Target = Resources[State.RenderTarget - 1];
+	const CPUResolvedDepth& Source = Resources[DepthView->Resource - 1].ResolvedDepth;
+
+	const uint32_t DrawWidth = std::min(Target.TextureDesc.Width, Source.Width);
+	const uint32_t DrawHeight = std::min(Target.TextureDesc.Height, Source.Height);
+
+	for (uint32_t y = 0; y < DrawHeight; ++y)
+	{
+		const float* SourceRow = Source.GetRow(y);
+		uint32_t* TargetRow = &Target.Color[static_cast<size_t>(y) * Target.TextureDesc.Width];
+
+		for (uint32_t x = 0; x < DrawWidth; ++x)
+			TargetRow[x] = PipelineDesc.CPUDepthPixelShader(SourceRow[x]);
+	}
+}
+
+void RecordingRenderBackend::ExecuteDispatch(const RenderDispatchCommand& Command, const ExecutionState& State)
+{
+	const auto BoundTable = std::find_if(std::begin(State.DescriptorTables), std::end(State.DescriptorTables), [](RenderView Table) { return Table != RenderNullHandle; });
+	const auto BoundConstants = std::find_if(std::begin(State.RootConstants), std::end(State.RootConstants), [](const uint32_t* Constants) { return Constants != nullptr; });
+
+	// Nothing to resolve without a pipeline, a table and constants bound
+	if (State.Pipeline == RenderNullHandle || BoundTable == std::end(State.DescriptorTables) || BoundConstants == std::end(State.RootConstants))
+	{
+		++Stats.SkippedCount;
+		return;
+	}
+
+	const RenderComputePipelineDesc& PipelineDesc = Pipelines[State.Pipeline - 1].ComputeDesc;
+	const RenderView Table = *BoundTable;
+	const uint32_t* Constants = *BoundConstants;
+
+	if (PipelineDesc.CPUHiZKernel != RENDER_CPU_HIZ_KERNEL_NONE)
+	{
+		if (!ExecuteHiZDispatch(Command, PipelineDesc.CPUHiZKernel, Table, Constants))
+			++Stats.SkippedCount;
+
+		return;
+	}
+
+	// The table is the depth SRV followed by the UAV written
+	const View* SourceView = Table != RenderNullHandle && Views[Table - 1].Type == RENDER_DESCRIPTOR_TYPE_SRV ? &Views[Table - 1] : nullptr;
+	const View* TargetView = SourceView && Table < Views.size() && Views[Table].Type == RENDER_DESCRIPTOR_TYPE_UAV ? &Views[Table] : nullptr;
+
+	const uint32_t GroupSize = PipelineDesc.CPUResolveGroupSize;
+	const CPUDepthSurface* Source = SourceView ? &Resources[SourceView->Resource - 1].DepthSurface : nullptr;
+
+	// Only resolve kernels with a CPU counterpart, dispatched over the whole multisampled source
+	if (GroupSize == 0 || !Source || Source->Samples.empty() || !TargetView || !Constants ||
+		static_cast<uint64_t>(Command.GroupsX) * GroupSize < Source->Width || static_cast<uint64_t>(Command.GroupsY) * GroupSize < Source->Height)
+	{
+		++Stats.SkippedCount;
+		return;
+	}
+
+	Resource& Target = Resources[TargetView->Resource - 1];
+	const CPUResolveMode Mode = GetCPUResolveMode(static_cast<RenderResolveMode>(Constants[0]));
+	bool Resolved = false;
+
+	if (!Target.Color.empty() && PipelineDesc.CPUDepthPixelShader)
+		Resolved = Target.TextureDesc.Width == Source->Width && Target.TextureDesc.Height == Source->Height && CPUResolveShadeGroups(Target.Color.data(), PipelineDesc.CPUDepthPixelShader, *Source, Mode, GroupSize, Pool);
+	else if (!Target.ResolvedDepth.Depth.empty())
+		Resolved = CPUResolveDepthGroups(Target.ResolvedDepth, *Source, Mode, GroupSize, Pool);
+
+	if (!Resolved)
+		++Stats.SkippedCount;
+}
+
+bool RecordingRenderBackend::ExecuteHiZDispatch(const RenderDispatchCommand& Command, RenderCPUHiZKernel Kernel, RenderView Table, const uint32_t* Constants)
+{
+	// The table is the depth SRV, the resolved depth UAV and the pyramid buffer UAV
+	if (static_cast<size_t>(Table) + 1 >= Views.size() || Views[Table - 1].Type != RENDER_DESCRIPTOR_TYPE_SRV || Views[Table].Type != RENDER_DESCRIPTOR_TYPE_UAV || Views[Table + 1].Type != RENDER_DESCRIPTOR_TYPE_UAV)
+		return false;
+
+	HiZShaderConstants HiZConstants;
+	memcpy(&HiZConstants, Constants, sizeof(HiZConstants));
+
+	const CPUDepthSurface& Source = Resources[Views[Table - 1].Resource - 1].DepthSurface;
+	CPUResolvedDepth& ResolvedDepth = Resources[Views[Table].Resource - 1].ResolvedDepth;
+	std::vector<uint8_t>& Buffer = Resources[Views[Table + 1].Resource - 1].Data;
+
+	if (HiZConstants.LevelCount == 0 || HiZConstants.LevelCount > HiZLevelsPerDispatch ||
+		static_cast<uint64_t>(Command.GroupsX) * HiZGroupFootprint < HiZConstants.SourceWidth || static_cast<uint64_t>(Command.GroupsY) * HiZGroupFootprint < HiZConstants.SourceHeight)
+		return false;
+
+	CPUHiZLevel Levels[HiZLevelsPerDispatch];
+
+	for (uint32_t Level = 0; Level < HiZConstants.LevelCount; ++Level)
+	{
+		Levels[Level] = { HiZConstants.Levels[Level][0], HiZConstants.Levels[Level][1], HiZConstants.Levels[Level][2] };
+
+		if ((static_cast<uint64_t>(Levels[Level].Offset) + static_cast<uint64_t>(Levels[Level].Width) * Levels[Level].Height) * sizeof(CPUHiZTexel) > Buffer.size())
+			return false;
+	}
+
+	CPUHiZTexel* Texels = reinterpret_cast<CPUHiZTexel*>(Buffer.data());
+
+	if (Kernel == RENDER_CPU_HIZ_KERNEL_REDUCE)
+	{
+		const CPUHiZLevel Below = { HiZConstants.SourceWidth, HiZConstants.SourceHeight, HiZConstants.SourceOffset };
+
+		if ((static_cast<uint64_t>(Below.Offset) + static_cast<uint64_t>(Below.Width) * Below.Height) * sizeof(CPUHiZTexel) > Buffer.size())
+			return false;
+
+		CPUReduceHiZLevels(Texels, Below, Levels, HiZConstants.LevelCount);
+		return true;
+	}
+
+	// Resolves the whole source and keeps the levels this dispatch writes, the same layout as the buffer
+	if (Source.Samples.empty() || Source.Width != HiZConstants.SourceWidth || Source.Height != HiZConstants.SourceHeight ||
+		!CPUResolveDepthRegionHiZ(ResolvedDepth, 0, 0, Source, nullptr, GetCPUResolveMode(static_cast<RenderResolveMode>(HiZConstants.ResolveMode)), HiZScratch, Pool))
+		return false;
+
+	for (uint32_t Level = 0; Level < HiZConstants.LevelCount; ++Level)
+	{
+		if (Level >= HiZScratch.Levels.size() || HiZScratch.Levels[Level].Width != Levels[Level].Width || HiZScratch.Levels[Level].Height != Levels[Level].Height || HiZScratch.Levels[Level].Offset != Levels[Level].Offset)
+			return false;
+
+		memcpy(Texels + Levels[Level].Offset, HiZScratch.GetRow(Level, 0), static_cast<size_t>(Levels[Level].Width) * Levels[Level].Height * sizeof(CPUHiZTexel));
+	}
+
+	return true;
+}
+
+const CPUDepthSurface* RecordingRenderBackend::GetDepthSurface(RenderResource Texture) const
+{
+	const Resource& Target = Resources[Texture - 1];
+	return Target.DepthSurface.Samples.empty() ? nullptr : &Target.DepthSurface;
+}
+
+const CPUResolvedDepth* RecordingRenderBackend::GetResolvedDepth(RenderResource Texture) const
+{
+	const Resource& Target = Resources[Texture - 1];
+	return Target.ResolvedDepth.Depth.empty() ? nullptr : &Target.ResolvedDepth;
+}
+
+const CPUResolvedStencil* RecordingRenderBackend::GetResolvedStencil(RenderResource Texture) const
+{
+	const Resource& Target = Resources[Texture - 1];
+	return Target.ResolvedStencil.Stencil.empty() ? nullptr : &Target.ResolvedStencil;
+}
+
+const std::vector<uint32_t>* RecordingRenderBackend::GetColorTexture(RenderResource Texture) const
+{
+	const Resource& Target = Resources[Texture - 1];
+	return Target.Color.empty() ? nullptr : &Target.Color;
+}
+
+const std::vector<uint8_t>* RecordingRenderBackend::GetBufferData(RenderResource Buffer) const
+{
+	const Resource& Source = Resources[Buffer - 1];
+	return Source.Data.empty() ? nullptr : &Source.Data;
+}
+
+const CPUCompressedDepthSurface* RecordingRenderBackend::GetCompressedDepthSurface(RenderResource Texture) const
+{
+	const Resource& Target = Resources[Texture - 1];
+	return Target.CompressedDepth.Width == 0 ? nullptr : &Target.CompressedDepth;
+}
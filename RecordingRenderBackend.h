@@ -0,0 +1,268 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RenderBackend.h"
+#include "RenderCommands.h"
+#include "FrameScheduler.h"
+#include "FencedObjectPool.h"
+#include "DescriptorAllocator.h"
+#include "CPUCompressedDepth.h"
+#include "CPUDepthSurface.h"
+#include "CPUHiZ.h"
+#include "CPURasterizer.h"
+
+class CPUThreadPool;
+
+class RecordingRenderCommandList : public RenderCommandList
+{
+public:
+	explicit RecordingRenderCommandList(RenderCommandArena& Arena) : Arena(Arena) {}
+
+	void ResourceBarrier(uint32_t Count, const RenderBarrier* Barriers) override;
+	void DiscardResource(RenderResource Resource) override;
+
+	void ClearDepthStencil(RenderResource DepthTarget, float Depth, uint8_t Stencil) override;
+	void SetRenderTargets(RenderResource RenderTarget, RenderResource DepthTarget) override;
+	void SetViewport(uint32_t Width, uint32_t Height) override;
+
+	void SetPipeline(RenderPipeline Pipeline) override;
+	void SetDescriptorTable(uint32_t RootParameter, RenderView FirstView) override;
+	void SetRootConstants(uint32_t RootParameter, uint32_t Count, const void* Data) override;
+	void SetRootConstantBuffer(uint32_t RootParameter, RenderResource Buffer, uint64_t Offset) override;
+
+	void SetPrimitiveTopology(RenderPrimitiveTopology Topology) override;
+	void SetVertexBuffer(RenderResource Buffer, uint32_t Size, uint32_t Stride) override;
+	void SetIndexBuffer(RenderResource Buffer, uint32_t Size, RenderFormat Format) override;
+
+	void Draw(uint32_t VertexCount, uint32_t InstanceCount) override;
+	void DrawIndexed(uint32_t IndexCount, uint32_t InstanceCount) override;
+	void Dispatch(uint32_t GroupsX, uint32_t GroupsY, uint32_t GroupsZ) override;
+
+	void ResolveSubresourceRegion(RenderResource Destination, uint32_t DstX, uint32_t DstY, RenderResource Source, const RenderRect* SourceRect, RenderFormat Format, RenderResolveMode Mode) override;
+
+	void WriteTimestamp(RenderQueryHeap Heap, uint32_t Index) override;
+	void ResolveTimestamps(RenderQueryHeap Heap, uint32_t FirstIndex, uint32_t Count, RenderResource Destination, uint64_t Offset) override;
+
+private:
+	RenderCommandArena& Arena;
+};
+
+struct RecordingRenderStats
+{
+	// Commands of the frame's list and of the lists submitted into it
+	uint32_t CommandCount = 0;
+	size_t CommandBytes = 0;
+	uint32_t BarrierCallCount = 0;
+	uint32_t BarrierCount = 0;
+	uint32_t DrawCount = 0;
+	uint32_t DispatchCount = 0;
+	uint32_t ResolveCount = 0;
+	uint32_t SubmittedListCount = 0;
+	// Commands the CPU execution has no counterpart for (dispatches of kernels without a CPUResolveGroupSize)
+	uint32_t SkippedCount = 0;
+};
+
+// Backend without a device: frames are recorded into a RenderCommandArena and, with Execute, replayed on the CPU
+// when they end. Depth targets become CPUDepthSurface/CPUResolvedDepth in their format, draws with a depth pipeline
+// go through CPURasterizer, resolves through CPUResolveDepthRegion (CPUResolveStencilRegion for the stencil plane),
+// full screen draws of pipelines with a CPUDepthPixelShader write RGBA8 into the render target and dispatches of
+// kernels with a CPUResolveGroupSize go through CPUResolveDepthGroups or CPUResolveShadeGroups. Other dispatches are
+// recorded only.
+class RecordingRenderBackend : public RenderBackend
+{
+public:
+	RecordingRenderBackend(uint32_t Width, uint32_t Height, bool Execute = false, CPUThreadPool* Pool = nullptr);
+
+	const char* GetName() const override { return Execute ? "CPU" : "Recording"; }
+
+	RenderResource CreateTexture(const RenderTextureDesc& Desc) override;
+	RenderResource CreateBuffer(const RenderBufferDesc& Desc) override;
+	void WriteBuffer(RenderResource Buffer, uint64_t Offset, const void* Data, size_t Size) override;
+	void* MapBuffer(RenderResource Buffer) override;
+
+	// Sizes follow the D3D12 placement rules: 64KB alignment, 4MB for multisampled textures
+	RenderAllocationInfo GetTextureAllocationInfo(const RenderTextureDesc& Desc) override;
+	RenderAllocationInfo GetBufferAllocationInfo(const RenderBufferDesc& Desc) override;
+	RenderHeap CreateHeap(RenderHeapKind Kind, uint64_t Size, uint64_t Alignment) override;
+	// Placed resources keep CPU storage of their own, only the placement is checked: RenderNullHandle when the
+	// resource does not fit the heap, is misaligned or is of the wrong kind
+	RenderResource CreatePlacedTexture(RenderHeap Heap, uint64_t Offset, const RenderTextureDesc& Desc) override;
+	RenderResource CreatePlacedBuffer(RenderHeap Heap, uint64_t Offset, const RenderBufferDesc& Desc) override;
+	// Storage is freed when the frame ends, like released views; released heaps take no placements
+	void ReleaseResource(RenderResource Resource) override;
+	void ReleaseHeap(RenderHeap Heap) override;
+
+	RenderView CreateConstantBufferView(RenderResource Buffer, uint32_t Size) override;
+	RenderView CreateShaderResourceView(RenderResource Resource, RenderFormat Format) override;
+	RenderView CreateUnorderedAccessView(RenderResource Resource, RenderFormat Format) override;
+	void UpdateShaderResourceView(RenderView View, RenderResource Resource, RenderFormat Format) override;
+	void UpdateUnorderedAccessView(RenderView View, RenderResource Resource, RenderFormat Format) override;
+	// The replay reads views when the frame ends, so released views are handed out again after that
+	void ReleaseView(RenderView View) override;
+
+	RenderRootSignature CreateRootSignature(const RenderRootSignatureDesc& Desc) override;
+	RenderPipeline CreateGraphicsPipeline(const RenderGraphicsPipelineDesc& Desc) override;
+	RenderPipeline CreateComputePipeline(const RenderComputePipelineDesc& Desc) override;
+	// Nothing is compiled, pipelines are ready when they are created
+	RenderPipelineStatus GetPipelineStatus(RenderPipeline) override { return RENDER_PIPELINE_STATUS_READY; }
+
+	uint32_t GetWidth() const override { return Width; }
+	uint32_t GetHeight() const override { return Height; }
+	RenderResource GetBackBuffer() override { return BackBuffers[CurrentBackBufferIndex]; }
+	void ResizeSwapChain(uint32_t Width, uint32_t Height) override;
+
+	RenderCommandList* BeginFrame() override;
+	void EndFrame() override;
+	uint32_t GetFramesInFlight() const override { return Scheduler.GetFramesInFlight(); }
+	uint32_t GetFrameSlot() const override { return Scheduler.GetFrameSlot(); }
+	uint64_t GetFrameNumber() const override { return Scheduler.GetFrameNumber(); }
+	uint64_t GetCompletedFrame() const override { return Scheduler.GetCompletedFrame(); }
+
+	RenderCommandList* AcquireCommandList() override;
+	void SubmitCommandLists(uint32_t Count, RenderCommandList* const* Lists) override;
+
+	void WaitIdle() override { Scheduler.WaitIdle(); }
+
+	// With Execute, timestamps are the steady_clock time the replay reaches them at, so they time the CPU execution
+	uint64_t GetTimestampFrequency() override { return Execute ? 1000000000 : 0; }
+	RenderQueryHeap CreateTimestampQueryHeap(uint32_t Count) override;
+	bool GetTimestampCalibration(uint64_t& GPUTimestamp, uint64_t& CPUNanoseconds) override;
+
+	// Commands of the last frame, valid until the next BeginFrame. Submitted lists appear as
+	// RENDER_COMMAND_EXECUTE_COMMAND_LIST packets, GetSubmittedCommands returns their commands.
+	const RenderCommandArena& GetCommands() const { return Arena; }
+	const RenderCommandArena& GetSubmittedCommands(uint32_t ListIndex) const { return SecondaryLists[ListIndex].Arena; }
+	const RecordingRenderStats& GetStats() const { return Stats; }
+	// Bytes of all heaps created and not released
+	uint64_t GetHeapSize() const;
+	// Multisampled depth textures created afterwards keep CPUDepthSurface::UniformPixels, so their resolves read one
+	// sample of the pixels every sample of which is equal. On by default.
+	void SetUniformPixelTracking(bool Track) { TrackUniformPixels = Track; }
+	// Multisampled D32_FLOAT_S8X24_UINT textures created afterwards also keep a CPUCompressedDepthSurface that every
+	// clear and draw of the texture goes to as well. Off by default.
+	void SetCompressedDepth(bool Compress) { CompressDepth = Compress; }
+
+	// CPU copies of resources; only filled with Execute
+	const CPUDepthSurface* GetDepthSurface(RenderResource Texture) const;
+	const CPUResolvedDepth* GetResolvedDepth(RenderResource Texture) const;
+	// Stencil plane of single-sample depth-stencil textures with stencil
+	const CPUResolvedStencil* GetResolvedStencil(RenderResource Texture) const;
+	// RGBA8 texels in row-major order
+	const std::vector<uint32_t>* GetColorTexture(RenderResource Texture) const;
+	const std::vector<uint8_t>* GetBufferData(RenderResource Buffer) const;
+	// Compressed copy of a depth texture created with SetCompressedDepth
+	const CPUCompressedDepthSurface* GetCompressedDepthSurface(RenderResource Texture) const;
+
+private:
+	struct Resource
+	{
+		bool Buffer;
+		RenderTextureDesc TextureDesc;
+		RenderBufferDesc BufferDesc;
+		std::vector<uint8_t> Data;          // buffers
+		CPUDepthSurface DepthSurface;       // multisampled depth textures
+		CPUResolvedDepth ResolvedDepth;     // single-sample depth and R32_FLOAT textures
+		CPUResolvedStencil ResolvedStencil; // single-sample depth textures with stencil
+		std::vector<uint32_t> Color;        // RGBA8 textures
+		CPUCompressedDepthSurface CompressedDepth; // multisampled depth textures with SetCompressedDepth
+	};
+
+	struct Heap
+	{
+		RenderHeapKind Kind;
+		uint64_t Size;
+		uint64_t Alignment;
+		bool Released = false;
+	};
+
+	struct View
+	{
+		RenderDescriptorType Type;
+		RenderResource Resource;
+		RenderFormat Format;
+	};
+
+	struct Pipeline
+	{
+		bool Compute;
+		RenderGraphicsPipelineDesc GraphicsDesc;
+		RenderComputePipelineDesc ComputeDesc;
+	};
+
+	// State of the command list replay
+	struct ExecutionState
+	{
+		static constexpr uint32_t MaxRootParameters = 8;
+
+		RenderResource RenderTarget = RenderNullHandle;
+		RenderResource DepthTarget = RenderNullHandle;
+		RenderPipeline Pipeline = RenderNullHandle;
+		RenderView DescriptorTables[MaxRootParameters] = {};
+		RenderResource RootConstantBuffers[MaxRootParameters] = {};
+		uint64_t RootConstantBufferOffsets[MaxRootParameters] = {};
+		const uint32_t* RootConstants[MaxRootParameters] = {};
+		RenderResource VertexBuffer = RenderNullHandle;
+		uint32_t VertexBufferSize = 0;
+		uint32_t VertexStride = 0;
+		RenderResource IndexBuffer = RenderNullHandle;
+		uint32_t IndexBufferSize = 0;
+	};
+
+	struct SecondaryCommandList
+	{
+		RenderCommandArena Arena;
+		RecordingRenderCommandList CommandList{ Arena };
+	};
+
+
+	// Stats and, with Execute, the CPU replay of one command
+	void ProcessCommand(const RenderCommandHeader& Command, ExecutionState& State);
+	void ExecuteCommand(const RenderCommandHeader& Command, ExecutionState& State);
+	void ExecuteDrawIndexed(const RenderDrawIndexedCommand& Command, const ExecutionState& State);
+	void ExecuteDraw(const RenderDrawCommand& Command, const ExecutionState& State);
+	void ExecuteDispatch(const RenderDispatchCommand& Command, const ExecutionState& State);
+	bool ExecuteHiZDispatch(const RenderDispatchCommand& Command, RenderCPUHiZKernel Kernel, RenderView Table, const uint32_t* Constants);
+	// First view of Type in the descriptor tables currently set
+	const View* FindBoundView(const ExecutionState& State, RenderDescriptorType Type) const;
+
+	uint32_t Width;
+	uint32_t Height;
+	bool Execute;
+	bool TrackUniformPixels = true;
+	bool CompressDepth = false;
+	CPUThreadPool* Pool;
+
+	CPURasterizer Rasterizer;
+	// Pyramid of the last HiZ resolve dispatch, copied into the buffer level by level
+	CPUHiZPyramid HiZScratch;
+
+	RenderView AddView(const View& NewView);
+	bool IsPlacementValid(RenderHeap Heap, uint64_t Offset, RenderHeapKind Kind, const RenderAllocationInfo& Info) const;
+
+	std::vector<Heap> Heaps;
+	std::vector<Resource> Resources;
+	std::vector<View> Views;
+	DescriptorFreeList ViewIndices{ RenderMaxViews };
+	std::vector<RenderView> ReleasedViews;
+	std::vector<RenderResource> ReleasedResources;
+	uint32_t RootSignatureCount = 0;
+	std::vector<Pipeline> Pipelines;
+	std::vector<std::vector<uint64_t>> QueryHeaps;
+
+	RenderResource BackBuffers[2];
+	uint32_t CurrentBackBufferIndex = 0;
+
+	// Frames complete as soon as they end, replayed or not
+	SimulatedFrameFence Fence;
+	FrameScheduler Scheduler;
+
+	RenderCommandArena Arena;
+	RecordingRenderCommandList CommandList;
+	RecordingRenderStats Stats;
+
+	FencedObjectPool<SecondaryCommandList, RenderMaxAcquiredCommandLists> SecondaryLists;
+	// Pool indices released when the frame ends
+	std::vector<uint32_t> SubmittedLists;
+};
@@ -0,0 +1,443 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Thin interface over the part of D3D12 the frame uses: resources, views, root signatures, pipelines and one command list per frame.
+// Enum values match their D3D12/DXGI counterparts so the D3D12 backend passes them through unchanged.
+
+typedef uint32_t RenderResource;
+typedef uint32_t RenderView;
+typedef uint32_t RenderRootSignature;
+typedef uint32_t RenderPipeline;
+typedef uint32_t RenderHeap;
+typedef uint32_t RenderQueryHeap;
+
+// Handles start at 1, 0 is never a valid object
+constexpr uint32_t RenderNullHandle = 0;
+
+// Command lists AcquireCommandList hands out per backend, recording or in flight
+constexpr uint32_t RenderMaxAcquiredCommandLists = 64;
+// Shader views alive at once per backend
+constexpr uint32_t RenderMaxViews = 128 * 1024;
+
+// Mirrors DXGI_FORMAT
+enum RenderFormat
+{
+	RENDER_FORMAT_UNKNOWN = 0,
+	RENDER_FORMAT_R32G32B32_FLOAT = 6,
+	RENDER_FORMAT_D32_FLOAT_S8X24_UINT = 20,
+	RENDER_FORMAT_R32_FLOAT_X8X24_TYPELESS = 21,
+	RENDER_FORMAT_X32_TYPELESS_G8X24_UINT = 22,
+	RENDER_FORMAT_R8G8B8A8_UNORM = 28,
+	RENDER_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+	RENDER_FORMAT_D32_FLOAT = 40,
+	RENDER_FORMAT_R32_FLOAT = 41,
+	RENDER_FORMAT_D24_UNORM_S8_UINT = 45,
+	RENDER_FORMAT_R24_UNORM_X8_TYPELESS = 46,
+	RENDER_FORMAT_X24_TYPELESS_G8_UINT = 47,
+	RENDER_FORMAT_D16_UNORM = 55,
+	RENDER_FORMAT_R16_UNORM = 56,
+	RENDER_FORMAT_R16_UINT = 57
+};
+
+// Depth-stencil formats of depth targets and the formats their planes are viewed and resolved as
+struct RenderDepthFormatInfo
+{
+	RenderFormat Format;
+	const char* Name;
+	RenderFormat DepthPlaneFormat;   // plane slice 0
+	RenderFormat StencilPlaneFormat; // plane slice 1, UNKNOWN without stencil
+	uint32_t SampleSize;             // bytes per sample
+};
+
+constexpr RenderDepthFormatInfo RenderDepthFormats[] =
+{
+	{ RENDER_FORMAT_D32_FLOAT_S8X24_UINT, "D32_FLOAT_S8X24_UINT", RENDER_FORMAT_R32_FLOAT_X8X24_TYPELESS, RENDER_FORMAT_X32_TYPELESS_G8X24_UINT, 8 },
+	{ RENDER_FORMAT_D32_FLOAT, "D32_FLOAT", RENDER_FORMAT_R32_FLOAT, RENDER_FORMAT_UNKNOWN, 4 },
+	{ RENDER_FORMAT_D24_UNORM_S8_UINT, "D24_UNORM_S8_UINT", RENDER_FORMAT_R24_UNORM_X8_TYPELESS, RENDER_FORMAT_X24_TYPELESS_G8_UINT, 4 },
+	{ RENDER_FORMAT_D16_UNORM, "D16_UNORM", RENDER_FORMAT_R16_UNORM, RENDER_FORMAT_UNKNOWN, 2 }
+};
+
+// nullptr when Format is not a depth-stencil format
+inline const RenderDepthFormatInfo* GetRenderDepthFormatInfo(RenderFormat Format)
+{
+	for (const RenderDepthFormatInfo& Info : RenderDepthFormats)
+	{
+		if (Info.Format == Format)
+			return &Info;
+	}
+
+	return nullptr;
+}
+
+// Plane views and resolves of Format read: 1 for the stencil plane formats, else 0
+inline uint32_t GetRenderFormatPlaneSlice(RenderFormat Format)
+{
+	return Format == RENDER_FORMAT_X32_TYPELESS_G8X24_UINT || Format == RENDER_FORMAT_X24_TYPELESS_G8_UINT ? 1 : 0;
+}
+
+// Mirrors D3D12_RESOURCE_STATES
+enum RenderResourceState : uint32_t
+{
+	RENDER_RESOURCE_STATE_COMMON = 0,
+	RENDER_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1,
+	RENDER_RESOURCE_STATE_INDEX_BUFFER = 0x2,
+	RENDER_RESOURCE_STATE_RENDER_TARGET = 0x4,
+	RENDER_RESOURCE_STATE_UNORDERED_ACCESS = 0x8,
+	RENDER_RESOURCE_STATE_DEPTH_WRITE = 0x10,
+	RENDER_RESOURCE_STATE_DEPTH_READ = 0x20,
+	RENDER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+	RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE = 0x80,
+	RENDER_RESOURCE_STATE_INDIRECT_ARGUMENT = 0x200,
+	RENDER_RESOURCE_STATE_COPY_DEST = 0x400,
+	RENDER_RESOURCE_STATE_COPY_SOURCE = 0x800,
+	RENDER_RESOURCE_STATE_RESOLVE_DEST = 0x1000,
+	RENDER_RESOURCE_STATE_RESOLVE_SOURCE = 0x2000,
+	RENDER_RESOURCE_STATE_GENERIC_READ = 0xAC3,
+	RENDER_RESOURCE_STATE_PRESENT = 0
+};
+
+constexpr RenderResourceState operator|(RenderResourceState a, RenderResourceState b)
+{
+	return static_cast<RenderResourceState>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
+// Mirrors D3D12_RESOURCE_FLAGS
+enum RenderResourceFlags : uint32_t
+{
+	RENDER_RESOURCE_FLAG_NONE = 0,
+	RENDER_RESOURCE_FLAG_ALLOW_RENDER_TARGET = 0x1,
+	RENDER_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL = 0x2,
+	RENDER_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS = 0x4
+};
+
+// Mirrors D3D12_HEAP_TYPE
+enum RenderHeapType
+{
+	RENDER_HEAP_TYPE_DEFAULT = 1,
+	RENDER_HEAP_TYPE_UPLOAD = 2,
+	RENDER_HEAP_TYPE_READBACK = 3
+};
+
+// Resource heap tier 1 keeps buffers, render target/depth-stencil textures and other textures in separate heaps
+enum RenderHeapKind
+{
+	RENDER_HEAP_KIND_BUFFERS,
+	RENDER_HEAP_KIND_TARGET_TEXTURES,
+	RENDER_HEAP_KIND_OTHER_TEXTURES
+};
+
+// Mirrors D3D12_RESOLVE_MODE
+enum RenderResolveMode
+{
+	RENDER_RESOLVE_MODE_DECOMPRESS = 0,
+	RENDER_RESOLVE_MODE_MIN = 1,
+	RENDER_RESOLVE_MODE_MAX = 2,
+	RENDER_RESOLVE_MODE_AVERAGE = 3
+};
+
+// Mirrors D3D_PRIMITIVE_TOPOLOGY
+enum RenderPrimitiveTopology
+{
+	RENDER_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4,
+	RENDER_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP = 5
+};
+
+// Mirrors D3D12_CULL_MODE
+enum RenderCullMode
+{
+	RENDER_CULL_MODE_NONE = 1,
+	RENDER_CULL_MODE_FRONT = 2,
+	RENDER_CULL_MODE_BACK = 3
+};
+
+// Mirrors D3D12_SHADER_VISIBILITY
+enum RenderShaderVisibility
+{
+	RENDER_SHADER_VISIBILITY_ALL = 0,
+	RENDER_SHADER_VISIBILITY_VERTEX = 1,
+	RENDER_SHADER_VISIBILITY_PIXEL = 5
+};
+
+// Mirrors D3D12_DESCRIPTOR_RANGE_TYPE
+enum RenderDescriptorType
+{
+	RENDER_DESCRIPTOR_TYPE_SRV = 0,
+	RENDER_DESCRIPTOR_TYPE_UAV = 1,
+	RENDER_DESCRIPTOR_TYPE_CBV = 2
+};
+
+// Same layout as D3D12_RECT
+struct RenderRect
+{
+	int32_t Left;
+	int32_t Top;
+	int32_t Right;
+	int32_t Bottom;
+};
+
+struct RenderTextureDesc
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t SampleCount = 1;
+	RenderFormat Format = RENDER_FORMAT_UNKNOWN;
+	uint32_t Flags = RENDER_RESOURCE_FLAG_NONE;
+	RenderResourceState InitialState = RENDER_RESOURCE_STATE_COMMON;
+	// Optimized clear value of depth-stencil targets
+	float ClearDepth = 1.0f;
+	uint8_t ClearStencil = 0;
+	const char* Name = nullptr;
+};
+
+struct RenderBufferDesc
+{
+	uint64_t Size = 0;
+	RenderHeapType HeapType = RENDER_HEAP_TYPE_DEFAULT;
+	uint32_t Flags = RENDER_RESOURCE_FLAG_NONE;
+	RenderResourceState InitialState = RENDER_RESOURCE_STATE_COMMON;
+	uint32_t StructureStride = 0; // structured buffer views use it as the element size
+	const char* Name = nullptr;
+};
+
+// Mirrors D3D12_RESOURCE_ALLOCATION_INFO
+struct RenderAllocationInfo
+{
+	uint64_t Size;
+	uint64_t Alignment;
+};
+
+struct RenderDescriptorRange
+{
+	RenderDescriptorType Type;
+	uint32_t Count;
+	uint32_t BaseRegister;
+};
+
+// A root parameter is either a descriptor table (RangeCount > 0), a root constant buffer view at b[ConstantRegister]
+// (ConstantBuffer) or Constants32Bit root constants at b[ConstantRegister]
+struct RenderRootParameter
+{
+	const RenderDescriptorRange* Ranges = nullptr;
+	uint32_t RangeCount = 0;
+	uint32_t Constants32Bit = 0;
+	uint32_t ConstantRegister = 0;
+	RenderShaderVisibility Visibility = RENDER_SHADER_VISIBILITY_ALL;
+	bool ConstantBuffer = false;
+};
+
+struct RenderRootSignatureDesc
+{
+	const RenderRootParameter* Parameters = nullptr;
+	uint32_t ParameterCount = 0;
+	bool AllowInputLayout = false;
+};
+
+// Shaders are HLSL source compiled by the backend, possibly after CreateGraphicsPipeline returns. Pipelines without
+// input layout use SV_VertexID only, PositionInput feeds a single float3 POSITION stream.
+struct RenderGraphicsPipelineDesc
+{
+	RenderRootSignature RootSignature = RenderNullHandle;
+	const char* Name = nullptr;
+	const char* VertexShaderSource = nullptr;
+	const char* VertexShaderEntry = "VS";
+	const char* PixelShaderSource = nullptr;
+	const char* PixelShaderEntry = "PS";
+	bool PositionInput = false;
+	bool DepthEnable = false; // DepthFunc LESS with depth writes
+	RenderCullMode CullMode = RENDER_CULL_MODE_BACK;
+	RenderFormat RenderTargetFormat = RENDER_FORMAT_UNKNOWN;
+	RenderFormat DepthStencilFormat = RENDER_FORMAT_UNKNOWN;
+	uint32_t SampleCount = 1;
+	// CPU counterpart of pixel shaders that turn the depth texel at the pixel into an RGBA8 color, for backends executing on the CPU
+	uint32_t (*CPUDepthPixelShader)(float Depth) = nullptr;
+};
+
+// CPU counterparts of the HiZ kernels of HiZShaders.h, for backends executing on the CPU. Their table is the
+// multisampled depth SRV, the R32_FLOAT UAV of the resolved depth and the UAV of the pyramid buffer, and their root
+// constants are HiZShaderConstants.
+enum RenderCPUHiZKernel
+{
+	RENDER_CPU_HIZ_KERNEL_NONE,
+	RENDER_CPU_HIZ_KERNEL_RESOLVE, // ResolveHiZCS: resolves the whole source and writes the first levels
+	RENDER_CPU_HIZ_KERNEL_REDUCE   // ReduceHiZCS: reduces the level at SourceOffset into the next ones
+};
+
+struct RenderComputePipelineDesc
+{
+	RenderRootSignature RootSignature = RenderNullHandle;
+	const char* Name = nullptr;
+	const char* ShaderSource = nullptr;
+	const char* ShaderEntry = "CS";
+	// CPU counterpart of kernels resolving the multisampled depth SRV of their table, for backends executing on the
+	// CPU: one CPUResolveGroupSize pixels square block per group, in the RenderResolveMode of the first root constant,
+	// into the R32_FLOAT UAV of the table, or into the color CPUDepthPixelShader gives the depth for an RGBA8 UAV.
+	// 0 for kernels without one.
+	uint32_t CPUResolveGroupSize = 0;
+	uint32_t (*CPUDepthPixelShader)(float Depth) = nullptr;
+	RenderCPUHiZKernel CPUHiZKernel = RENDER_CPU_HIZ_KERNEL_NONE;
+};
+
+enum RenderPipelineStatus
+{
+	RENDER_PIPELINE_STATUS_PENDING, // shaders still compiling
+	RENDER_PIPELINE_STATUS_READY,
+	RENDER_PIPELINE_STATUS_FAILED   // a shader did not compile, the backend reports why
+};
+
+// Mirrors D3D12_RESOURCE_BARRIER for transitions of all subresources, UAV barriers and aliasing barriers
+// that activate a placed resource (any resource sharing its memory is deactivated)
+struct RenderBarrier
+{
+	enum BarrierType
+	{
+		TRANSITION,
+		UAV,
+		ALIASING
+	};
+
+	BarrierType Type;
+	RenderResource Resource;
+	RenderResourceState Before;
+	RenderResourceState After;
+
+	static RenderBarrier Transition(RenderResource Resource, RenderResourceState Before, RenderResourceState After)
+	{
+		return { TRANSITION, Resource, Before, After };
+	}
+
+	static RenderBarrier UnorderedAccess(RenderResource Resource)
+	{
+		return { UAV, Resource, RENDER_RESOURCE_STATE_UNORDERED_ACCESS, RENDER_RESOURCE_STATE_UNORDERED_ACCESS };
+	}
+
+	static RenderBarrier Aliasing(RenderResource Resource)
+	{
+		return { ALIASING, Resource, RENDER_RESOURCE_STATE_COMMON, RENDER_RESOURCE_STATE_COMMON };
+	}
+};
+
+// Commands of one frame, in ID3D12GraphicsCommandList terms. Pipelines bind their own root signature; descriptor tables
+// and root constants go to the graphics or compute root signature depending on the pipeline last set.
+class RenderCommandList
+{
+public:
+	virtual ~RenderCommandList() = default;
+
+	virtual void ResourceBarrier(uint32_t Count, const RenderBarrier* Barriers) = 0;
+	// Render targets in RENDER_TARGET and depth-stencil targets in DEPTH_WRITE only
+	virtual void DiscardResource(RenderResource Resource) = 0;
+
+	virtual void ClearDepthStencil(RenderResource DepthTarget, float Depth, uint8_t Stencil) = 0;
+	virtual void SetRenderTargets(RenderResource RenderTarget, RenderResource DepthTarget) = 0;
+	// Viewport with depth range [0, 1] and a scissor rect covering the same area
+	virtual void SetViewport(uint32_t Width, uint32_t Height) = 0;
+
+	virtual void SetPipeline(RenderPipeline Pipeline) = 0;
+	virtual void SetDescriptorTable(uint32_t RootParameter, RenderView FirstView) = 0;
+	virtual void SetRootConstants(uint32_t RootParameter, uint32_t Count, const void* Data) = 0;
+	// Offset must be a multiple of 256
+	virtual void SetRootConstantBuffer(uint32_t RootParameter, RenderResource Buffer, uint64_t Offset) = 0;
+
+	virtual void SetPrimitiveTopology(RenderPrimitiveTopology Topology) = 0;
+	virtual void SetVertexBuffer(RenderResource Buffer, uint32_t Size, uint32_t Stride) = 0;
+	virtual void SetIndexBuffer(RenderResource Buffer, uint32_t Size, RenderFormat Format) = 0;
+
+	virtual void Draw(uint32_t VertexCount, uint32_t InstanceCount) = 0;
+	virtual void DrawIndexed(uint32_t IndexCount, uint32_t InstanceCount) = 0;
+	virtual void Dispatch(uint32_t GroupsX, uint32_t GroupsY, uint32_t GroupsZ) = 0;
+
+	// SourceRect == nullptr resolves the whole source. Format picks the plane of depth-stencil textures: the stencil
+	// plane formats resolve plane slice 1 with MIN or MAX, any other format the depth plane.
+	virtual void ResolveSubresourceRegion(RenderResource Destination, uint32_t DstX, uint32_t DstY, RenderResource Source, const RenderRect* SourceRect, RenderFormat Format, RenderResolveMode Mode) = 0;
+
+	// GPU clock into query Index once everything before it has executed
+	virtual void WriteTimestamp(RenderQueryHeap Heap, uint32_t Index) = 0;
+	// Count queries from FirstIndex as uint64_t to a readback buffer in COPY_DEST, Offset a multiple of 8
+	virtual void ResolveTimestamps(RenderQueryHeap Heap, uint32_t FirstIndex, uint32_t Count, RenderResource Destination, uint64_t Offset) = 0;
+};
+
+// Views created one after another with no release in between get consecutive handles, so a descriptor table starting
+// at a view spans the views created right after it.
+// Render targets and depth-stencil targets get their views when they are created.
+class RenderBackend
+{
+public:
+	virtual ~RenderBackend() = default;
+
+	virtual const char* GetName() const = 0;
+
+	virtual RenderResource CreateTexture(const RenderTextureDesc& Desc) = 0;
+	virtual RenderResource CreateBuffer(const RenderBufferDesc& Desc) = 0;
+	// Upload heap buffers only
+	virtual void WriteBuffer(RenderResource Buffer, uint64_t Offset, const void* Data, size_t Size) = 0;
+	// Upload and readback heap buffers, mapped once and left mapped for the lifetime of the buffer. Readback data is
+	// there once the frame that wrote it has completed.
+	virtual void* MapBuffer(RenderResource Buffer) = 0;
+
+	// Placed resources in default heaps. Resources whose memory overlaps must be activated with an aliasing barrier,
+	// and render or depth-stencil targets then initialized by a clear or DiscardResource before anything reads them.
+	virtual RenderAllocationInfo GetTextureAllocationInfo(const RenderTextureDesc& Desc) = 0;
+	virtual RenderAllocationInfo GetBufferAllocationInfo(const RenderBufferDesc& Desc) = 0;
+	virtual RenderHeap CreateHeap(RenderHeapKind Kind, uint64_t Size, uint64_t Alignment) = 0;
+	virtual RenderResource CreatePlacedTexture(RenderHeap Heap, uint64_t Offset, const RenderTextureDesc& Desc) = 0;
+	virtual RenderResource CreatePlacedBuffer(RenderHeap Heap, uint64_t Offset, const RenderBufferDesc& Desc) = 0;
+	// Both destroy the object once the frames recorded so far have completed; handles are not handed out again.
+	// Placed resources go before their heap, their render target and depth-stencil views with them.
+	virtual void ReleaseResource(RenderResource Resource) = 0;
+	virtual void ReleaseHeap(RenderHeap Heap) = 0;
+
+	virtual RenderView CreateConstantBufferView(RenderResource Buffer, uint32_t Size) = 0;
+	// Multisampled textures get a Texture2DMS view, buffers a structured buffer view
+	virtual RenderView CreateShaderResourceView(RenderResource Resource, RenderFormat Format) = 0;
+	virtual RenderView CreateUnorderedAccessView(RenderResource Resource, RenderFormat Format) = 0;
+	// Tables are copied when they are set, so a view may be released as soon as it has been set for the last time
+	virtual void ReleaseView(RenderView View) = 0;
+	// Rewrite a view for another resource under the same handle, keeping its place in its table. Like ReleaseView,
+	// once the view has been set for the last time with the old one.
+	virtual void UpdateShaderResourceView(RenderView View, RenderResource Resource, RenderFormat Format) = 0;
+	virtual void UpdateUnorderedAccessView(RenderView View, RenderResource Resource, RenderFormat Format) = 0;
+
+	virtual RenderRootSignature CreateRootSignature(const RenderRootSignatureDesc& Desc) = 0;
+	virtual RenderPipeline CreateGraphicsPipeline(const RenderGraphicsPipelineDesc& Desc) = 0;
+	virtual RenderPipeline CreateComputePipeline(const RenderComputePipelineDesc& Desc) = 0;
+	// Pipelines may be set on a command list once they are READY. Pending ones are finished in BeginFrame.
+	virtual RenderPipelineStatus GetPipelineStatus(RenderPipeline Pipeline) = 0;
+
+	// Swap chain size and the back buffer the current frame presents, in PRESENT state between frames
+	virtual uint32_t GetWidth() const = 0;
+	virtual uint32_t GetHeight() const = 0;
+	virtual RenderResource GetBackBuffer() = 0;
+	// Between frames: waits for the GPU and resizes the back buffers. Their handles stay the same, shader views of
+	// them must be created again.
+	virtual void ResizeSwapChain(uint32_t Width, uint32_t Height) = 0;
+
+	// Waits until the frame's command memory can be reused and returns its open command list
+	virtual RenderCommandList* BeginFrame() = 0;
+	// Frames recorded or executing at once, and the slot of per-frame resources the current frame may write
+	virtual uint32_t GetFramesInFlight() const = 0;
+	virtual uint32_t GetFrameSlot() const = 0;
+	// Number of the current frame, counting from 1, and of the last frame the GPU has finished
+	virtual uint64_t GetFrameNumber() const = 0;
+	virtual uint64_t GetCompletedFrame() const = 0;
+	// Submits the command list and presents
+	virtual void EndFrame() = 0;
+
+	// Command list for recording on a worker thread while the frame is open, callable from any thread. Each list
+	// starts with no state set and must be passed to SubmitCommandLists within the frame. nullptr when all
+	// RenderMaxAcquiredCommandLists lists are in use or still executing.
+	virtual RenderCommandList* AcquireCommandList() = 0;
+	// Executes Lists, in order, after everything recorded so far into the frame's command list, which then carries
+	// on recording with no state set. Frame thread only.
+	virtual void SubmitCommandLists(uint32_t Count, RenderCommandList* const* Lists) = 0;
+
+	// Blocks until everything submitted has finished
+	virtual void WaitIdle() = 0;
+
+	// Timestamps in ticks of GetTimestampFrequency per second, 0 when the backend has no timestamps
+	virtual uint64_t GetTimestampFrequency() = 0;
+	virtual RenderQueryHeap CreateTimestampQueryHeap(uint32_t Count) = 0;
+	// A GPU timestamp and the std::chrono::steady_clock time, in nanoseconds since its epoch, taken at the same moment
+	virtual bool GetTimestampCalibration(uint64_t& GPUTimestamp, uint64_t& CPUNanoseconds) = 0;
+};
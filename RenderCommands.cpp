@@ -0,0 +1,54 @@
+#include "RenderCommands.h"
+
+#include <algorithm>
+
+RenderCommandArena::RenderCommandArena(size_t ChunkSize) : ChunkSize(ChunkSize)
+{
+}
+
+void RenderCommandArena::Reset()
+{
+	for (Chunk& Current : Chunks)
+		Current.Used = 0;
+
+	CurrentChunk = 0;
+	CommandCount = 0;
+	UsedSize = 0;
+}
+
+RenderCommandHeader* RenderCommandArena::Allocate(RenderCommandType Type, size_t Size)
+{
+	Size = (Size + RenderCommandAlignment - 1) & ~(RenderCommandAlignment - 1);
+
+	while (CurrentChunk < Chunks.size() && Chunks[CurrentChunk].Used + Size > Chunks[CurrentChunk].Capacity)
+		++CurrentChunk;
+
+	if (CurrentChunk == Chunks.size())
+	{
+		// Packets never straddle chunks, an oversized one gets a chunk of its own
+		const size_t Capacity = std::max(ChunkSize, Size);
+		Chunks.push_back({ std::make_unique<uint8_t[]>(Capacity), Capacity, 0 });
+	}
+
+	Chunk& Current = Chunks[CurrentChunk];
+
+	RenderCommandHeader* Header = reinterpret_cast<RenderCommandHeader*>(Current.Data.get() + Current.Used);
+	Header->Type = Type;
+	Header->Size = static_cast<uint32_t>(Size);
+
+	Current.Used += Size;
+	UsedSize += Size;
+	++CommandCount;
+
+	return Header;
+}
+
+size_t RenderCommandArena::GetReservedSize() const
+{
+	size_t Size = 0;
+
+	for (const Chunk& Current : Chunks)
+		Size += Current.Capacity;
+
+	return Size;
+}
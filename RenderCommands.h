@@ -0,0 +1,243 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "RenderBackend.h"
+
+// Command packets of the recording backend. Every packet starts with a header and is followed by its payload;
+// barriers and root constants trail the packet, so a whole frame is a few contiguous chunks of plain data.
+
+enum RenderCommandType : uint32_t
+{
+	RENDER_COMMAND_RESOURCE_BARRIER,
+	RENDER_COMMAND_DISCARD_RESOURCE,
+	RENDER_COMMAND_CLEAR_DEPTH_STENCIL,
+	RENDER_COMMAND_SET_RENDER_TARGETS,
+	RENDER_COMMAND_SET_VIEWPORT,
+	RENDER_COMMAND_SET_PIPELINE,
+	RENDER_COMMAND_SET_DESCRIPTOR_TABLE,
+	RENDER_COMMAND_SET_ROOT_CONSTANTS,
+	RENDER_COMMAND_SET_ROOT_CONSTANT_BUFFER,
+	RENDER_COMMAND_SET_PRIMITIVE_TOPOLOGY,
+	RENDER_COMMAND_SET_VERTEX_BUFFER,
+	RENDER_COMMAND_SET_INDEX_BUFFER,
+	RENDER_COMMAND_DRAW,
+	RENDER_COMMAND_DRAW_INDEXED,
+	RENDER_COMMAND_DISPATCH,
+	RENDER_COMMAND_RESOLVE_SUBRESOURCE_REGION,
+	RENDER_COMMAND_WRITE_TIMESTAMP,
+	RENDER_COMMAND_RESOLVE_TIMESTAMPS,
+	RENDER_COMMAND_EXECUTE_COMMAND_LIST,
+	RENDER_COMMAND_TYPE_COUNT
+};
+
+struct RenderCommandHeader
+{
+	RenderCommandType Type;
+	uint32_t Size; // whole packet including the header and trailing data, a multiple of RenderCommandAlignment
+};
+
+constexpr size_t RenderCommandAlignment = 8;
+
+struct RenderResourceBarrierCommand
+{
+	RenderCommandHeader Header;
+	uint32_t Count;
+
+	const RenderBarrier* GetBarriers() const { return reinterpret_cast<const RenderBarrier*>(this + 1); }
+};
+
+struct RenderDiscardResourceCommand
+{
+	RenderCommandHeader Header;
+	RenderResource Resource;
+};
+
+struct RenderClearDepthStencilCommand
+{
+	RenderCommandHeader Header;
+	RenderResource DepthTarget;
+	float Depth;
+	uint8_t Stencil;
+};
+
+struct RenderSetRenderTargetsCommand
+{
+	RenderCommandHeader Header;
+	RenderResource RenderTarget;
+	RenderResource DepthTarget;
+};
+
+struct RenderSetViewportCommand
+{
+	RenderCommandHeader Header;
+	uint32_t Width;
+	uint32_t Height;
+};
+
+struct RenderSetPipelineCommand
+{
+	RenderCommandHeader Header;
+	RenderPipeline Pipeline;
+};
+
+struct RenderSetDescriptorTableCommand
+{
+	RenderCommandHeader Header;
+	uint32_t RootParameter;
+	RenderView FirstView;
+};
+
+struct RenderSetRootConstantsCommand
+{
+	RenderCommandHeader Header;
+	uint32_t RootParameter;
+	uint32_t Count;
+
+	const uint32_t* GetConstants() const { return reinterpret_cast<const uint32_t*>(this + 1); }
+};
+
+struct RenderSetRootConstantBufferCommand
+{
+	RenderCommandHeader Header;
+	uint32_t RootParameter;
+	RenderResource Buffer;
+	uint64_t Offset;
+};
+
+struct RenderSetPrimitiveTopologyCommand
+{
+	RenderCommandHeader Header;
+	RenderPrimitiveTopology Topology;
+};
+
+struct RenderSetVertexBufferCommand
+{
+	RenderCommandHeader Header;
+	RenderResource Buffer;
+	uint32_t Size;
+	uint32_t Stride;
+};
+
+struct RenderSetIndexBufferCommand
+{
+	RenderCommandHeader Header;
+	RenderResource Buffer;
+	uint32_t Size;
+	RenderFormat Format;
+};
+
+struct RenderDrawCommand
+{
+	RenderCommandHeader Header;
+	uint32_t VertexCount;
+	uint32_t InstanceCount;
+};
+
+struct RenderDrawIndexedCommand
+{
+	RenderCommandHeader Header;
+	uint32_t IndexCount;
+	uint32_t InstanceCount;
+};
+
+struct RenderDispatchCommand
+{
+	RenderCommandHeader Header;
+	uint32_t GroupsX;
+	uint32_t GroupsY;
+	uint32_t GroupsZ;
+};
+
+struct RenderResolveSubresourceRegionCommand
+{
+	RenderCommandHeader Header;
+	RenderResource Destination;
+	uint32_t DstX;
+	uint32_t DstY;
+	RenderResource Source;
+	bool HasSourceRect;
+	RenderRect SourceRect;
+	RenderFormat Format;
+	RenderResolveMode Mode;
+};
+
+struct RenderWriteTimestampCommand
+{
+	RenderCommandHeader Header;
+	RenderQueryHeap Heap;
+	uint32_t Index;
+};
+
+struct RenderResolveTimestampsCommand
+{
+	RenderCommandHeader Header;
+	RenderQueryHeap Heap;
+	uint32_t FirstIndex;
+	uint32_t Count;
+	RenderResource Destination;
+	uint64_t Offset;
+};
+
+// Commands of a list recorded on another thread run here; the recording backend keeps the list by index
+struct RenderExecuteCommandListCommand
+{
+	RenderCommandHeader Header;
+	uint32_t ListIndex;
+};
+
+// Linear allocator the packets are written into. Memory comes in chunks that are kept across Reset,
+// so recording a frame of the same shape as the last one does not allocate.
+class RenderCommandArena
+{
+public:
+	explicit RenderCommandArena(size_t ChunkSize = 64 * 1024);
+
+	// Drops the recorded packets, keeps the chunks
+	void Reset();
+
+	// Packet of Size bytes (header included, rounded up to RenderCommandAlignment) with its header filled in
+	RenderCommandHeader* Allocate(RenderCommandType Type, size_t Size);
+
+	template<typename Command>
+	Command* Allocate(RenderCommandType Type, size_t TrailingSize = 0)
+	{
+		return reinterpret_cast<Command*>(Allocate(Type, sizeof(Command) + TrailingSize));
+	}
+
+	uint32_t GetCommandCount() const { return CommandCount; }
+	// Bytes of packets recorded since the last Reset
+	size_t GetUsedSize() const { return UsedSize; }
+	// Bytes held by all chunks
+	size_t GetReservedSize() const;
+
+	// Calls Func(const RenderCommandHeader&) for every packet in recording order
+	template<typename Function>
+	void ForEach(Function&& Func) const
+	{
+		for (size_t i = 0; i <= CurrentChunk && i < Chunks.size(); ++i)
+		{
+			const uint8_t* Data = Chunks[i].Data.get();
+
+			for (size_t Offset = 0; Offset < Chunks[i].Used; Offset += reinterpret_cast<const RenderCommandHeader*>(Data + Offset)->Size)
+				Func(*reinterpret_cast<const RenderCommandHeader*>(Data + Offset));
+		}
+	}
+
+private:
+	struct Chunk
+	{
+		std::unique_ptr<uint8_t[]> Data;
+		size_t Capacity;
+		size_t Used;
+	};
+
+	size_t ChunkSize;
+	std::vector<Chunk> Chunks;
+	size_t CurrentChunk = 0;
+	uint32_t CommandCount = 0;
+	size_t UsedSize = 0;
+};
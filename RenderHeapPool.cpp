@@ -0,0 +1,131 @@
+#include "RenderHeapPool.h"
+
+RenderHeapPool::RenderHeapPool(RenderBackend& Backend, uint32_t MaxIdleFrames, uint64_t MaxFreeSize) : Backend(Backend), MaxIdleFrames(MaxIdleFrames), MaxFreeSize(MaxFreeSize)
+{
+}
+
+uint64_t RenderHeapPool::GetSizeClass(uint64_t Size, uint64_t Alignment)
+{
+	uint64_t Class = MinSizeClass;
+
+	if (Size > MinSizeClass)
+	{
+		// Classes between two powers of two are a quarter of the lower one apart
+		uint64_t Step = MinSizeClass;
+
+		while (Step * 2 <= Size)
+			Step *= 2;
+
+		Step /= 4;
+		Class = (Size + Step - 1) / Step * Step;
+	}
+
+	if (Alignment > 1)
+		Class = (Class + Alignment - 1) / Alignment * Alignment;
+
+	return Class;
+}
+
+RenderHeap RenderHeapPool::Acquire(RenderHeapKind Kind, uint64_t Size, uint64_t Alignment)
+{
+	const uint64_t ClassSize = GetSizeClass(Size, Alignment);
+	const uint64_t CompletedFrame = Backend.GetCompletedFrame();
+	PooledHeap* Best = nullptr;
+
+	for (PooledHeap& Pooled : Heaps)
+	{
+		if (!Pooled.Free || Pooled.Kind != Kind || Pooled.ReleaseFrame > CompletedFrame)
+			continue;
+
+		// Much larger heaps stay for the sizes they were made for
+		if (Pooled.Size < Size || Pooled.Size >= ClassSize * 2 || Pooled.Alignment < Alignment)
+			continue;
+
+		if (!Best || Pooled.Size < Best->Size)
+			Best = &Pooled;
+	}
+
+	if (Best)
+	{
+		Best->Free = false;
+		++PoolStats.HitCount;
+		return Best->Heap;
+	}
+
+	const RenderHeap Heap = Backend.CreateHeap(Kind, ClassSize, Alignment);
+
+	if (Heap == RenderNullHandle)
+		return RenderNullHandle;
+
+	Heaps.push_back({ Heap, Kind, ClassSize, Alignment, false, 0 });
+	++PoolStats.MissCount;
+	PoolStats.CreatedSize += ClassSize;
+
+	return Heap;
+}
+
+void RenderHeapPool::Release(RenderHeap Heap)
+{
+	for (PooledHeap& Pooled : Heaps)
+	{
+		if (Pooled.Heap == Heap)
+		{
+			Pooled.Free = true;
+			Pooled.ReleaseFrame = Backend.GetFrameNumber();
+			return;
+		}
+	}
+}
+
+void RenderHeapPool::Trim()
+{
+	const uint64_t FrameNumber = Backend.GetFrameNumber();
+	uint64_t FreeSize = GetFreeSize();
+
+	// Oldest first, until the oldest left is recent enough and the free heaps fit the budget
+	for (;;)
+	{
+		auto Oldest = Heaps.end();
+
+		for (auto Pooled = Heaps.begin(); Pooled != Heaps.end(); ++Pooled)
+		{
+			if (Pooled->Free && (Oldest == Heaps.end() || Pooled->ReleaseFrame < Oldest->ReleaseFrame))
+				Oldest = Pooled;
+		}
+
+		if (Oldest == Heaps.end() || (FrameNumber - Oldest->ReleaseFrame <= MaxIdleFrames && FreeSize <= MaxFreeSize))
+			break;
+
+		FreeSize -= Oldest->Size;
+		Backend.ReleaseHeap(Oldest->Heap);
+		++PoolStats.TrimCount;
+
+		Heaps.erase(Oldest);
+	}
+}
+
+uint64_t RenderHeapPool::GetUsedSize() const
+{
+	uint64_t Size = 0;
+
+	for (const PooledHeap& Pooled : Heaps)
+	{
+		if (!Pooled.Free)
+			Size += Pooled.Size;
+	}
+
+	return Size;
+}
+
+uint64_t RenderHeapPool::GetFreeSize() const
+{
+	uint64_t Size = 0;
+
+	for (const PooledHeap& Pooled : Heaps)
+	{
+		if (Pooled.Free)
+			Size += Pooled.Size;
+	}
+
+	return Size;
+}
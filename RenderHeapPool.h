@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RenderBackend.h"
+
+// Placed-resource heaps handed back by a frame graph that is compiled again, typically at every size the window
+// goes through while it is resized, kept for the next compile instead of going back to the driver. Heaps are
+// created in size classes a quarter of a power of two apart, so a heap fits every size of its class and wastes at
+// most a quarter of it. A released heap is handed out again once the frames that used it have completed; heaps
+// unused for MaxIdleFrames, and the oldest ones past MaxFreeSize, are released to the backend by Trim.
+class RenderHeapPool
+{
+public:
+	struct Stats
+	{
+		uint32_t HitCount = 0;     // Acquire calls served by a pooled heap
+		uint32_t MissCount = 0;    // Acquire calls that created a heap
+		uint32_t TrimCount = 0;    // heaps released to the backend
+		uint64_t CreatedSize = 0;  // bytes of all heaps created
+	};
+
+	// Smallest heap created
+	static constexpr uint64_t MinSizeClass = 64 * 1024;
+
+	explicit RenderHeapPool(RenderBackend& Backend, uint32_t MaxIdleFrames = 120, uint64_t MaxFreeSize = 256ull * 1024 * 1024);
+
+	RenderHeapPool(const RenderHeapPool&) = delete;
+	RenderHeapPool& operator=(const RenderHeapPool&) = delete;
+
+	// Size rounded up to its class, then to Alignment
+	static uint64_t GetSizeClass(uint64_t Size, uint64_t Alignment);
+
+	// Smallest free heap of Kind at least Size large, aligned to at least Alignment and less than twice the class
+	// of Size, else a new heap of that class. RenderNullHandle when the backend cannot create it.
+	RenderHeap Acquire(RenderHeapKind Kind, uint64_t Size, uint64_t Alignment);
+	// Heap from Acquire whose placed resources have been released, reusable after the current frame
+	void Release(RenderHeap Heap);
+	// Once per frame
+	void Trim();
+
+	const Stats& GetStats() const { return PoolStats; }
+	// Bytes of the heaps acquired and of the free ones
+	uint64_t GetUsedSize() const;
+	uint64_t GetFreeSize() const;
+
+private:
+	struct PooledHeap
+	{
+		RenderHeap Heap;
+		RenderHeapKind Kind;
+		uint64_t Size;
+		uint64_t Alignment;
+		bool Free;
+		uint64_t ReleaseFrame; // frame number when it was released
+	};
+
+	RenderBackend& Backend;
+	uint32_t MaxIdleFrames;
+	uint64_t MaxFreeSize;
+
+	std::vector<PooledHeap> Heaps;
+	Stats PoolStats;
+};
@@ -0,0 +1,315 @@
+#include "ResolveBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <new>
+
+#include "CPUParallel.h"
+#include "CPUResolve.h"
+#include "CPUResolveKernels.h"
+
+uint32_t GetDepthFormatSampleSize(RenderFormat Format)
+{
+	const RenderDepthFormatInfo* Info = GetRenderDepthFormatInfo(Format);
+	return Info ? Info->SampleSize : 0;
+}
+
+const char* GetResolveBenchmarkFormatName(RenderFormat Format)
+{
+	const RenderDepthFormatInfo* Info = GetRenderDepthFormatInfo(Format);
+	return Info ? Info->Name : "UNKNOWN";
+}
+
+const char* GetResolveBenchmarkModeName(RenderResolveMode Mode)
+{
+	switch (Mode)
+	{
+	case RENDER_RESOLVE_MODE_MIN: return "MIN";
+	case RENDER_RESOLVE_MODE_MAX: return "MAX";
+	case RENDER_RESOLVE_MODE_AVERAGE: return "AVERAGE";
+	default: return "DECOMPRESS";
+	}
+}
+
+static CPUDepthFormat GetCPUDepthFormat(RenderFormat Format)
+{
+	switch (Format)
+	{
+	case RENDER_FORMAT_D32_FLOAT: return CPU_DEPTH_FORMAT_D32_FLOAT;
+	case RENDER_FORMAT_D24_UNORM_S8_UINT: return CPU_DEPTH_FORMAT_D24_UNORM_S8_UINT;
+	case RENDER_FORMAT_D16_UNORM: return CPU_DEPTH_FORMAT_D16_UNORM;
+	default: return CPU_DEPTH_FORMAT_D32_FLOAT_S8X24_UINT;
+	}
+}
+
+CPUResolveBenchmarkEngine::CPUResolveBenchmarkEngine(CPUThreadPool& Pool) : Pool(Pool)
+{
+	char Buffer[64];
+	snprintf(Buffer, sizeof(Buffer), "CPU %s, %u threads", GetBestCPUResolveKernels8x().Name, Pool.GetThreadCount());
+	Name = Buffer;
+}
+
+bool CPUResolveBenchmarkEngine::IsSupported(const ResolveBenchmarkConfig& Config, const char*& Why)
+{
+	if (!GetRenderDepthFormatInfo(Config.Format))
+	{
+		Why = "format";
+		return false;
+	}
+
+	if (Config.Mode == RENDER_RESOLVE_MODE_DECOMPRESS)
+	{
+		Why = "mode";
+		return false;
+	}
+
+	return true;
+}
+
+bool CPUResolveBenchmarkEngine::Prepare(const ResolveBenchmarkConfig& NewConfig)
+{
+	const CPUDepthFormat Format = GetCPUDepthFormat(NewConfig.Format);
+	const bool SameSource = Source.Width == NewConfig.Width && Source.Height == NewConfig.Height && Source.SampleCount == NewConfig.SampleCount && Source.Format == Format;
+	Config = NewConfig;
+
+	if (SameSource)
+		return true;
+
+	try
+	{
+		// Drops the previous surfaces first so two large ones are never alive at once
+		Source = CPUDepthSurface();
+		Destination = CPUResolvedDepth();
+		Source.Allocate(Config.Width, Config.Height, Config.SampleCount, Format);
+		Destination.Allocate(Config.Width, Config.Height);
+	}
+	catch (const std::bad_alloc&)
+	{
+		Source = CPUDepthSurface();
+		Destination = CPUResolvedDepth();
+		return false;
+	}
+
+	// A covered rectangle over the clear depth, sloped so no two texels match, crossed by edges every 32 rows and
+	// columns whose samples alternate between the rectangle and the clear depth
+	const uint32_t Left = Config.Width / 4, Right = Config.Width * 3 / 4;
+	const uint32_t Top = Config.Height / 4, Bottom = Config.Height * 3 / 4;
+
+	CPUDispatchDepthFormat(Format, [&](auto Traits)
+	{
+		typedef typename decltype(Traits)::Sample Sample;
+
+		Pool.ParallelFor(Config.Height, [&](uint32_t y)
+		{
+			for (uint32_t x = 0; x < Config.Width; ++x)
+			{
+				Sample* Samples = Source.GetPixel<Sample>(x, y);
+				const bool Covered = x >= Left && x < Right && y >= Top && y < Bottom;
+				const bool Edge = Covered && (x == Left || x == Right - 1 || y == Top || y == Bottom - 1 || x % 32 == 0 || y % 32 == 0);
+				const float Depth = 0.25f + 0.5f * static_cast<float>(x + y) / static_cast<float>(Config.Width + Config.Height);
+
+				for (uint32_t i = 0; i < Config.SampleCount; ++i)
+					Samples[i] = decltype(Traits)::Make(Covered && !(Edge && i % 2 == 1) ? Depth : 1.0f, 0);
+			}
+		});
+	});
+
+	return true;
+}
+
+double CPUResolveBenchmarkEngine::Resolve()
+{
+	const CPUResolveMode Mode = Config.Mode == RENDER_RESOLVE_MODE_MIN ? CPU_RESOLVE_MODE_MIN : (Config.Mode == RENDER_RESOLVE_MODE_MAX ? CPU_RESOLVE_MODE_MAX : CPU_RESOLVE_MODE_AVERAGE);
+	const auto Begin = std::chrono::high_resolution_clock::now();
+
+	if (!Config.Regions)
+	{
+		CPUResolveDepthRegion(Destination, 0, 0, Source, nullptr, Mode, &Pool);
+	}
+	else
+	{
+		for (uint32_t y = 0; y < Config.Height; y += ResolveBenchmarkRegionSize)
+		{
+			for (uint32_t x = 0; x < Config.Width; x += ResolveBenchmarkRegionSize)
+			{
+				const CPURect Rect = { static_cast<int32_t>(x), static_cast<int32_t>(y), static_cast<int32_t>(std::min(x + ResolveBenchmarkRegionSize, Config.Width)), static_cast<int32_t>(std::min(y + ResolveBenchmarkRegionSize, Config.Height)) };
+				CPUResolveDepthRegion(Destination, x, y, Source, &Rect, Mode, &Pool);
+			}
+		}
+	}
+
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - Begin).count();
+}
+
+uint64_t CPUResolveBenchmarkEngine::GetTrafficBytes(const ResolveBenchmarkConfig& Config) const
+{
+	const uint64_t PixelCount = static_cast<uint64_t>(Config.Width) * Config.Height;
+	return PixelCount * Config.SampleCount * GetDepthFormatSampleSize(Config.Format) + PixelCount * sizeof(float);
+}
+
+// Nearest rank of sorted Times
+static double GetPercentile(const std::vector<double>& Times, double Percentile)
+{
+	const size_t Rank = static_cast<size_t>(Percentile / 100.0 * Times.size() + 0.999999);
+	return Times[std::clamp<size_t>(Rank, 1, Times.size()) - 1];
+}
+
+static ResolveBenchmarkResult RunConfig(ResolveBenchmarkEngine& Engine, const ResolveBenchmarkSettings& Settings, const ResolveBenchmarkConfig& Config)
+{
+	ResolveBenchmarkResult Result;
+	Result.Config = Config;
+
+	const char* Why = "";
+	const uint64_t SourceBytes = static_cast<uint64_t>(Config.Width) * Config.Height * Config.SampleCount * GetDepthFormatSampleSize(Config.Format);
+
+	if (!Engine.IsSupported(Config, Why))
+	{
+		Result.Skipped = std::string("unsupported ") + Why;
+		return Result;
+	}
+
+	if (SourceBytes > Settings.MaxSourceBytes || !Engine.Prepare(Config))
+	{
+		Result.Skipped = "out of memory";
+		return Result;
+	}
+
+	for (uint32_t i = 0; i < Settings.WarmupCount; ++i)
+		Engine.Resolve();
+
+	std::vector<double> Times(std::max(1u, Settings.RepetitionCount));
+
+	for (double& Time : Times)
+		Time = Engine.Resolve();
+
+	std::sort(Times.begin(), Times.end());
+
+	Result.Minimum = Times.front();
+	Result.Median = GetPercentile(Times, 50.0);
+	Result.Percentile90 = GetPercentile(Times, 90.0);
+	Result.Percentile99 = GetPercentile(Times, 99.0);
+
+	for (double Time : Times)
+		Result.Mean += Time / Times.size();
+
+	const double Seconds = std::max(Result.Median, 1e-9) / 1000.0;
+	Result.GigabytesPerSecond = Engine.GetTrafficBytes(Config) / Seconds / 1e9;
+	Result.NanosecondsPerPixel = Seconds * 1e9 / (static_cast<double>(Config.Width) * Config.Height);
+
+	return Result;
+}
+
+bool MeasureUniformResolve(const CPUDepthSurface& Source, CPUResolveMode Mode, uint32_t RepetitionCount, CPUThreadPool& Pool, UniformResolveReport& Report)
+{
+	if (Source.UniformPixels.empty())
+		return false;
+
+	Report.PixelCount = Source.UniformPixels.size();
+	Report.EdgePixelCount = std::count(Source.UniformPixels.begin(), Source.UniformPixels.end(), static_cast<uint8_t>(0));
+
+	CPUDepthSurface Full = Source;
+	Full.UniformPixels.clear();
+
+	CPUResolvedDepth Destination;
+	Destination.Allocate(Source.Width, Source.Height);
+
+	std::vector<double> FullTimes(std::max(1u, RepetitionCount));
+	std::vector<double> UniformTimes(FullTimes.size());
+
+	// Interleaved so both see the same cache and clock state
+	for (size_t i = 0; i < FullTimes.size(); ++i)
+	{
+		auto Begin = std::chrono::high_resolution_clock::now();
+		CPUResolveDepthRegion(Destination, 0, 0, Full, nullptr, Mode, &Pool);
+		FullTimes[i] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - Begin).count();
+
+		Begin = std::chrono::high_resolution_clock::now();
+		CPUResolveDepthRegion(Destination, 0, 0, Source, nullptr, Mode, &Pool);
+		UniformTimes[i] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - Begin).count();
+	}
+
+	std::sort(FullTimes.begin(), FullTimes.end());
+	std::sort(UniformTimes.begin(), UniformTimes.end());
+
+	Report.FullMilliseconds = GetPercentile(FullTimes, 50.0);
+	Report.UniformMilliseconds = GetPercentile(UniformTimes, 50.0);
+	return true;
+}
+
+ResolveBenchmarkRun RunResolveBenchmark(ResolveBenchmarkEngine& Engine, const ResolveBenchmarkSettings& Settings)
+{
+	ResolveBenchmarkRun Run;
+	Run.Engine = Engine.GetName();
+
+	printf("Resolve benchmark on %s\n", Run.Engine.c_str());
+
+	for (uint32_t Height : Settings.Heights)
+	for (uint32_t SampleCount : Settings.SampleCounts)
+	for (RenderFormat Format : Settings.Formats)
+	for (RenderResolveMode Mode : Settings.Modes)
+	for (bool Regions : { false, true })
+	{
+		const ResolveBenchmarkConfig Config = { Height * 16 / 9, Height, SampleCount, Format, Mode, Regions };
+		const ResolveBenchmarkResult Result = RunConfig(Engine, Settings, Config);
+
+		printf("  %ux%u %2ux %-20s %-7s %-7s ", Config.Width, Config.Height, SampleCount, GetResolveBenchmarkFormatName(Format), GetResolveBenchmarkModeName(Mode), Regions ? "regions" : "full");
+
+		if (Result.Skipped.empty())
+			printf("%8.3f ms median, %8.3f ms p90, %6.1f GB/s, %.3f ns/pixel\n", Result.Median, Result.Percentile90, Result.GigabytesPerSecond, Result.NanosecondsPerPixel);
+		else
+			printf("skipped, %s\n", Result.Skipped.c_str());
+
+		Run.Results.push_back(Result);
+	}
+
+	return Run;
+}
+
+bool WriteResolveBenchmarkJSON(const std::string& Path, const ResolveBenchmarkSettings& Settings, const std::vector<ResolveBenchmarkRun>& Runs)
+{
+	std::ofstream Stream(Path, std::ios::trunc);
+
+	char Line[512];
+
+	snprintf(Line, sizeof(Line), "{\n  \"warmup\": %u,\n  \"repetitions\": %u,\n  \"region_size\": %u,\n  \"runs\": [\n", Settings.WarmupCount, Settings.RepetitionCount, ResolveBenchmarkRegionSize);
+	Stream << Line;
+
+	for (size_t r = 0; r < Runs.size(); ++r)
+	{
+		// Engine names are ours, nothing in them needs escaping
+		Stream << "    {\n      \"engine\": \"" << Runs[r].Engine << "\",\n      \"results\": [\n";
+
+		for (size_t i = 0; i < Runs[r].Results.size(); ++i)
+		{
+			const ResolveBenchmarkResult& Result = Runs[r].Results[i];
+			const ResolveBenchmarkConfig& Config = Result.Config;
+
+			snprintf(Line, sizeof(Line), "        { \"width\": %u, \"height\": %u, \"samples\": %u, \"format\": \"%s\", \"mode\": \"%s\", \"regions\": %s, ",
+				Config.Width, Config.Height, Config.SampleCount, GetResolveBenchmarkFormatName(Config.Format), GetResolveBenchmarkModeName(Config.Mode), Config.Regions ? "true" : "false");
+			Stream << Line;
+
+			if (Result.Skipped.empty())
+				snprintf(Line, sizeof(Line), "\"ms\": { \"min\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"mean\": %.4f }, \"gb_per_s\": %.3f, \"ns_per_pixel\": %.4f }",
+					Result.Minimum, Result.Median, Result.Percentile90, Result.Percentile99, Result.Mean, Result.GigabytesPerSecond, Result.NanosecondsPerPixel);
+			else
+				snprintf(Line, sizeof(Line), "\"skipped\": \"%s\" }", Result.Skipped.c_str());
+
+			Stream << Line << (i + 1 < Runs[r].Results.size() ? ",\n" : "\n");
+		}
+
+		Stream << "      ]\n    }" << (r + 1 < Runs.size() ? ",\n" : "\n");
+	}
+
+	Stream << "  ]\n}\n";
+	Stream.close();
+
+	if (Stream.fail())
+	{
+		printf("Resolve benchmark: could not write %s\n", Path.c_str());
+		return false;
+	}
+
+	return true;
+}
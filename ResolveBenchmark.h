@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "RenderBackend.h"
+#include "CPUDepthSurface.h"
+#include "CPUResolve.h"
+
+class CPUThreadPool;
+
+struct ResolveBenchmarkConfig
+{
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t SampleCount;
+	// Depth-stencil format of the multisampled source
+	RenderFormat Format;
+	RenderResolveMode Mode;
+	// Resolves the surface as ResolveBenchmarkRegionSize squares, one ResolveSubresourceRegion each, instead of in one call
+	bool Regions;
+};
+
+// Side of the sub-rectangles of ResolveBenchmarkConfig::Regions
+constexpr uint32_t ResolveBenchmarkRegionSize = 256;
+
+// Something that resolves depth, timed one configuration at a time
+class ResolveBenchmarkEngine
+{
+public:
+	virtual ~ResolveBenchmarkEngine() = default;
+
+	virtual const char* GetName() const = 0;
+	// False when the engine cannot resolve Config at all, Why tells the reason
+	virtual bool IsSupported(const ResolveBenchmarkConfig& Config, const char*& Why) = 0;
+	// Creates the source and the destination of Config and fills the source. False when they do not fit in memory.
+	virtual bool Prepare(const ResolveBenchmarkConfig& Config) = 0;
+	// Resolves the whole surface once and returns how long it took
+	virtual double Resolve() = 0;
+	// Bytes Resolve reads and writes
+	virtual uint64_t GetTrafficBytes(const ResolveBenchmarkConfig& Config) const = 0;
+};
+
+// CPUResolveDepthRegion on a pool, on surfaces that store the samples of each format as the GPU does
+class CPUResolveBenchmarkEngine : public ResolveBenchmarkEngine
+{
+public:
+	explicit CPUResolveBenchmarkEngine(CPUThreadPool& Pool);
+
+	const char* GetName() const override { return Name.c_str(); }
+	bool IsSupported(const ResolveBenchmarkConfig& Config, const char*& Why) override;
+	bool Prepare(const ResolveBenchmarkConfig& Config) override;
+	double Resolve() override;
+	uint64_t GetTrafficBytes(const ResolveBenchmarkConfig& Config) const override;
+
+private:
+	CPUThreadPool& Pool;
+	std::string Name;
+
+	ResolveBenchmarkConfig Config = {};
+	CPUDepthSurface Source;
+	CPUResolvedDepth Destination;
+};
+
+struct ResolveBenchmarkSettings
+{
+	std::vector<uint32_t> Heights = { 720, 1080, 1440, 2160, 4320 }; // 16:9
+	std::vector<uint32_t> SampleCounts = { 2, 4, 8, 16 };
+	std::vector<RenderFormat> Formats = { RENDER_FORMAT_D32_FLOAT, RENDER_FORMAT_D32_FLOAT_S8X24_UINT, RENDER_FORMAT_D24_UNORM_S8_UINT, RENDER_FORMAT_D16_UNORM };
+	std::vector<RenderResolveMode> Modes = { RENDER_RESOLVE_MODE_MIN, RENDER_RESOLVE_MODE_MAX, RENDER_RESOLVE_MODE_AVERAGE };
+	uint32_t WarmupCount = 3;
+	uint32_t RepetitionCount = 20;
+	// Configurations whose source is larger are skipped
+	uint64_t MaxSourceBytes = 2ull * 1024 * 1024 * 1024;
+};
+
+struct ResolveBenchmarkResult
+{
+	ResolveBenchmarkConfig Config;
+	// Empty when the configuration ran, else why it did not
+	std::string Skipped;
+	// Milliseconds over the repetitions
+	double Minimum = 0.0;
+	double Median = 0.0;
+	double Percentile90 = 0.0;
+	double Percentile99 = 0.0;
+	double Mean = 0.0;
+	// At the median
+	double GigabytesPerSecond = 0.0;
+	double NanosecondsPerPixel = 0.0;
+};
+
+struct ResolveBenchmarkRun
+{
+	std::string Engine;
+	std::vector<ResolveBenchmarkResult> Results;
+};
+
+// Times every combination of the settings, full resolves and sub-rectangles, on Engine. Each configuration is resolved
+// WarmupCount times untimed and then RepetitionCount times timed, and printed as it finishes.
+ResolveBenchmarkRun RunResolveBenchmark(ResolveBenchmarkEngine& Engine, const ResolveBenchmarkSettings& Settings);
+
+// One JSON object with the settings and the results of every run, to Path
+bool WriteResolveBenchmarkJSON(const std::string& Path, const ResolveBenchmarkSettings& Settings, const std::vector<ResolveBenchmarkRun>& Runs);
+
+struct UniformResolveReport
+{
+	uint64_t PixelCount = 0;
+	// Pixels CPUDepthSurface::UniformPixels does not mark, the resolve reduces all their samples
+	uint64_t EdgePixelCount = 0;
+	// Median milliseconds of a whole-surface CPUResolveDepthRegion, without and with the mask
+	double FullMilliseconds = 0.0;
+	double UniformMilliseconds = 0.0;
+};
+
+// Edge pixels of Source and what resolving only them saves: Source is resolved RepetitionCount times as it is and as
+// many times through a copy without its mask. False when Source does not track its uniform pixels.
+bool MeasureUniformResolve(const CPUDepthSurface& Source, CPUResolveMode Mode, uint32_t RepetitionCount, CPUThreadPool& Pool, UniformResolveReport& Report);
+
+// Bytes of one sample of a depth-stencil format, 0 for other formats
+uint32_t GetDepthFormatSampleSize(RenderFormat Format);
+const char* GetResolveBenchmarkFormatName(RenderFormat Format);
+const char* GetResolveBenchmarkModeName(RenderResolveMode Mode);
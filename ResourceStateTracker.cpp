@@ -0,0 +1,155 @@
+#include "ResourceStateTracker.h"
+
+void ResourceStateTracker::Track(RenderResource Resource, RenderResourceState State)
+{
+	if (Resource == RenderNullHandle)
+		return;
+
+	if (Resource >= Resources.size())
+		Resources.resize(Resource + 1);
+
+	TrackedResource& Tracked = Resources[Resource];
+
+	// A queued transition would start from the old state
+	if (Tracked.PendingTransition != NoBarrier)
+	{
+		Pending[Tracked.PendingTransition].Resource = RenderNullHandle;
+		Tracked.PendingTransition = NoBarrier;
+	}
+
+	Tracked.Tracked = true;
+	Tracked.State = State;
+}
+
+void ResourceStateTracker::Untrack(RenderResource Resource)
+{
+	if (Resource < Resources.size())
+		Resources[Resource] = TrackedResource();
+}
+
+bool ResourceStateTracker::IsTracked(RenderResource Resource) const
+{
+	return Resource < Resources.size() && Resources[Resource].Tracked;
+}
+
+RenderResourceState ResourceStateTracker::GetState(RenderResource Resource) const
+{
+	return IsTracked(Resource) ? Resources[Resource].State : RENDER_RESOURCE_STATE_COMMON;
+}
+
+bool ResourceStateTracker::IsSatisfied(RenderResourceState Current, RenderResourceState Requested)
+{
+	if (Current == Requested)
+		return true;
+
+	// A combination of read states serves a read of any part of it
+	return (Current & ~ReadOnlyStates) == 0 && (Requested & ~ReadOnlyStates) == 0 && (Current & Requested) == Requested && Requested != 0;
+}
+
+bool ResourceStateTracker::Transition(RenderResource Resource, RenderResourceState State)
+{
+	if (!IsTracked(Resource))
+		return false;
+
+	TrackedResource& Tracked = Resources[Resource];
+	++TrackerStats.Requests;
+
+	if (IsSatisfied(Tracked.State, State))
+		return true;
+
+	if (Tracked.PendingTransition != NoBarrier)
+	{
+		RenderBarrier& Barrier = Pending[Tracked.PendingTransition];
+
+		// Back to where the resource was before the flush, the round trip needs no barrier at all
+		if (IsSatisfied(Barrier.Before, State))
+		{
+			Tracked.State = Barrier.Before;
+			Tracked.PendingTransition = NoBarrier;
+			Barrier.Resource = RenderNullHandle;
+		}
+		else
+		{
+			Barrier.After = State;
+			Tracked.State = State;
+		}
+
+		return true;
+	}
+
+	Tracked.PendingTransition = static_cast<uint32_t>(Pending.size());
+	Tracked.PendingUAV = NoBarrier;
+	Pending.push_back(RenderBarrier::Transition(Resource, Tracked.State, State));
+	Tracked.State = State;
+
+	return true;
+}
+
+bool ResourceStateTracker::UAVBarrier(RenderResource Resource)
+{
+	if (!IsTracked(Resource))
+		return false;
+
+	TrackedResource& Tracked = Resources[Resource];
+	++TrackerStats.Requests;
+
+	if (Tracked.PendingUAV != NoBarrier)
+		return true;
+
+	// Transitions requested after this barrier must stay after it
+	Tracked.PendingTransition = NoBarrier;
+	Tracked.PendingUAV = static_cast<uint32_t>(Pending.size());
+	Pending.push_back(RenderBarrier::UnorderedAccess(Resource));
+
+	return true;
+}
+
+bool ResourceStateTracker::AliasingBarrier(RenderResource Resource)
+{
+	if (!IsTracked(Resource))
+		return false;
+
+	TrackedResource& Tracked = Resources[Resource];
+	++TrackerStats.Requests;
+
+	Tracked.PendingTransition = NoBarrier;
+	Tracked.PendingUAV = NoBarrier;
+	Pending.push_back(RenderBarrier::Aliasing(Resource));
+
+	return true;
+}
+
+uint32_t ResourceStateTracker::GetPendingCount() const
+{
+	uint32_t Count = 0;
+
+	for (const RenderBarrier& Barrier : Pending)
+		Count += Barrier.Resource != RenderNullHandle;
+
+	return Count;
+}
+
+void ResourceStateTracker::Flush(RenderCommandList& CommandList)
+{
+	uint32_t Count = 0;
+
+	for (const RenderBarrier& Barrier : Pending)
+	{
+		if (Barrier.Resource == RenderNullHandle)
+			continue;
+
+		Resources[Barrier.Resource].PendingTransition = NoBarrier;
+		Resources[Barrier.Resource].PendingUAV = NoBarrier;
+		Pending[Count++] = Barrier;
+	}
+
+	if (Count > 0)
+	{
+		CommandList.ResourceBarrier(Count, Pending.data());
+
+		TrackerStats.Barriers += Count;
+		++TrackerStats.BarrierCalls;
+	}
+
+	Pending.clear();
+}
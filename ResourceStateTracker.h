@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RenderBackend.h"
+
+// Keeps the current state of every tracked resource so passes only say which state they need next.
+// Requests are queued until Flush, which issues them as a single ResourceBarrier call. While queued, transitions of
+// the same resource merge (A->B then B->C becomes A->C, A->B then B->A disappears), requests already satisfied by the
+// current state are dropped, and a read state contained in the current combination of read states needs no barrier.
+// Flush before the work that relies on the requested states; nothing may use a resource between its request and the flush.
+class ResourceStateTracker
+{
+public:
+	struct Stats
+	{
+		uint32_t Requests = 0;      // Transition, UAVBarrier and AliasingBarrier calls
+		uint32_t Barriers = 0;      // barriers issued
+		uint32_t BarrierCalls = 0;  // ResourceBarrier calls issued
+	};
+
+	// Starts tracking Resource in State, or overrides the tracked state of a resource changed outside the tracker
+	void Track(RenderResource Resource, RenderResourceState State);
+	void Untrack(RenderResource Resource);
+	bool IsTracked(RenderResource Resource) const;
+
+	// State the resource is in once the queued barriers are issued, COMMON for resources not tracked
+	RenderResourceState GetState(RenderResource Resource) const;
+
+	// Both return false for resources not tracked
+	bool Transition(RenderResource Resource, RenderResourceState State);
+	// Orders unordered access work before and after the flush; repeated requests for one resource merge
+	bool UAVBarrier(RenderResource Resource);
+	// Activates a placed resource sharing memory with others; transitions requested afterwards are issued after it
+	bool AliasingBarrier(RenderResource Resource);
+
+	uint32_t GetPendingCount() const;
+	void Flush(RenderCommandList& CommandList);
+
+	const Stats& GetStats() const { return TrackerStats; }
+	void ResetStats() { TrackerStats = Stats(); }
+
+	// States no write is done in, any combination of them can be held at once
+	static constexpr uint32_t ReadOnlyStates = RENDER_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER | RENDER_RESOURCE_STATE_INDEX_BUFFER | RENDER_RESOURCE_STATE_DEPTH_READ |
+		RENDER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | RENDER_RESOURCE_STATE_INDIRECT_ARGUMENT |
+		RENDER_RESOURCE_STATE_COPY_SOURCE | RENDER_RESOURCE_STATE_RESOLVE_SOURCE;
+
+private:
+	static constexpr uint32_t NoBarrier = UINT32_MAX;
+
+	struct TrackedResource
+	{
+		bool Tracked = false;
+		RenderResourceState State = RENDER_RESOURCE_STATE_COMMON;
+		uint32_t PendingTransition = NoBarrier; // index in Pending
+		uint32_t PendingUAV = NoBarrier;
+	};
+
+	static bool IsSatisfied(RenderResourceState Current, RenderResourceState Requested);
+
+	std::vector<TrackedResource> Resources; // indexed by handle
+	std::vector<RenderBarrier> Pending;     // merged away entries have Resource == RenderNullHandle
+	Stats TrackerStats;
+};
@@ -0,0 +1,182 @@
+#include "SamplePatternBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "CPUParallel.h"
+#include "CPURasterizer.h"
+#include "CPUResolve.h"
+#include "CubeMesh.h"
+
+// Reference pixels per benchmark pixel in each direction
+constexpr uint32_t ReferenceScale = 4;
+constexpr uint32_t ReferenceSampleCount = 16;
+
+const char* GetSamplePatternName(SamplePatternKind Pattern)
+{
+	return Pattern == SAMPLE_PATTERN_ROTATED_QUAD ? "rotated quad" : "standard";
+}
+
+// Standard positions turned by 90 degrees per quad pixel; -8 has no positive counterpart and becomes 7
+static void GetRotatedQuadPositions(uint32_t SampleCount, CPUSamplePosition* Positions)
+{
+	const CPUSamplePosition* Standard = GetStandardSamplePositions(SampleCount);
+
+	for (uint32_t QuadPixel = 0; QuadPixel < 4; ++QuadPixel)
+	{
+		for (uint32_t s = 0; s < SampleCount; ++s)
+		{
+			CPUSamplePosition Position = Standard[s];
+
+			for (uint32_t Turn = 0; Turn < QuadPixel; ++Turn)
+				Position = { static_cast<int8_t>(std::min(-Position.Y, 7)), Position.X };
+
+			Positions[QuadPixel * SampleCount + s] = Position;
+		}
+	}
+}
+
+// Fraction of the samples of every pixel of a D32_FLOAT surface in front of the clear depth of 1
+static std::vector<float> GetCoverage(const CPUDepthSurface& Surface)
+{
+	std::vector<float> Coverage(static_cast<size_t>(Surface.Width) * Surface.Height);
+
+	for (uint32_t y = 0; y < Surface.Height; ++y)
+	{
+		for (uint32_t x = 0; x < Surface.Width; ++x)
+		{
+			const float* Samples = Surface.GetPixel<float>(x, y);
+			uint32_t Covered = 0;
+
+			for (uint32_t s = 0; s < Surface.SampleCount; ++s)
+				Covered += Samples[s] < 1.0f;
+
+			Coverage[static_cast<size_t>(y) * Surface.Width + x] = static_cast<float>(Covered) / Surface.SampleCount;
+		}
+	}
+
+	return Coverage;
+}
+
+static double GetMedian(std::vector<double>& Times)
+{
+	std::sort(Times.begin(), Times.end());
+	return Times[Times.size() / 2];
+}
+
+// Clears Surface and draws the scene into it RepetitionCount times, returns the median draw time
+static double DrawScene(CPURasterizer& Rasterizer, CPUDepthSurface& Surface, const StressScene& Scene, uint32_t RepetitionCount)
+{
+	CPUDrawIndexedDesc Draw;
+	Draw.Vertices = CubeVertices;
+	Draw.VertexCount = CubeVertexCount;
+	Draw.Indices = CubeIndices;
+	Draw.IndexCount = CubeIndexCount;
+	Draw.TransformMatrix = Scene.ViewProjection;
+	Draw.InstanceCount = static_cast<uint32_t>(Scene.InstanceTransforms.size());
+	Draw.InstanceTransforms = Scene.InstanceTransforms.data();
+
+	std::vector<double> Times;
+
+	for (uint32_t Repetition = 0; Repetition < std::max(RepetitionCount, 1u); ++Repetition)
+	{
+		Surface.Clear(1.0f, 0);
+
+		const auto Begin = std::chrono::high_resolution_clock::now();
+		Rasterizer.DrawIndexed(Surface, Draw);
+		Times.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - Begin).count());
+	}
+
+	return GetMedian(Times);
+}
+
+std::vector<SamplePatternBenchmarkResult> RunSamplePatternBenchmark(const SamplePatternBenchmarkSettings& Settings, CPUThreadPool& Pool)
+{
+	std::vector<SamplePatternBenchmarkResult> Results;
+
+	if (Settings.Width == 0 || Settings.Height == 0)
+		return Results;
+
+	const StressScene Scene = GenerateStressScene(Settings.Scene, static_cast<float>(Settings.Width) / Settings.Height);
+	CPURasterizer Rasterizer(&Pool);
+
+	// Reference coverage of each pixel, the mean over a block of reference pixels
+	std::vector<float> ReferenceCoverage(static_cast<size_t>(Settings.Width) * Settings.Height, 0.0f);
+	{
+		CPUDepthSurface ReferenceSurface;
+		ReferenceSurface.Allocate(Settings.Width * ReferenceScale, Settings.Height * ReferenceScale, ReferenceSampleCount, CPU_DEPTH_FORMAT_D32_FLOAT);
+		DrawScene(Rasterizer, ReferenceSurface, Scene, 1);
+
+		const std::vector<float> BlockCoverage = GetCoverage(ReferenceSurface);
+
+		for (uint32_t y = 0; y < ReferenceSurface.Height; ++y)
+		{
+			for (uint32_t x = 0; x < ReferenceSurface.Width; ++x)
+				ReferenceCoverage[static_cast<size_t>(y / ReferenceScale) * Settings.Width + x / ReferenceScale] += BlockCoverage[static_cast<size_t>(y) * ReferenceSurface.Width + x] / (ReferenceScale * ReferenceScale);
+		}
+	}
+
+	for (uint32_t SampleCount : Settings.SampleCounts)
+	{
+		if (!GetStandardSamplePositions(SampleCount))
+			continue;
+
+		for (SamplePatternKind Pattern : Settings.Patterns)
+		{
+			CPUSamplePosition Positions[4 * CPUMaxSampleCount];
+			GetRotatedQuadPositions(SampleCount, Positions);
+
+			if (Pattern == SAMPLE_PATTERN_ROTATED_QUAD ? !Rasterizer.SetSamplePositions(SampleCount, 4, Positions) : !Rasterizer.SetSamplePositions(0, 0, nullptr))
+				continue;
+
+			SamplePatternBenchmarkResult Result;
+			Result.SampleCount = SampleCount;
+			Result.Pattern = Pattern;
+
+			CPUDepthSurface Surface;
+			Surface.Allocate(Settings.Width, Settings.Height, SampleCount, CPU_DEPTH_FORMAT_D32_FLOAT);
+			Result.SurfaceBytes = Surface.Samples.size();
+			Result.DrawMilliseconds = DrawScene(Rasterizer, Surface, Scene, Settings.RepetitionCount);
+
+			CPUResolvedDepth Resolved;
+			Resolved.Allocate(Settings.Width, Settings.Height);
+			std::vector<double> ResolveTimes;
+
+			for (uint32_t Repetition = 0; Repetition < std::max(Settings.RepetitionCount, 1u); ++Repetition)
+			{
+				const auto Begin = std::chrono::high_resolution_clock::now();
+				CPUResolveDepthRegion(Resolved, 0, 0, Surface, nullptr, CPU_RESOLVE_MODE_AVERAGE, &Pool);
+				ResolveTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - Begin).count());
+			}
+
+			Result.ResolveMilliseconds = GetMedian(ResolveTimes);
+
+			const std::vector<float> Coverage = GetCoverage(Surface);
+
+			for (size_t i = 0; i < Coverage.size(); ++i)
+			{
+				const bool Partial = (ReferenceCoverage[i] > 0.0f && ReferenceCoverage[i] < 1.0f) || (Coverage[i] > 0.0f && Coverage[i] < 1.0f);
+
+				if (!Partial)
+					continue;
+
+				const double Error = std::fabs(static_cast<double>(Coverage[i]) - ReferenceCoverage[i]);
+				Result.MeanError += Error;
+				Result.MaxError = std::max(Result.MaxError, Error);
+				++Result.EdgePixelCount;
+			}
+
+			Result.MeanError /= std::max<uint64_t>(Result.EdgePixelCount, 1);
+
+			printf("Sample patterns %2ux %-12s: draw %.3f ms, AVERAGE resolve %.3f ms, %.1f MB, coverage error mean %.4f max %.4f over %llu edge pixels\n", SampleCount, GetSamplePatternName(Pattern),
+				Result.DrawMilliseconds, Result.ResolveMilliseconds, Result.SurfaceBytes / (1024.0 * 1024.0), Result.MeanError, Result.MaxError, static_cast<unsigned long long>(Result.EdgePixelCount));
+
+			Results.push_back(Result);
+		}
+	}
+
+	Rasterizer.SetSamplePositions(0, 0, nullptr);
+	return Results;
+}
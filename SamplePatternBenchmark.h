@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "StressScene.h"
+
+class CPUThreadPool;
+
+enum SamplePatternKind
+{
+	SAMPLE_PATTERN_STANDARD,     // D3D standard positions in every pixel
+	SAMPLE_PATTERN_ROTATED_QUAD  // Tier 2: the standard positions turned by 90 degrees from one pixel of a 2x2 quad to the next
+};
+
+struct SamplePatternBenchmarkSettings
+{
+	uint32_t Width = 640;
+	uint32_t Height = 360;
+	StressSceneSettings Scene = { 2000, 4.0f, 0.7f, 1 };
+	std::vector<uint32_t> SampleCounts = { 2, 4, 8, 16 };
+	std::vector<SamplePatternKind> Patterns = { SAMPLE_PATTERN_STANDARD, SAMPLE_PATTERN_ROTATED_QUAD };
+	uint32_t RepetitionCount = 10;
+};
+
+struct SamplePatternBenchmarkResult
+{
+	uint32_t SampleCount;
+	SamplePatternKind Pattern;
+	// Median milliseconds of drawing the scene and of an AVERAGE resolve of it
+	double DrawMilliseconds = 0.0;
+	double ResolveMilliseconds = 0.0;
+	uint64_t SurfaceBytes = 0;
+	// Mean and largest absolute difference of the part of each pixel the scene covers, the fraction of its samples in
+	// front of the clear depth, from the reference, over the pixels either covers partly
+	double MeanError = 0.0;
+	double MaxError = 0.0;
+	uint64_t EdgePixelCount = 0;
+};
+
+// Draws the stress scene on the CPU rasterizer with every sample count and pattern, with CPURasterizer::SetSamplePositions
+// for the programmed ones, and compares the coverage of every pixel with a reference of 4x4 pixels of 16 standard
+// samples per pixel, so edge quality can be weighed against the draw and AVERAGE resolve cost of each count. Prints
+// each result as it finishes.
+std::vector<SamplePatternBenchmarkResult> RunSamplePatternBenchmark(const SamplePatternBenchmarkSettings& Settings, CPUThreadPool& Pool);
+
+const char* GetSamplePatternName(SamplePatternKind Pattern);
@@ -0,0 +1,178 @@
+#include "ShaderCompileService.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+// Reads "error X3004: Text", "warning: Text" or any other Text into Message
+static void ParseMessageBody(const std::string& Body, ShaderCompileMessage& Message)
+{
+	const size_t Start = Body.find_first_not_of(' ');
+
+	if (Start == std::string::npos)
+		return;
+
+	Message.Text = Body.substr(Start);
+
+	for (const auto& [Word, Severity] : { std::make_pair("error", SHADER_MESSAGE_ERROR), std::make_pair("warning", SHADER_MESSAGE_WARNING) })
+	{
+		const size_t Length = strlen(Word);
+		const size_t Colon = Body.find(':', Start);
+
+		if (Body.compare(Start, Length, Word) != 0 || Colon == std::string::npos)
+			continue;
+
+		// Nothing or a code of one word between the severity and the colon
+		const std::string Code = Body.substr(Start + Length, Colon - Start - Length);
+
+		if (!Code.empty() && (Code[0] != ' ' || Code.find(' ', 1) != std::string::npos))
+			continue;
+
+		Message.Severity = Severity;
+		Message.Code = Code.empty() ? Code : Code.substr(1);
+		Message.Text = Body.substr(std::min(Body.find_first_not_of(' ', Colon + 1), Body.size()));
+		return;
+	}
+}
+
+std::vector<ShaderCompileMessage> ParseShaderCompileLog(const std::string& Log)
+{
+	std::vector<ShaderCompileMessage> Messages;
+	size_t LineStart = 0;
+
+	while (LineStart < Log.size())
+	{
+		size_t LineEnd = Log.find('\n', LineStart);
+
+		if (LineEnd == std::string::npos)
+			LineEnd = Log.size();
+
+		std::string Line = Log.substr(LineStart, LineEnd - LineStart);
+		LineStart = LineEnd + 1;
+
+		while (!Line.empty() && (Line.back() == '\r' || Line.back() == ' ' || Line.back() == '\0'))
+			Line.pop_back();
+
+		if (Line.empty())
+			continue;
+
+		ShaderCompileMessage Message;
+		std::string Body = Line;
+
+		// Name(Line,Column): or Name(Line,Column-EndColumn): or Name(Line):
+		const size_t LocationEnd = Line.find("): ");
+		const size_t LocationStart = LocationEnd == std::string::npos ? std::string::npos : Line.rfind('(', LocationEnd);
+
+		if (LocationStart != std::string::npos)
+		{
+			const std::string Location = Line.substr(LocationStart + 1, LocationEnd - LocationStart - 1);
+
+			if (!Location.empty() && Location.find_first_not_of("0123456789,-") == std::string::npos)
+			{
+				Message.File = Line.substr(0, LocationStart);
+				Message.Line = static_cast<uint32_t>(strtoul(Location.c_str(), nullptr, 10));
+
+				const size_t Comma = Location.find(',');
+
+				if (Comma != std::string::npos)
+					Message.Column = static_cast<uint32_t>(strtoul(Location.c_str() + Comma + 1, nullptr, 10));
+
+				Body = Line.substr(LocationEnd + 2);
+			}
+		}
+
+		ParseMessageBody(Body, Message);
+		Messages.push_back(std::move(Message));
+	}
+
+	return Messages;
+}
+
+ShaderCompileService::ShaderCompileService(CompileFunction Compiler, uint32_t ThreadCount) : Compiler(std::move(Compiler))
+{
+	if (ThreadCount == 0)
+		ThreadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	Workers.reserve(ThreadCount);
+
+	for (uint32_t i = 0; i < ThreadCount; ++i)
+		Workers.emplace_back(&ShaderCompileService::WorkerLoop, this);
+}
+
+ShaderCompileService::~ShaderCompileService()
+{
+	{
+		std::lock_guard<std::mutex> Lock(QueueMutex);
+		ShuttingDown = true;
+	}
+
+	JobQueued.notify_all();
+
+	for (std::thread& Worker : Workers)
+		Worker.join();
+}
+
+std::shared_future<ShaderCompileResult> ShaderCompileService::Compile(ShaderCompileRequest Request)
+{
+	std::shared_future<ShaderCompileResult> Result;
+
+	{
+		std::lock_guard<std::mutex> Lock(QueueMutex);
+
+		Queue.push_back({ std::move(Request), std::promise<ShaderCompileResult>() });
+		Result = Queue.back().Result.get_future().share();
+	}
+
+	JobQueued.notify_one();
+	return Result;
+}
+
+void ShaderCompileService::WaitIdle()
+{
+	std::unique_lock<std::mutex> Lock(QueueMutex);
+	JobFinished.wait(Lock, [this] { return Queue.empty() && RunningCount == 0; });
+}
+
+uint32_t ShaderCompileService::GetPendingCount() const
+{
+	std::lock_guard<std::mutex> Lock(QueueMutex);
+	return static_cast<uint32_t>(Queue.size()) + RunningCount;
+}
+
+void ShaderCompileService::WorkerLoop()
+{
+	while (true)
+	{
+		Job Current;
+
+		{
+			std::unique_lock<std::mutex> Lock(QueueMutex);
+			JobQueued.wait(Lock, [this] { return ShuttingDown || !Queue.empty(); });
+
+			// Whatever was submitted still completes, so no future is left without a value
+			if (Queue.empty())
+				return;
+
+			Current = std::move(Queue.front());
+			Queue.pop_front();
+			++RunningCount;
+		}
+
+		const auto Begin = std::chrono::high_resolution_clock::now();
+
+		ShaderCompileResult Result = Compiler(Current.Request);
+
+		Result.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - Begin).count();
+		Result.Messages = ParseShaderCompileLog(Result.Log);
+
+		Current.Result.set_value(std::move(Result));
+
+		{
+			std::lock_guard<std::mutex> Lock(QueueMutex);
+			--RunningCount;
+		}
+
+		JobFinished.notify_all();
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ShaderCompileRequest
+{
+	std::string Source;
+	std::string Name;       // file name the messages refer to
+	std::string EntryPoint;
+	std::string Model;      // vs_5_0, ps_5_0, cs_5_0
+};
+
+enum ShaderMessageSeverity
+{
+	SHADER_MESSAGE_ERROR,
+	SHADER_MESSAGE_WARNING
+};
+
+// One line of compiler output in the "Name(Line,Column): error X3004: Text" form of fxc. Line and Column are 0 when
+// the message has no location, Code is empty when it has no code.
+struct ShaderCompileMessage
+{
+	ShaderMessageSeverity Severity = SHADER_MESSAGE_ERROR;
+	std::string File;
+	uint32_t Line = 0;
+	uint32_t Column = 0;
+	std::string Code;
+	std::string Text;
+};
+
+struct ShaderCompileResult
+{
+	bool Succeeded = false;
+	std::vector<uint8_t> Bytecode;
+	// Raw compiler output and the messages parsed from it, warnings included on success
+	std::string Log;
+	std::vector<ShaderCompileMessage> Messages;
+	double Milliseconds = 0.0;
+};
+
+// Splits compiler output into messages, one per non-empty line. Lines in no known form become errors with no location.
+std::vector<ShaderCompileMessage> ParseShaderCompileLog(const std::string& Log);
+
+// Compiles on a pool of worker threads. The compiler function is called concurrently and only fills in Succeeded,
+// Bytecode and Log; the service times the call and parses the log into messages. Results come back as shared futures,
+// so a shader used by several pipelines is waited on by each of them. Requests are started in submission order.
+class ShaderCompileService
+{
+public:
+	typedef std::function<ShaderCompileResult(const ShaderCompileRequest&)> CompileFunction;
+
+	// ThreadCount == 0 means std::thread::hardware_concurrency()
+	explicit ShaderCompileService(CompileFunction Compiler, uint32_t ThreadCount = 0);
+	// Finishes the requests already submitted
+	~ShaderCompileService();
+
+	ShaderCompileService(const ShaderCompileService&) = delete;
+	ShaderCompileService& operator=(const ShaderCompileService&) = delete;
+
+	std::shared_future<ShaderCompileResult> Compile(ShaderCompileRequest Request);
+	// Blocks until every request submitted so far has finished
+	void WaitIdle();
+
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(Workers.size()); }
+	// Submitted and not finished yet
+	uint32_t GetPendingCount() const;
+
+private:
+	struct Job
+	{
+		ShaderCompileRequest Request;
+		std::promise<ShaderCompileResult> Result;
+	};
+
+	void WorkerLoop();
+
+	CompileFunction Compiler;
+	std::vector<std::thread> Workers;
+
+	mutable std::mutex QueueMutex;
+	std::condition_variable JobQueued;
+	std::condition_variable JobFinished;
+	std::deque<Job> Queue;
+	uint32_t RunningCount = 0;
+	bool ShuttingDown = false;
+};
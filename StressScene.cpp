@@ -0,0 +1,69 @@
+#include "StressScene.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "CubeMesh.h"
+
+// Camera of GetCubeViewProjectionMatrix
+constexpr float CameraZ = -2.5f;
+constexpr float CameraTanHalfFov = 0.99920399f; // tan(3.14 / 4)
+
+// View distances the cubes are placed at
+constexpr float NearestDistance = 5.0f;
+constexpr float FarthestDistance = 50.0f;
+
+// Average area a randomly rotated cube of unit edge covers on screen
+constexpr float CubeMeanProjectedArea = 1.5f;
+
+// xorshift32, the standard distributions are not the same on every platform
+static float NextRandom(uint32_t& State)
+{
+	State ^= State << 13;
+	State ^= State >> 17;
+	State ^= State << 5;
+	return static_cast<float>(State >> 8) / 16777216.0f;
+}
+
+StressScene GenerateStressScene(const StressSceneSettings& Settings, float Aspect)
+{
+	StressScene Scene;
+	Scene.ViewProjection = GetCubeViewProjectionMatrix(Aspect);
+
+	if (Settings.InstanceCount == 0)
+	{
+		Scene.InstanceTransforms.push_back(GetCubeWorldMatrix());
+		return Scene;
+	}
+
+	// Edge of a cube on screen in screen heights
+	const float EdgeDensity = std::clamp(Settings.EdgeDensity, 0.0f, 1.0f);
+	const float CubeSize = 0.25f * std::pow(0.02f, EdgeDensity);
+
+	// Part of the screen, in each direction, the cubes cover DepthComplexity times
+	const float DepthComplexity = std::max(Settings.DepthComplexity, 0.01f);
+	const float CoveredArea = Settings.InstanceCount * CubeMeanProjectedArea * CubeSize * CubeSize / DepthComplexity;
+	const float Spread = std::min(std::sqrt(CoveredArea / Aspect), 1.0f);
+
+	uint32_t State = Settings.Seed != 0 ? Settings.Seed : 0x9E3779B9u;
+	Scene.InstanceTransforms.resize(Settings.InstanceCount);
+
+	for (CPUMatrix& Transform : Scene.InstanceTransforms)
+	{
+		const float x = (NextRandom(State) * 2.0f - 1.0f) * Spread;
+		const float y = (NextRandom(State) * 2.0f - 1.0f) * Spread;
+		const float Distance = NearestDistance + NextRandom(State) * (FarthestDistance - NearestDistance);
+
+		const float Pitch = NextRandom(State) * 6.2831853f;
+		const float Yaw = NextRandom(State) * 6.2831853f;
+		const float Roll = NextRandom(State) * 6.2831853f;
+
+		// The mesh spans [-1, 1], an edge of 2 * Scale at Distance projects to CubeSize screen heights
+		const float Scale = CubeSize * Distance * CameraTanHalfFov;
+
+		Transform = CPUMatrixMultiply(CPUMatrixMultiply(CPUMatrixScaling(Scale, Scale, Scale), CPUMatrixRotationRollPitchYaw(Pitch, Yaw, Roll)),
+			CPUMatrixTranslation(x * Distance * CameraTanHalfFov * Aspect, y * Distance * CameraTanHalfFov, CameraZ + Distance));
+	}
+
+	return Scene;
+}
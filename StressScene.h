@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "CPUMath.h"
+
+struct StressSceneSettings
+{
+	// Cubes drawn, 0 for the single cube of the test
+	uint32_t InstanceCount = 0;
+	// Cubes over an average covered pixel. The cubes spread over the part of the screen that gives it, so it is
+	// lower when they would need more than the whole screen.
+	float DepthComplexity = 4.0f;
+	// 0 to 1, from cubes a quarter of the screen high to cubes a few pixels wide that are mostly edges
+	float EdgeDensity = 0.5f;
+	// Same seed, same scene on every platform
+	uint32_t Seed = 1;
+};
+
+// Instances of the cube mesh seen by the camera of the test. Instance i's vertices are transformed by
+// InstanceTransforms[i] and then by ViewProjection.
+struct StressScene
+{
+	std::vector<CPUMatrix> InstanceTransforms;
+	CPUMatrix ViewProjection;
+};
+
+// Randomly rotated cubes at random depths, their sizes scaled with the distance so they all project to the size
+// EdgeDensity asks for, spread over a screen Aspect (width over height) times as wide as it is high
+StressScene GenerateStressScene(const StressSceneSettings& Settings, float Aspect);
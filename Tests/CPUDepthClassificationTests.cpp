@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "CPUDepthClassification.h"
+#include "CPUResolveKernels.h"
+#include "TestCheck.h"
+
+static float FromBits(uint32_t Bits)
+{
+	float Value;
+	memcpy(&Value, &Bits, sizeof(Value));
+	return Value;
+}
+
+// Mostly the clear depth, with covered runs of every class and values on the class boundaries
+static void FillRandom(std::mt19937& Random, CPUResolvedDepth& Depth, uint32_t CoveredPercent)
+{
+	const float Special[] =
+	{
+		0.0f, -0.0f, 1.0f, FromBits(0x3F7FFFFF), FromBits(0x3F800001), FromBits(0x00000001), FromBits(0x80000001),
+		FromBits(0x7F800000), FromBits(0xFF800000), FromBits(0x7FC00000), FromBits(0xFFC00001), FromBits(0x7F800001), -0.5f, 2.0f
+	};
+
+	for (float& Value : Depth.Depth)
+	{
+		if (Random() % 100 >= CoveredPercent)
+			Value = 1.0f;
+		else if (Random() % 2 == 0)
+			Value = Special[Random() % (sizeof(Special) / sizeof(Special[0]))];
+		else
+			Value = std::uniform_real_distribution<float>(0.0f, 1.0f)(Random);
+	}
+}
+
+// Classifies Depth with Kernels and checks the counts, the covered rectangle and the colors against CPUGetDepthClass
+static void CheckClassification(const CPUResolveKernels& Kernels, const CPUResolvedDepth& Depth)
+{
+	CPUDepthClassification Expected;
+	CPURect& Rect = Expected.CoveredRect;
+	bool Covered = false;
+
+	for (uint32_t y = 0; y < Depth.Height; ++y)
+	{
+		for (uint32_t x = 0; x < Depth.Width; ++x)
+		{
+			const float Value = Depth.GetRow(y)[x];
+			++Expected.Counts[CPUGetDepthClass(Value)];
+
+			if (Value == 1.0f)
+				continue;
+
+			if (!Covered)
+				Rect = { static_cast<int32_t>(x), static_cast<int32_t>(y), static_cast<int32_t>(x) + 1, static_cast<int32_t>(y) + 1 };
+
+			Covered = true;
+			Rect.Left = std::min(Rect.Left, static_cast<int32_t>(x));
+			Rect.Right = std::max(Rect.Right, static_cast<int32_t>(x) + 1);
+			Rect.Bottom = static_cast<int32_t>(y) + 1;
+		}
+	}
+
+	std::vector<uint32_t> Colors(Depth.Depth.size() + 1, 0x12345678);
+	const CPUDepthClassification Classification = CPUClassifyDepth(Depth, Colors.data(), nullptr, &Kernels);
+
+	bool Same = memcmp(Classification.Counts, Expected.Counts, sizeof(Expected.Counts)) == 0;
+	Same = Same && memcmp(&Classification.CoveredRect, &Expected.CoveredRect, sizeof(CPURect)) == 0;
+
+	for (size_t i = 0; i < Depth.Depth.size(); ++i)
+		Same = Same && Colors[i] == CPUDepthClassColors[CPUGetDepthClass(Depth.Depth[i])];
+
+	if (!Same)
+		printf("%s classification of %ux%u depths differs from CPUGetDepthClass\n", Kernels.Name, Depth.Width, Depth.Height);
+
+	TEST_CHECK(Same);
+	TEST_CHECK(Colors.back() == 0x12345678);
+
+	// Without colors, the same counts
+	const CPUDepthClassification Counted = CPUClassifyDepth(Depth, nullptr, nullptr, &Kernels);
+	TEST_CHECK(memcmp(Counted.Counts, Expected.Counts, sizeof(Expected.Counts)) == 0);
+	TEST_CHECK(memcmp(&Counted.CoveredRect, &Expected.CoveredRect, sizeof(CPURect)) == 0);
+}
+
+static void TestKernels(const CPUResolveKernels& Kernels)
+{
+	const uint32_t Sizes[][2] = { { 1, 1 }, { 1, 40 }, { 7, 3 }, { 17, 33 }, { 31, 16 }, { 64, 17 }, { 129, 50 } };
+	std::mt19937 Random(7);
+
+	for (const uint32_t (&Size)[2] : Sizes)
+	{
+		CPUResolvedDepth Depth;
+		Depth.Allocate(Size[0], Size[1]);
+
+		// All clear: nothing covered, an empty rectangle
+		std::fill(Depth.Depth.begin(), Depth.Depth.end(), 1.0f);
+		CheckClassification(Kernels, Depth);
+
+		for (uint32_t CoveredPercent : { 1u, 20u, 100u })
+		{
+			FillRandom(Random, Depth, CoveredPercent);
+			CheckClassification(Kernels, Depth);
+		}
+
+		// A single covered texel in the last row and column, and in the first
+		std::fill(Depth.Depth.begin(), Depth.Depth.end(), 1.0f);
+		Depth.Depth.back() = 0.5f;
+		CheckClassification(Kernels, Depth);
+
+		std::fill(Depth.Depth.begin(), Depth.Depth.end(), 1.0f);
+		Depth.Depth.front() = FromBits(0x7FC00000);
+		CheckClassification(Kernels, Depth);
+	}
+}
+
+int main()
+{
+	for (CPUResolveISA ISA : { CPU_RESOLVE_ISA_SCALAR, CPU_RESOLVE_ISA_AVX2, CPU_RESOLVE_ISA_AVX512, CPU_RESOLVE_ISA_NEON })
+	{
+		if (const CPUResolveKernels* Kernels = GetCPUResolveKernels8x(ISA))
+		{
+			printf("Testing the %s classification\n", Kernels->Name);
+			TestKernels(*Kernels);
+		}
+	}
+
+	// The default kernels are the best ones
+	CPUResolvedDepth Depth;
+	Depth.Allocate(5, 5);
+	std::fill(Depth.Depth.begin(), Depth.Depth.end(), 1.0f);
+	Depth.GetRow(2)[3] = 0.0f;
+
+	const CPUDepthClassification Classification = CPUClassifyDepth(Depth, nullptr);
+	TEST_CHECK(Classification.Counts[CPU_DEPTH_CLASS_ZERO] == 1 && Classification.Counts[CPU_DEPTH_CLASS_ONE] == 24);
+	TEST_CHECK(Classification.CoveredRect.Left == 3 && Classification.CoveredRect.Top == 2 && Classification.CoveredRect.Right == 4 && Classification.CoveredRect.Bottom == 3);
+	TEST_CHECK(Classification.GetCoveredCount() == 1);
+
+	return FinishTests("CPUDepthClassificationTests");
+}
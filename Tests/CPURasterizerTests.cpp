@@ -0,0 +1,188 @@
+#include <cstring>
+
+#include "CPURasterizer.h"
+#include "TestCheck.h"
+
+// Target size the test coordinates assume: 1/16 pixel units map to NDC exactly, x / 1024 - 1 and 1 - y / 1024
+constexpr uint32_t TargetSize = 128;
+
+static bool SamePattern(const CPUSamplePattern& A, const CPUSamplePattern& B)
+{
+	return A.SampleCount == B.SampleCount && A.PixelCount == B.PixelCount && memcmp(A.Positions, B.Positions, A.SampleCount * A.PixelCount * sizeof(CPUSamplePosition)) == 0;
+}
+
+static void TestSetSamplePositions()
+{
+	CPURasterizer Rasterizer;
+	const CPUSamplePosition Custom[4] = { { -8, -8 }, { 7, -8 }, { -8, 7 }, { 7, 7 } };
+
+	TEST_CHECK(SamePattern(Rasterizer.GetSamplePattern(4), GetStandardSamplePattern(4)));
+	TEST_CHECK(Rasterizer.SetSamplePositions(4, 1, Custom));
+
+	CPUSamplePattern Programmed;
+	TEST_CHECK(MakeSamplePattern(4, 1, Custom, Programmed));
+	TEST_CHECK(SamePattern(Rasterizer.GetSamplePattern(4), Programmed));
+
+	// Rejected tables keep the programmed pattern: 2 pixels, a count without a standard pattern, offsets past
+	// [-8, 7] on either axis, no positions
+	CPUSamplePosition Positions[4 * CPUMaxSampleCount] = {};
+	TEST_CHECK(!Rasterizer.SetSamplePositions(4, 2, Positions));
+	TEST_CHECK(!Rasterizer.SetSamplePositions(3, 1, Positions));
+	TEST_CHECK(!Rasterizer.SetSamplePositions(32, 1, Positions));
+
+	for (CPUSamplePosition Outside : { CPUSamplePosition{ 8, 0 }, CPUSamplePosition{ 0, 8 }, CPUSamplePosition{ -9, 0 }, CPUSamplePosition{ 0, -9 } })
+	{
+		Positions[1] = Outside;
+		TEST_CHECK(!Rasterizer.SetSamplePositions(4, 1, Positions));
+		Positions[1] = {};
+
+		// In the last pixel of a quad
+		Positions[13] = Outside;
+		TEST_CHECK(!Rasterizer.SetSamplePositions(4, 4, Positions));
+		Positions[13] = {};
+	}
+
+	TEST_CHECK(!Rasterizer.SetSamplePositions(4, 1, nullptr));
+	TEST_CHECK(SamePattern(Rasterizer.GetSamplePattern(4), Programmed));
+
+	// Targets of another sample count use their standard pattern
+	TEST_CHECK(SamePattern(Rasterizer.GetSamplePattern(8), GetStandardSamplePattern(8)));
+
+	// Zero samples restores the standard pattern whatever the other arguments are
+	TEST_CHECK(Rasterizer.SetSamplePositions(0, 0, nullptr));
+	TEST_CHECK(SamePattern(Rasterizer.GetSamplePattern(4), GetStandardSamplePattern(4)));
+}
+
+// Draws the triangle with corners in 1/16 pixel units into a cleared target at depth 0.5
+static void DrawTriangle(CPURasterizer& Rasterizer, CPUDepthSurface& Target, const int32_t (&Corners)[3][2])
+{
+	CPUFloat3 Vertices[3];
+
+	for (uint32_t i = 0; i < 3; ++i)
+		Vertices[i] = { Corners[i][0] / 1024.0f - 1.0f, 1.0f - Corners[i][1] / 1024.0f, 0.5f };
+
+	const uint16_t Indices[3] = { 0, 1, 2 };
+
+	CPUDrawIndexedDesc Draw;
+	Draw.Vertices = Vertices;
+	Draw.VertexCount = 3;
+	Draw.Indices = Indices;
+	Draw.IndexCount = 3;
+	Draw.CullMode = CPU_CULL_MODE_NONE;
+
+	Target.Clear(1.0f, 0);
+	TEST_CHECK(Rasterizer.DrawIndexed(Target, Draw) == 1);
+}
+
+// Splits the square [Left, Right) x [Top, Bottom) along a diagonal and draws each half into a target of its own.
+// Every sample inside must be covered by exactly one half, whatever lies on the edges, and none outside.
+static void CheckSquare(CPURasterizer& Rasterizer, const CPUSamplePattern& Pattern, int32_t Left, int32_t Top, int32_t Right, int32_t Bottom)
+{
+	CPUDepthSurface Halves[2];
+
+	for (CPUDepthSurface& Half : Halves)
+		Half.Allocate(TargetSize, TargetSize, Pattern.SampleCount);
+
+	for (bool MainDiagonal : { true, false })
+	{
+		if (MainDiagonal)
+		{
+			DrawTriangle(Rasterizer, Halves[0], { { Left, Top }, { Right, Top }, { Right, Bottom } });
+			DrawTriangle(Rasterizer, Halves[1], { { Left, Top }, { Left, Bottom }, { Right, Bottom } });
+		}
+		else
+		{
+			DrawTriangle(Rasterizer, Halves[0], { { Left, Top }, { Right, Top }, { Left, Bottom } });
+			DrawTriangle(Rasterizer, Halves[1], { { Right, Top }, { Right, Bottom }, { Left, Bottom } });
+		}
+
+		uint32_t Errors = 0;
+
+		for (uint32_t y = 0; y < TargetSize; ++y)
+		{
+			for (uint32_t x = 0; x < TargetSize; ++x)
+			{
+				// Quad pixels are ordered (0,0), (1,0), (0,1), (1,1)
+				const CPUSamplePosition* Positions = &Pattern.Positions[Pattern.PixelCount == 4 ? ((y & 1) * 2 + (x & 1)) * Pattern.SampleCount : 0];
+
+				for (uint32_t s = 0; s < Pattern.SampleCount; ++s)
+				{
+					const int32_t SampleX = static_cast<int32_t>(x) * 16 + 8 + Positions[s].X;
+					const int32_t SampleY = static_cast<int32_t>(y) * 16 + 8 + Positions[s].Y;
+					const bool Inside = SampleX >= Left && SampleX < Right && SampleY >= Top && SampleY < Bottom;
+					const uint32_t Covered = (Halves[0].GetPixel(x, y)[s].Depth == 0.5f) + (Halves[1].GetPixel(x, y)[s].Depth == 0.5f);
+
+					Errors += Covered != (Inside ? 1u : 0u);
+				}
+			}
+		}
+
+		if (Errors != 0)
+			printf("%ux%u pattern on %u pixels, square (%d, %d)-(%d, %d): %u samples wrong\n", Pattern.SampleCount, Pattern.SampleCount, Pattern.PixelCount, Left, Top, Right, Bottom, Errors);
+
+		TEST_CHECK(Errors == 0);
+	}
+}
+
+// Squares crossing the tile boundary at pixel 64, with edges between samples and edges through the samples of the
+// pattern. A square whose corner lies on a sample has a diagonal through one sample per pixel along it.
+static void CheckPattern(CPURasterizer& Rasterizer, const CPUSamplePattern& Pattern)
+{
+	CheckSquare(Rasterizer, Pattern, 50 * 16 + 3, 40 * 16 + 5, 80 * 16 + 3, 70 * 16 + 5);
+
+	for (uint32_t QuadPixel = 0; QuadPixel < Pattern.PixelCount; ++QuadPixel)
+	{
+		for (uint32_t s = 0; s < Pattern.SampleCount; ++s)
+		{
+			const CPUSamplePosition Position = Pattern.Positions[QuadPixel * Pattern.SampleCount + s];
+			const int32_t X = static_cast<int32_t>(QuadPixel & 1) * 16 + 8 + Position.X;
+			const int32_t Y = static_cast<int32_t>(QuadPixel >> 1) * 16 + 8 + Position.Y;
+
+			CheckSquare(Rasterizer, Pattern, 52 * 16 + X, 44 * 16 + Y, 72 * 16 + X, 64 * 16 + Y);
+		}
+	}
+}
+
+// The expected positions come from the tables, not from the rasterizer, so a target drawn with the wrong pattern fails
+static CPUSamplePattern MakePattern(uint32_t SampleCount, uint32_t PixelCount, const CPUSamplePosition* Positions)
+{
+	CPUSamplePattern Pattern;
+	TEST_CHECK(MakeSamplePattern(SampleCount, PixelCount, Positions, Pattern));
+	return Pattern;
+}
+
+static void TestCoverage()
+{
+	CPURasterizer Rasterizer;
+
+	for (uint32_t SampleCount : { 1u, 2u, 4u, 8u, 16u })
+		CheckPattern(Rasterizer, MakePattern(SampleCount, 1, GetStandardSamplePositions(SampleCount)));
+
+	// Tier 1: the corners of the pixel, including the -8 offsets on its top and left edges
+	const CPUSamplePosition Corners[4] = { { -8, -8 }, { 7, -8 }, { -8, 7 }, { 7, 7 } };
+	TEST_CHECK(Rasterizer.SetSamplePositions(4, 1, Corners));
+	CheckPattern(Rasterizer, MakePattern(4, 1, Corners));
+
+	// Tier 2: a different pattern in each pixel of the quad
+	const CPUSamplePosition Quad[4 * 2] =
+	{
+		{ -4, -4 }, { 4, 4 },
+		{ 7, -8 }, { -8, 7 },
+		{ 0, 0 }, { -1, 1 },
+		{ -8, -8 }, { 3, -5 },
+	};
+
+	TEST_CHECK(Rasterizer.SetSamplePositions(2, 4, Quad));
+	CheckPattern(Rasterizer, MakePattern(2, 4, Quad));
+
+	// Programming 2x sample positions returned 4x targets to the standard pattern
+	CheckPattern(Rasterizer, MakePattern(4, 1, GetStandardSamplePositions(4)));
+}
+
+int main()
+{
+	TestSetSamplePositions();
+	TestCoverage();
+
+	return FinishTests("CPURasterizerTests");
+}
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "CPUResolveKernels.h"
+#include "TestCheck.h"
+
+constexpr uint32_t SampleCount = 8;
+constexpr float GuardValue = 12345.0f;
+
+// Depths a resolve has to order, skip or keep exactly, picked more often than a random float would be
+static const uint32_t SpecialDepths[] =
+{
+	0x00000000, 0x80000000,             // +0, -0
+	0x7F800000, 0xFF800000,             // +inf, -inf
+	0x7FC00000, 0xFFC00000, 0x7F800001, // quiet, negative and signaling NaN
+	0x7FBFFFFF, 0xFFFFFFFF,             // other NaN payloads
+	0x00000001, 0x807FFFFF, 0x00400000, // denormals
+	0x3F800000, 0x3F7FFFFF, 0x7F7FFFFF  // 1, below 1, largest finite
+};
+
+static float GetRandomDepth(std::mt19937& Random)
+{
+	uint32_t Bits;
+
+	switch (Random() % 4)
+	{
+		case 0:
+			Bits = SpecialDepths[Random() % (sizeof(SpecialDepths) / sizeof(SpecialDepths[0]))];
+			break;
+		case 1:
+			Bits = Random();
+			break;
+		default:
+		{
+			const float Depth = std::uniform_real_distribution<float>(0.0f, 1.0f)(Random);
+			memcpy(&Bits, &Depth, sizeof(Bits));
+			break;
+		}
+	}
+
+	float Depth;
+	memcpy(&Depth, &Bits, sizeof(Depth));
+	return Depth;
+}
+
+// Random pixels, some of them uniform, with random stencil and padding bytes the kernels must not read as depth
+static std::vector<CPUDepthStencilSample> GetRandomSamples(std::mt19937& Random, uint32_t PixelCount)
+{
+	std::vector<CPUDepthStencilSample> Samples(PixelCount * SampleCount);
+
+	for (uint32_t Pixel = 0; Pixel < PixelCount; ++Pixel)
+	{
+		const bool Uniform = Random() % 8 == 0;
+		const float UniformDepth = GetRandomDepth(Random);
+
+		for (uint32_t s = 0; s < SampleCount; ++s)
+		{
+			CPUDepthStencilSample& Sample = Samples[Pixel * SampleCount + s];
+			Sample.Depth = Uniform ? UniformDepth : GetRandomDepth(Random);
+			Sample.Stencil = static_cast<uint8_t>(Random());
+
+			for (uint8_t& Byte : Sample.Unused)
+				Byte = static_cast<uint8_t>(Random());
+		}
+	}
+
+	return Samples;
+}
+
+// Runs Kernel at a sample and a destination offset, so that neither is aligned to the vector width, and checks the
+// floats around the row are left alone
+static std::vector<float> ResolveRow(CPUResolveRowFunc Kernel, const std::vector<CPUDepthStencilSample>& Samples, uint32_t PixelCount, uint32_t Offset)
+{
+	std::vector<CPUDepthStencilSample> Source(Offset + Samples.size());
+	std::copy(Samples.begin(), Samples.end(), Source.begin() + Offset);
+
+	std::vector<float> Destination(Offset + PixelCount + 16, GuardValue);
+	Kernel(Source.data() + Offset, Destination.data() + Offset, PixelCount);
+
+	for (uint32_t i = 0; i < Offset; ++i)
+		TEST_CHECK(Destination[i] == GuardValue);
+
+	for (size_t i = Offset + PixelCount; i < Destination.size(); ++i)
+		TEST_CHECK(Destination[i] == GuardValue);
+
+	return std::vector<float>(Destination.begin() + Offset, Destination.begin() + Offset + PixelCount);
+}
+
+static void TestKernels(const CPUResolveKernels& Kernels)
+{
+	const CPUResolveKernels& Scalar = *GetCPUResolveKernels8x(CPU_RESOLVE_ISA_SCALAR);
+	const uint32_t PixelCounts[] = { 1, 3, 7, 9, 15, 17, 31, 33, 63, 65, 127, 255, 1001 };
+
+	std::mt19937 Random(42);
+
+	for (uint32_t PixelCount : PixelCounts)
+	{
+		for (uint32_t Offset : { 0u, 1u, 3u })
+		{
+			const std::vector<CPUDepthStencilSample> Samples = GetRandomSamples(Random, PixelCount);
+
+			for (uint32_t Mode = CPU_RESOLVE_MODE_MIN; Mode <= CPU_RESOLVE_MODE_AVERAGE; ++Mode)
+			{
+				const std::vector<float> Expected = ResolveRow(Scalar.Resolve[Mode], Samples, PixelCount, 0);
+				const std::vector<float> Actual = ResolveRow(Kernels.Resolve[Mode], Samples, PixelCount, Offset);
+
+				if (memcmp(Expected.data(), Actual.data(), PixelCount * sizeof(float)) != 0)
+				{
+					printf("%s kernel, mode %u, %u pixels at offset %u differs from the scalar one\n", Kernels.Name, Mode, PixelCount, Offset);
+					TEST_CHECK(false);
+				}
+
+				// The scalar kernel is ResolveDepthSamples
+				for (uint32_t Pixel = 0; Pixel < PixelCount; ++Pixel)
+				{
+					const float Reference = ResolveDepthSamples(&Samples[Pixel * SampleCount], SampleCount, static_cast<CPUResolveMode>(Mode));
+					TEST_CHECK(memcmp(&Reference, &Expected[Pixel], sizeof(float)) == 0);
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	for (CPUResolveISA ISA : { CPU_RESOLVE_ISA_SCALAR, CPU_RESOLVE_ISA_AVX2, CPU_RESOLVE_ISA_AVX512, CPU_RESOLVE_ISA_NEON })
+	{
+		const CPUResolveKernels* Kernels = GetCPUResolveKernels8x(ISA);
+
+		if (!Kernels)
+			continue;
+
+		printf("Testing the %s kernels\n", Kernels->Name);
+		TEST_CHECK(Kernels->ISA == ISA);
+		TestKernels(*Kernels);
+	}
+
+	return FinishTests("CPUResolveKernelsTests");
+}
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "CPUResolve.h"
+#include "TestCheck.h"
+
+static uint32_t GetBits(float Value)
+{
+	uint32_t Bits;
+	memcpy(&Bits, &Value, sizeof(Bits));
+	return Bits;
+}
+
+static float FromBits(uint32_t Bits)
+{
+	float Value;
+	memcpy(&Value, &Bits, sizeof(Value));
+	return Value;
+}
+
+static uint32_t Resolve(const float* Depths, uint32_t SampleCount, CPUResolveMode Mode)
+{
+	return GetBits(ResolveDepthValues(Depths, SampleCount, Mode));
+}
+
+static void TestSignedZero()
+{
+	// -0.0 orders below +0.0 whichever sample holds it
+	const float ZeroFirst[2] = { 0.0f, -0.0f };
+	const float NegativeZeroFirst[2] = { -0.0f, 0.0f };
+
+	for (const float* Depths : { ZeroFirst, NegativeZeroFirst })
+	{
+		TEST_CHECK(Resolve(Depths, 2, CPU_RESOLVE_MODE_MIN) == 0x80000000);
+		TEST_CHECK(Resolve(Depths, 2, CPU_RESOLVE_MODE_MAX) == 0x00000000);
+	}
+
+	// Below every positive depth, above every negative one
+	const float Mixed[4] = { FromBits(0x00000001), -0.0f, FromBits(0x80000001), 0.0f };
+	TEST_CHECK(Resolve(Mixed, 4, CPU_RESOLVE_MODE_MIN) == 0x80000001);
+	TEST_CHECK(Resolve(Mixed, 4, CPU_RESOLVE_MODE_MAX) == 0x00000001);
+
+	const float NegativeZeros[4] = { -0.0f, -0.0f, -0.0f, -0.0f };
+	TEST_CHECK(Resolve(NegativeZeros, 4, CPU_RESOLVE_MODE_AVERAGE) == 0x80000000);
+}
+
+static void TestNaN()
+{
+	const float Infinity = std::numeric_limits<float>::infinity();
+	const uint32_t Payloads[] = { 0x7FC00000, 0x7F800001, 0x7FBFFFFF, 0xFFC00001, 0xFFFFFFFF };
+
+	for (uint32_t Payload : Payloads)
+	{
+		const float NaN = FromBits(Payload);
+
+		// NaN samples are skipped wherever they are, infinities are ordered
+		const float Depths[8] = { NaN, 0.5f, -Infinity, NaN, 0.25f, Infinity, NaN, 0.75f };
+		TEST_CHECK(Resolve(Depths, 8, CPU_RESOLVE_MODE_MIN) == GetBits(-Infinity));
+		TEST_CHECK(Resolve(Depths, 8, CPU_RESOLVE_MODE_MAX) == GetBits(Infinity));
+
+		const float Last[4] = { 0.5f, 0.25f, 0.75f, NaN };
+		TEST_CHECK(Resolve(Last, 4, CPU_RESOLVE_MODE_MIN) == GetBits(0.25f));
+		TEST_CHECK(Resolve(Last, 4, CPU_RESOLVE_MODE_MAX) == GetBits(0.75f));
+
+		// All NaN, or a NaN in the sum: the quiet NaN, whatever the payloads were
+		float AllNaN[16];
+
+		for (uint32_t i = 0; i < 16; ++i)
+			AllNaN[i] = FromBits(Payloads[(i + Payload) % 5]);
+
+		for (uint32_t SampleCount : { 1u, 2u, 4u, 8u, 16u })
+		{
+			TEST_CHECK(Resolve(AllNaN, SampleCount, CPU_RESOLVE_MODE_MIN) == CPUResolveNaN);
+			TEST_CHECK(Resolve(AllNaN, SampleCount, CPU_RESOLVE_MODE_MAX) == CPUResolveNaN);
+			TEST_CHECK(Resolve(AllNaN, SampleCount, CPU_RESOLVE_MODE_AVERAGE) == CPUResolveNaN);
+		}
+
+		TEST_CHECK(Resolve(Last, 4, CPU_RESOLVE_MODE_AVERAGE) == CPUResolveNaN);
+	}
+
+	// Infinities of both signs sum to NaN
+	const float Infinities[2] = { Infinity, -Infinity };
+	TEST_CHECK(Resolve(Infinities, 2, CPU_RESOLVE_MODE_AVERAGE) == CPUResolveNaN);
+	TEST_CHECK(Resolve(Infinities, 2, CPU_RESOLVE_MODE_MIN) == GetBits(-Infinity));
+}
+
+static void TestAverageOrder()
+{
+	// Sample i is added to sample i + N/2 first: ((d0 + d4) + (d2 + d6)) + ((d1 + d5) + (d3 + d7)). In submission
+	// order 1e8 would swallow the ones before -1e8 cancels it.
+	const float Depths[8] = { 1e8f, 1.0f, 1.0f, 1.0f, -1e8f, 1.0f, 1.0f, 1.0f };
+	TEST_CHECK(Resolve(Depths, 8, CPU_RESOLVE_MODE_AVERAGE) == GetBits(0.75f));
+
+	const float Pairs[4] = { 1e8f, 1.0f, -1e8f, 1.0f };
+	TEST_CHECK(Resolve(Pairs, 4, CPU_RESOLVE_MODE_AVERAGE) == GetBits(0.5f));
+
+	// Scaled by 1/N after the sum, so a sum that overflows stays infinite
+	const float Large[2] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+	TEST_CHECK(Resolve(Large, 2, CPU_RESOLVE_MODE_AVERAGE) == GetBits(std::numeric_limits<float>::infinity()));
+
+	// Denormals are kept, not flushed
+	const float Denormals[2] = { FromBits(0x00000002), FromBits(0x00000002) };
+	TEST_CHECK(Resolve(Denormals, 2, CPU_RESOLVE_MODE_AVERAGE) == 0x00000002);
+
+	// The uniform shortcut gives what the reduction gives
+	for (float Depth : { 0.0f, -0.0f, 0.3f, 1.0f, std::numeric_limits<float>::max(), FromBits(0x00000003), FromBits(0xFFC00001) })
+	{
+		for (uint32_t SampleCount : { 1u, 2u, 4u, 8u, 16u })
+		{
+			float Uniform[16];
+
+			for (uint32_t i = 0; i < SampleCount; ++i)
+				Uniform[i] = Depth;
+
+			for (CPUResolveMode Mode : { CPU_RESOLVE_MODE_MIN, CPU_RESOLVE_MODE_MAX, CPU_RESOLVE_MODE_AVERAGE })
+				TEST_CHECK(GetBits(ResolveUniformDepth(Depth, SampleCount, Mode)) == Resolve(Uniform, SampleCount, Mode));
+		}
+	}
+}
+
+static void TestRegion()
+{
+	CPUDepthSurface Source;
+	Source.Allocate(37, 21, 8);
+
+	for (uint32_t y = 0; y < Source.Height; ++y)
+	{
+		for (uint32_t x = 0; x < Source.Width; ++x)
+		{
+			CPUDepthStencilSample* Samples = Source.GetPixel(x, y);
+
+			for (uint32_t s = 0; s < Source.SampleCount; ++s)
+				Samples[s] = { static_cast<float>((x * 7 + y * 13 + s * 5) % 17) / 16.0f, static_cast<uint8_t>(x + s), {} };
+		}
+	}
+
+	CPUResolvedDepth Destination;
+	Destination.Allocate(40, 30);
+	std::fill(Destination.Depth.begin(), Destination.Depth.end(), -1.0f);
+
+	// The rectangle lands at (DstX, DstY), nothing around it is written
+	const CPURect Rect = { 3, 2, 30, 19 };
+	TEST_CHECK(CPUResolveDepthRegion(Destination, 5, 9, Source, &Rect, CPU_RESOLVE_MODE_MAX));
+
+	for (uint32_t y = 0; y < Destination.Height; ++y)
+	{
+		for (uint32_t x = 0; x < Destination.Width; ++x)
+		{
+			const bool Inside = x >= 5 && x < 32 && y >= 9 && y < 26;
+			const float Expected = Inside ? ResolveDepthPixel(Source, x - 5 + 3, y - 9 + 2, CPU_RESOLVE_MODE_MAX) : -1.0f;
+			TEST_CHECK(GetBits(Destination.GetRow(y)[x]) == GetBits(Expected));
+		}
+	}
+
+	// Rectangles outside the source, inverted or landing outside the destination
+	const CPURect PastSource = { 0, 0, 38, 21 };
+	const CPURect Inverted = { 10, 4, 4, 10 };
+	TEST_CHECK(!CPUResolveDepthRegion(Destination, 0, 0, Source, &PastSource, CPU_RESOLVE_MODE_MIN));
+	TEST_CHECK(!CPUResolveDepthRegion(Destination, 0, 0, Source, &Inverted, CPU_RESOLVE_MODE_MIN));
+	TEST_CHECK(!CPUResolveDepthRegion(Destination, 10, 20, Source, &Rect, CPU_RESOLVE_MODE_MIN));
+
+	Source.Allocate(37, 21, 3);
+	TEST_CHECK(!CPUResolveDepthRegion(Destination, 0, 0, Source, nullptr, CPU_RESOLVE_MODE_MIN));
+}
+
+int main()
+{
+	TestSignedZero();
+	TestNaN();
+	TestAverageOrder();
+	TestRegion();
+
+	return FinishTests("CPUResolveTests");
+}
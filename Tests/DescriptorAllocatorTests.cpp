@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "DescriptorAllocator.h"
+#include "TestCheck.h"
+
+static void TestFreeList()
+{
+	DescriptorFreeList FreeList(4);
+
+	// In order until the first free, then the most recently freed first
+	TEST_CHECK(FreeList.Allocate() == 0);
+	TEST_CHECK(FreeList.Allocate() == 1);
+	TEST_CHECK(FreeList.Allocate() == 2);
+	FreeList.Free(0);
+	FreeList.Free(2);
+	TEST_CHECK(FreeList.GetAllocatedCount() == 1);
+	TEST_CHECK(FreeList.Allocate() == 2);
+	TEST_CHECK(FreeList.Allocate() == 0);
+	TEST_CHECK(FreeList.Allocate() == 3);
+	TEST_CHECK(FreeList.Allocate() == DescriptorFreeList::InvalidIndex);
+	TEST_CHECK(FreeList.GetAllocatedCount() == FreeList.GetCapacity());
+
+	// Random allocations and frees never hand out an index twice or lose one
+	std::mt19937 Random(7);
+	DescriptorFreeList Large(256);
+	std::vector<bool> Allocated(Large.GetCapacity(), false);
+	uint32_t AllocatedCount = 0;
+
+	for (uint32_t Step = 0; Step < 20000; ++Step)
+	{
+		if (Random() % 2 == 0)
+		{
+			const uint32_t Index = Large.Allocate();
+
+			if (Index == DescriptorFreeList::InvalidIndex)
+			{
+				TEST_CHECK(AllocatedCount == Large.GetCapacity());
+				continue;
+			}
+
+			TEST_CHECK(Index < Large.GetCapacity() && !Allocated[Index]);
+			Allocated[Index] = true;
+			++AllocatedCount;
+		}
+		else if (AllocatedCount > 0)
+		{
+			uint32_t Index = Random() % Large.GetCapacity();
+
+			while (!Allocated[Index])
+				Index = (Index + 1) % Large.GetCapacity();
+
+			Large.Free(Index);
+			Allocated[Index] = false;
+			--AllocatedCount;
+		}
+
+		TEST_CHECK(Large.GetAllocatedCount() == AllocatedCount);
+	}
+}
+
+static void TestHandles()
+{
+	DescriptorAllocator Allocator(8, 16);
+
+	// Increments as a device might report them, and heap starts that are not multiples of them
+	DescriptorHeapLayout Persistent;
+	Persistent.CPUStart = 0x10000;
+	Persistent.IncrementSize = 32;
+
+	DescriptorHeapLayout Staging;
+	Staging.CPUStart = 0x200008;
+	Staging.GPUStart = 0x7000000000ull;
+	Staging.IncrementSize = 56;
+
+	Allocator.SetLayouts(Persistent, Staging);
+
+	const uint32_t First = Allocator.AllocatePersistent();
+	const uint32_t Second = Allocator.AllocatePersistent();
+	TEST_CHECK(Allocator.GetPersistentHandle(First) == 0x10000);
+	TEST_CHECK(Allocator.GetPersistentHandle(Second) == 0x10000 + 32);
+	TEST_CHECK(Allocator.GetPersistentCount() == 2);
+
+	const uint32_t Table = Allocator.AllocateStaging(3);
+	TEST_CHECK(Table == 0);
+	TEST_CHECK(Allocator.GetStagingCPUHandle(Table + 2) == 0x200008 + 2 * 56);
+	TEST_CHECK(Allocator.GetStagingGPUHandle(Table + 2) == 0x7000000000ull + 2 * 56);
+
+	// Persistent descriptors past the capacity are refused
+	for (uint32_t i = 2; i < Allocator.GetPersistentCapacity(); ++i)
+		TEST_CHECK(Allocator.AllocatePersistent() != DescriptorAllocator::InvalidIndex);
+
+	TEST_CHECK(Allocator.AllocatePersistent() == DescriptorAllocator::InvalidIndex);
+	Allocator.FreePersistent(Second);
+	TEST_CHECK(Allocator.AllocatePersistent() == Second);
+}
+
+static void TestStagingFrames()
+{
+	DescriptorAllocator Allocator(4, 16);
+
+	// Tables are contiguous and never split across the end of the ring
+	TEST_CHECK(Allocator.AllocateStaging(10) == 0);
+	Allocator.FinishFrame(1);
+	TEST_CHECK(Allocator.AllocateStaging(4) == 10);
+	TEST_CHECK(Allocator.AllocateStaging(4) == DescriptorAllocator::InvalidIndex);
+	Allocator.FinishFrame(2);
+	TEST_CHECK(Allocator.GetStagedCount() == 14);
+
+	Allocator.Reclaim(1);
+	TEST_CHECK(Allocator.AllocateStaging(4) == 0);
+	Allocator.FinishFrame(3);
+
+	Allocator.Reclaim(3);
+	TEST_CHECK(Allocator.GetStagedCount() == 0);
+	TEST_CHECK(Allocator.AllocateStaging(17) == DescriptorAllocator::InvalidIndex);
+}
+
+static void TestConcurrentStaging()
+{
+	const uint32_t ThreadCount = 4;
+	const uint32_t TablesPerThread = 64;
+	DescriptorAllocator Allocator(1, ThreadCount * TablesPerThread * 4);
+
+	// Worker threads staging their tables at once get disjoint ranges
+	std::vector<std::vector<uint32_t>> Tables(ThreadCount);
+	std::vector<std::thread> Threads;
+
+	for (uint32_t Thread = 0; Thread < ThreadCount; ++Thread)
+	{
+		Threads.emplace_back([&, Thread]
+		{
+			for (uint32_t i = 0; i < TablesPerThread; ++i)
+				Tables[Thread].push_back(Allocator.AllocateStaging(4));
+		});
+	}
+
+	for (std::thread& Thread : Threads)
+		Thread.join();
+
+	std::vector<uint32_t> Starts;
+
+	for (const std::vector<uint32_t>& ThreadTables : Tables)
+		Starts.insert(Starts.end(), ThreadTables.begin(), ThreadTables.end());
+
+	std::sort(Starts.begin(), Starts.end());
+
+	for (size_t i = 0; i < Starts.size(); ++i)
+		TEST_CHECK(Starts[i] == i * 4);
+
+	TEST_CHECK(Allocator.GetStagedCount() == Allocator.GetStagingCapacity());
+}
+
+int main()
+{
+	TestFreeList();
+	TestHandles();
+	TestStagingFrames();
+	TestConcurrentStaging();
+
+	return FinishTests("DescriptorAllocatorTests");
+}
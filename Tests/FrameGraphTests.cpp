@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "FrameGraph.h"
+#include "RecordingRenderBackend.h"
+#include "TestCheck.h"
+
+static bool LifetimesOverlap(const TransientAllocation& A, const TransientAllocation& B)
+{
+	return A.FirstPass <= B.LastPass && B.FirstPass <= A.LastPass;
+}
+
+static bool MemoryOverlaps(const TransientAllocation& A, const TransientAllocation& B)
+{
+	return A.Offset < B.Offset + B.Size && B.Offset < A.Offset + A.Size;
+}
+
+// Every placement aligned and inside the heap, no two allocations alive at once sharing memory, and a heap no
+// smaller than the peak and no larger than all allocations side by side
+static void CheckPlacement(const std::vector<TransientAllocation>& Allocations, uint64_t HeapSize)
+{
+	uint64_t UnaliasedSize = 0;
+
+	for (size_t i = 0; i < Allocations.size(); ++i)
+	{
+		const TransientAllocation& Allocation = Allocations[i];
+		TEST_CHECK(Allocation.Offset % Allocation.Alignment == 0);
+		TEST_CHECK(Allocation.Offset + Allocation.Size <= HeapSize);
+		UnaliasedSize += (Allocation.Size + Allocation.Alignment - 1) / Allocation.Alignment * Allocation.Alignment;
+
+		for (size_t j = i + 1; j < Allocations.size(); ++j)
+			TEST_CHECK(!LifetimesOverlap(Allocation, Allocations[j]) || !MemoryOverlaps(Allocation, Allocations[j]));
+	}
+
+	TEST_CHECK(HeapSize >= GetPeakLiveSize(Allocations));
+	TEST_CHECK(HeapSize <= UnaliasedSize);
+}
+
+static void TestAliasingPlans()
+{
+	const uint64_t Alignment = 64 * 1024;
+
+	std::vector<TransientAllocation> Allocations;
+	TEST_CHECK(PlanTransientAliasing(Allocations) == 0);
+	TEST_CHECK(GetPeakLiveSize(Allocations) == 0);
+
+	// A chain of passes each reading the last one's output: every other allocation shares memory
+	Allocations = {
+		{ 4 * Alignment, Alignment, 0, 1 },
+		{ 4 * Alignment, Alignment, 1, 2 },
+		{ 4 * Alignment, Alignment, 2, 3 },
+		{ 4 * Alignment, Alignment, 3, 4 },
+	};
+
+	uint64_t HeapSize = PlanTransientAliasing(Allocations);
+	TEST_CHECK(HeapSize == 8 * Alignment);
+	TEST_CHECK(GetPeakLiveSize(Allocations) == 8 * Alignment);
+	TEST_CHECK(Allocations[0].Offset == Allocations[2].Offset && Allocations[1].Offset == Allocations[3].Offset);
+	CheckPlacement(Allocations, HeapSize);
+
+	// All alive in pass 1: nothing shared
+	Allocations = {
+		{ 3 * Alignment, Alignment, 0, 2 },
+		{ Alignment, Alignment, 1, 1 },
+		{ 2 * Alignment, Alignment, 1, 3 },
+	};
+
+	HeapSize = PlanTransientAliasing(Allocations);
+	TEST_CHECK(HeapSize == 6 * Alignment);
+	TEST_CHECK(GetPeakLiveSize(Allocations) == 6 * Alignment);
+	CheckPlacement(Allocations, HeapSize);
+
+	// A small allocation fits the hole between two larger ones alive around it
+	Allocations = {
+		{ 2 * Alignment, Alignment, 0, 0 },
+		{ 2 * Alignment, Alignment, 0, 2 },
+		{ Alignment, Alignment, 1, 1 },
+	};
+
+	HeapSize = PlanTransientAliasing(Allocations);
+	TEST_CHECK(HeapSize == 4 * Alignment);
+	CheckPlacement(Allocations, HeapSize);
+
+	// Random lifetimes, sizes and alignments
+	std::mt19937 Random(1234);
+
+	for (uint32_t Iteration = 0; Iteration < 500; ++Iteration)
+	{
+		Allocations.resize(1 + Random() % 24);
+
+		for (TransientAllocation& Allocation : Allocations)
+		{
+			Allocation.Alignment = Random() % 4 == 0 ? 4 * 1024 * 1024 : Alignment;
+			Allocation.Size = (1 + Random() % 64) * Alignment;
+			Allocation.FirstPass = Random() % 16;
+			Allocation.LastPass = Allocation.FirstPass + Random() % 6;
+			Allocation.Offset = 0;
+		}
+
+		CheckPlacement(Allocations, PlanTransientAliasing(Allocations));
+	}
+}
+
+static RenderTextureDesc GetTargetDesc(uint32_t Flags, RenderFormat Format, RenderResourceState State)
+{
+	RenderTextureDesc Desc;
+	Desc.Width = 256;
+	Desc.Height = 256;
+	Desc.Format = Format;
+	Desc.Flags = Flags;
+	Desc.InitialState = State;
+
+	return Desc;
+}
+
+// Resources DiscardResource was called for in the frame the backend recorded last
+static std::vector<RenderResource> GetDiscards(const RecordingRenderBackend& Backend)
+{
+	std::vector<RenderResource> Discards;
+
+	Backend.GetCommands().ForEach([&](const RenderCommandHeader& Header)
+	{
+		if (Header.Type == RENDER_COMMAND_DISCARD_RESOURCE)
+			Discards.push_back(reinterpret_cast<const RenderDiscardResourceCommand&>(Header).Resource);
+	});
+
+	return Discards;
+}
+
+static void ExecuteFrame(RecordingRenderBackend& Backend, FrameGraph& Graph, ResourceStateTracker& Tracker)
+{
+	RenderCommandList* CommandList = Backend.BeginFrame();
+	Graph.Execute(*CommandList, Tracker);
+	Tracker.Flush(*CommandList);
+	Backend.EndFrame();
+}
+
+static void TestCompileAndDiscards()
+{
+	RecordingRenderBackend Backend(256, 256);
+	ResourceStateTracker Tracker;
+	FrameGraph Graph;
+
+	// Depth -> resolved depth -> output, and a pass nothing reads
+	const FrameGraphResource Depth = Graph.CreateTexture(GetTargetDesc(RENDER_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL, RENDER_FORMAT_D32_FLOAT, RENDER_RESOURCE_STATE_DEPTH_WRITE));
+	const FrameGraphResource Scratch = Graph.CreateTexture(GetTargetDesc(RENDER_RESOURCE_FLAG_ALLOW_RENDER_TARGET, RENDER_FORMAT_R32_FLOAT, RENDER_RESOURCE_STATE_RENDER_TARGET));
+	const FrameGraphResource Resolved = Graph.CreateTexture(GetTargetDesc(RENDER_RESOURCE_FLAG_ALLOW_RENDER_TARGET, RENDER_FORMAT_R32_FLOAT, RENDER_RESOURCE_STATE_RENDER_TARGET));
+	Graph.MarkOutput(Resolved);
+
+	uint32_t ExecutedCount = 0;
+	const uint32_t DrawPass = Graph.AddPass("Draw", [&](RenderCommandList&) { ++ExecutedCount; });
+	const uint32_t UnusedPass = Graph.AddPass("Unused", [&](RenderCommandList&) { ++ExecutedCount; });
+	const uint32_t ResolvePass = Graph.AddPass("Resolve", [&](RenderCommandList&) { ++ExecutedCount; });
+	TEST_CHECK(Graph.Write(DrawPass, Depth, RENDER_RESOURCE_STATE_DEPTH_WRITE));
+	TEST_CHECK(Graph.Write(UnusedPass, Scratch, RENDER_RESOURCE_STATE_RENDER_TARGET));
+	TEST_CHECK(Graph.Read(ResolvePass, Depth, RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+	TEST_CHECK(Graph.Write(ResolvePass, Resolved, RENDER_RESOURCE_STATE_RENDER_TARGET));
+	TEST_CHECK(!Graph.Read(ResolvePass, 99, RENDER_RESOURCE_STATE_COPY_SOURCE));
+
+	TEST_CHECK(Graph.Compile(Backend, Tracker));
+	TEST_CHECK(!Graph.Compile(Backend, Tracker));
+	TEST_CHECK(Graph.IsPassCulled(UnusedPass) && !Graph.IsPassCulled(DrawPass));
+	TEST_CHECK(Graph.GetResource(Scratch) == RenderNullHandle);
+	TEST_CHECK(Graph.GetResource(Depth) != RenderNullHandle && Graph.GetResource(Resolved) != RenderNullHandle);
+
+	const FrameGraphMemoryReport& Report = Graph.GetMemoryReport();
+	TEST_CHECK(Report.CulledPassCount == 1 && Report.CulledTransientCount == 1 && Report.TransientCount == 2);
+	TEST_CHECK(Report.HeapSize >= Report.PeakLiveSize && Report.HeapSize <= Report.UnaliasedSize);
+
+	// Targets placed by Compile are discarded on their first use, once
+	ExecuteFrame(Backend, Graph, Tracker);
+	TEST_CHECK(ExecutedCount == 2);
+	std::vector<RenderResource> Discards = GetDiscards(Backend);
+	TEST_CHECK(Discards.size() == 2);
+	TEST_CHECK(std::find(Discards.begin(), Discards.end(), Graph.GetResource(Depth)) != Discards.end());
+
+	ExecuteFrame(Backend, Graph, Tracker);
+	TEST_CHECK(GetDiscards(Backend).empty());
+
+	// And again after every compile, at the new size too
+	Graph.Release(Backend, Tracker);
+	TEST_CHECK(Graph.GetResource(Depth) == RenderNullHandle);
+	TEST_CHECK(Graph.SetTextureSize(Depth, 128, 128) && Graph.SetTextureSize(Resolved, 128, 128));
+	TEST_CHECK(Graph.Compile(Backend, Tracker));
+
+	ExecuteFrame(Backend, Graph, Tracker);
+	TEST_CHECK(GetDiscards(Backend).size() == 2);
+	TEST_CHECK(Tracker.GetState(Graph.GetResource(Resolved)) == RENDER_RESOURCE_STATE_RENDER_TARGET);
+
+	Graph.Release(Backend, Tracker);
+}
+
+class FailingHeapBackend : public RecordingRenderBackend
+{
+public:
+	FailingHeapBackend() : RecordingRenderBackend(64, 64) {}
+
+	RenderHeap CreateHeap(RenderHeapKind, uint64_t, uint64_t) override { return RenderNullHandle; }
+};
+
+static void TestHeapFailure()
+{
+	FailingHeapBackend Backend;
+	ResourceStateTracker Tracker;
+	FrameGraph Graph;
+
+	const FrameGraphResource Depth = Graph.CreateTexture(GetTargetDesc(RENDER_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL, RENDER_FORMAT_D32_FLOAT, RENDER_RESOURCE_STATE_DEPTH_WRITE));
+	Graph.MarkOutput(Depth);
+	Graph.Write(Graph.AddPass("Draw", [](RenderCommandList&) {}), Depth, RENDER_RESOURCE_STATE_DEPTH_WRITE);
+
+	TEST_CHECK(!Graph.Compile(Backend, Tracker));
+	TEST_CHECK(Graph.GetResource(Depth) == RenderNullHandle);
+}
+
+int main()
+{
+	TestAliasingPlans();
+	TestCompileAndDiscards();
+	TestHeapFailure();
+
+	return FinishTests("FrameGraphTests");
+}
@@ -0,0 +1,103 @@
+#include "FrameScheduler.h"
+#include "TestCheck.h"
+
+static void TestSimulatedFence()
+{
+	SimulatedFrameFence Fence;
+
+	// Completion never passes what was signaled
+	Fence.Signal(3);
+	Fence.Complete(5);
+	TEST_CHECK(Fence.GetCompletedValue() == 3);
+
+	Fence.Signal(2);
+	TEST_CHECK(Fence.GetSignaledValue() == 3);
+
+	// Waits for completed values return at once, others block, and those for values never signaled would hang
+	Fence.Wait(3);
+	TEST_CHECK(Fence.GetBlockingWaitCount() == 0);
+	Fence.Signal(6);
+	Fence.Wait(5);
+	TEST_CHECK(Fence.GetCompletedValue() == 5 && Fence.GetBlockingWaitCount() == 1 && Fence.GetDeadlockCount() == 0);
+	Fence.Wait(7);
+	TEST_CHECK(Fence.GetBlockingWaitCount() == 2 && Fence.GetDeadlockCount() == 1);
+}
+
+static void TestFramesInFlight()
+{
+	for (uint32_t FramesInFlight = FrameScheduler::MinFramesInFlight; FramesInFlight <= FrameScheduler::MaxFramesInFlight; ++FramesInFlight)
+	{
+		SimulatedFrameFence Fence;
+		FrameScheduler Scheduler(Fence, FramesInFlight);
+
+		// The GPU never catches up on its own: the first FramesInFlight frames start freely, every one after waits
+		// for the frame that last used its slot
+		for (uint32_t Frame = 1; Frame <= 20; ++Frame)
+		{
+			const uint32_t Slot = Scheduler.BeginFrame();
+			TEST_CHECK(Slot == Frame % FramesInFlight);
+			TEST_CHECK(Scheduler.GetFrameNumber() == Frame);
+			TEST_CHECK(Scheduler.GetStallCount() == (Frame > FramesInFlight ? Frame - FramesInFlight : 0));
+
+			// Never more than FramesInFlight frames between recording and completion
+			TEST_CHECK(Frame - Fence.GetCompletedValue() <= FramesInFlight);
+			TEST_CHECK(Frame <= FramesInFlight || Fence.GetCompletedValue() == Frame - FramesInFlight);
+
+			Scheduler.EndFrame();
+			TEST_CHECK(Fence.GetSignaledValue() == Frame);
+		}
+
+		TEST_CHECK(Fence.GetDeadlockCount() == 0);
+
+		Scheduler.WaitIdle();
+		TEST_CHECK(Fence.GetCompletedValue() == 20 && Fence.GetDeadlockCount() == 0);
+	}
+
+	SimulatedFrameFence Fence;
+	TEST_CHECK(FrameScheduler(Fence, 1).GetFramesInFlight() == FrameScheduler::MinFramesInFlight);
+	TEST_CHECK(FrameScheduler(Fence, 9).GetFramesInFlight() == FrameScheduler::MaxFramesInFlight);
+}
+
+static void TestGPUKeepingUp()
+{
+	SimulatedFrameFence Fence;
+	FrameScheduler Scheduler(Fence, 3);
+
+	// A GPU finishing each frame one frame after it was submitted never stalls the CPU
+	for (uint32_t Frame = 1; Frame <= 50; ++Frame)
+	{
+		Scheduler.BeginFrame();
+		Scheduler.EndFrame();
+		Fence.Complete(Frame - 1);
+	}
+
+	TEST_CHECK(Scheduler.GetStallCount() == 0);
+	TEST_CHECK(Fence.GetBlockingWaitCount() == 0);
+
+	// Nor does a GPU completing frames out of step, as long as it stays within the frames in flight
+	for (uint32_t Frame = 51; Frame <= 100; ++Frame)
+	{
+		Scheduler.BeginFrame();
+		Scheduler.EndFrame();
+
+		if (Frame % 2 == 0)
+			Fence.Complete(Frame - 1);
+	}
+
+	TEST_CHECK(Scheduler.GetStallCount() == 0);
+
+	// WaitIdle with everything complete does not wait
+	Fence.CompleteAll();
+	Scheduler.WaitIdle();
+	TEST_CHECK(Fence.GetBlockingWaitCount() == 0);
+	TEST_CHECK(Scheduler.GetCompletedFrame() == 100);
+}
+
+int main()
+{
+	TestSimulatedFence();
+	TestFramesInFlight();
+	TestGPUKeepingUp();
+
+	return FinishTests("FrameSchedulerTests");
+}
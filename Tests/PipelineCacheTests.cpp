@@ -0,0 +1,238 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "PipelineCache.h"
+#include "TestCheck.h"
+
+static const char* CachePath = "PipelineCacheTests.bin";
+
+static std::vector<uint8_t> ReadFile(const char* Path)
+{
+	std::ifstream File(Path, std::ios::binary);
+	return std::vector<uint8_t>(std::istreambuf_iterator<char>(File), std::istreambuf_iterator<char>());
+}
+
+static void WriteFile(const char* Path, const std::vector<uint8_t>& Data)
+{
+	std::ofstream File(Path, std::ios::binary | std::ios::trunc);
+	File.write(reinterpret_cast<const char*>(Data.data()), Data.size());
+}
+
+static uint64_t HashString(const char* String)
+{
+	PipelineCacheHasher Hasher;
+	Hasher.Add(String, strlen(String));
+	return Hasher.GetHash();
+}
+
+static bool FindString(PipelineCache& Cache, uint64_t Key, const std::string& Expected)
+{
+	PipelineCacheBlob Blob;
+	return Cache.Find(Key, Blob) && Blob.Size == Expected.size() && memcmp(Blob.Data, Expected.data(), Blob.Size) == 0;
+}
+
+static void TestHasher()
+{
+	// FNV-1a 64 reference values
+	TEST_CHECK(PipelineCacheHasher().GetHash() == 0xcbf29ce484222325ull);
+	TEST_CHECK(HashString("a") == 0xaf63dc4c8601ec8cull);
+	TEST_CHECK(HashString("foobar") == 0x85944171f73967e8ull);
+
+	PipelineCacheHasher Null;
+	PipelineCacheHasher Empty;
+	Null.AddString(nullptr);
+	Empty.AddString("");
+	TEST_CHECK(Null.GetHash() != Empty.GetHash());
+
+	PipelineCacheHasher Left;
+	PipelineCacheHasher Right;
+	Left.AddString("ab");
+	Left.AddString("c");
+	Right.AddString("a");
+	Right.AddString("bc");
+	TEST_CHECK(Left.GetHash() != Right.GetHash());
+
+	PipelineCacheHasher Again;
+	Again.AddString("ab");
+	Again.AddString("c");
+	TEST_CHECK(Again.GetHash() == Left.GetHash());
+}
+
+static void TestRoundTrip()
+{
+	const uint64_t Device = 0x1111;
+	const std::string Bytecode = "vertex shader bytecode";
+	const std::string PipelineBlob = "pipeline state blob of the driver";
+	const std::string Empty;
+
+	std::filesystem::remove(CachePath);
+
+	{
+		PipelineCache Cache;
+		TEST_CHECK(!Cache.Load(CachePath, Device));
+
+		PipelineCacheBlob Blob;
+		TEST_CHECK(!Cache.Find(1, Blob) && Cache.GetMissCount() == 1);
+
+		Cache.Store(1, Bytecode.data(), Bytecode.size(), false);
+		Cache.Store(2, PipelineBlob.data(), PipelineBlob.size(), true);
+		Cache.Store(3, Empty.data(), 0, false);
+		TEST_CHECK(FindString(Cache, 2, PipelineBlob));
+		TEST_CHECK(Cache.Save());
+	}
+
+	// Header, entry table, blobs 16 byte aligned
+	const std::vector<uint8_t> File = ReadFile(CachePath);
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t FileDevice;
+	uint32_t EntryCount;
+	TEST_CHECK(File.size() >= 24);
+
+	if (File.size() >= 24)
+	{
+		memcpy(&Magic, &File[0], 4);
+		memcpy(&Version, &File[4], 4);
+		memcpy(&FileDevice, &File[8], 8);
+		memcpy(&EntryCount, &File[16], 4);
+		TEST_CHECK(Magic == 0x48435050 && Version == PipelineCache::FormatVersion && FileDevice == Device && EntryCount == 3);
+
+		for (uint32_t i = 0; i < EntryCount && 24 + (i + 1) * 40 <= File.size(); ++i)
+		{
+			uint64_t Offset;
+			uint64_t Size;
+			memcpy(&Offset, &File[24 + i * 40 + 8], 8);
+			memcpy(&Size, &File[24 + i * 40 + 16], 8);
+			TEST_CHECK(Offset % 16 == 0 && Offset >= 24 + EntryCount * 40 && Offset + Size <= File.size());
+		}
+	}
+
+	// Same device: everything comes back
+	{
+		PipelineCache Cache;
+		TEST_CHECK(Cache.Load(CachePath, Device));
+		TEST_CHECK(Cache.GetLoadedCount() == 3 && Cache.GetDroppedCount() == 0);
+		TEST_CHECK(FindString(Cache, 1, Bytecode));
+		TEST_CHECK(FindString(Cache, 2, PipelineBlob));
+		TEST_CHECK(FindString(Cache, 3, Empty));
+		TEST_CHECK(Cache.GetHitCount() == 3);
+
+		// Nothing changed, nothing written
+		const auto WriteTime = std::filesystem::last_write_time(CachePath);
+		TEST_CHECK(Cache.Save());
+		TEST_CHECK(std::filesystem::last_write_time(CachePath) == WriteTime);
+	}
+
+	// Another adapter or driver: the device specific blob is dropped, bytecode stays, and the file is rewritten
+	{
+		PipelineCache Cache;
+		TEST_CHECK(Cache.Load(CachePath, 0x2222));
+		TEST_CHECK(Cache.GetLoadedCount() == 3 && Cache.GetDroppedCount() == 1 && Cache.GetEntryCount() == 2);
+		TEST_CHECK(FindString(Cache, 1, Bytecode));
+		TEST_CHECK(!FindString(Cache, 2, PipelineBlob));
+		TEST_CHECK(Cache.Save());
+	}
+
+	{
+		PipelineCache Cache;
+		TEST_CHECK(Cache.Load(CachePath, 0x2222));
+		TEST_CHECK(Cache.GetLoadedCount() == 2 && Cache.GetDroppedCount() == 0);
+
+		// Removed blobs are gone after the next save
+		Cache.Remove(1);
+		TEST_CHECK(Cache.Save());
+	}
+
+	{
+		PipelineCache Cache;
+		TEST_CHECK(Cache.Load(CachePath, 0x2222));
+		TEST_CHECK(Cache.GetEntryCount() == 1 && !FindString(Cache, 1, Bytecode));
+	}
+
+	std::filesystem::remove(CachePath);
+}
+
+static void TestInvalidFiles()
+{
+	const std::string Bytecode = "pixel shader bytecode";
+
+	std::filesystem::remove(CachePath);
+
+	{
+		PipelineCache Cache;
+		Cache.Load(CachePath, 1);
+		Cache.Store(7, Bytecode.data(), Bytecode.size(), false);
+		TEST_CHECK(Cache.Save());
+	}
+
+	std::vector<uint8_t> File = ReadFile(CachePath);
+
+	// A corrupt blob is dropped the first time it is found
+	std::vector<uint8_t> Corrupt = File;
+	Corrupt.back() ^= 0xFF;
+	WriteFile(CachePath, Corrupt);
+
+	{
+		PipelineCache Cache;
+		TEST_CHECK(Cache.Load(CachePath, 1));
+		TEST_CHECK(Cache.GetEntryCount() == 1);
+		TEST_CHECK(!FindString(Cache, 7, Bytecode));
+		TEST_CHECK(Cache.GetDroppedCount() == 1 && Cache.GetMissCount() == 1 && Cache.GetEntryCount() == 0);
+	}
+
+	// Another format version is ignored as a whole
+	std::vector<uint8_t> NewerVersion = File;
+	const uint32_t Version = PipelineCache::FormatVersion + 1;
+	memcpy(&NewerVersion[4], &Version, 4);
+	WriteFile(CachePath, NewerVersion);
+
+	{
+		PipelineCache Cache;
+		TEST_CHECK(!Cache.Load(CachePath, 1));
+		TEST_CHECK(Cache.GetEntryCount() == 0);
+
+		// And replaced by the next save
+		Cache.Store(8, Bytecode.data(), Bytecode.size(), false);
+		TEST_CHECK(Cache.Save());
+	}
+
+	{
+		PipelineCache Cache;
+		TEST_CHECK(Cache.Load(CachePath, 1));
+		TEST_CHECK(FindString(Cache, 8, Bytecode) && Cache.GetEntryCount() == 1);
+	}
+
+	// Truncated files and entry tables pointing past the end
+	WriteFile(CachePath, std::vector<uint8_t>(File.begin(), File.begin() + 10));
+
+	{
+		PipelineCache Cache;
+		TEST_CHECK(!Cache.Load(CachePath, 1));
+	}
+
+	std::vector<uint8_t> PastEnd = File;
+	const uint64_t Offset = PastEnd.size();
+	memcpy(&PastEnd[24 + 8], &Offset, 8);
+	WriteFile(CachePath, PastEnd);
+
+	{
+		PipelineCache Cache;
+		TEST_CHECK(Cache.Load(CachePath, 1));
+		TEST_CHECK(Cache.GetDroppedCount() == 1 && Cache.GetEntryCount() == 0);
+	}
+
+	std::filesystem::remove(CachePath);
+}
+
+int main()
+{
+	TestHasher();
+	TestRoundTrip();
+	TestInvalidFiles();
+
+	return FinishTests("PipelineCacheTests");
+}
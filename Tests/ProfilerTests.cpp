@@ -0,0 +1,204 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Profiler.h"
+#include "RecordingRenderBackend.h"
+#include "TestCheck.h"
+
+static const char* TracePath = "ProfilerTests.json";
+
+static size_t CountOccurrences(const std::string& Text, const std::string& Pattern)
+{
+	size_t Count = 0;
+
+	for (size_t Position = Text.find(Pattern); Position != std::string::npos; Position = Text.find(Pattern, Position + 1))
+		++Count;
+
+	return Count;
+}
+
+// Brackets and braces outside strings balance and never close more than was opened
+static bool IsBalanced(const std::string& Text)
+{
+	int Depth = 0;
+	bool InString = false;
+
+	for (size_t i = 0; i < Text.size(); ++i)
+	{
+		if (InString)
+		{
+			if (Text[i] == '\\')
+				++i;
+			else if (Text[i] == '"')
+				InString = false;
+		}
+		else if (Text[i] == '"')
+		{
+			InString = true;
+		}
+		else if (Text[i] == '{' || Text[i] == '[')
+		{
+			++Depth;
+		}
+		else if (Text[i] == '}' || Text[i] == ']')
+		{
+			if (--Depth < 0)
+				return false;
+		}
+	}
+
+	return Depth == 0 && !InString;
+}
+
+// Frames with a GPU scope nested in another and a CPU scope on the frame thread and on a worker
+static void RecordFrames(RecordingRenderBackend& Backend, Profiler& Profiling, uint32_t FrameCount)
+{
+	for (uint32_t Frame = 0; Frame < FrameCount; ++Frame)
+	{
+		RenderCommandList* CommandList = Backend.BeginFrame();
+		Profiling.BeginFrame();
+
+		{
+			ProfileScope Scope("Record");
+
+			Profiling.BeginGPUScope(*CommandList, "Frame");
+			Profiling.BeginGPUScope(*CommandList, "Resolve");
+			CommandList->SetViewport(64, 64);
+			Profiling.EndGPUScope(*CommandList);
+			Profiling.EndGPUScope(*CommandList);
+
+			std::thread Worker([] { ProfileScope WorkerScope("Worker"); });
+			Worker.join();
+		}
+
+		Profiling.EndFrame(*CommandList);
+		Backend.EndFrame();
+	}
+
+	Backend.WaitIdle();
+	Profiling.Flush();
+}
+
+static void TestGPUTimestamps()
+{
+	const uint32_t FrameCount = 6;
+	RecordingRenderBackend Backend(64, 64, true);
+	Profiler Profiling(&Backend);
+	Profiler::SetActive(&Profiling);
+
+	TEST_CHECK(Profiling.HasGPUTimestamps());
+	RecordFrames(Backend, Profiling, FrameCount);
+
+	const std::vector<ProfileEvent> Events = Profiling.GetEvents();
+	std::vector<const ProfileEvent*> Frames;
+	std::vector<const ProfileEvent*> Resolves;
+	std::vector<const ProfileEvent*> FrameThreadEvents;
+	std::vector<const ProfileEvent*> WorkerEvents;
+
+	for (const ProfileEvent& Event : Events)
+	{
+		TEST_CHECK(Event.Duration >= 0.0);
+		TEST_CHECK(Event.Frame >= 1 && Event.Frame <= FrameCount);
+
+		if (Event.GPU)
+		{
+			TEST_CHECK(Event.Thread == 0);
+			(strcmp(Event.Name, "Frame") == 0 ? Frames : Resolves).push_back(&Event);
+		}
+		else
+		{
+			// The backend times its submit on the frame thread
+			TEST_CHECK(Event.Thread >= 1);
+			(strcmp(Event.Name, "Worker") == 0 ? WorkerEvents : FrameThreadEvents).push_back(&Event);
+		}
+	}
+
+	// Record and Submit every frame, all on one thread, the workers each on another
+	TEST_CHECK(FrameThreadEvents.size() == 2 * FrameCount && WorkerEvents.size() == FrameCount);
+
+	for (const ProfileEvent* Event : FrameThreadEvents)
+	{
+		TEST_CHECK(strcmp(Event->Name, "Record") == 0 || strcmp(Event->Name, "Submit") == 0);
+		TEST_CHECK(Event->Thread == FrameThreadEvents[0]->Thread);
+	}
+
+	for (const ProfileEvent* Event : WorkerEvents)
+		TEST_CHECK(Event->Thread != FrameThreadEvents[0]->Thread);
+
+	TEST_CHECK(Frames.size() == FrameCount && Resolves.size() == FrameCount);
+
+	// Every frame once, in order, the inner scope inside the outer one on the same timeline
+	for (size_t i = 0; i < Frames.size() && i < Resolves.size(); ++i)
+	{
+		TEST_CHECK(Frames[i]->Frame == i + 1 && Resolves[i]->Frame == i + 1);
+		TEST_CHECK(Resolves[i]->Begin >= Frames[i]->Begin);
+		TEST_CHECK(Resolves[i]->Begin + Resolves[i]->Duration <= Frames[i]->Begin + Frames[i]->Duration + 0.001);
+		TEST_CHECK(i == 0 || Frames[i]->Begin >= Frames[i - 1]->Begin);
+	}
+
+	// The trace holds one complete event per profile event, on the CPU and GPU processes
+	TEST_CHECK(Profiling.WriteChromeTrace(TracePath));
+
+	std::ifstream File(TracePath);
+	const std::string Trace((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+
+	TEST_CHECK(IsBalanced(Trace));
+	TEST_CHECK(Trace.find("\"traceEvents\": [") != std::string::npos);
+	TEST_CHECK(CountOccurrences(Trace, "\"ph\": \"X\"") == Events.size());
+	TEST_CHECK(CountOccurrences(Trace, "\"ph\": \"M\"") == 2);
+	TEST_CHECK(CountOccurrences(Trace, "\"cat\": \"gpu\", \"ph\": \"X\", \"pid\": 2, \"tid\": 0") == 2 * FrameCount);
+	TEST_CHECK(CountOccurrences(Trace, "{ \"name\": \"Record\", \"cat\": \"cpu\", \"ph\": \"X\", \"pid\": 1") == FrameCount);
+
+	File.close();
+	std::remove(TracePath);
+	Profiler::SetActive(nullptr);
+}
+
+static void TestCPUOnly()
+{
+	// Recording only: no timestamps, GPU scopes record nothing
+	RecordingRenderBackend Backend(64, 64);
+	Profiler Profiling(&Backend);
+	Profiler::SetActive(&Profiling);
+
+	TEST_CHECK(!Profiling.HasGPUTimestamps());
+	RecordFrames(Backend, Profiling, 2);
+
+	uint32_t TimestampCount = 0;
+
+	Backend.GetCommands().ForEach([&](const RenderCommandHeader& Header)
+	{
+		TimestampCount += Header.Type == RENDER_COMMAND_WRITE_TIMESTAMP || Header.Type == RENDER_COMMAND_RESOLVE_TIMESTAMPS;
+	});
+
+	TEST_CHECK(TimestampCount == 0);
+
+	// Record, Submit and Worker every frame
+	const std::vector<ProfileEvent> Events = Profiling.GetEvents();
+	TEST_CHECK(Events.size() == 6);
+
+	for (const ProfileEvent& Event : Events)
+		TEST_CHECK(!Event.GPU);
+
+	// Scopes report to the active profiler only
+	Profiler::SetActive(nullptr);
+
+	{
+		ProfileScope Scope("Inactive");
+	}
+
+	TEST_CHECK(Profiling.GetEvents().size() == 6);
+}
+
+int main()
+{
+	TestGPUTimestamps();
+	TestCPUOnly();
+
+	return FinishTests("ProfilerTests");
+}
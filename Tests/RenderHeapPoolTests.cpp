@@ -0,0 +1,150 @@
+#include "FrameGraph.h"
+#include "RecordingRenderBackend.h"
+#include "RenderHeapPool.h"
+#include "TestCheck.h"
+
+constexpr uint64_t KB = 1024;
+constexpr uint64_t MB = 1024 * KB;
+
+static void EndFrame(RecordingRenderBackend& Backend)
+{
+	Backend.BeginFrame();
+	Backend.EndFrame();
+}
+
+static void TestSizeClasses()
+{
+	TEST_CHECK(RenderHeapPool::GetSizeClass(1, 1) == 64 * KB);
+	TEST_CHECK(RenderHeapPool::GetSizeClass(64 * KB, 64 * KB) == 64 * KB);
+	// A quarter of the power of two below apart, then the alignment
+	TEST_CHECK(RenderHeapPool::GetSizeClass(65 * KB, 1) == 80 * KB);
+	TEST_CHECK(RenderHeapPool::GetSizeClass(65 * KB, 64 * KB) == 128 * KB);
+	TEST_CHECK(RenderHeapPool::GetSizeClass(100 * MB, 64 * KB) == 112 * MB);
+	TEST_CHECK(RenderHeapPool::GetSizeClass(128 * MB, 4 * MB) == 128 * MB);
+	TEST_CHECK(RenderHeapPool::GetSizeClass(129 * MB, 4 * MB) == 160 * MB);
+	TEST_CHECK(RenderHeapPool::GetSizeClass(5 * MB, 4 * MB) == 8 * MB);
+
+	// Never smaller than the size, at most a quarter larger
+	for (uint64_t Size = 1; Size < 3000 * MB; Size = Size * 3 / 2 + 7)
+	{
+		const uint64_t Class = RenderHeapPool::GetSizeClass(Size, 1);
+		TEST_CHECK(Class >= Size);
+		TEST_CHECK(Size <= 64 * KB || Class <= Size + Size / 4 + 1);
+	}
+}
+
+static void TestAcquire()
+{
+	RecordingRenderBackend Backend(64, 64);
+	RenderHeapPool Pool(Backend, 10, 20 * MB);
+
+	const RenderHeap First = Pool.Acquire(RENDER_HEAP_KIND_TARGET_TEXTURES, 9 * MB, 64 * KB);
+	TEST_CHECK(First != RenderNullHandle && Backend.GetHeapSize() == 10 * MB);
+	TEST_CHECK(Pool.Acquire(RENDER_HEAP_KIND_TARGET_TEXTURES, 9 * MB, 64 * KB) != First);
+
+	// Not handed out again before the frame that released it completes
+	Backend.BeginFrame();
+	Pool.Release(First);
+	TEST_CHECK(Pool.Acquire(RENDER_HEAP_KIND_TARGET_TEXTURES, 9 * MB, 64 * KB) != First);
+	Backend.EndFrame();
+
+	// Then for any size of its class
+	TEST_CHECK(Pool.Acquire(RENDER_HEAP_KIND_TARGET_TEXTURES, 8 * MB + 1, 64 * KB) == First);
+	TEST_CHECK(Pool.GetStats().HitCount == 1 && Pool.GetStats().MissCount == 3);
+	TEST_CHECK(Pool.GetUsedSize() == 30 * MB && Pool.GetFreeSize() == 0);
+
+	// Not for another kind, a larger size, a size it would waste half of or a larger alignment
+	Pool.Release(First);
+	TEST_CHECK(Pool.Acquire(RENDER_HEAP_KIND_OTHER_TEXTURES, 9 * MB, 64 * KB) != First);
+	TEST_CHECK(Pool.Acquire(RENDER_HEAP_KIND_TARGET_TEXTURES, 11 * MB, 64 * KB) != First);
+	TEST_CHECK(Pool.Acquire(RENDER_HEAP_KIND_TARGET_TEXTURES, 4 * MB, 64 * KB) != First);
+	TEST_CHECK(Pool.Acquire(RENDER_HEAP_KIND_TARGET_TEXTURES, 6 * MB, 4 * MB) != First);
+	TEST_CHECK(Pool.Acquire(RENDER_HEAP_KIND_TARGET_TEXTURES, 7 * MB, 64 * KB) == First);
+}
+
+static void TestTrim()
+{
+	RecordingRenderBackend Backend(64, 64);
+	RenderHeapPool Pool(Backend, 10, 20 * MB);
+
+	// Released after MaxIdleFrames unused
+	const RenderHeap Idle = Pool.Acquire(RENDER_HEAP_KIND_TARGET_TEXTURES, 9 * MB, 64 * KB);
+	Pool.Release(Idle);
+
+	for (uint32_t Frame = 0; Frame < 10; ++Frame)
+	{
+		EndFrame(Backend);
+		Pool.Trim();
+	}
+
+	TEST_CHECK(Pool.GetFreeSize() == 10 * MB && Backend.GetHeapSize() == 10 * MB);
+	EndFrame(Backend);
+	Pool.Trim();
+	TEST_CHECK(Pool.GetFreeSize() == 0 && Backend.GetHeapSize() == 0 && Pool.GetStats().TrimCount == 1);
+
+	// Past MaxFreeSize, oldest first
+	const RenderHeap Older = Pool.Acquire(RENDER_HEAP_KIND_BUFFERS, 12 * MB, 64 * KB);
+	const RenderHeap Newer = Pool.Acquire(RENDER_HEAP_KIND_BUFFERS, 12 * MB, 64 * KB);
+	Pool.Release(Older);
+	EndFrame(Backend);
+	Pool.Release(Newer);
+	Pool.Trim();
+	TEST_CHECK(Pool.GetFreeSize() == 12 * MB && Pool.GetStats().TrimCount == 2);
+	EndFrame(Backend);
+	TEST_CHECK(Pool.Acquire(RENDER_HEAP_KIND_BUFFERS, 12 * MB, 64 * KB) == Newer);
+
+	// Heaps in use stay whatever their age
+	for (uint32_t Frame = 0; Frame < 20; ++Frame)
+	{
+		EndFrame(Backend);
+		Pool.Trim();
+	}
+
+	TEST_CHECK(Pool.GetUsedSize() == 12 * MB && Backend.GetHeapSize() == 12 * MB);
+}
+
+static void TestFrameGraphRecompile()
+{
+	RecordingRenderBackend Backend(64, 64);
+	ResourceStateTracker Tracker;
+	RenderHeapPool Pool(Backend);
+	FrameGraph Graph;
+
+	RenderTextureDesc Desc;
+	Desc.Width = 640;
+	Desc.Height = 480;
+	Desc.SampleCount = 4;
+	Desc.Format = RENDER_FORMAT_D32_FLOAT;
+	Desc.Flags = RENDER_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+	Desc.InitialState = RENDER_RESOURCE_STATE_DEPTH_WRITE;
+
+	const FrameGraphResource Depth = Graph.CreateTexture(Desc);
+	Graph.MarkOutput(Depth);
+	Graph.Write(Graph.AddPass("Draw", [](RenderCommandList&) {}), Depth, RENDER_RESOURCE_STATE_DEPTH_WRITE);
+
+	TEST_CHECK(Graph.Compile(Backend, Tracker, &Pool));
+	const RenderResource First = Graph.GetResource(Depth);
+	TEST_CHECK(First != RenderNullHandle && Tracker.IsTracked(First));
+	TEST_CHECK(!Graph.SetTextureSize(Depth, 620, 470));
+
+	// A resize a little smaller compiles into the same heap
+	Graph.Release(Backend, Tracker, &Pool);
+	TEST_CHECK(!Tracker.IsTracked(First) && Graph.GetResource(Depth) == RenderNullHandle);
+	TEST_CHECK(Graph.SetTextureSize(Depth, 620, 470));
+	EndFrame(Backend);
+	TEST_CHECK(Graph.Compile(Backend, Tracker, &Pool));
+	TEST_CHECK(Graph.GetResource(Depth) != First);
+	TEST_CHECK(Pool.GetStats().HitCount == 1 && Pool.GetStats().MissCount == 1);
+
+	Graph.Release(Backend, Tracker, &Pool);
+}
+
+int main()
+{
+	TestSizeClasses();
+	TestAcquire();
+	TestTrim();
+	TestFrameGraphRecompile();
+
+	return FinishTests("RenderHeapPoolTests");
+}
@@ -0,0 +1,204 @@
+#include <vector>
+
+#include "RecordingRenderBackend.h"
+#include "ResourceStateTracker.h"
+#include "TestCheck.h"
+
+typedef std::vector<RenderBarrier> BarrierCall;
+
+// ResourceBarrier calls of the frame the backend recorded last
+static std::vector<BarrierCall> GetBarrierCalls(const RecordingRenderBackend& Backend)
+{
+	std::vector<BarrierCall> Calls;
+
+	Backend.GetCommands().ForEach([&](const RenderCommandHeader& Header)
+	{
+		if (Header.Type != RENDER_COMMAND_RESOURCE_BARRIER)
+			return;
+
+		const RenderResourceBarrierCommand& Command = reinterpret_cast<const RenderResourceBarrierCommand&>(Header);
+		Calls.emplace_back(Command.GetBarriers(), Command.GetBarriers() + Command.Count);
+	});
+
+	return Calls;
+}
+
+// Records the requests and a flush as one frame and returns its barrier calls
+template<typename Function>
+static std::vector<BarrierCall> RecordFrame(RecordingRenderBackend& Backend, ResourceStateTracker& Tracker, Function&& Requests)
+{
+	RenderCommandList* CommandList = Backend.BeginFrame();
+	Requests();
+	Tracker.Flush(*CommandList);
+	Backend.EndFrame();
+
+	return GetBarrierCalls(Backend);
+}
+
+static bool IsTransition(const RenderBarrier& Barrier, RenderResource Resource, RenderResourceState Before, RenderResourceState After)
+{
+	return Barrier.Type == RenderBarrier::TRANSITION && Barrier.Resource == Resource && Barrier.Before == Before && Barrier.After == After;
+}
+
+static RenderResource CreateDepthTarget(RecordingRenderBackend& Backend)
+{
+	RenderTextureDesc Desc;
+	Desc.Width = 64;
+	Desc.Height = 64;
+	Desc.SampleCount = 8;
+	Desc.Format = RENDER_FORMAT_D32_FLOAT_S8X24_UINT;
+	Desc.Flags = RENDER_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+	Desc.InitialState = RENDER_RESOURCE_STATE_DEPTH_WRITE;
+
+	return Backend.CreateTexture(Desc);
+}
+
+static RenderResource CreateTexture(RecordingRenderBackend& Backend, RenderResourceState State)
+{
+	RenderTextureDesc Desc;
+	Desc.Width = 64;
+	Desc.Height = 64;
+	Desc.Format = RENDER_FORMAT_R32_FLOAT;
+	Desc.Flags = RENDER_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+	Desc.InitialState = State;
+
+	return Backend.CreateTexture(Desc);
+}
+
+static void TestBatching()
+{
+	RecordingRenderBackend Backend(64, 64);
+	ResourceStateTracker Tracker;
+
+	const RenderResource Depth = CreateDepthTarget(Backend);
+	const RenderResource Resolved = CreateTexture(Backend, RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	const RenderResource BackBuffer = Backend.GetBackBuffer();
+	Tracker.Track(Depth, RENDER_RESOURCE_STATE_DEPTH_WRITE);
+	Tracker.Track(Resolved, RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	Tracker.Track(BackBuffer, RENDER_RESOURCE_STATE_PRESENT);
+
+	// The transitions of the main loop before the resolve, one call
+	const std::vector<BarrierCall> Calls = RecordFrame(Backend, Tracker, [&]
+	{
+		TEST_CHECK(Tracker.Transition(Depth, RENDER_RESOURCE_STATE_RESOLVE_SOURCE));
+		TEST_CHECK(Tracker.Transition(Resolved, RENDER_RESOURCE_STATE_RESOLVE_DEST));
+		TEST_CHECK(Tracker.Transition(BackBuffer, RENDER_RESOURCE_STATE_RENDER_TARGET));
+		TEST_CHECK(Tracker.GetPendingCount() == 3);
+	});
+
+	TEST_CHECK(Calls.size() == 1);
+
+	if (Calls.size() == 1)
+	{
+		TEST_CHECK(Calls[0].size() == 3);
+		TEST_CHECK(IsTransition(Calls[0][0], Depth, RENDER_RESOURCE_STATE_DEPTH_WRITE, RENDER_RESOURCE_STATE_RESOLVE_SOURCE));
+		TEST_CHECK(IsTransition(Calls[0][1], Resolved, RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RENDER_RESOURCE_STATE_RESOLVE_DEST));
+		TEST_CHECK(IsTransition(Calls[0][2], BackBuffer, RENDER_RESOURCE_STATE_PRESENT, RENDER_RESOURCE_STATE_RENDER_TARGET));
+	}
+
+	TEST_CHECK(Tracker.GetPendingCount() == 0);
+	TEST_CHECK(Tracker.GetStats().Requests == 3 && Tracker.GetStats().Barriers == 3 && Tracker.GetStats().BarrierCalls == 1);
+	TEST_CHECK(Backend.GetStats().BarrierCallCount == 1 && Backend.GetStats().BarrierCount == 3);
+}
+
+static void TestRedundantTransitions()
+{
+	RecordingRenderBackend Backend(64, 64);
+	ResourceStateTracker Tracker;
+
+	const RenderResource Depth = CreateDepthTarget(Backend);
+	const RenderResource Texture = CreateTexture(Backend, RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	Tracker.Track(Depth, RENDER_RESOURCE_STATE_DEPTH_WRITE);
+	Tracker.Track(Texture, RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+	// Already in the state, and a round trip within the frame
+	std::vector<BarrierCall> Calls = RecordFrame(Backend, Tracker, [&]
+	{
+		Tracker.Transition(Depth, RENDER_RESOURCE_STATE_DEPTH_WRITE);
+		Tracker.Transition(Depth, RENDER_RESOURCE_STATE_RESOLVE_SOURCE);
+		Tracker.Transition(Depth, RENDER_RESOURCE_STATE_DEPTH_WRITE);
+	});
+
+	TEST_CHECK(Calls.empty());
+	TEST_CHECK(Tracker.GetState(Depth) == RENDER_RESOURCE_STATE_DEPTH_WRITE);
+
+	// A -> B -> C is issued as A -> C
+	Calls = RecordFrame(Backend, Tracker, [&]
+	{
+		Tracker.Transition(Texture, RENDER_RESOURCE_STATE_RESOLVE_DEST);
+		Tracker.Transition(Texture, RENDER_RESOURCE_STATE_UNORDERED_ACCESS);
+	});
+
+	TEST_CHECK(Calls.size() == 1 && Calls[0].size() == 1);
+	TEST_CHECK(!Calls.empty() && IsTransition(Calls[0][0], Texture, RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RENDER_RESOURCE_STATE_UNORDERED_ACCESS));
+
+	// Returning the depth target to RESOLVE_SOURCE at the end of a frame only to make it DEPTH_WRITE at the start of
+	// the next: the state carries over, so the next frame needs no barrier
+	Calls = RecordFrame(Backend, Tracker, [&] { Tracker.Transition(Depth, RENDER_RESOURCE_STATE_RESOLVE_SOURCE); });
+	TEST_CHECK(Calls.size() == 1);
+	Calls = RecordFrame(Backend, Tracker, [&] { Tracker.Transition(Depth, RENDER_RESOURCE_STATE_RESOLVE_SOURCE); });
+	TEST_CHECK(Calls.empty());
+
+	// A read state within the current combination of read states
+	Tracker.Track(Texture, static_cast<RenderResourceState>(RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | RENDER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+	Calls = RecordFrame(Backend, Tracker, [&] { Tracker.Transition(Texture, RENDER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE); });
+	TEST_CHECK(Calls.empty());
+
+	// Tracking again drops a queued transition, it would start from the old state
+	Calls = RecordFrame(Backend, Tracker, [&]
+	{
+		Tracker.Transition(Depth, RENDER_RESOURCE_STATE_DEPTH_READ);
+		Tracker.Track(Depth, RENDER_RESOURCE_STATE_COMMON);
+		TEST_CHECK(Tracker.GetPendingCount() == 0);
+	});
+	TEST_CHECK(Calls.empty());
+	TEST_CHECK(Tracker.GetState(Depth) == RENDER_RESOURCE_STATE_COMMON);
+
+	// Resources not tracked
+	const RenderResource Untracked = CreateTexture(Backend, RENDER_RESOURCE_STATE_COMMON);
+	TEST_CHECK(!Tracker.Transition(Untracked, RENDER_RESOURCE_STATE_COPY_DEST));
+	TEST_CHECK(!Tracker.UAVBarrier(Untracked));
+	TEST_CHECK(Tracker.GetPendingCount() == 0);
+}
+
+static void TestUAVAndAliasingOrder()
+{
+	RecordingRenderBackend Backend(64, 64);
+	ResourceStateTracker Tracker;
+
+	const RenderResource Texture = CreateTexture(Backend, RENDER_RESOURCE_STATE_UNORDERED_ACCESS);
+	Tracker.Track(Texture, RENDER_RESOURCE_STATE_UNORDERED_ACCESS);
+
+	// Repeated UAV barriers merge, a transition requested after them stays after them
+	const std::vector<BarrierCall> Calls = RecordFrame(Backend, Tracker, [&]
+	{
+		Tracker.UAVBarrier(Texture);
+		Tracker.UAVBarrier(Texture);
+		Tracker.Transition(Texture, RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		Tracker.AliasingBarrier(Texture);
+		Tracker.Transition(Texture, RENDER_RESOURCE_STATE_RENDER_TARGET);
+	});
+
+	TEST_CHECK(Calls.size() == 1);
+
+	if (Calls.size() == 1 && Calls[0].size() == 4)
+	{
+		TEST_CHECK(Calls[0][0].Type == RenderBarrier::UAV && Calls[0][0].Resource == Texture);
+		TEST_CHECK(IsTransition(Calls[0][1], Texture, RENDER_RESOURCE_STATE_UNORDERED_ACCESS, RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+		TEST_CHECK(Calls[0][2].Type == RenderBarrier::ALIASING && Calls[0][2].Resource == Texture);
+		TEST_CHECK(IsTransition(Calls[0][3], Texture, RENDER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RENDER_RESOURCE_STATE_RENDER_TARGET));
+	}
+	else
+	{
+		TEST_CHECK(!"expected one call of four barriers");
+	}
+}
+
+int main()
+{
+	TestBatching();
+	TestRedundantTransitions();
+	TestUAVAndAliasingOrder();
+
+	return FinishTests("ResourceStateTrackerTests");
+}
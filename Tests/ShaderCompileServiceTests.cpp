@@ -0,0 +1,145 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ShaderCompileService.h"
+#include "TestCheck.h"
+
+static bool IsMessage(const ShaderCompileMessage& Message, ShaderMessageSeverity Severity, const char* File, uint32_t Line, uint32_t Column, const char* Code, const char* Text)
+{
+	return Message.Severity == Severity && Message.File == File && Message.Line == Line && Message.Column == Column && Message.Code == Code && Message.Text == Text;
+}
+
+static void TestParseLog()
+{
+	const std::string Log =
+		"ResolveCS.hlsl(12,5): error X3004: undeclared identifier 'Depth'\r\n"
+		"\n"
+		"C:\\Shaders\\Hi Z (copy).hlsl(40,9-17): warning X3206: implicit truncation of vector type\n"
+		"ResolveCS.hlsl(3): error: no code here\n"
+		"warning X4000: use of potentially uninitialized variable\n"
+		"compilation failed; no code produced\n"
+		"Shader(7,1): something without a severity\n"
+		"error X1 2: not a code of one word";
+
+	const std::vector<ShaderCompileMessage> Messages = ParseShaderCompileLog(Log);
+	TEST_CHECK(Messages.size() == 7);
+
+	if (Messages.size() != 7)
+		return;
+
+	TEST_CHECK(IsMessage(Messages[0], SHADER_MESSAGE_ERROR, "ResolveCS.hlsl", 12, 5, "X3004", "undeclared identifier 'Depth'"));
+	// Paths with spaces and parentheses, and column ranges
+	TEST_CHECK(IsMessage(Messages[1], SHADER_MESSAGE_WARNING, "C:\\Shaders\\Hi Z (copy).hlsl", 40, 9, "X3206", "implicit truncation of vector type"));
+	TEST_CHECK(IsMessage(Messages[2], SHADER_MESSAGE_ERROR, "ResolveCS.hlsl", 3, 0, "", "no code here"));
+	TEST_CHECK(IsMessage(Messages[3], SHADER_MESSAGE_WARNING, "", 0, 0, "X4000", "use of potentially uninitialized variable"));
+	// Lines in no known form are errors without a location
+	TEST_CHECK(IsMessage(Messages[4], SHADER_MESSAGE_ERROR, "", 0, 0, "", "compilation failed; no code produced"));
+	TEST_CHECK(IsMessage(Messages[5], SHADER_MESSAGE_ERROR, "Shader", 7, 1, "", "something without a severity"));
+	TEST_CHECK(IsMessage(Messages[6], SHADER_MESSAGE_ERROR, "", 0, 0, "", "error X1 2: not a code of one word"));
+
+	TEST_CHECK(ParseShaderCompileLog("").empty());
+	TEST_CHECK(ParseShaderCompileLog("\r\n  \n").empty());
+}
+
+// Stands in for D3DCompile: fails sources containing "fail", warns about those containing "warn"
+static ShaderCompileResult StubCompile(const ShaderCompileRequest& Request)
+{
+	ShaderCompileResult Result;
+	Result.Succeeded = Request.Source.find("fail") == std::string::npos;
+
+	if (Result.Succeeded)
+		Result.Bytecode.assign(Request.EntryPoint.begin(), Request.EntryPoint.end());
+	else
+		Result.Log = Request.Name + "(1,1): error X3000: syntax error\n";
+
+	if (Request.Source.find("warn") != std::string::npos)
+		Result.Log += Request.Name + "(2,3): warning X3206: implicit truncation\n";
+
+	return Result;
+}
+
+static void TestCompile()
+{
+	ShaderCompileService Service(StubCompile, 3);
+	TEST_CHECK(Service.GetThreadCount() == 3);
+
+	std::shared_future<ShaderCompileResult> Vertex = Service.Compile({ "float4 Main() warn", "Cube.hlsl", "MainVS", "vs_5_0" });
+	std::shared_future<ShaderCompileResult> Pixel = Service.Compile({ "fail", "Resolve.hlsl", "MainPS", "ps_5_0" });
+
+	// Results are shared, each pipeline using a shader waits on the same one
+	std::shared_future<ShaderCompileResult> SameVertex = Vertex;
+
+	const ShaderCompileResult& VertexResult = Vertex.get();
+	TEST_CHECK(VertexResult.Succeeded && VertexResult.Bytecode.size() == 6);
+	TEST_CHECK(VertexResult.Messages.size() == 1 && VertexResult.Messages[0].Severity == SHADER_MESSAGE_WARNING && VertexResult.Messages[0].File == "Cube.hlsl");
+	TEST_CHECK(VertexResult.Milliseconds >= 0.0);
+	TEST_CHECK(&SameVertex.get() == &VertexResult);
+
+	const ShaderCompileResult& PixelResult = Pixel.get();
+	TEST_CHECK(!PixelResult.Succeeded && PixelResult.Bytecode.empty());
+	TEST_CHECK(PixelResult.Messages.size() == 1 && PixelResult.Messages[0].Code == "X3000" && PixelResult.Messages[0].Line == 1);
+
+	Service.WaitIdle();
+	TEST_CHECK(Service.GetPendingCount() == 0);
+}
+
+static void TestConcurrency()
+{
+	const uint32_t ThreadCount = 4;
+	std::atomic<uint32_t> Running = 0;
+	std::atomic<uint32_t> MaxRunning = 0;
+	std::atomic<uint32_t> Started = 0;
+	std::vector<std::shared_future<ShaderCompileResult>> Results;
+
+	{
+		ShaderCompileService Service([&](const ShaderCompileRequest& Request)
+		{
+			++Started;
+			const uint32_t Now = ++Running;
+			uint32_t Max = MaxRunning;
+
+			while (Now > Max && !MaxRunning.compare_exchange_weak(Max, Now))
+				;
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			--Running;
+
+			ShaderCompileResult Result;
+			Result.Succeeded = true;
+			Result.Bytecode.assign(Request.Name.begin(), Request.Name.end());
+			return Result;
+		}, ThreadCount);
+
+		for (uint32_t i = 0; i < 32; ++i)
+			Results.push_back(Service.Compile({ "", std::to_string(i), "Main", "cs_5_0" }));
+
+		Service.WaitIdle();
+		TEST_CHECK(Service.GetPendingCount() == 0 && Started == 32);
+
+		// Destroying the service finishes what was submitted, so no future is left without a value
+		for (uint32_t i = 0; i < 16; ++i)
+			Results.push_back(Service.Compile({ "", std::to_string(32 + i), "Main", "cs_5_0" }));
+	}
+
+	TEST_CHECK(Started == 48);
+	TEST_CHECK(MaxRunning > 1 && MaxRunning <= ThreadCount);
+
+	for (uint32_t i = 0; i < Results.size(); ++i)
+	{
+		const std::string Name = std::to_string(i);
+		const ShaderCompileResult& Result = Results[i].get();
+		TEST_CHECK(Result.Succeeded && std::string(Result.Bytecode.begin(), Result.Bytecode.end()) == Name);
+	}
+}
+
+int main()
+{
+	TestParseLog();
+	TestCompile();
+	TestConcurrency();
+
+	return FinishTests("ShaderCompileServiceTests");
+}
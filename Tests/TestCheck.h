@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdio>
+
+// Checks of one test executable: a failed check is printed and counted, main returns FinishTests()
+inline int TestFailureCount = 0;
+
+#define TEST_CHECK(Condition) \
+	do \
+	{ \
+		if (!(Condition)) \
+		{ \
+			printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #Condition); \
+			++TestFailureCount; \
+		} \
+	} while (0)
+
+inline int FinishTests(const char* Name)
+{
+	printf("%s: %s\n", Name, TestFailureCount == 0 ? "passed" : "FAILED");
+	return TestFailureCount == 0 ? 0 : 1;
+}
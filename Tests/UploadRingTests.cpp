@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "RecordingRenderBackend.h"
+#include "TestCheck.h"
+#include "UploadRingAllocator.h"
+
+struct LiveAllocation
+{
+	uint64_t Offset;
+	uint64_t Size;
+	uint64_t FenceValue; // 0 while its frame is being recorded
+};
+
+static void TestWraparound()
+{
+	UploadRing Ring(1024);
+
+	// Fills up to the end, the next allocation that does not fit starts over at 0 once that memory is free
+	TEST_CHECK(Ring.Allocate(600, 256) == 0);
+	Ring.FinishFrame(1);
+	TEST_CHECK(Ring.Allocate(300, 4) == 600);
+	Ring.FinishFrame(2);
+	TEST_CHECK(Ring.Allocate(200, 4) == UploadRing::InvalidOffset);
+
+	Ring.Reclaim(1);
+	TEST_CHECK(Ring.GetFramesInFlight() == 1);
+	TEST_CHECK(Ring.Allocate(200, 4) == 0);
+	// The skipped end of the ring counts as used until the frame before it completes
+	TEST_CHECK(Ring.GetUsedSize() == 300 + 124 + 200);
+	Ring.FinishFrame(3);
+
+	Ring.Reclaim(3);
+	TEST_CHECK(Ring.GetUsedSize() == 0 && Ring.GetFramesInFlight() == 0);
+
+	// An empty ring fits anything up to its capacity wherever its head is, nothing larger
+	TEST_CHECK(Ring.Allocate(1024, 256) == 0);
+	Ring.FinishFrame(4);
+	Ring.Reclaim(4);
+	TEST_CHECK(Ring.Allocate(1025, 1) == UploadRing::InvalidOffset);
+
+	// Frames without allocations take no entry
+	Ring.FinishFrame(5);
+	TEST_CHECK(Ring.GetFramesInFlight() == 0);
+}
+
+static void TestRandomFrames()
+{
+	std::mt19937 Random(42);
+
+	for (uint64_t Capacity : { 4096ull, 65536ull, 1ull << 20 })
+	{
+		UploadRing Ring(Capacity);
+		std::deque<LiveAllocation> Live;
+		uint64_t FenceValue = 0;
+		uint64_t CompletedValue = 0;
+		uint32_t FailureCount = 0;
+
+		for (uint32_t Frame = 0; Frame < 2000; ++Frame)
+		{
+			const uint32_t AllocationCount = Random() % 12;
+
+			for (uint32_t i = 0; i < AllocationCount; ++i)
+			{
+				const uint64_t Alignment = 1ull << (Random() % 9);
+				const uint64_t Size = 1 + Random() % (Random() % 8 == 0 ? Capacity / 2 : Capacity / 16);
+				const bool Empty = Live.empty();
+				const uint64_t Offset = Ring.Allocate(Size, Alignment);
+
+				if (Offset == UploadRing::InvalidOffset)
+				{
+					// Nothing in flight and nothing recorded means nothing stands in the way
+					TEST_CHECK(!Empty);
+					++FailureCount;
+					continue;
+				}
+
+				TEST_CHECK(Offset % Alignment == 0);
+				TEST_CHECK(Offset + Size <= Capacity);
+
+				for (const LiveAllocation& Other : Live)
+					TEST_CHECK(Offset + Size <= Other.Offset || Other.Offset + Other.Size <= Offset);
+
+				Live.push_back({ Offset, Size, 0 });
+			}
+
+			++FenceValue;
+			Ring.FinishFrame(FenceValue);
+
+			for (LiveAllocation& Allocation : Live)
+			{
+				if (Allocation.FenceValue == 0)
+					Allocation.FenceValue = FenceValue;
+			}
+
+			// The GPU completes zero to three frames, never more than it was given
+			CompletedValue = std::min(FenceValue, CompletedValue + Random() % 4);
+			Ring.Reclaim(CompletedValue);
+
+			while (!Live.empty() && Live.front().FenceValue <= CompletedValue)
+				Live.pop_front();
+
+			TEST_CHECK(Ring.GetUsedSize() <= Capacity);
+			TEST_CHECK(Ring.GetFramesInFlight() <= FenceValue - CompletedValue);
+		}
+
+		// A ring this busy runs full now and then; the test is only worth something if it does
+		TEST_CHECK(FailureCount > 0);
+	}
+}
+
+static void TestAllocator()
+{
+	RecordingRenderBackend Backend(64, 64);
+	UploadRingAllocator Allocator(Backend, 1024);
+	const uint8_t* Mapped = static_cast<const uint8_t*>(Backend.MapBuffer(Allocator.GetBuffer()));
+
+	TEST_CHECK(Allocator.GetBuffer() != RenderNullHandle && Mapped);
+
+	Backend.BeginFrame();
+	Allocator.BeginFrame();
+
+	// Constants are copied in and take whole 256 byte blocks
+	const float Constants[5] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f };
+	RenderUploadAllocation First;
+	RenderUploadAllocation Second;
+	TEST_CHECK(Allocator.AllocateConstants(Constants, sizeof(Constants), First));
+	TEST_CHECK(Allocator.AllocateConstants(Constants, sizeof(Constants), Second));
+	TEST_CHECK(First.Buffer == Allocator.GetBuffer() && First.Offset == 0 && Second.Offset == 256);
+	TEST_CHECK(memcmp(Mapped + Second.Offset, Constants, sizeof(Constants)) == 0);
+	TEST_CHECK(First.Data == Mapped && Second.Data == Mapped + 256);
+
+	RenderUploadAllocation Rest;
+	TEST_CHECK(Allocator.Allocate(512, 256, Rest));
+	TEST_CHECK(!Allocator.AllocateConstants(Constants, sizeof(Constants), Rest));
+
+	Allocator.EndFrame();
+	Backend.EndFrame();
+
+	// The recording backend completes frames as they end, so the next frame has the whole ring
+	Backend.BeginFrame();
+	Allocator.BeginFrame();
+	TEST_CHECK(Allocator.GetRing().GetUsedSize() == 0);
+	TEST_CHECK(Allocator.Allocate(1024, 256, Rest));
+	Allocator.EndFrame();
+	Backend.EndFrame();
+}
+
+int main()
+{
+	TestWraparound();
+	TestRandomFrames();
+	TestAllocator();
+
+	return FinishTests("UploadRingTests");
+}
@@ -0,0 +1,93 @@
+#include "UploadRingAllocator.h"
+
+#include <cstring>
+
+UploadRing::UploadRing(uint64_t Capacity) : Capacity(Capacity)
+{
+}
+
+uint64_t UploadRing::Allocate(uint64_t Size, uint64_t Alignment)
+{
+	if (Size > Capacity)
+		return InvalidOffset;
+
+	const uint64_t Position = Head % Capacity;
+	const uint64_t AlignedPosition = (Position + Alignment - 1) & ~(Alignment - 1);
+
+	// Start over at the beginning of the ring rather than split the allocation
+	const uint64_t Start = AlignedPosition + Size <= Capacity ? Head + (AlignedPosition - Position) : Head + (Capacity - Position);
+	const uint64_t End = Start + Size;
+
+	// Nothing in flight: the skipped end is not owed to any frame
+	if (Head == Tail)
+		Tail = Start;
+
+	if (End - Tail > Capacity)
+		return InvalidOffset;
+
+	Head = End;
+	return Start % Capacity;
+}
+
+void UploadRing::FinishFrame(uint64_t FenceValue)
+{
+	if (Head != FrameStart)
+		Frames.push_back({ FenceValue, Head });
+
+	FrameStart = Head;
+}
+
+void UploadRing::Reclaim(uint64_t CompletedValue)
+{
+	while (!Frames.empty() && Frames.front().FenceValue <= CompletedValue)
+	{
+		Tail = Frames.front().End;
+		Frames.pop_front();
+	}
+}
+
+UploadRingAllocator::UploadRingAllocator(RenderBackend& Backend, uint64_t Capacity) : Backend(Backend), Ring(Capacity)
+{
+	RenderBufferDesc BufferDesc;
+	BufferDesc.Size = Capacity;
+	BufferDesc.HeapType = RENDER_HEAP_TYPE_UPLOAD;
+	BufferDesc.InitialState = RENDER_RESOURCE_STATE_GENERIC_READ;
+	BufferDesc.Name = "UploadRing";
+
+	Buffer = Backend.CreateBuffer(BufferDesc);
+	Data = static_cast<uint8_t*>(Backend.MapBuffer(Buffer));
+}
+
+void UploadRingAllocator::BeginFrame()
+{
+	Ring.Reclaim(Backend.GetCompletedFrame());
+}
+
+void UploadRingAllocator::EndFrame()
+{
+	Ring.FinishFrame(Backend.GetFrameNumber());
+}
+
+bool UploadRingAllocator::Allocate(uint64_t Size, uint64_t Alignment, RenderUploadAllocation& Allocation)
+{
+	const uint64_t Offset = Ring.Allocate(Size, Alignment);
+
+	if (Offset == UploadRing::InvalidOffset)
+		return false;
+
+	Allocation.Data = Data + Offset;
+	Allocation.Buffer = Buffer;
+	Allocation.Offset = Offset;
+
+	return true;
+}
+
+bool UploadRingAllocator::AllocateConstants(const void* Data, uint64_t Size, RenderUploadAllocation& Allocation)
+{
+	// Constant buffer views cover whole 256 byte blocks
+	if (!Allocate((Size + ConstantBufferAlignment - 1) & ~(ConstantBufferAlignment - 1), ConstantBufferAlignment, Allocation))
+		return false;
+
+	memcpy(Allocation.Data, Data, Size);
+	return true;
+}
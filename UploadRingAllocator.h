@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include "RenderBackend.h"
+
+// Offsets of a ring of Capacity bytes, no memory behind it. Allocations go at the head and never wrap: when one does
+// not fit before the end, the rest of the ring is skipped and it starts at 0. Frames end with the fence value their
+// GPU work signals, and Reclaim frees the oldest frames whose value has completed.
+class UploadRing
+{
+public:
+	static constexpr uint64_t InvalidOffset = UINT64_MAX;
+
+	explicit UploadRing(uint64_t Capacity);
+
+	// Offset of Size bytes aligned to Alignment (a power of two dividing Capacity), InvalidOffset when the space
+	// is still used by frames in flight
+	uint64_t Allocate(uint64_t Size, uint64_t Alignment);
+
+	// Everything allocated since the last call is in use until FenceValue completes
+	void FinishFrame(uint64_t FenceValue);
+	void Reclaim(uint64_t CompletedValue);
+
+	uint64_t GetCapacity() const { return Capacity; }
+	// Bytes between the oldest frame in flight and the head, skipped ends of the ring included
+	uint64_t GetUsedSize() const { return Head - Tail; }
+	uint32_t GetFramesInFlight() const { return static_cast<uint32_t>(Frames.size()); }
+
+private:
+	struct Frame
+	{
+		uint64_t FenceValue;
+		uint64_t End;
+	};
+
+	// Head and Tail count bytes ever allocated, the offset in the ring is the remainder by Capacity
+	uint64_t Capacity;
+	uint64_t Head = 0;
+	uint64_t Tail = 0;
+	uint64_t FrameStart = 0;
+	std::deque<Frame> Frames;
+};
+
+struct RenderUploadAllocation
+{
+	void* Data = nullptr;
+	RenderResource Buffer = RenderNullHandle;
+	uint64_t Offset = 0;
+};
+
+// Per-frame upload memory in one persistently mapped upload buffer. Memory written during a frame stays untouched
+// until the backend reports that frame complete, so nothing waits and nothing is created or mapped per frame.
+class UploadRingAllocator
+{
+public:
+	// Root constant buffer views need 256 byte aligned addresses
+	static constexpr uint64_t ConstantBufferAlignment = 256;
+
+	UploadRingAllocator(RenderBackend& Backend, uint64_t Capacity);
+
+	// After Backend.BeginFrame: frees the memory of completed frames
+	void BeginFrame();
+	// Before Backend.EndFrame
+	void EndFrame();
+
+	// Both return false when the ring is full of frames in flight
+	bool Allocate(uint64_t Size, uint64_t Alignment, RenderUploadAllocation& Allocation);
+	bool AllocateConstants(const void* Data, uint64_t Size, RenderUploadAllocation& Allocation);
+
+	RenderResource GetBuffer() const { return Buffer; }
+	const UploadRing& GetRing() const { return Ring; }
+
+private:
+	RenderBackend& Backend;
+	UploadRing Ring;
+	RenderResource Buffer;
+	uint8_t* Data;
+};